@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "binary.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "exceptions.h"
+
+namespace wikiopencite::citescoop::cli::binary {
+
+namespace {
+constexpr unsigned kVarintPayloadBits = 7;
+constexpr uint8_t kVarintContinue = 0x80;
+constexpr uint8_t kVarintMask = 0x7f;
+constexpr unsigned kMaxVarintShift = 63;
+constexpr unsigned kBitsPerByte = 8;
+}  // namespace
+
+void PutVarint(std::string* output, uint64_t value) {
+  while (value >= kVarintContinue) {
+    output->push_back(
+        static_cast<char>((value & kVarintMask) | kVarintContinue));
+    value >>= kVarintPayloadBits;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void PutSignedVarint(std::string* output, int64_t value) {
+  PutVarint(output, (static_cast<uint64_t>(value) << 1U) ^
+                        static_cast<uint64_t>(value >> kMaxVarintShift));
+}
+
+void PutFixed32(std::string* output, uint32_t value) {
+  for (unsigned i = 0; i < sizeof(value); ++i) {
+    output->push_back(static_cast<char>(value >> (i * kBitsPerByte)));
+  }
+}
+
+void PutFixed64(std::string* output, uint64_t value) {
+  for (unsigned i = 0; i < sizeof(value); ++i) {
+    output->push_back(static_cast<char>(value >> (i * kBitsPerByte)));
+  }
+}
+
+void PutDouble(std::string* output, double value) {
+  PutFixed64(output, std::bit_cast<uint64_t>(value));
+}
+
+void PutString(std::string* output, std::string_view value) {
+  PutVarint(output, value.size());
+  output->append(value);
+}
+
+void Reader::Require(size_t size) const {
+  if (size > remaining())
+    throw exceptions::UserInputException("unexpected end of encoded data");
+}
+
+uint64_t Reader::Varint() {
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift <= kMaxVarintShift;
+       shift += kVarintPayloadBits) {
+    Require(1);
+    const auto kByte = static_cast<uint8_t>(data_[position_++]);
+    value |= static_cast<uint64_t>(kByte & kVarintMask) << shift;
+    if ((kByte & kVarintContinue) == 0)
+      return value;
+  }
+  throw exceptions::UserInputException("malformed varint");
+}
+
+int64_t Reader::SignedVarint() {
+  const uint64_t kRaw = Varint();
+  return static_cast<int64_t>(kRaw >> 1U) ^ -static_cast<int64_t>(kRaw & 1U);
+}
+
+uint32_t Reader::Fixed32() {
+  Require(sizeof(uint32_t));
+  uint32_t value = 0;
+  for (unsigned i = 0; i < sizeof(value); ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[position_++]))
+             << (i * kBitsPerByte);
+  }
+  return value;
+}
+
+uint64_t Reader::Fixed64() {
+  Require(sizeof(uint64_t));
+  uint64_t value = 0;
+  for (unsigned i = 0; i < sizeof(value); ++i) {
+    value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[position_++]))
+             << (i * kBitsPerByte);
+  }
+  return value;
+}
+
+double Reader::Double() {
+  return std::bit_cast<double>(Fixed64());
+}
+
+std::string_view Reader::String() {
+  return Bytes(Varint());
+}
+
+std::string_view Reader::Bytes(size_t size) {
+  Require(size);
+  auto bytes = data_.substr(position_, size);
+  position_ += size;
+  return bytes;
+}
+
+void SkipWireValue(Reader* reader, uint32_t number, uint32_t type) {
+  switch (type) {
+    case kVarint:
+      reader->Varint();
+      return;
+    case kFixed64:
+      reader->Fixed64();
+      return;
+    case kLengthDelimited:
+      reader->String();
+      return;
+    case kFixed32:
+      reader->Fixed32();
+      return;
+    case kStartGroup:
+      while (true) {
+        const uint64_t kTag = reader->Varint();
+        const auto kNumber = static_cast<uint32_t>(kTag >> kTagTypeBits);
+        const auto kType = static_cast<uint32_t>(kTag & kTagTypeMask);
+        if (kType == kEndGroup) {
+          if (kNumber != number)
+            break;
+          return;
+        }
+        SkipWireValue(reader, kNumber, kType);
+      }
+      break;
+    default:
+      break;
+  }
+  throw exceptions::UserInputException("malformed message wire format");
+}
+
+bool HasWireField(std::string_view message, uint32_t number) {
+  Reader reader(message);
+  while (!reader.empty()) {
+    const uint64_t kTag = reader.Varint();
+    const auto kNumber = static_cast<uint32_t>(kTag >> kTagTypeBits);
+    if (kNumber == number)
+      return true;
+    SkipWireValue(&reader, kNumber,
+                  static_cast<uint32_t>(kTag & kTagTypeMask));
+  }
+  return false;
+}
+
+uint64_t WireVarint(std::string_view message, uint32_t number) {
+  Reader reader(message);
+  uint64_t value = 0;
+  while (!reader.empty()) {
+    const uint64_t kTag = reader.Varint();
+    const auto kNumber = static_cast<uint32_t>(kTag >> kTagTypeBits);
+    const auto kType = static_cast<uint32_t>(kTag & kTagTypeMask);
+    if (kNumber == number && kType == kVarint) {
+      value = reader.Varint();
+    } else {
+      SkipWireValue(&reader, kNumber, kType);
+    }
+  }
+  return value;
+}
+
+}  // namespace wikiopencite::citescoop::cli::binary
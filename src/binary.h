@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_BINARY_H_
+#define SRC_BINARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace wikiopencite::citescoop::cli::binary {
+
+/// @brief Append an unsigned LEB128 varint.
+void PutVarint(std::string* output, uint64_t value);
+
+/// @brief Append a signed value as a zigzag encoded varint.
+void PutSignedVarint(std::string* output, int64_t value);
+
+/// @brief Append a little endian 32 bit integer.
+void PutFixed32(std::string* output, uint32_t value);
+
+/// @brief Append a little endian 64 bit integer.
+void PutFixed64(std::string* output, uint64_t value);
+
+/// @brief Append a double as its little endian IEEE 754 bytes.
+void PutDouble(std::string* output, double value);
+
+/// @brief Append a varint length followed by the bytes.
+void PutString(std::string* output, std::string_view value);
+
+/// @brief Bounds checked reader over an encoded buffer. Reading past
+/// the end throws exceptions::UserInputException, as it means the file
+/// being decoded is truncated or corrupt.
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  uint64_t Varint();
+  int64_t SignedVarint();
+  uint32_t Fixed32();
+  uint64_t Fixed64();
+  double Double();
+  std::string_view String();
+  std::string_view Bytes(size_t size);
+
+  [[nodiscard]] bool empty() const { return position_ >= data_.size(); }
+  [[nodiscard]] size_t position() const { return position_; }
+  [[nodiscard]] size_t remaining() const { return data_.size() - position_; }
+
+ private:
+  void Require(size_t size) const;
+
+  std::string_view data_;
+  size_t position_ = 0;
+};
+
+/// Wire types of protobuf fields, the low bits of their tags.
+enum WireType : uint32_t {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kStartGroup = 3,
+  kEndGroup = 4,
+  kFixed32 = 5,
+};
+
+inline constexpr uint32_t kTagTypeBits = 3;
+inline constexpr uint32_t kTagTypeMask = 7;
+
+/// @brief Skip the value of a protobuf field following its tag. Groups
+/// are skipped up to their matching end tag.
+/// @throws exceptions::UserInputException if the value is malformed.
+void SkipWireValue(Reader* reader, uint32_t number, uint32_t type);
+
+/// @brief Whether a serialized message has a top level field, found by
+/// walking its wire format rather than decoding it.
+/// @throws exceptions::UserInputException if the message is malformed.
+bool HasWireField(std::string_view message, uint32_t number);
+
+/// @brief Value of a top level varint field of a serialized message,
+/// found by walking its wire format, or 0 if it is absent as protobuf
+/// omits fields holding 0. The last occurrence wins, as when parsing.
+/// @throws exceptions::UserInputException if the message is malformed.
+uint64_t WireVarint(std::string_view message, uint32_t number);
+
+}  // namespace wikiopencite::citescoop::cli::binary
+
+#endif  // SRC_BINARY_H_
@@ -0,0 +1,278 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "bloom_filter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fmt/format.h"
+#include "google/protobuf/message.h"
+
+#include "binary.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "hyperloglog.h"
+#include "io.h"
+#include "scan.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace fs = std::filesystem;
+
+constexpr size_t kHeaderSize =
+    BloomFilter::kMagic.size() + 4 * sizeof(uint64_t);
+constexpr size_t kBlockBytes = BloomFilter::kBlockWords * sizeof(uint64_t);
+constexpr uint64_t kBlockBits = BloomFilter::kBlockWords * 64;
+
+/// Extra bits per key making up for confining each key to one block.
+constexpr double kBlockedOverhead = 1.1;
+
+constexpr uint64_t kMaxHashes = 16;
+
+/// Standard errors of the distinct key estimate the filter is sized
+/// above it by.
+constexpr double kSizingErrors = 3;
+
+struct FilterHeader {
+  uint64_t file_size;
+  uint64_t entries;
+  uint64_t blocks;
+  uint64_t hashes;
+};
+
+FilterHeader ReadHeader(std::ifstream* stream, const std::string& path) {
+  std::string buffer(kHeaderSize, '\0');
+  stream->read(buffer.data(), static_cast<std::streamsize>(kHeaderSize));
+  binary::Reader reader(buffer);
+  if (!*stream || reader.Bytes(BloomFilter::kMagic.size()) !=
+                      BloomFilter::kMagic) {
+    throw exceptions::UserInputException(
+        fmt::format("{} is not a Bloom filter", path).c_str());
+  }
+
+  FilterHeader header{};
+  header.file_size = reader.Fixed64();
+  header.entries = reader.Fixed64();
+  header.blocks = reader.Fixed64();
+  header.hashes = reader.Fixed64();
+  if (header.blocks == 0 || header.hashes == 0 ||
+      header.hashes > kMaxHashes) {
+    throw exceptions::UserInputException(
+        fmt::format("{} is corrupt", path).c_str());
+  }
+  return header;
+}
+
+/// @brief Call visit(worker, hash) for every value a field path reaches
+/// in each message of a file.
+void ScanKeys(
+    const std::string& pbf_path, const std::string& key, unsigned threads,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::function<void(unsigned, const hash::Hash128&)>& visit) {
+  auto file = io::OpenPbfFile(pbf_path);
+  auto header = io::ReadPbfHeader(file.get());
+  const auto kPath = fields::FieldPath::Parse(
+      io::DescriptorForFileType(header->type()), key);
+
+  scan::ParallelScan(
+      file.get(), *header, threads,
+      [&kPath, &visit](unsigned worker, uint64_t,
+                       const google::protobuf::Message& message) {
+        kPath.Visit(message, [&](const fields::Value& value) {
+          if (std::holds_alternative<std::monostate>(value))
+            return;
+          visit(worker, hash::Bytes128(fields::ToString(value)));
+        });
+      });
+  io::ClosePbfFile(std::move(file));
+}
+}  // namespace
+
+BloomFilter::BloomFilter(uint64_t entries, double false_positive_rate) {
+  if (!(false_positive_rate > 0 && false_positive_rate < 1)) {
+    throw exceptions::UserInputException(
+        "false positive rate must be between 0 and 1");
+  }
+
+  const double kLn2 = std::log(2.0);
+  const double kBitsPerKey =
+      -std::log(false_positive_rate) / (kLn2 * kLn2) * kBlockedOverhead;
+  const auto kBits = static_cast<uint64_t>(
+      std::ceil(static_cast<double>(std::max<uint64_t>(entries, 1)) *
+                kBitsPerKey));
+
+  hashes_ = std::clamp<uint64_t>(
+      static_cast<uint64_t>(std::lround(kBitsPerKey * kLn2)), 1, kMaxHashes);
+  blocks_.assign((kBits + kBlockBits - 1) / kBlockBits, Block{});
+}
+
+std::string BloomFilter::PathFor(const std::string& pbf_path,
+                                 // NOLINTNEXTLINE(whitespace/indent_namespace)
+                                 const std::string& key) {
+  return fmt::format("{}.{}.bloom", pbf_path, key);
+}
+
+uint64_t BloomFilter::Build(const std::string& pbf_path,
+                            const std::string& key,
+                            double false_positive_rate,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            unsigned threads) {
+  std::vector<HyperLogLog> sketches(std::max(threads, 1U));
+  ScanKeys(pbf_path, key, threads,
+           [&sketches](unsigned worker, const hash::Hash128& hash) {
+             sketches[worker].Add(hash.low);
+           });
+  for (size_t i = 1; i < sketches.size(); ++i) {
+    sketches[0].Merge(sketches[i]);
+  }
+
+  // Sized for a few standard errors over the estimate, so an estimate
+  // on the low side does not raise the false positive rate.
+  const double kEstimate = sketches[0].Estimate();
+  BloomFilter filter(
+      static_cast<uint64_t>(std::ceil(
+          kEstimate * (1 + kSizingErrors * sketches[0].StandardError()))),
+      false_positive_rate);
+  ScanKeys(pbf_path, key, threads,
+           [&filter](unsigned, const hash::Hash128& hash) {
+             filter.InsertHashConcurrently(hash);
+           });
+  filter.entries_ = static_cast<uint64_t>(std::llround(kEstimate));
+
+  filter.Save(PathFor(pbf_path, key), fs::file_size(pbf_path));
+  return filter.entries_;
+}
+
+std::optional<std::vector<bool>> BloomFilter::Probe(
+    const std::string& pbf_path, const std::string& key,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::vector<std::string>& values) {
+  const auto kFilterPath = PathFor(pbf_path, key);
+  std::ifstream stream(kFilterPath, std::ios::in | std::ios::binary);
+  if (!stream)
+    return std::nullopt;
+
+  const auto kHeader = ReadHeader(&stream, kFilterPath);
+  std::error_code err;
+  if (kHeader.file_size != fs::file_size(pbf_path, err) || err)
+    return std::nullopt;
+
+  std::vector<bool> found;
+  found.reserve(values.size());
+  std::string buffer(kBlockBytes, '\0');
+  for (const auto& value : values) {
+    const auto kHash = hash::Bytes128(value);
+    stream.seekg(static_cast<std::streamoff>(
+        kHeaderSize + BlockFor(kHash, kHeader.blocks) * kBlockBytes));
+    stream.read(buffer.data(), static_cast<std::streamsize>(kBlockBytes));
+    if (!stream) {
+      throw exceptions::UserInputException(
+          fmt::format("{} is truncated", kFilterPath).c_str());
+    }
+
+    binary::Reader reader(buffer);
+    const Block kMask = MaskFor(kHash, kHeader.hashes);
+    bool present = true;
+    for (size_t i = 0; i < kBlockWords; ++i) {
+      present = present && (reader.Fixed64() & kMask[i]) == kMask[i];
+    }
+    found.push_back(present);
+  }
+
+  return found;
+}
+
+void BloomFilter::Insert(std::string_view key) {
+  InsertHash(hash::Bytes128(key));
+}
+
+void BloomFilter::InsertHash(const hash::Hash128& hash) {
+  const Block kMask = MaskFor(hash, hashes_);
+  Block& block = blocks_[BlockFor(hash, blocks())];
+  for (size_t i = 0; i < kBlockWords; ++i) {
+    block[i] |= kMask[i];
+  }
+  entries_++;
+}
+
+void BloomFilter::InsertHashConcurrently(const hash::Hash128& hash) {
+  const Block kMask = MaskFor(hash, hashes_);
+  Block& block = blocks_[BlockFor(hash, blocks())];
+  for (size_t i = 0; i < kBlockWords; ++i) {
+    if (kMask[i] != 0) {
+      std::atomic_ref<uint64_t>(block[i]).fetch_or(kMask[i],
+                                                   std::memory_order_relaxed);
+    }
+  }
+}
+
+bool BloomFilter::MayContain(std::string_view key) const {
+  const auto kHash = hash::Bytes128(key);
+  const Block kMask = MaskFor(kHash, hashes_);
+  const Block& block = blocks_[BlockFor(kHash, blocks())];
+  for (size_t i = 0; i < kBlockWords; ++i) {
+    if ((block[i] & kMask[i]) != kMask[i])
+      return false;
+  }
+  return true;
+}
+
+void BloomFilter::Save(const std::string& path, uint64_t file_size) const {
+  std::string buffer(kMagic);
+  binary::PutFixed64(&buffer, file_size);
+  binary::PutFixed64(&buffer, entries_);
+  binary::PutFixed64(&buffer, blocks());
+  binary::PutFixed64(&buffer, hashes_);
+  buffer.reserve(kHeaderSize + blocks() * kBlockBytes);
+  for (const auto& block : blocks_) {
+    for (const uint64_t kWord : block) {
+      binary::PutFixed64(&buffer, kWord);
+    }
+  }
+
+  std::ofstream stream(path,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  stream.close();
+  if (!stream) {
+    throw exceptions::CliException(
+        fmt::format("failed to write {}", path));
+  }
+}
+
+uint64_t BloomFilter::BlockFor(const hash::Hash128& hash, uint64_t blocks) {
+  return hash.low % blocks;
+}
+
+BloomFilter::Block BloomFilter::MaskFor(const hash::Hash128& hash,
+                                        // NOLINTNEXTLINE
+                                        uint64_t hashes) {
+  // Double hashing within the block. An odd step visits every bit of
+  // the block before repeating, so the bits are distinct.
+  const uint64_t kStart = hash.high % kBlockBits;
+  const uint64_t kStep = ((hash.high >> 32U) % kBlockBits) | 1U;
+
+  Block mask{};
+  for (uint64_t i = 0; i < hashes; ++i) {
+    const uint64_t kBit = (kStart + i * kStep) % kBlockBits;
+    mask[kBit / 64] |= uint64_t{1} << (kBit % 64);
+  }
+  return mask;
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_BLOOM_FILTER_H_
+#define SRC_BLOOM_FILTER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.h"
+
+/// Blocked Bloom filter over the values of a field of a PBF file,
+/// stored next to it as <file>.<field>.bloom:
+///
+///     magic | file size | entries | blocks | hashes | block ...
+///
+/// Header fields are fixed64. A block is kBlockWords fixed64 words, one
+/// cache line, and each key sets all of its bits within a single block,
+/// so probing for a key reads 64 bytes whether the filter is in memory
+/// or on disk. This costs a little accuracy over a classic Bloom filter,
+/// which the sizing makes up for with a few more bits per key.
+namespace wikiopencite::citescoop::cli {
+
+class BloomFilter {
+ public:
+  /// Magic bytes at the start of a filter file.
+  static constexpr std::string_view kMagic = "CSBLOOM1";
+
+  /// 64 bit words per block.
+  static constexpr size_t kBlockWords = 8;
+
+  /// @brief Create an empty filter sized for a number of distinct keys.
+  BloomFilter(uint64_t entries, double false_positive_rate);
+
+  /// @brief Path of the filter of a PBF file over a field path.
+  static std::string PathFor(const std::string& pbf_path,
+                             const std::string& key);
+
+  /// @brief Build the filter of a PBF file over every value a field
+  /// path reaches in each message, and write it next to the file.
+  ///
+  /// The file is read twice: once into a HyperLogLog sketch to size
+  /// the filter from the estimated number of distinct keys, then by
+  /// the workers setting the bits of every value in the one filter. No
+  /// memory is held per key.
+  ///
+  /// @return Estimated number of distinct keys in the filter.
+  static uint64_t Build(const std::string& pbf_path, const std::string& key,
+                        double false_positive_rate, unsigned threads);
+
+  /// @brief Check keys against the filter of a PBF file, reading one
+  /// block from disk per key.
+  /// @return For each key, whether the file may hold it, or
+  /// std::nullopt if there is no filter or it no longer matches the
+  /// file.
+  /// @throws exceptions::UserInputException if the filter is corrupt.
+  static std::optional<std::vector<bool>> Probe(
+      const std::string& pbf_path, const std::string& key,
+      const std::vector<std::string>& values);
+
+  void Insert(std::string_view key);
+
+  [[nodiscard]] bool MayContain(std::string_view key) const;
+
+  /// @brief Write the filter, recording the size of the file it covers.
+  void Save(const std::string& path, uint64_t file_size) const;
+
+  [[nodiscard]] uint64_t entries() const { return entries_; }
+  [[nodiscard]] uint64_t blocks() const { return blocks_.size(); }
+  [[nodiscard]] uint64_t hashes() const { return hashes_; }
+
+ private:
+  using Block = std::array<uint64_t, kBlockWords>;
+
+  void InsertHash(const hash::Hash128& hash);
+
+  /// @brief Set the bits of a key atomically, for workers filling one
+  /// filter. Does not count the key in entries.
+  void InsertHashConcurrently(const hash::Hash128& hash);
+
+  /// @brief Block of a key among a number of blocks.
+  static uint64_t BlockFor(const hash::Hash128& hash, uint64_t blocks);
+
+  /// @brief Bits a key sets within its block.
+  static Block MaskFor(const hash::Hash128& hash, uint64_t hashes);
+
+  uint64_t entries_ = 0;
+  uint64_t hashes_ = 0;
+  std::vector<Block> blocks_;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_BLOOM_FILTER_H_
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_BOUNDED_QUEUE_H_
+#define SRC_BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Blocking multi-producer multi-consumer queue with a fixed
+/// capacity, used to apply back pressure between a reader and workers.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  /// @brief Add an item, blocking while the queue is full.
+  /// @return False if the queue was closed and the item was dropped.
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock,
+                   [this]() { return closed_ || items_.size() < capacity_; });
+    if (closed_)
+      return false;
+
+    items_.push_back(std::move(item));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /// @brief Remove an item, blocking while the queue is empty.
+  /// @return The item, or std::nullopt once the queue is closed and
+  /// drained.
+  std::optional<T> Pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+    if (items_.empty())
+      return std::nullopt;
+
+    T item = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return item;
+  }
+
+  /// @brief Stop accepting items. Consumers drain what is left.
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  size_t capacity_;
+  std::deque<T> items_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  bool closed_ = false;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_BOUNDED_QUEUE_H_
@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "checksum.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "crc32c/crc32c.h"
+
+#include "binary.h"
+#include "exceptions.h"
+
+namespace wikiopencite::citescoop::cli::checksum {
+
+namespace {
+constexpr size_t kFooterSize = 2 * sizeof(uint64_t) + kTrailerMagic.size();
+}  // namespace
+
+uint32_t Extend(uint32_t crc, std::string_view data) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return crc32c::Extend(crc, reinterpret_cast<const uint8_t*>(data.data()),
+                        data.size());
+}
+
+std::optional<Trailer> ReadTrailer(std::istream* input, uint64_t file_size) {
+  if (file_size < kFooterSize)
+    return std::nullopt;
+
+  std::string buffer(kFooterSize, '\0');
+  input->clear();
+  input->seekg(static_cast<std::streamoff>(file_size - kFooterSize));
+  input->read(buffer.data(), static_cast<std::streamsize>(kFooterSize));
+  if (!*input)
+    return std::nullopt;
+
+  binary::Reader footer(buffer);
+  Trailer trailer;
+  trailer.block_size = footer.Fixed64();
+  const uint64_t kBlocks = footer.Fixed64();
+  if (footer.Bytes(kTrailerMagic.size()) != kTrailerMagic)
+    return std::nullopt;
+
+  if (trailer.block_size == 0 ||
+      kBlocks > (file_size - kFooterSize) / sizeof(uint32_t))
+    throw exceptions::UserInputException("checksum trailer is corrupt");
+  trailer.content_size = file_size - kFooterSize - kBlocks * sizeof(uint32_t);
+  if (kBlocks != (trailer.content_size + trailer.block_size - 1) /
+                     trailer.block_size)
+    throw exceptions::UserInputException("checksum trailer is corrupt");
+
+  buffer.resize(kBlocks * sizeof(uint32_t));
+  input->seekg(static_cast<std::streamoff>(trailer.content_size));
+  input->read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  if (!*input)
+    throw exceptions::UserInputException("checksum trailer is truncated");
+
+  binary::Reader reader(buffer);
+  trailer.checksums.reserve(kBlocks);
+  for (uint64_t i = 0; i < kBlocks; ++i) {
+    trailer.checksums.push_back(reader.Fixed32());
+  }
+  return trailer;
+}
+
+ChecksummingBuffer::ChecksummingBuffer(std::streambuf* target,
+                                       // NOLINTNEXTLINE
+                                       size_t block_size)
+    : target_(target), block_size_(block_size) {}
+
+ChecksummingBuffer::int_type ChecksummingBuffer::overflow(int_type ch) {
+  if (traits_type::eq_int_type(ch, traits_type::eof()))
+    return traits_type::not_eof(ch);
+
+  const char kChar = traits_type::to_char_type(ch);
+  return xsputn(&kChar, 1) == 1 ? ch : traits_type::eof();
+}
+
+std::streamsize ChecksummingBuffer::xsputn(const char* data,
+                                           // NOLINTNEXTLINE
+                                           std::streamsize size) {
+  const std::streamsize kWritten = target_->sputn(data, size);
+  if (kWritten != size)
+    failed_ = true;
+  Checksum(data, static_cast<size_t>(kWritten));
+  return kWritten;
+}
+
+int ChecksummingBuffer::sync() { return target_->pubsync(); }
+
+void ChecksummingBuffer::Checksum(const char* data, size_t size) {
+  while (size > 0) {
+    const size_t kTake = std::min(size, block_size_ - block_used_);
+    crc_ = Extend(crc_, std::string_view(data, kTake));
+    block_used_ += kTake;
+    data += kTake;
+    size -= kTake;
+
+    if (block_used_ == block_size_) {
+      checksums_.push_back(crc_);
+      crc_ = 0;
+      block_used_ = 0;
+    }
+  }
+}
+
+bool ChecksummingBuffer::Finish() {
+  if (block_used_ > 0) {
+    checksums_.push_back(crc_);
+    crc_ = 0;
+    block_used_ = 0;
+  }
+
+  std::string trailer;
+  for (const uint32_t kChecksum : checksums_) {
+    binary::PutFixed32(&trailer, kChecksum);
+  }
+  binary::PutFixed64(&trailer, block_size_);
+  binary::PutFixed64(&trailer, checksums_.size());
+  trailer.append(kTrailerMagic);
+
+  const auto kSize = static_cast<std::streamsize>(trailer.size());
+  if (target_->sputn(trailer.data(), kSize) != kSize)
+    failed_ = true;
+  if (target_->pubsync() != 0)
+    failed_ = true;
+  return !failed_;
+}
+
+}  // namespace wikiopencite::citescoop::cli::checksum
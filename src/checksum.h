@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_CHECKSUM_H_
+#define SRC_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+/// CRC32C checksums over fixed size blocks of a PBF file, stored in a
+/// trailer after everything else in the file:
+///
+///     checksum ... | block size | block count | magic
+///
+/// Each checksum is a fixed32 covering one block of the file, starting
+/// from its first byte, with the last block possibly short. The block
+/// size and count are fixed64. Readers stop after the number of
+/// messages given by the header, so they never see the trailer.
+namespace wikiopencite::citescoop::cli::checksum {
+
+/// Bytes covered by each checksum.
+inline constexpr size_t kDefaultBlockSize = size_t{4} << 20U;
+
+/// Magic bytes ending the trailer.
+inline constexpr std::string_view kTrailerMagic = "CSCRCTR1";
+
+/// @brief Checksums read back from a trailer.
+struct Trailer {
+  uint64_t block_size;
+  uint64_t content_size;  ///< Bytes before the trailer.
+  std::vector<uint32_t> checksums;
+};
+
+/// @brief CRC32C of a byte string, continuing from crc.
+uint32_t Extend(uint32_t crc, std::string_view data);
+
+/// @brief Read the trailer at the end of a stream.
+/// @param input Seekable stream over the whole file. Its position is
+/// left unspecified.
+/// @param file_size Size of the file in bytes.
+/// @return The trailer, or std::nullopt if the file has none.
+/// @throws exceptions::UserInputException if the trailer is corrupt.
+std::optional<Trailer> ReadTrailer(std::istream* input, uint64_t file_size);
+
+/// @brief Stream buffer passing everything through to another buffer
+/// while checksumming it block by block. The first byte written must be
+/// the first byte of the file.
+class ChecksummingBuffer : public std::streambuf {
+ public:
+  /// @param target Buffer receiving the bytes. Must outlive this one.
+  /// @param block_size Bytes covered by each checksum.
+  explicit ChecksummingBuffer(std::streambuf* target,
+                              size_t block_size = kDefaultBlockSize);
+
+  /// @brief Write the trailer. Nothing may be written afterwards.
+  /// @return Whether every byte reached the target buffer.
+  bool Finish();
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char* data, std::streamsize size) override;
+  int sync() override;
+
+ private:
+  void Checksum(const char* data, size_t size);
+
+  std::streambuf* target_;
+  size_t block_size_;
+  size_t block_used_ = 0;
+  uint32_t crc_ = 0;
+  std::vector<uint32_t> checksums_;
+  bool failed_ = false;
+};
+
+}  // namespace wikiopencite::citescoop::cli::checksum
+
+#endif  // SRC_CHECKSUM_H_
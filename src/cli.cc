@@ -10,6 +10,7 @@
 #include <utility>
 #include <vector>
 
+#include "boost/program_options/cmdline.hpp"
 #include "boost/program_options/detail/parsers.hpp"
 #include "boost/program_options/options_description.hpp"
 #include "boost/program_options/parsers.hpp"
@@ -226,12 +227,17 @@ std::pair<options::variables_map, options::parsed_options> Cli::ParseGlobalArgs(
     // NOLINTNEXTLINE (modernize-avoid-c-arrays, whitespace/indent_namespace)
     char* argv[]) {
 
+  // Prefix guessing is disabled so that command options which share a
+  // prefix with a global option (e.g. --top and --topic) are passed
+  // through to the command rather than captured here.
   // Changes each run
   // NOLINTNEXTLINE(readability-identifier-naming)
   const options::parsed_options parsed =
       options::command_line_parser(argc, argv)
           .options(global_options_)
           .positional(positional_options_)
+          .style(options::command_line_style::default_style &
+                 ~options::command_line_style::allow_guessing)
           .allow_unregistered()
           .run();
 
@@ -0,0 +1,444 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "columnar.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::columnar {
+
+namespace {
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+constexpr uint64_t kFormatVersion = 3;
+
+/// Nested messages deeper than this are not flattened, which also
+/// stops recursive message types from expanding forever.
+constexpr size_t kMaxDepth = 6;
+
+/// Size of the fixed trailer: footer size followed by the magic.
+constexpr size_t kTrailerSize = sizeof(uint64_t) + kMagic.size();
+
+ValueKind KindFor(const pb::FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      return ValueKind::kUint;
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+      return ValueKind::kDouble;
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      return ValueKind::kBool;
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      return ValueKind::kString;
+    default:
+      // Signed integers, enums and timestamps.
+      return ValueKind::kInt;
+  }
+}
+
+void Flatten(const pb::Descriptor* descriptor, const std::string& prefix,
+             bool has_lengths, size_t depth, std::vector<Column>* columns) {
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const auto* field = descriptor->field(i);
+    const std::string kPath = prefix + field->name();
+    const bool kLengths = has_lengths || field->is_repeated() || depth > 0;
+
+    if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE &&
+        field->message_type()->full_name() != "google.protobuf.Timestamp") {
+      if (depth + 1 < kMaxDepth) {
+        Flatten(field->message_type(), kPath + ".", kLengths, depth + 1,
+                columns);
+      }
+      continue;
+    }
+
+    columns->push_back(
+        Column{.path = kPath, .kind = KindFor(field), .has_lengths = kLengths});
+  }
+}
+
+void PutValue(std::string* output, ValueKind kind,
+              const fields::Value& value) {
+  if (std::holds_alternative<std::monostate>(value)) {
+    output->push_back(0);
+    return;
+  }
+  output->push_back(1);
+
+  switch (kind) {
+    case ValueKind::kInt:
+      binary::PutSignedVarint(output, std::get<int64_t>(value));
+      break;
+    case ValueKind::kUint:
+      binary::PutVarint(output, std::get<uint64_t>(value));
+      break;
+    case ValueKind::kDouble:
+      binary::PutDouble(output, std::get<double>(value));
+      break;
+    case ValueKind::kBool:
+      output->push_back(std::get<bool>(value) ? 1 : 0);
+      break;
+    case ValueKind::kString:
+      binary::PutString(output, std::get<std::string>(value));
+      break;
+  }
+}
+
+fields::Value ReadScalar(binary::Reader* reader, ValueKind kind) {
+  switch (kind) {
+    case ValueKind::kInt:
+      return reader->SignedVarint();
+    case ValueKind::kUint:
+      return reader->Varint();
+    case ValueKind::kDouble:
+      return reader->Double();
+    case ValueKind::kBool:
+      return reader->Bytes(1)[0] != 0;
+    case ValueKind::kString:
+      return std::string(reader->String());
+  }
+  throw exceptions::UserInputException("unknown column value kind");
+}
+
+fields::Value ReadValue(binary::Reader* reader, ValueKind kind) {
+  if (reader->Bytes(1)[0] == 0)
+    return std::monostate();
+  return ReadScalar(reader, kind);
+}
+
+std::string EncodeFooter(const Footer& footer) {
+  std::string output;
+  binary::PutVarint(&output, kFormatVersion);
+  binary::PutVarint(&output, static_cast<uint64_t>(footer.file_type));
+  binary::PutString(&output, footer.message_type);
+  binary::PutVarint(&output, footer.rows);
+
+  binary::PutVarint(&output, footer.columns.size());
+  for (const auto& column : footer.columns) {
+    binary::PutString(&output, column.path);
+    binary::PutVarint(&output, static_cast<uint64_t>(column.kind));
+    binary::PutVarint(&output, column.has_lengths ? 1 : 0);
+  }
+
+  binary::PutVarint(&output, footer.row_groups.size());
+  for (const auto& group : footer.row_groups) {
+    binary::PutVarint(&output, group.rows);
+    for (size_t i = 0; i < group.chunks.size(); ++i) {
+      const auto& chunk = group.chunks[i];
+      binary::PutVarint(&output, chunk.offset);
+      binary::PutVarint(&output, chunk.size);
+      binary::PutVarint(&output, chunk.values);
+      binary::PutVarint(&output, static_cast<uint64_t>(chunk.encoding));
+      PutValue(&output, footer.columns[i].kind, chunk.min);
+      PutValue(&output, footer.columns[i].kind, chunk.max);
+    }
+  }
+  return output;
+}
+
+Footer DecodeFooter(std::string_view data) {
+  binary::Reader reader(data);
+  if (reader.Varint() != kFormatVersion)
+    throw exceptions::UserInputException("unsupported columnar version");
+
+  Footer footer;
+  footer.file_type = static_cast<proto::FileType>(reader.Varint());
+  footer.message_type = std::string(reader.String());
+  footer.rows = reader.Varint();
+
+  const uint64_t kColumns = reader.Varint();
+  for (uint64_t i = 0; i < kColumns; ++i) {
+    Column column;
+    column.path = std::string(reader.String());
+    column.kind = static_cast<ValueKind>(reader.Varint());
+    column.has_lengths = reader.Varint() != 0;
+    footer.columns.push_back(std::move(column));
+  }
+
+  const uint64_t kGroups = reader.Varint();
+  for (uint64_t i = 0; i < kGroups; ++i) {
+    RowGroupInfo group;
+    group.rows = reader.Varint();
+    for (const auto& column : footer.columns) {
+      ChunkInfo chunk;
+      chunk.offset = reader.Varint();
+      chunk.size = reader.Varint();
+      chunk.values = reader.Varint();
+      chunk.encoding = static_cast<Encoding>(reader.Varint());
+      chunk.min = ReadValue(&reader, column.kind);
+      chunk.max = ReadValue(&reader, column.kind);
+      group.chunks.push_back(std::move(chunk));
+    }
+    footer.row_groups.push_back(std::move(group));
+  }
+  return footer;
+}
+}  // namespace
+
+std::vector<Column> FlattenColumns(const pb::Descriptor* descriptor) {
+  std::vector<Column> columns;
+  Flatten(descriptor, "", false, 0, &columns);
+  return columns;
+}
+
+bool IsColumnarFile(const std::string& path) {
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  std::string magic(kMagic.size(), '\0');
+  stream.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  return stream && magic == kMagic;
+}
+
+Writer::Writer(std::ostream* output, proto::FileType file_type,
+               // NOLINTNEXTLINE(whitespace/indent_namespace)
+               size_t row_group_size)
+    : output_(output), row_group_size_(row_group_size) {
+  const auto* descriptor = io::DescriptorForFileType(file_type);
+  footer_.file_type = file_type;
+  footer_.message_type = descriptor->full_name();
+  footer_.columns = FlattenColumns(descriptor);
+
+  for (const auto& column : footer_.columns) {
+    paths_.push_back(fields::FieldPath::Parse(descriptor, column.path));
+  }
+  builders_.resize(footer_.columns.size());
+
+  output_->write(kMagic.data(), static_cast<std::streamsize>(kMagic.size()));
+  position_ = kMagic.size();
+}
+
+void Writer::Add(const pb::Message& message) {
+  for (size_t i = 0; i < paths_.size(); ++i) {
+    auto& builder = builders_[i];
+    const size_t kBefore = builder.values.size();
+    paths_[i].Visit(message, [&builder](const fields::Value& value) {
+      builder.values.push_back(value);
+    });
+
+    if (footer_.columns[i].has_lengths)
+      builder.lengths.push_back(builder.values.size() - kBefore);
+  }
+
+  footer_.rows++;
+  if (++buffered_rows_ >= row_group_size_)
+    FlushRowGroup();
+}
+
+void Writer::Finish() {
+  if (buffered_rows_ > 0)
+    FlushRowGroup();
+
+  const std::string kFooter = EncodeFooter(footer_);
+  std::string trailer;
+  binary::PutFixed64(&trailer, kFooter.size());
+  trailer.append(kMagic);
+
+  output_->write(kFooter.data(), static_cast<std::streamsize>(kFooter.size()));
+  output_->write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+  output_->flush();
+}
+
+void Writer::FlushRowGroup() {
+  RowGroupInfo group;
+  group.rows = buffered_rows_;
+
+  std::string chunk;
+  for (size_t i = 0; i < builders_.size(); ++i) {
+    chunk.clear();
+    auto info = EncodeChunk(i, builders_[i], &chunk);
+    info.offset = position_;
+    info.size = chunk.size();
+
+    output_->write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    position_ += chunk.size();
+    group.chunks.push_back(std::move(info));
+
+    builders_[i].values.clear();
+    builders_[i].lengths.clear();
+  }
+
+  spdlog::trace("Wrote row group of {} rows", buffered_rows_);
+  footer_.row_groups.push_back(std::move(group));
+  buffered_rows_ = 0;
+}
+
+ChunkInfo Writer::EncodeChunk(size_t column, const Builder& builder,
+                              // NOLINTNEXTLINE(whitespace/indent_namespace)
+                              std::string* output) const {
+  const auto kKind = footer_.columns[column].kind;
+  ChunkInfo info{.offset = 0,
+                 .size = 0,
+                 .values = builder.values.size(),
+                 .encoding = Encoding::kPlain,
+                 .min = std::monostate(),
+                 .max = std::monostate()};
+
+  for (const auto& value : builder.values) {
+    if (std::holds_alternative<std::monostate>(info.min) ||
+        fields::Compare(value, info.min) < 0) {
+      info.min = value;
+    }
+    if (std::holds_alternative<std::monostate>(info.max) ||
+        fields::Compare(value, info.max) > 0) {
+      info.max = value;
+    }
+  }
+
+  for (const auto kLength : builder.lengths) {
+    binary::PutVarint(output, kLength);
+  }
+
+  if (kKind == ValueKind::kString) {
+    std::unordered_map<std::string_view, uint64_t> ids;
+    std::vector<std::string_view> dictionary;
+    for (const auto& value : builder.values) {
+      const auto& text = std::get<std::string>(value);
+      if (ids.try_emplace(text, dictionary.size()).second)
+        dictionary.push_back(text);
+    }
+
+    // Only worth it if every entry is referenced twice on average.
+    if (dictionary.size() * 2 <= builder.values.size()) {
+      info.encoding = Encoding::kDictionary;
+      binary::PutVarint(output, dictionary.size());
+      for (const auto& entry : dictionary) {
+        binary::PutString(output, entry);
+      }
+      for (const auto& value : builder.values) {
+        binary::PutVarint(output, ids.at(std::get<std::string>(value)));
+      }
+      return info;
+    }
+  }
+
+  for (const auto& value : builder.values) {
+    switch (kKind) {
+      case ValueKind::kInt:
+        binary::PutSignedVarint(output, std::get<int64_t>(value));
+        break;
+      case ValueKind::kUint:
+        binary::PutVarint(output, std::get<uint64_t>(value));
+        break;
+      case ValueKind::kDouble:
+        binary::PutDouble(output, std::get<double>(value));
+        break;
+      case ValueKind::kBool:
+        output->push_back(std::get<bool>(value) ? 1 : 0);
+        break;
+      case ValueKind::kString:
+        binary::PutString(output, std::get<std::string>(value));
+        break;
+    }
+  }
+  return info;
+}
+
+Reader::Reader(std::string path) : path_(std::move(path)) {
+  std::ifstream stream(path_, std::ios::in | std::ios::binary | std::ios::ate);
+  const auto kFileSize = static_cast<uint64_t>(stream.tellg());
+  if (!stream || kFileSize < kMagic.size() + kTrailerSize)
+    throw exceptions::UserInputException("not a columnar file");
+
+  std::string trailer(kTrailerSize, '\0');
+  stream.seekg(static_cast<std::streamoff>(kFileSize - kTrailerSize));
+  stream.read(trailer.data(), static_cast<std::streamsize>(kTrailerSize));
+
+  binary::Reader trailer_reader(trailer);
+  const uint64_t kFooterSize = trailer_reader.Fixed64();
+  if (trailer_reader.Bytes(kMagic.size()) != kMagic ||
+      kFooterSize > kFileSize - kTrailerSize - kMagic.size()) {
+    throw exceptions::UserInputException("columnar file trailer is corrupt");
+  }
+
+  std::string footer(kFooterSize, '\0');
+  stream.seekg(
+      static_cast<std::streamoff>(kFileSize - kTrailerSize - kFooterSize));
+  stream.read(footer.data(), static_cast<std::streamsize>(kFooterSize));
+  footer_ = DecodeFooter(footer);
+
+  spdlog::debug("Opened columnar file {} with {} rows in {} row groups",
+                path_, footer_.rows, footer_.row_groups.size());
+}
+
+std::optional<size_t> Reader::FindColumn(const std::string& path) const {
+  for (size_t i = 0; i < footer_.columns.size(); ++i) {
+    if (footer_.columns[i].path == path)
+      return i;
+  }
+  return std::nullopt;
+}
+
+ColumnChunk Reader::ReadChunk(size_t row_group, size_t column) const {
+  const auto& group = footer_.row_groups.at(row_group);
+  const auto& info = group.chunks.at(column);
+  const auto& description = footer_.columns.at(column);
+
+  std::string data(info.size, '\0');
+  std::ifstream stream(path_, std::ios::in | std::ios::binary);
+  stream.seekg(static_cast<std::streamoff>(info.offset));
+  stream.read(data.data(), static_cast<std::streamsize>(info.size));
+  if (!stream)
+    throw exceptions::UserInputException("columnar file is truncated");
+
+  binary::Reader reader(data);
+  ColumnChunk chunk;
+  chunk.offsets.reserve(group.rows + 1);
+  chunk.offsets.push_back(0);
+  for (uint64_t row = 0; row < group.rows; ++row) {
+    chunk.offsets.push_back(chunk.offsets.back() +
+                            (description.has_lengths ? reader.Varint() : 1));
+  }
+
+  if (chunk.offsets.back() != info.values)
+    throw exceptions::UserInputException("columnar chunk lengths corrupt");
+
+  chunk.values.reserve(info.values);
+  if (info.encoding == Encoding::kDictionary) {
+    // Every dictionary entry is used by at least one value.
+    const uint64_t kEntries = reader.Varint();
+    if (kEntries > info.values)
+      throw exceptions::UserInputException("columnar dictionary corrupt");
+
+    std::vector<std::string> dictionary(kEntries);
+    for (auto& entry : dictionary) {
+      entry = std::string(reader.String());
+    }
+    for (uint64_t i = 0; i < info.values; ++i) {
+      const uint64_t kId = reader.Varint();
+      if (kId >= dictionary.size())
+        throw exceptions::UserInputException("columnar dictionary corrupt");
+      chunk.values.emplace_back(dictionary[kId]);
+    }
+    return chunk;
+  }
+
+  for (uint64_t i = 0; i < info.values; ++i) {
+    chunk.values.push_back(ReadScalar(&reader, description.kind));
+  }
+  return chunk;
+}
+
+}  // namespace wikiopencite::citescoop::cli::columnar
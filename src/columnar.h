@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_COLUMNAR_H_
+#define SRC_COLUMNAR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#include "fields.h"
+
+/// Columnar layout for PBF data.
+///
+/// A columnar file stores every scalar field path of a message type as
+/// its own column, split into row groups:
+///
+///     magic | chunk ... | footer | footer size (fixed64) | magic
+///
+/// Each column chunk holds the values of one column for one row group.
+/// Columns whose path crosses a repeated or nested field also store the
+/// number of values of every row, from which the offset array is
+/// rebuilt on read. String columns are dictionary encoded when that is
+/// smaller. The footer describes the message type, the columns and, for
+/// every row group, where each chunk lives together with the minimum
+/// and maximum value it holds, so a reader fetches only the chunks it
+/// needs and skips row groups whose values cannot match a filter.
+namespace wikiopencite::citescoop::cli::columnar {
+
+/// Magic bytes at the start and end of a columnar file.
+inline constexpr std::string_view kMagic = "CSCOLv03";
+
+/// Default number of rows per row group.
+inline constexpr size_t kDefaultRowGroupSize = 65536;
+
+enum class ValueKind : std::uint8_t {
+  kInt = 1,
+  kUint = 2,
+  kDouble = 3,
+  kBool = 4,
+  kString = 5,
+};
+
+enum class Encoding : std::uint8_t {
+  kPlain = 0,
+  kDictionary = 1,
+};
+
+struct Column {
+  std::string path;
+  ValueKind kind;
+  bool has_lengths;  ///< Rows may hold zero or several values.
+};
+
+struct ChunkInfo {
+  uint64_t offset;  ///< Byte offset of the chunk in the file.
+  uint64_t size;    ///< Size of the chunk in bytes.
+  uint64_t values;  ///< Number of values in the chunk.
+  Encoding encoding;
+  fields::Value min;  ///< Smallest value, std::monostate if none.
+  fields::Value max;  ///< Largest value, std::monostate if none.
+};
+
+struct RowGroupInfo {
+  uint64_t rows;
+  std::vector<ChunkInfo> chunks;  ///< One per column.
+};
+
+struct Footer {
+  wikiopencite::proto::FileType file_type;
+  std::string message_type;
+  uint64_t rows = 0;
+  std::vector<Column> columns;
+  std::vector<RowGroupInfo> row_groups;
+};
+
+/// @brief The decoded values of one column in one row group.
+struct ColumnChunk {
+  std::vector<fields::Value> values;
+
+  /// Values of row i are values[offsets[i]] to values[offsets[i + 1]].
+  std::vector<uint64_t> offsets;
+};
+
+/// @brief List the columns a message type is flattened into.
+std::vector<Column> FlattenColumns(
+    const google::protobuf::Descriptor* descriptor);
+
+/// @brief Whether the file at path starts with the columnar magic.
+bool IsColumnarFile(const std::string& path);
+
+/// @brief Write messages of one type as a columnar file.
+class Writer {
+ public:
+  /// @param output Stream to write to. Must outlive the writer.
+  /// @param file_type Type of the source PBF file.
+  /// @param row_group_size Rows buffered before a row group is written.
+  Writer(std::ostream* output, wikiopencite::proto::FileType file_type,
+         size_t row_group_size);
+
+  /// @brief Add a message as the next row.
+  void Add(const google::protobuf::Message& message);
+
+  /// @brief Flush the last row group and write the footer.
+  void Finish();
+
+ private:
+  struct Builder {
+    std::vector<fields::Value> values;
+    std::vector<uint64_t> lengths;
+  };
+
+  void FlushRowGroup();
+  [[nodiscard]] ChunkInfo EncodeChunk(size_t column, const Builder& builder,
+                                      std::string* output) const;
+
+  std::ostream* output_;
+  uint64_t position_ = 0;
+  size_t row_group_size_;
+  uint64_t buffered_rows_ = 0;
+  Footer footer_;
+  std::vector<fields::FieldPath> paths_;
+  std::vector<Builder> builders_;
+};
+
+/// @brief Random access reader over a columnar file. ReadChunk may be
+/// called concurrently from several threads.
+class Reader {
+ public:
+  /// @throws exceptions::UserInputException if the file is not a valid
+  /// columnar file.
+  explicit Reader(std::string path);
+
+  [[nodiscard]] const Footer& footer() const { return footer_; }
+
+  /// @brief Index of the column with the given path.
+  [[nodiscard]] std::optional<size_t> FindColumn(
+      const std::string& path) const;
+
+  /// @brief Read and decode a single column chunk, touching only its
+  /// byte range of the file.
+  [[nodiscard]] ColumnChunk ReadChunk(size_t row_group, size_t column) const;
+
+ private:
+  std::string path_;
+  Footer footer_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::columnar
+
+#endif  // SRC_COLUMNAR_H_
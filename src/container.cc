@@ -0,0 +1,312 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "container.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "zstd.h"
+
+#include "binary.h"
+#include "checksum.h"
+#include "exceptions.h"
+#include "header.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::container {
+
+namespace {
+namespace proto = wikiopencite::proto;
+
+constexpr size_t kBlockHeaderSize = 2 * sizeof(uint32_t);
+constexpr size_t kIndexEntrySize = 2 * sizeof(uint64_t);
+constexpr size_t kTrailerSize = sizeof(uint64_t) + kIndexMagic.size();
+
+/// Blocks queued per thread before the caller waits for the oldest.
+constexpr size_t kBlocksPerThread = 2;
+
+void ReadExactly(std::istream* input, std::string* buffer, size_t size) {
+  buffer->resize(size);
+  input->read(buffer->data(), static_cast<std::streamsize>(size));
+  if (static_cast<size_t>(input->gcount()) != size)
+    throw exceptions::UserInputException("compressed payload is truncated");
+}
+}  // namespace
+
+std::string CompressBlock(std::string_view raw) {
+  std::string compressed(ZSTD_compressBound(raw.size()), '\0');
+  const size_t kSize = ZSTD_compress(compressed.data(), compressed.size(),
+                                     raw.data(), raw.size(),
+                                     ZSTD_CLEVEL_DEFAULT);
+  if (ZSTD_isError(kSize) != 0) {
+    throw exceptions::CliException(
+        fmt::format("failed to compress block: {}", ZSTD_getErrorName(kSize)));
+  }
+  compressed.resize(kSize);
+  return compressed;
+}
+
+std::string DecompressBlock(std::string_view compressed, size_t raw_size) {
+  std::string raw(raw_size, '\0');
+  const size_t kSize = ZSTD_decompress(raw.data(), raw.size(),
+                                       compressed.data(), compressed.size());
+  if (ZSTD_isError(kSize) != 0 || kSize != raw_size)
+    throw exceptions::UserInputException("corrupt compressed block");
+  return raw;
+}
+
+bool IsCompressed(const proto::FileHeader& header) {
+  const auto kContainer = header::GetVarint(header, header::kContainerField);
+  if (!kContainer)
+    return false;
+  if (*kContainer != kZstdBlocks)
+    throw exceptions::UnsupportedFileType("unknown payload container");
+  return true;
+}
+
+void MarkCompressed(proto::FileHeader* header) {
+  header::SetVarint(header, header::kContainerField, kZstdBlocks);
+}
+
+CompressingBuffer::CompressingBuffer(std::ostream* output, unsigned threads,
+                                     // NOLINTNEXTLINE
+                                     size_t block_size)
+    : output_(output),
+      block_size_(block_size),
+      max_pending_(std::max(threads, 1U) * kBlocksPerThread) {}
+
+CompressingBuffer::int_type CompressingBuffer::overflow(int_type ch) {
+  if (traits_type::eq_int_type(ch, traits_type::eof()))
+    return traits_type::not_eof(ch);
+
+  block_.push_back(traits_type::to_char_type(ch));
+  if (block_.size() >= block_size_)
+    Submit();
+  return ch;
+}
+
+std::streamsize CompressingBuffer::xsputn(const char* data,
+                                          // NOLINTNEXTLINE
+                                          std::streamsize size) {
+  block_.append(data, static_cast<size_t>(size));
+  if (block_.size() >= block_size_)
+    Submit();
+  return size;
+}
+
+void CompressingBuffer::Submit() {
+  if (block_.empty())
+    return;
+
+  pending_.push_back(ThreadPool::Shared().Submit([raw = std::move(block_)]() {
+    return Compressed{CompressBlock(raw), raw.size()};
+  }));
+  block_ = std::string();
+  block_.reserve(block_size_);
+
+  while (pending_.size() > max_pending_) {
+    WriteOldest();
+  }
+}
+
+void CompressingBuffer::WriteOldest() {
+  Compressed block = pending_.front().get();
+  pending_.pop_front();
+
+  std::string block_header;
+  binary::PutFixed32(&block_header, static_cast<uint32_t>(block.raw_size));
+  binary::PutFixed32(&block_header, static_cast<uint32_t>(block.data.size()));
+  output_->write(block_header.data(),
+                 static_cast<std::streamsize>(block_header.size()));
+  output_->write(block.data.data(),
+                 static_cast<std::streamsize>(block.data.size()));
+
+  index_.push_back({compressed_offset_, raw_offset_});
+  compressed_offset_ += block_header.size() + block.data.size();
+  raw_offset_ += block.raw_size;
+}
+
+void CompressingBuffer::Finish() {
+  Submit();
+  while (!pending_.empty()) {
+    WriteOldest();
+  }
+
+  std::string trailer;
+  binary::PutFixed32(&trailer, 0);
+  binary::PutFixed32(&trailer, 0);
+  for (const auto& entry : index_) {
+    binary::PutFixed64(&trailer, entry.compressed_offset);
+    binary::PutFixed64(&trailer, entry.raw_offset);
+  }
+  binary::PutFixed64(&trailer, index_.size());
+  trailer.append(kIndexMagic);
+  output_->write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+  output_->flush();
+}
+
+DecompressingBuffer::DecompressingBuffer(std::istream* input,
+                                         unsigned threads)
+    : input_(input),
+      payload_start_(input->tellg()),
+      read_ahead_(std::max(threads, 1U) * kBlocksPerThread) {}
+
+void DecompressingBuffer::SetReadAhead(unsigned threads) {
+  read_ahead_ = std::max(threads, 1U) * kBlocksPerThread;
+}
+
+void DecompressingBuffer::Prefetch() {
+  std::string buffer;
+  while (!input_done_ && pending_.size() < read_ahead_) {
+    ReadExactly(input_, &buffer, kBlockHeaderSize);
+    binary::Reader reader(buffer);
+    const uint32_t kRawSize = reader.Fixed32();
+    const uint32_t kCompressedSize = reader.Fixed32();
+    if (kRawSize == 0) {
+      input_done_ = true;
+      break;
+    }
+
+    std::string compressed;
+    ReadExactly(input_, &compressed, kCompressedSize);
+    pending_.push_back(
+        {next_raw_offset_,
+         ThreadPool::Shared().Submit(
+             [compressed = std::move(compressed), kRawSize]() {
+               return DecompressBlock(compressed, kRawSize);
+             })});
+    next_raw_offset_ += kRawSize;
+  }
+}
+
+void DecompressingBuffer::NextBlock() {
+  Prefetch();
+  if (pending_.empty()) {
+    block_.clear();
+    setg(nullptr, nullptr, nullptr);
+    return;
+  }
+
+  block_start_ = pending_.front().raw_offset;
+  block_ = pending_.front().data.get();
+  pending_.pop_front();
+  setg(block_.data(), block_.data(), block_.data() + block_.size());
+
+  // Queue the block after the last one again so the pool keeps busy
+  // while this one is consumed.
+  Prefetch();
+}
+
+DecompressingBuffer::int_type DecompressingBuffer::underflow() {
+  if (gptr() != nullptr && gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  if (gptr() != nullptr)
+    block_start_ += block_.size();
+  NextBlock();
+  if (gptr() == egptr())
+    return traits_type::eof();
+  return traits_type::to_int_type(*gptr());
+}
+
+DecompressingBuffer::pos_type DecompressingBuffer::seekoff(
+    off_type offset, std::ios_base::seekdir direction,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    std::ios_base::openmode which) {
+  const auto kCurrent = static_cast<off_type>(
+      block_start_ + static_cast<uint64_t>(gptr() - eback()));
+
+  if (direction == std::ios_base::cur) {
+    if (offset == 0)
+      return {kCurrent};
+    return seekpos(kCurrent + offset, which);
+  }
+  if (direction == std::ios_base::beg)
+    return seekpos(offset, which);
+  return {off_type(-1)};
+}
+
+DecompressingBuffer::pos_type DecompressingBuffer::seekpos(
+    pos_type position, std::ios_base::openmode which) {
+  const pos_type kFailed = off_type(-1);
+  if ((which & std::ios_base::in) == 0 || off_type(position) < 0)
+    return kFailed;
+
+  const auto kTarget = static_cast<uint64_t>(off_type(position));
+  if (kTarget >= block_start_ && kTarget <= block_start_ + block_.size() &&
+      eback() != nullptr) {
+    setg(eback(), eback() + (kTarget - block_start_), egptr());
+    return position;
+  }
+
+  LoadIndex();
+  auto entry = std::upper_bound(
+      index_->begin(), index_->end(), kTarget,
+      [](uint64_t target, const IndexEntry& candidate) {
+        return target < candidate.raw_offset;
+      });
+  if (entry == index_->begin())
+    return kFailed;
+  --entry;
+
+  pending_.clear();
+  input_->clear();
+  input_->seekg(payload_start_ +
+                static_cast<std::streamoff>(entry->compressed_offset));
+  input_done_ = false;
+  next_raw_offset_ = entry->raw_offset;
+  block_.clear();
+  NextBlock();
+
+  if (kTarget - block_start_ > block_.size())
+    return kFailed;
+  setg(eback(), eback() + (kTarget - block_start_), egptr());
+  return position;
+}
+
+void DecompressingBuffer::LoadIndex() {
+  if (index_)
+    return;
+
+  input_->clear();
+  input_->seekg(0, std::ios::end);
+  auto end = static_cast<uint64_t>(input_->tellg());
+  if (const auto kChecksums = checksum::ReadTrailer(input_, end))
+    end = kChecksums->content_size;
+  if (end < static_cast<uint64_t>(payload_start_) + kTrailerSize)
+    throw exceptions::UserInputException("compressed payload has no index");
+
+  std::string buffer;
+  input_->seekg(static_cast<std::streamoff>(end - kTrailerSize));
+  ReadExactly(input_, &buffer, kTrailerSize);
+  binary::Reader trailer(buffer);
+  const uint64_t kBlocks = trailer.Fixed64();
+  if (trailer.Bytes(kIndexMagic.size()) != kIndexMagic ||
+      kBlocks * kIndexEntrySize > end - kTrailerSize)
+    throw exceptions::UserInputException("compressed payload index corrupt");
+
+  input_->seekg(static_cast<std::streamoff>(end - kTrailerSize -
+                                            kBlocks * kIndexEntrySize));
+  ReadExactly(input_, &buffer, kBlocks * kIndexEntrySize);
+  binary::Reader reader(buffer);
+  index_.emplace();
+  index_->reserve(kBlocks);
+  for (uint64_t i = 0; i < kBlocks; ++i) {
+    const uint64_t kCompressedOffset = reader.Fixed64();
+    const uint64_t kRawOffset = reader.Fixed64();
+    index_->push_back({kCompressedOffset, kRawOffset});
+  }
+}
+
+}  // namespace wikiopencite::citescoop::cli::container
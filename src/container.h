@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_CONTAINER_H_
+#define SRC_CONTAINER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+
+#include "thread_pool.h"
+
+/// Block compressed container for the payload of a PBF file.
+///
+/// The header stays a plain length prefixed message so any reader can
+/// tell what the file holds. When header::kContainerField is set to
+/// kZstdBlocks, the framed messages following it are cut into blocks
+/// of about kDefaultBlockSize bytes, each compressed independently:
+///
+///     block ... | end block | index entry ... | block count | magic
+///
+/// A block is its raw size and compressed size (fixed32 each) followed
+/// by one zstd frame. An end block has both sizes set to zero. Each
+/// index entry gives the compressed offset of a block relative to the
+/// start of the payload and the raw offset of its first byte (fixed64
+/// each). Blocks are cut on byte counts rather than message
+/// boundaries, so the decompressed payload is byte for byte the payload
+/// of an uncompressed file and offsets into it stay meaningful. A
+/// checksum trailer may follow the index (see checksum.h).
+namespace wikiopencite::citescoop::cli::container {
+
+/// Value of header::kContainerField for zstd block compression.
+inline constexpr uint64_t kZstdBlocks = 1;
+
+/// Raw bytes per block.
+inline constexpr size_t kDefaultBlockSize = size_t{2} << 20U;
+
+/// Magic bytes ending the block index.
+inline constexpr std::string_view kIndexMagic = "CSBLKIX1";
+
+/// @brief Where a block starts in the compressed and raw payload.
+struct IndexEntry {
+  uint64_t compressed_offset;
+  uint64_t raw_offset;
+};
+
+/// @brief Compress one block as a single zstd frame.
+std::string CompressBlock(std::string_view raw);
+
+/// @brief Decompress a block written by CompressBlock.
+/// @throws exceptions::UserInputException if the block is corrupt or
+/// does not decompress to raw_size bytes.
+std::string DecompressBlock(std::string_view compressed, size_t raw_size);
+
+/// @brief Whether the payload of a file is block compressed.
+bool IsCompressed(const wikiopencite::proto::FileHeader& header);
+
+/// @brief Flag a header as having a block compressed payload.
+void MarkCompressed(wikiopencite::proto::FileHeader* header);
+
+/// @brief Stream buffer compressing everything written through it into
+/// blocks. Blocks are compressed on ThreadPool::Shared and written in
+/// order.
+class CompressingBuffer : public std::streambuf {
+ public:
+  /// @param output Stream receiving the compressed payload. Must
+  /// outlive the buffer.
+  /// @param threads Number of blocks compressed at once.
+  /// @param block_size Raw bytes per block.
+  CompressingBuffer(std::ostream* output, unsigned threads,
+                    size_t block_size = kDefaultBlockSize);
+
+  /// @brief Compress the last block and write the end block and index.
+  /// Nothing may be written afterwards.
+  void Finish();
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char* data, std::streamsize size) override;
+
+ private:
+  struct Compressed {
+    std::string data;
+    uint64_t raw_size;
+  };
+
+  void Submit();
+  void WriteOldest();
+
+  std::ostream* output_;
+  size_t block_size_;
+  std::string block_;
+  uint64_t compressed_offset_ = 0;
+  uint64_t raw_offset_ = 0;
+  std::vector<IndexEntry> index_;
+  size_t max_pending_;
+  std::deque<std::future<Compressed>> pending_;
+};
+
+/// @brief Stream buffer decompressing a block compressed payload. The
+/// following blocks are decompressed ahead on ThreadPool::Shared while
+/// the current one is consumed. Seeking uses the block index, with
+/// positions counted in decompressed bytes.
+///
+/// Corrupt data is reported by throwing exceptions::UserInputException,
+/// so the istream using this buffer should have badbit in its exception
+/// mask.
+class DecompressingBuffer : public std::streambuf {
+ public:
+  /// @param input Stream positioned at the start of the payload. Must
+  /// outlive the buffer.
+  /// @param threads Number of blocks decompressed at once, which bounds
+  /// how far ahead of the reader decompression runs.
+  DecompressingBuffer(std::istream* input, unsigned threads);
+
+  /// @brief Change the number of blocks decompressed at once, for
+  /// instance to widen it for a sequential scan of the whole file.
+  void SetReadAhead(unsigned threads);
+
+ protected:
+  int_type underflow() override;
+  pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                   std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+ private:
+  struct Pending {
+    uint64_t raw_offset;
+    std::future<std::string> data;
+  };
+
+  void Prefetch();
+  void NextBlock();
+  void LoadIndex();
+
+  std::istream* input_;
+  std::istream::pos_type payload_start_;
+  size_t read_ahead_;
+  bool input_done_ = false;
+  std::string block_;
+  uint64_t block_start_ = 0;
+  uint64_t next_raw_offset_ = 0;
+  std::optional<std::vector<IndexEntry>> index_;
+  std::deque<Pending> pending_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::container
+
+#endif  // SRC_CONTAINER_H_
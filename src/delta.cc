@@ -0,0 +1,225 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "delta.h"
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/citation.pb.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/revision.pb.h"
+#include "google/protobuf/repeated_ptr_field.h"
+#include "google/protobuf/unknown_field_set.h"
+
+#include "binary.h"
+#include "exceptions.h"
+#include "header.h"
+
+namespace wikiopencite::citescoop::cli::delta {
+
+namespace {
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+void AppendTriple(std::string* edits, uint64_t start, uint64_t length,
+                  uint64_t inserted) {
+  binary::PutVarint(edits, start);
+  binary::PutVarint(edits, length);
+  binary::PutVarint(edits, inserted);
+}
+}  // namespace
+
+bool IsEncoded(const proto::FileHeader& header) {
+  return header::GetVarint(header, header::kRevisionEncodingField) ==
+         kDeltaRevisions;
+}
+
+void MarkEncoded(proto::FileHeader* header) {
+  header::SetVarint(header, header::kRevisionEncodingField, kDeltaRevisions);
+}
+
+std::optional<uint64_t> KeyframeDistance(const proto::Revision& revision) {
+  const auto& unknown = revision.GetReflection()->GetUnknownFields(revision);
+  for (int i = 0; i < unknown.field_count(); ++i) {
+    const auto& field = unknown.field(i);
+    if (field.number() == kKeyframeField &&
+        field.type() == pb::UnknownField::TYPE_VARINT)
+      return field.varint();
+  }
+  return std::nullopt;
+}
+
+namespace {
+/// @brief Rebuild the citations of a delta from the previous revision,
+/// taking each copied citation through take(index, output).
+template <typename Take>
+void ApplyEdits(int available, proto::Revision* delta, const Take& take) {
+  auto* unknown = delta->GetReflection()->MutableUnknownFields(delta);
+  std::string edits;
+  for (int i = 0; i < unknown->field_count(); ++i) {
+    const auto& field = unknown->field(i);
+    if (field.number() == kEditsField &&
+        field.type() == pb::UnknownField::TYPE_LENGTH_DELIMITED)
+      edits = field.length_delimited();
+  }
+  unknown->DeleteByNumber(kEditsField);
+  unknown->DeleteByNumber(kKeyframeField);
+
+  pb::RepeatedPtrField<proto::Citation> inserted;
+  inserted.Swap(delta->mutable_citations());
+
+  const auto kMalformed = [] {
+    return exceptions::UserInputException(
+        "malformed delta encoded revision");
+  };
+
+  int next_inserted = 0;
+  binary::Reader reader(edits);
+  while (!reader.empty()) {
+    const uint64_t kStart = reader.Varint();
+    const uint64_t kLength = reader.Varint();
+    const uint64_t kInserted = reader.Varint();
+    const auto kAvailable = static_cast<uint64_t>(available);
+    if (kStart > kAvailable || kLength > kAvailable - kStart ||
+        kInserted > static_cast<uint64_t>(inserted.size() - next_inserted))
+      throw kMalformed();
+
+    for (uint64_t i = kStart; i < kStart + kLength; ++i) {
+      take(static_cast<int>(i), delta->add_citations());
+    }
+    for (uint64_t i = 0; i < kInserted; ++i) {
+      delta->mutable_citations()->Add(
+          std::move(*inserted.Mutable(next_inserted++)));
+    }
+  }
+
+  if (next_inserted != inserted.size())
+    throw kMalformed();
+}
+}  // namespace
+
+void Apply(const proto::Revision& previous, proto::Revision* delta) {
+  ApplyEdits(previous.citations_size(), delta,
+             [&](int index, proto::Citation* citation) {
+               *citation = previous.citations(index);
+             });
+}
+
+void Apply(proto::Revision* previous, proto::Revision* delta) {
+  // A script may copy a citation more than once, so only its first use
+  // may take it and later ones copy from where it was taken to.
+  std::vector<int> taken_to(previous->citations_size(), -1);
+  ApplyEdits(previous->citations_size(), delta,
+             [&](int index, proto::Citation* citation) {
+               if (taken_to[index] >= 0) {
+                 *citation = delta->citations(taken_to[index]);
+               } else {
+                 citation->Swap(previous->mutable_citations(index));
+                 taken_to[index] = delta->citations_size() - 1;
+               }
+             });
+}
+
+bool IsKeyframe(std::string_view serialized) {
+  return !binary::HasWireField(serialized, kKeyframeField);
+}
+
+RevisionEncoder::RevisionEncoder(std::ostream* output,
+                                 // NOLINTNEXTLINE(whitespace/indent_namespace)
+                                 uint32_t keyframe_interval)
+    : output_(output),
+      writer_(output),
+      keyframe_interval_(keyframe_interval) {}
+
+void RevisionEncoder::Write(const proto::Revision& revision) {
+  std::vector<std::string> citations;
+  citations.reserve(revision.citations_size());
+  for (const auto& citation : revision.citations()) {
+    citations.push_back(citation.SerializeAsString());
+  }
+
+  const auto kPosition = static_cast<uint64_t>(output_->tellp());
+  proto::Revision delta;
+  const bool kKeyframe = page_id_ != revision.page_id() ||
+                         since_keyframe_ + 1 >= keyframe_interval_ ||
+                         !Diff(revision, citations, &delta);
+
+  if (kKeyframe) {
+    writer_.WriteMessage(revision);
+    keyframe_position_ = kPosition;
+    since_keyframe_ = 0;
+    keyframes_++;
+  } else {
+    delta.GetReflection()->MutableUnknownFields(&delta)->AddVarint(
+        kKeyframeField, kPosition - keyframe_position_);
+    writer_.WriteMessage(delta);
+    since_keyframe_++;
+    deltas_++;
+  }
+
+  page_id_ = revision.page_id();
+  previous_ = std::move(citations);
+}
+
+bool RevisionEncoder::Diff(const proto::Revision& revision,
+                           const std::vector<std::string>& citations,
+                           // NOLINTNEXTLINE(whitespace/indent_namespace)
+                           proto::Revision* delta) const {
+  // Where each citation of the previous revision is, first occurrence
+  // first. Citations are compared by their serialized bytes.
+  std::unordered_map<std::string_view, uint64_t> positions;
+  positions.reserve(previous_.size());
+  for (uint64_t i = 0; i < previous_.size(); ++i) {
+    positions.try_emplace(previous_[i], i);
+  }
+
+  std::string edits;
+  std::vector<int> inserted_indexes;
+  uint64_t start = 0;
+  uint64_t length = 0;
+  uint64_t inserted = 0;
+  for (size_t i = 0; i < citations.size(); ++i) {
+    // Extend the current copy while the lists run in step.
+    if (inserted == 0 && length > 0 && start + length < previous_.size() &&
+        previous_[start + length] == citations[i]) {
+      length++;
+      continue;
+    }
+
+    const auto kFound = positions.find(citations[i]);
+    if (kFound == positions.end()) {
+      inserted_indexes.push_back(static_cast<int>(i));
+      inserted++;
+      continue;
+    }
+
+    if (length > 0 || inserted > 0)
+      AppendTriple(&edits, start, length, inserted);
+    start = kFound->second;
+    length = 1;
+    inserted = 0;
+  }
+  if (length > 0 || inserted > 0)
+    AppendTriple(&edits, start, length, inserted);
+
+  if (inserted_indexes.size() == citations.size())
+    return false;
+
+  delta->CopyFrom(revision);
+  delta->clear_citations();
+  for (const int kIndex : inserted_indexes) {
+    *delta->add_citations() = revision.citations(kIndex);
+  }
+  delta->GetReflection()->MutableUnknownFields(delta)->AddLengthDelimited(
+      kEditsField, edits);
+  return true;
+}
+
+}  // namespace wikiopencite::citescoop::cli::delta
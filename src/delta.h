@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_DELTA_H_
+#define SRC_DELTA_H_
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "citescoop/io.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/revision.pb.h"
+
+/// Delta encoding of the revisions of a page.
+///
+/// Successive revisions of a page mostly share their citations, so in a
+/// file flagged by MarkEncoded a revision may store only the citations
+/// it adds and an edit script rebuilding its full list from that of the
+/// revision before it. The script is a packed list of varint triples
+///
+///     start | length | inserted
+///
+/// each appending length citations of the previous revision starting at
+/// start, then the next inserted citations of the delta. It is kept in
+/// the unknown field kEditsField, next to kKeyframeField giving the
+/// number of payload bytes between the start of the delta and the start
+/// of the keyframe its chain begins at. A keyframe is an ordinary
+/// revision holding its full list; one starts every page and follows
+/// every keyframe_interval revisions, bounding the messages a reader
+/// landing on a delta after a seek has to replay.
+///
+/// io::ReadGenericMessage rebuilds the full lists as it reads, so
+/// commands never see deltas and files they write are plain.
+namespace wikiopencite::citescoop::cli::delta {
+
+/// Value of header::kRevisionEncodingField for delta encoded revisions.
+inline constexpr uint64_t kDeltaRevisions = 1;
+
+/// Revisions from one keyframe to the next.
+inline constexpr uint32_t kDefaultKeyframeInterval = 32;
+
+/// Unknown field of a delta holding its edit script.
+inline constexpr int kEditsField = 1000;
+
+/// Unknown field of a delta holding its distance from its keyframe.
+inline constexpr int kKeyframeField = 1001;
+
+/// @brief Whether the revisions of a file are delta encoded.
+bool IsEncoded(const wikiopencite::proto::FileHeader& header);
+
+/// @brief Flag a header as having delta encoded revisions.
+void MarkEncoded(wikiopencite::proto::FileHeader* header);
+
+/// @brief Payload bytes from the start of a delta back to the start of
+/// its keyframe, or nothing if the revision is a keyframe.
+std::optional<uint64_t> KeyframeDistance(
+    const wikiopencite::proto::Revision& revision);
+
+/// @brief Turn a delta into the full revision it encodes.
+/// @param previous Full revision read before the delta.
+/// @throws exceptions::UserInputException if the edit script does not
+/// fit previous.
+void Apply(const wikiopencite::proto::Revision& previous,
+           wikiopencite::proto::Revision* delta);
+
+/// @brief Like Apply, but moves the citations the delta shares out of
+/// previous rather than copying them, for readers done with previous.
+/// previous is left with an unspecified list of citations.
+void Apply(wikiopencite::proto::Revision* previous,
+           wikiopencite::proto::Revision* delta);
+
+/// @brief Whether a serialized revision is a keyframe, found without
+/// decoding it.
+/// @throws exceptions::UserInputException if it is malformed.
+bool IsKeyframe(std::string_view serialized);
+
+/// @brief Writes framed revisions, delta encoding each against the one
+/// before it when they belong to the same page. Revisions should be
+/// grouped by page, as dumps list them, for deltas to be used.
+class RevisionEncoder {
+ public:
+  /// @param output Stream receiving the framed payload, positioned at
+  /// its start. Must outlive the encoder.
+  /// @param keyframe_interval Revisions from one keyframe to the next.
+  explicit RevisionEncoder(
+      std::ostream* output,
+      uint32_t keyframe_interval = kDefaultKeyframeInterval);
+
+  void Write(const wikiopencite::proto::Revision& revision);
+
+  [[nodiscard]] uint64_t keyframes() const { return keyframes_; }
+  [[nodiscard]] uint64_t deltas() const { return deltas_; }
+
+ private:
+  /// @brief Build the edit script of citations against previous_,
+  /// copying the citations it inserts into delta. Returns false if no
+  /// citation could be copied, where a keyframe is as small.
+  bool Diff(const wikiopencite::proto::Revision& revision,
+            const std::vector<std::string>& citations,
+            wikiopencite::proto::Revision* delta) const;
+
+  std::ostream* output_;
+  wikiopencite::citescoop::MessageWriter writer_;
+  uint32_t keyframe_interval_;
+
+  std::optional<uint64_t> page_id_;
+  std::vector<std::string> previous_;  ///< Serialized citations.
+  uint64_t keyframe_position_ = 0;
+  uint32_t since_keyframe_ = 0;
+  uint64_t keyframes_ = 0;
+  uint64_t deltas_ = 0;
+};
+
+}  // namespace wikiopencite::citescoop::cli::delta
+
+#endif  // SRC_DELTA_H_
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "doi.h"
+
+#include <array>
+#include <cctype>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace wikiopencite::citescoop::cli::doi {
+
+namespace {
+/// Prefixes stripped before a DOI, compared case insensitively.
+constexpr std::array<std::string_view, 7> kPrefixes = {
+    "https://doi.org/",    "http://doi.org/", "https://dx.doi.org/",
+    "http://dx.doi.org/",  "doi.org/",        "doi:",
+    "info:doi/",
+};
+
+/// Punctuation that ends a sentence rather than a DOI.
+constexpr std::string_view kTrailing = ".,;:";
+
+bool StartsWithIgnoreCase(std::string_view value, std::string_view prefix) {
+  if (value.size() < prefix.size())
+    return false;
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    if (std::tolower(static_cast<unsigned char>(value[i])) != prefix[i])
+      return false;
+  }
+  return true;
+}
+
+void Trim(std::string_view* value) {
+  while (!value->empty() &&
+         std::isspace(static_cast<unsigned char>(value->front())) != 0) {
+    value->remove_prefix(1);
+  }
+  while (!value->empty() &&
+         std::isspace(static_cast<unsigned char>(value->back())) != 0) {
+    value->remove_suffix(1);
+  }
+}
+}  // namespace
+
+std::optional<std::string> Normalize(std::string_view raw) {
+  std::string_view value = raw;
+  Trim(&value);
+  for (const auto kPrefix : kPrefixes) {
+    if (StartsWithIgnoreCase(value, kPrefix)) {
+      value.remove_prefix(kPrefix.size());
+      Trim(&value);
+      break;
+    }
+  }
+  while (!value.empty() && kTrailing.find(value.back()) != std::string::npos) {
+    value.remove_suffix(1);
+  }
+
+  // A DOI is 10.<registrant>/<suffix>, with a non-empty suffix.
+  const size_t kSlash = value.find('/');
+  if (!value.starts_with("10.") || kSlash == std::string_view::npos ||
+      kSlash + 1 == value.size())
+    return std::nullopt;
+
+  std::string normalized(value);
+  for (auto& chr : normalized) {
+    chr = static_cast<char>(std::tolower(static_cast<unsigned char>(chr)));
+  }
+  return normalized;
+}
+
+}  // namespace wikiopencite::citescoop::cli::doi
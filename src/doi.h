@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_DOI_H_
+#define SRC_DOI_H_
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace wikiopencite::citescoop::cli::doi {
+
+/// @brief Reduce a DOI as written in a citation or an OpenAlex work to
+/// a canonical form, so equal DOIs compare equal as strings.
+///
+/// Surrounding whitespace, resolver prefixes such as https://doi.org/
+/// and doi: and trailing punctuation are removed, and the result is
+/// lower cased, as DOIs are case insensitive.
+///
+/// @return The normalized DOI, or std::nullopt if the value does not
+/// look like a DOI.
+std::optional<std::string> Normalize(std::string_view raw);
+
+}  // namespace wikiopencite::citescoop::cli::doi
+
+#endif  // SRC_DOI_H_
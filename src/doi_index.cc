@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "doi_index.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "spdlog/spdlog.h"
+
+#include "doi.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "hash.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace proto = wikiopencite::proto;
+
+/// Largest share of slots in use before the table grows.
+constexpr double kMaxLoad = 0.7;
+}  // namespace
+
+DoiIndex DoiIndex::Build(const std::string& works_path) {
+  auto file = io::OpenPbfFile(works_path);
+  auto header = io::ReadPbfHeader(file.get());
+  if (header->type() != proto::FileType::FILE_TYPE_OPENALEX_WORKS) {
+    throw exceptions::UnsupportedFileType(
+        "DOI index needs an OpenAlex works file");
+  }
+  if (header->count() > std::numeric_limits<uint32_t>::max())
+    throw exceptions::UserInputException("too many works to index");
+
+  const auto* descriptor = io::DescriptorForFileType(header->type());
+  const auto kDoiPath = fields::FieldPath::Parse(descriptor, fields::kDoiField);
+  const auto kIdPath =
+      fields::FieldPath::Parse(descriptor, fields::kOpenAlexIdField);
+
+  DoiIndex index;
+  index.Reserve(header->count());
+  index.id_offsets_.reserve(header->count() + 1);
+
+  uint64_t duplicates = 0;
+  for (uint64_t i = 0; i < header->count(); ++i) {
+    const auto kMessage = io::ReadGenericMessage(file.get(), header->type());
+    index.ids_ += fields::ToString(kIdPath.First(*kMessage));
+    index.id_offsets_.push_back(index.ids_.size());
+
+    const auto kDoi =
+        doi::Normalize(fields::ToString(kDoiPath.First(*kMessage)));
+    if (kDoi && !index.Insert(*kDoi, static_cast<uint32_t>(i)))
+      duplicates++;
+  }
+  io::ClosePbfFile(std::move(file));
+
+  if (duplicates > 0)
+    spdlog::warn("{} works repeat the DOI of an earlier work", duplicates);
+  index.ids_.shrink_to_fit();
+  index.dois_.shrink_to_fit();
+  return index;
+}
+
+std::optional<uint32_t> DoiIndex::Find(std::string_view doi) const {
+  const uint64_t kHash = hash::Bytes64(doi);
+  const size_t kMask = slots_.size() - 1;
+  for (size_t i = kHash & kMask;; i = (i + 1) & kMask) {
+    const Slot& slot = slots_[i];
+    if (slot.doi_length == 0)
+      return std::nullopt;
+    if (slot.hash == kHash && DoiAt(slot) == doi)
+      return slot.work;
+  }
+}
+
+std::string_view DoiIndex::OpenAlexId(uint32_t work) const {
+  return std::string_view(ids_).substr(
+      id_offsets_[work], id_offsets_[work + 1] - id_offsets_[work]);
+}
+
+size_t DoiIndex::MemoryUsage() const {
+  return slots_.capacity() * sizeof(Slot) + dois_.capacity() +
+         ids_.capacity() + id_offsets_.capacity() * sizeof(uint64_t);
+}
+
+void DoiIndex::Reserve(size_t count) {
+  const size_t kCapacity = std::bit_ceil(std::max<size_t>(
+      16, static_cast<size_t>(static_cast<double>(count) / kMaxLoad) + 1));
+  if (kCapacity <= slots_.size())
+    return;
+
+  std::vector<Slot> old(kCapacity, Slot{});
+  old.swap(slots_);
+  const size_t kMask = slots_.size() - 1;
+  for (const Slot& slot : old) {
+    if (slot.doi_length == 0)
+      continue;
+    size_t i = slot.hash & kMask;
+    while (slots_[i].doi_length != 0) {
+      i = (i + 1) & kMask;
+    }
+    slots_[i] = slot;
+  }
+}
+
+bool DoiIndex::Insert(std::string_view doi, uint32_t work) {
+  if (static_cast<double>(size_ + 1) >
+      static_cast<double>(slots_.size()) * kMaxLoad)
+    Reserve(slots_.size());
+
+  const uint64_t kHash = hash::Bytes64(doi);
+  const size_t kMask = slots_.size() - 1;
+  size_t i = kHash & kMask;
+  for (; slots_[i].doi_length != 0; i = (i + 1) & kMask) {
+    if (slots_[i].hash == kHash && DoiAt(slots_[i]) == doi)
+      return false;
+  }
+
+  slots_[i] = {kHash, dois_.size(), static_cast<uint32_t>(doi.size()), work};
+  dois_ += doi;
+  size_++;
+  return true;
+}
+
+std::string_view DoiIndex::DoiAt(const Slot& slot) const {
+  return std::string_view(dois_).substr(slot.doi_offset, slot.doi_length);
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_DOI_INDEX_H_
+#define SRC_DOI_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief In memory index from normalized DOI to OpenAlex work, built
+/// from a works PBF file.
+///
+/// DOIs and OpenAlex ids are interned into two contiguous byte arenas
+/// and the DOIs are found through a flat open addressing table, so
+/// each work costs a few dozen bytes beyond its strings, with no
+/// allocation per entry. Works are identified by their ordinal in the
+/// works file.
+class DoiIndex {
+ public:
+  /// @brief Read a works file and index every work with a DOI. Where
+  /// several works share a DOI the first one is kept.
+  /// @throws exceptions::UserInputException if the file does not hold
+  /// OpenAlex works.
+  static DoiIndex Build(const std::string& works_path);
+
+  /// @brief The work with a normalized DOI, see doi::Normalize.
+  [[nodiscard]] std::optional<uint32_t> Find(std::string_view doi) const;
+
+  /// @brief OpenAlex id of a work.
+  [[nodiscard]] std::string_view OpenAlexId(uint32_t work) const;
+
+  /// @brief Number of works read, with or without a DOI.
+  [[nodiscard]] size_t works() const { return id_offsets_.size() - 1; }
+
+  /// @brief Number of distinct DOIs indexed.
+  [[nodiscard]] size_t size() const { return size_; }
+
+  /// @brief Approximate heap memory held by the index in bytes.
+  [[nodiscard]] size_t MemoryUsage() const;
+
+ private:
+  /// A slot of the table, empty while doi_length is zero.
+  struct Slot {
+    uint64_t hash;
+    uint64_t doi_offset;
+    uint32_t doi_length;
+    uint32_t work;
+  };
+
+  DoiIndex() = default;
+
+  /// @brief Size the table for at least count DOIs.
+  void Reserve(size_t count);
+
+  /// @brief Add a DOI unless it is already present.
+  /// @return Whether it was added.
+  bool Insert(std::string_view doi, uint32_t work);
+
+  [[nodiscard]] std::string_view DoiAt(const Slot& slot) const;
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+  std::string dois_;
+  std::string ids_;
+  std::vector<uint64_t> id_offsets_ = {0};
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_DOI_INDEX_H_
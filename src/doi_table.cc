@@ -0,0 +1,551 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "doi_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "doi.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace proto = wikiopencite::proto;
+
+static_assert(std::endian::native == std::endian::little,
+              "DOI tables are mapped as little endian words");
+
+/// Level bits per key still to be placed. Larger values place more
+/// keys per level, making lookups faster and the table larger.
+constexpr double kGamma = 2.0;
+
+/// Words of level bits per rank sample.
+constexpr uint64_t kRankWords = 8;
+
+/// Header words following the magic.
+enum HeaderField : uint8_t {
+  kKeys,
+  kLevels,
+  kFallback,
+  kIdBits,
+  kOrdinalBits,
+  kPrefixLength,
+  kBitWords,
+  kLevelSizesOffset,
+  kBitsOffset,
+  kRanksOffset,
+  kFallbackOffset,
+  kFingerprintsOffset,
+  kIdsOffset,
+  kOrdinalsOffset,
+  kPrefixOffset,
+  kHeaderFields,
+};
+
+constexpr size_t kHeaderSize =
+    DoiTable::kMagic.size() + kHeaderFields * sizeof(uint64_t);
+
+struct Key {
+  hash::Hash128 hash;
+  uint64_t id;
+  uint64_t ordinal;
+};
+
+bool HashLess(const hash::Hash128& lhs, const hash::Hash128& rhs) {
+  return lhs.low != rhs.low ? lhs.low < rhs.low : lhs.high < rhs.high;
+}
+
+/// @brief Position of a key within a level of a number of bits.
+uint64_t LevelPosition(const hash::Hash128& hash, uint64_t level,
+                       uint64_t bits) {
+  // The 64 bit finalizer of MurmurHash3, reseeded per level.
+  uint64_t value = hash.low + (level + 1) * 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 33U)) * 0xFF51AFD7ED558CCDULL;
+  value = (value ^ (value >> 33U)) * 0xC4CEB9FE1A85EC53ULL;
+  value ^= value >> 33U;
+  return value % bits;
+}
+
+uint32_t Fingerprint(const hash::Hash128& hash) {
+  return static_cast<uint32_t>(hash.high >> 32U);
+}
+
+bool TestBit(const uint64_t* words, uint64_t bit) {
+  return ((words[bit / 64] >> (bit % 64)) & 1U) != 0;
+}
+
+void SetBit(std::vector<uint64_t>* words, uint64_t bit) {
+  (*words)[bit / 64] |= uint64_t{1} << (bit % 64);
+}
+
+/// @brief Read value i of a bit packed array of a width.
+uint64_t Unpack(const uint64_t* words, uint64_t width, uint64_t i) {
+  const uint64_t kBit = i * width;
+  const uint64_t kShift = kBit % 64;
+  uint64_t value = words[kBit / 64] >> kShift;
+  if (kShift + width > 64)
+    value |= words[kBit / 64 + 1] << (64 - kShift);
+  return width == 64 ? value : value & ((uint64_t{1} << width) - 1);
+}
+
+void Pack(std::vector<uint64_t>* words, uint64_t width, uint64_t i,
+          uint64_t value) {
+  const uint64_t kBit = i * width;
+  const uint64_t kShift = kBit % 64;
+  (*words)[kBit / 64] |= value << kShift;
+  if (kShift + width > 64)
+    (*words)[kBit / 64 + 1] |= value >> (64 - kShift);
+}
+
+/// @brief Words holding count values of a width, with one to spare so
+/// a value never straddles the end.
+uint64_t PackedWords(uint64_t count, uint64_t width) {
+  return (count * width + 63) / 64 + 1;
+}
+
+/// @brief Split an OpenAlex id into its prefix and number.
+std::optional<std::pair<std::string_view, uint64_t>> SplitId(
+    std::string_view id) {
+  size_t start = id.size();
+  while (start > 0 && std::isdigit(static_cast<unsigned char>(id[start - 1])))
+    start--;
+  if (start == id.size() || id.size() - start > 19)
+    return std::nullopt;
+
+  uint64_t number = 0;
+  for (const char kDigit : id.substr(start)) {
+    number = number * 10 + static_cast<uint64_t>(kDigit - '0');
+  }
+  return std::make_pair(id.substr(0, start), number);
+}
+
+void PutWords(std::string* output, const std::vector<uint64_t>& words) {
+  for (const uint64_t kWord : words) {
+    binary::PutFixed64(output, kWord);
+  }
+}
+}  // namespace
+
+uint64_t DoiTable::Build(const std::string& works_path,
+                         // NOLINTNEXTLINE(whitespace/indent_namespace)
+                         const std::string& table_path) {
+  auto file = io::OpenPbfFile(works_path);
+  auto header = io::ReadPbfHeader(file.get());
+  if (header->type() != proto::FileType::FILE_TYPE_OPENALEX_WORKS) {
+    throw exceptions::UnsupportedFileType(
+        "DOI table needs an OpenAlex works file");
+  }
+
+  const auto* descriptor = io::DescriptorForFileType(header->type());
+  const auto kDoiPath = fields::FieldPath::Parse(descriptor, fields::kDoiField);
+  const auto kIdPath =
+      fields::FieldPath::Parse(descriptor, fields::kOpenAlexIdField);
+
+  std::vector<Key> keys;
+  keys.reserve(header->count());
+  std::optional<std::string> prefix;
+  for (uint64_t i = 0; i < header->count(); ++i) {
+    const auto kMessage = io::ReadGenericMessage(file.get(), header->type());
+    const auto kDoi =
+        doi::Normalize(fields::ToString(kDoiPath.First(*kMessage)));
+    if (!kDoi)
+      continue;
+
+    const auto kId = fields::ToString(kIdPath.First(*kMessage));
+    const auto kParts = SplitId(kId);
+    if (!prefix && kParts)
+      prefix = std::string(kParts->first);
+    if (!kParts || kParts->first != *prefix) {
+      throw exceptions::UserInputException(
+          fmt::format("OpenAlex id {} is not {} followed by a number", kId,
+                      prefix.value_or("a prefix"))
+              .c_str());
+    }
+    keys.push_back({hash::Bytes128(*kDoi), kParts->second, i});
+  }
+  io::ClosePbfFile(std::move(file));
+
+  // Keep the first work of each DOI.
+  std::stable_sort(keys.begin(), keys.end(),
+                   [](const Key& lhs, const Key& rhs) {
+                     return HashLess(lhs.hash, rhs.hash);
+                   });
+  const auto kUnique = std::unique(
+      keys.begin(), keys.end(),
+      [](const Key& lhs, const Key& rhs) { return lhs.hash == rhs.hash; });
+  if (kUnique != keys.end()) {
+    spdlog::warn("{} works repeat the DOI of an earlier work",
+                 std::distance(kUnique, keys.end()));
+    keys.erase(kUnique, keys.end());
+  }
+
+  // Place keys level by level, keeping those that land alone.
+  std::vector<uint64_t> level_sizes;
+  std::vector<uint64_t> bits;
+  std::vector<uint64_t> remaining(keys.size());
+  for (uint64_t i = 0; i < remaining.size(); ++i) {
+    remaining[i] = i;
+  }
+  while (!remaining.empty() && level_sizes.size() < kMaxLevels) {
+    const uint64_t kLevel = level_sizes.size();
+    const uint64_t kWords = std::max<uint64_t>(
+        1, static_cast<uint64_t>(static_cast<double>(remaining.size()) *
+                                 kGamma / 64) +
+               1);
+    const uint64_t kSize = kWords * 64;
+    std::vector<uint64_t> seen(kWords);
+    std::vector<uint64_t> collided(kWords);
+    for (const uint64_t kKey : remaining) {
+      const uint64_t kBit = LevelPosition(keys[kKey].hash, kLevel, kSize);
+      if (TestBit(seen.data(), kBit))
+        SetBit(&collided, kBit);
+      SetBit(&seen, kBit);
+    }
+
+    std::vector<uint64_t> next;
+    for (const uint64_t kKey : remaining) {
+      if (TestBit(collided.data(),
+                  LevelPosition(keys[kKey].hash, kLevel, kSize)))
+        next.push_back(kKey);
+    }
+    for (uint64_t i = 0; i < kWords; ++i) {
+      bits.push_back(seen[i] & ~collided[i]);
+    }
+    level_sizes.push_back(kSize);
+    remaining.swap(next);
+  }
+
+  std::vector<uint64_t> ranks;
+  uint64_t placed = 0;
+  for (uint64_t i = 0; i < bits.size(); ++i) {
+    if (i % kRankWords == 0)
+      ranks.push_back(placed);
+    placed += static_cast<uint64_t>(std::popcount(bits[i]));
+  }
+  ranks.push_back(placed);
+
+  std::sort(remaining.begin(), remaining.end(),
+            [&keys](uint64_t lhs, uint64_t rhs) {
+              return HashLess(keys[lhs].hash, keys[rhs].hash);
+            });
+  std::vector<uint64_t> fallback;
+  for (const uint64_t kKey : remaining) {
+    fallback.push_back(keys[kKey].hash.low);
+    fallback.push_back(keys[kKey].hash.high);
+  }
+
+  uint64_t max_id = 0;
+  for (const auto& key : keys) {
+    max_id = std::max(max_id, key.id);
+  }
+  const uint64_t kIdWidth =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::bit_width(max_id)));
+  const uint64_t kOrdinalWidth = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::bit_width(header->count())));
+
+  // Write the header and sections, then map the sections back in to
+  // fill the slots through the same lookup path readers use.
+  std::vector<uint64_t> fields(kHeaderFields);
+  fields[kKeys] = keys.size();
+  fields[kLevels] = level_sizes.size();
+  fields[kFallback] = remaining.size();
+  fields[kIdBits] = kIdWidth;
+  fields[kOrdinalBits] = kOrdinalWidth;
+  fields[kPrefixLength] = prefix ? prefix->size() : 0;
+  fields[kBitWords] = bits.size();
+  fields[kLevelSizesOffset] = kHeaderSize;
+  fields[kBitsOffset] =
+      fields[kLevelSizesOffset] + level_sizes.size() * sizeof(uint64_t);
+  fields[kRanksOffset] = fields[kBitsOffset] + bits.size() * sizeof(uint64_t);
+  fields[kFallbackOffset] =
+      fields[kRanksOffset] + ranks.size() * sizeof(uint64_t);
+  fields[kFingerprintsOffset] =
+      fields[kFallbackOffset] + fallback.size() * sizeof(uint64_t);
+  fields[kIdsOffset] =
+      fields[kFingerprintsOffset] + (keys.size() + 1) / 2 * sizeof(uint64_t);
+  fields[kOrdinalsOffset] =
+      fields[kIdsOffset] +
+      PackedWords(keys.size(), kIdWidth) * sizeof(uint64_t);
+  fields[kPrefixOffset] =
+      fields[kOrdinalsOffset] +
+      PackedWords(keys.size(), kOrdinalWidth) * sizeof(uint64_t);
+
+  std::string buffer(kMagic);
+  buffer.reserve(fields[kPrefixOffset] + fields[kPrefixLength]);
+  PutWords(&buffer, fields);
+  PutWords(&buffer, level_sizes);
+  PutWords(&buffer, bits);
+  PutWords(&buffer, ranks);
+  PutWords(&buffer, fallback);
+  buffer.resize(fields[kPrefixOffset], '\0');
+  if (prefix)
+    buffer += *prefix;
+
+  // Slots are only known once the rank samples exist, so resolve every
+  // key against the sections already in the buffer.
+  DoiTable table;
+  table.data_ = reinterpret_cast<const uint8_t*>(buffer.data());
+  table.size_ = buffer.size();
+  table.LoadSections();
+
+  auto* fingerprints = reinterpret_cast<uint32_t*>(
+      buffer.data() + fields[kFingerprintsOffset]);
+  std::vector<uint64_t> ids(PackedWords(keys.size(), kIdWidth));
+  std::vector<uint64_t> ordinals(PackedWords(keys.size(), kOrdinalWidth));
+  for (const auto& key : keys) {
+    const uint64_t kSlot = *table.SlotFor(key.hash);
+    fingerprints[kSlot] = Fingerprint(key.hash);
+    Pack(&ids, kIdWidth, kSlot, key.id);
+    Pack(&ordinals, kOrdinalWidth, kSlot, key.ordinal);
+  }
+  table.data_ = nullptr;
+  table.size_ = 0;
+
+  std::string packed;
+  PutWords(&packed, ids);
+  PutWords(&packed, ordinals);
+  buffer.replace(fields[kIdsOffset], packed.size(), packed);
+
+  std::ofstream stream(table_path,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  stream.close();
+  if (!stream) {
+    throw exceptions::CliException(
+        fmt::format("failed to write {}", table_path));
+  }
+
+  spdlog::debug("DOI table has {} levels, {} fallback keys and {} bytes",
+                level_sizes.size(), remaining.size(), buffer.size());
+  return keys.size();
+}
+
+bool DoiTable::IsTable(const std::string& path) {
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  std::string magic(kMagic.size(), '\0');
+  stream.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  return stream && magic == kMagic;
+}
+
+DoiTable::DoiTable(const std::string& path) {
+  const int kFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (kFd < 0) {
+    throw exceptions::UserInputException(
+        fmt::format("cannot open {}", path).c_str());
+  }
+
+  struct stat status{};
+  if (fstat(kFd, &status) != 0 ||
+      static_cast<size_t>(status.st_size) < kHeaderSize) {
+    close(kFd);
+    throw exceptions::UserInputException(
+        fmt::format("{} is not a DOI table", path).c_str());
+  }
+
+  size_ = static_cast<size_t>(status.st_size);
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, kFd, 0);
+  close(kFd);
+  if (data == MAP_FAILED) {
+    throw exceptions::UserInputException(
+        fmt::format("cannot map {}", path).c_str());
+  }
+  data_ = static_cast<const uint8_t*>(data);
+
+  try {
+    LoadSections();
+  } catch (const exceptions::CliException&) {
+    Unmap();
+    throw exceptions::UserInputException(
+        fmt::format("{} is not a valid DOI table", path).c_str());
+  }
+}
+
+DoiTable::~DoiTable() { Unmap(); }
+
+DoiTable::DoiTable(DoiTable&& other) noexcept { *this = std::move(other); }
+
+DoiTable& DoiTable::operator=(DoiTable&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    keys_ = other.keys_;
+    levels_ = other.levels_;
+    fallback_ = other.fallback_;
+    id_bits_ = other.id_bits_;
+    ordinal_bits_ = other.ordinal_bits_;
+    id_prefix_ = other.id_prefix_;
+    level_sizes_ = other.level_sizes_;
+    bits_ = other.bits_;
+    ranks_ = other.ranks_;
+    fallback_keys_ = other.fallback_keys_;
+    fingerprints_ = other.fingerprints_;
+    ids_ = other.ids_;
+    ordinals_ = other.ordinals_;
+  }
+  return *this;
+}
+
+std::optional<uint64_t> DoiTable::Find(std::string_view doi) const {
+  const auto kHash = hash::Bytes128(doi);
+  const auto kSlot = SlotFor(kHash);
+  if (!kSlot || fingerprints_[*kSlot] != Fingerprint(kHash))
+    return std::nullopt;
+  return kSlot;
+}
+
+uint64_t DoiTable::Work(uint64_t slot) const {
+  return Unpack(ordinals_, ordinal_bits_, slot);
+}
+
+std::string DoiTable::OpenAlexId(uint64_t slot) const {
+  return fmt::format("{}{}", id_prefix_, Unpack(ids_, id_bits_, slot));
+}
+
+std::optional<uint64_t> DoiTable::SlotFor(const hash::Hash128& hash) const {
+  uint64_t offset = 0;
+  for (uint64_t level = 0; level < levels_; ++level) {
+    const uint64_t kBit =
+        offset + LevelPosition(hash, level, level_sizes_[level]);
+    if (TestBit(bits_, kBit)) {
+      const uint64_t kWord = kBit / 64;
+      uint64_t rank = ranks_[kWord / kRankWords];
+      for (uint64_t i = kWord - kWord % kRankWords; i < kWord; ++i) {
+        rank += static_cast<uint64_t>(std::popcount(bits_[i]));
+      }
+      const uint64_t kBelow = (uint64_t{1} << (kBit % 64)) - 1;
+      return rank +
+             static_cast<uint64_t>(std::popcount(bits_[kWord] & kBelow));
+    }
+    offset += level_sizes_[level];
+  }
+
+  // Binary search the fallback keys, stored as (low, high) pairs.
+  uint64_t low = 0;
+  uint64_t high = fallback_;
+  while (low < high) {
+    const uint64_t kMiddle = low + (high - low) / 2;
+    const hash::Hash128 kKey = {fallback_keys_[kMiddle * 2],
+                                fallback_keys_[kMiddle * 2 + 1]};
+    if (kKey == hash)
+      return keys_ - fallback_ + kMiddle;
+    if (HashLess(kKey, hash)) {
+      low = kMiddle + 1;
+    } else {
+      high = kMiddle;
+    }
+  }
+  return std::nullopt;
+}
+
+void DoiTable::LoadSections() {
+  binary::Reader reader(
+      std::string_view(reinterpret_cast<const char*>(data_), kHeaderSize));
+  if (reader.Bytes(kMagic.size()) != kMagic)
+    throw exceptions::UserInputException("bad DOI table magic");
+
+  std::vector<uint64_t> fields(kHeaderFields);
+  for (auto& field : fields) {
+    field = reader.Fixed64();
+  }
+  // Counts are bounded by the file size first, so the section sizes
+  // computed from them below cannot overflow.
+  if (fields[kIdBits] == 0 || fields[kIdBits] > 64 ||
+      fields[kOrdinalBits] == 0 || fields[kOrdinalBits] > 64 ||
+      fields[kKeys] > size_ || fields[kFallback] > fields[kKeys] ||
+      fields[kLevels] > kMaxLevels ||
+      fields[kBitWords] > size_ / sizeof(uint64_t)) {
+    throw exceptions::UserInputException("bad DOI table header");
+  }
+
+  keys_ = fields[kKeys];
+  levels_ = fields[kLevels];
+  fallback_ = fields[kFallback];
+  id_bits_ = fields[kIdBits];
+  ordinal_bits_ = fields[kOrdinalBits];
+
+  // Sections follow each other in the order they are written, each
+  // checked to lie within the file after the one before.
+  uint64_t end = kHeaderSize;
+  level_sizes_ = Section(fields[kLevelSizesOffset], levels_, &end);
+  bits_ = Section(fields[kBitsOffset], fields[kBitWords], &end);
+  ranks_ = Section(fields[kRanksOffset],
+                   (fields[kBitWords] + kRankWords - 1) / kRankWords + 1,
+                   &end);
+  fallback_keys_ = Section(fields[kFallbackOffset], fallback_ * 2, &end);
+  fingerprints_ = reinterpret_cast<const uint32_t*>(
+      Section(fields[kFingerprintsOffset], (keys_ + 1) / 2, &end));
+  ids_ = Section(fields[kIdsOffset], PackedWords(keys_, id_bits_), &end);
+  ordinals_ = Section(fields[kOrdinalsOffset],
+                      PackedWords(keys_, ordinal_bits_), &end);
+  if (fields[kPrefixOffset] < end || fields[kPrefixOffset] > size_ ||
+      fields[kPrefixLength] > size_ - fields[kPrefixOffset]) {
+    throw exceptions::UserInputException("bad DOI table section");
+  }
+  id_prefix_ = std::string_view(
+      reinterpret_cast<const char*>(data_ + fields[kPrefixOffset]),
+      fields[kPrefixLength]);
+
+  // Lookups index the level bits by the level sizes and the slots by
+  // the ranks, so both must stay within the sections they point into.
+  uint64_t level_bits = 0;
+  for (uint64_t level = 0; level < levels_; ++level) {
+    const uint64_t kSize = level_sizes_[level];
+    if (kSize == 0 || kSize % 64 != 0 ||
+        kSize > fields[kBitWords] * 64 - level_bits) {
+      throw exceptions::UserInputException("bad DOI table levels");
+    }
+    level_bits += kSize;
+  }
+  const uint64_t kRanks = (fields[kBitWords] + kRankWords - 1) / kRankWords;
+  for (uint64_t i = 0; i < kRanks; ++i) {
+    if (ranks_[i] > ranks_[i + 1])
+      throw exceptions::UserInputException("bad DOI table ranks");
+  }
+  if (ranks_[kRanks] != keys_ - fallback_)
+    throw exceptions::UserInputException("bad DOI table ranks");
+}
+
+const uint64_t* DoiTable::Section(uint64_t offset, uint64_t words,
+                                  // NOLINTNEXTLINE(whitespace/indent_namespace)
+                                  uint64_t* end) const {
+  if (offset % sizeof(uint64_t) != 0 || offset < *end || offset > size_ ||
+      words > (size_ - offset) / sizeof(uint64_t)) {
+    throw exceptions::UserInputException("bad DOI table section");
+  }
+  *end = offset + words * sizeof(uint64_t);
+  return reinterpret_cast<const uint64_t*>(data_ + offset);
+}
+
+void DoiTable::Unmap() {
+  if (data_ != nullptr && size_ > 0)
+    munmap(const_cast<uint8_t*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace wikiopencite::citescoop::cli
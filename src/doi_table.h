@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_DOI_TABLE_H_
+#define SRC_DOI_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "hash.h"
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Read only table from normalized DOI to OpenAlex work, built
+/// once from a works PBF file and memory mapped by every reader.
+///
+/// DOIs are placed by a minimal perfect hash in the style of BBHash:
+/// each level is a bit array twice the size of the keys still to be
+/// placed, a key whose level hash lands on a bit no other key hits
+/// takes that bit, and colliding keys fall through to the next level.
+/// The rank of a key's bit across all levels is its slot. The few keys
+/// left after kMaxLevels are kept in a sorted fallback array. A slot
+/// holds a 32 bit fingerprint of the DOI, so that DOIs absent from the
+/// table are rejected with a false positive rate of 2^-32, and the
+/// OpenAlex id number and works file ordinal in bit packed arrays.
+/// Together this costs about 12 bytes per DOI.
+///
+/// The file is laid out as 64 bit little endian words:
+///
+///     magic | header | level sizes | level bits | ranks | fallback |
+///     fingerprints | ids | ordinals | id prefix
+///
+/// where the header gives the counts, widths and section offsets, so a
+/// reader maps the file and starts answering lookups without parsing.
+class DoiTable {
+ public:
+  /// Magic bytes at the start of a table file.
+  static constexpr std::string_view kMagic = "CSDOIMP1";
+
+  /// Levels before the remaining keys go to the fallback array.
+  static constexpr uint64_t kMaxLevels = 32;
+
+  /// @brief Read a works file and write a table of every work with a
+  /// DOI. Where several works share a DOI the first one is kept.
+  ///
+  /// OpenAlex ids must share a prefix followed by a number, as in
+  /// W2741809807 or https://openalex.org/W2741809807.
+  ///
+  /// @return Number of distinct DOIs in the table.
+  /// @throws exceptions::UserInputException if the file does not hold
+  /// OpenAlex works or an id does not fit the pattern.
+  static uint64_t Build(const std::string& works_path,
+                        const std::string& table_path);
+
+  /// @brief Whether a file starts with the table magic.
+  static bool IsTable(const std::string& path);
+
+  /// @brief Map a table file into memory.
+  /// @throws exceptions::UserInputException if it is not a valid table.
+  explicit DoiTable(const std::string& path);
+
+  ~DoiTable();
+  DoiTable(const DoiTable&) = delete;
+  DoiTable& operator=(const DoiTable&) = delete;
+  DoiTable(DoiTable&& other) noexcept;
+  DoiTable& operator=(DoiTable&& other) noexcept;
+
+  /// @brief The slot of a normalized DOI, see doi::Normalize.
+  [[nodiscard]] std::optional<uint64_t> Find(std::string_view doi) const;
+
+  /// @brief Ordinal in the works file of the work in a slot.
+  [[nodiscard]] uint64_t Work(uint64_t slot) const;
+
+  /// @brief OpenAlex id of the work in a slot.
+  [[nodiscard]] std::string OpenAlexId(uint64_t slot) const;
+
+  /// @brief Number of distinct DOIs held.
+  [[nodiscard]] uint64_t size() const { return keys_; }
+
+  /// @brief Size of the mapped file in bytes.
+  [[nodiscard]] size_t MappedSize() const { return size_; }
+
+ private:
+  DoiTable() = default;
+
+  /// @brief Point the section pointers into the mapped data.
+  void LoadSections();
+
+  /// @brief Slot of a DOI hash, before checking its fingerprint.
+  [[nodiscard]] std::optional<uint64_t> SlotFor(
+      const hash::Hash128& hash) const;
+
+  /// @brief Point at a section of a number of words.
+  /// @param end End of the previous section, which the section must
+  /// not start before. Advanced to the end of this one.
+  /// @throws exceptions::UserInputException if the section does not
+  /// fit in the file.
+  [[nodiscard]] const uint64_t* Section(uint64_t offset, uint64_t words,
+                                        uint64_t* end) const;
+
+  void Unmap();
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+
+  uint64_t keys_ = 0;
+  uint64_t levels_ = 0;
+  uint64_t fallback_ = 0;
+  uint64_t id_bits_ = 0;
+  uint64_t ordinal_bits_ = 0;
+  std::string_view id_prefix_;
+
+  const uint64_t* level_sizes_ = nullptr;
+  const uint64_t* bits_ = nullptr;
+  const uint64_t* ranks_ = nullptr;
+  const uint64_t* fallback_keys_ = nullptr;
+  const uint32_t* fingerprints_ = nullptr;
+  const uint64_t* ids_ = nullptr;
+  const uint64_t* ordinals_ = nullptr;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_DOI_TABLE_H_
@@ -1,15 +1,13 @@
-// SPDX-FileCopyrightText: 2025 The University of St Andrews
+// SPDX-FileCopyrightText: 2025-2026 The University of St Andrews
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "extract.h"
 
-#include <arpa/inet.h>  // NOLINT(misc-include-cleaner)
-
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <filesystem>  // NOLINT(build/c++17)
-#include <fstream>
+#include <future>
 #include <iostream>
-#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -18,28 +16,27 @@
 #include "boost/program_options/parsers.hpp"
 #include "boost/program_options/value_semantic.hpp"
 #include "boost/program_options/variables_map.hpp"
-#include "citescoop/extract.h"
-#include "citescoop/parser.h"
-#include "citescoop/proto/file_header.pb.h"
 #include "spdlog/spdlog.h"
 
 #include "cli.h"
-#include "io.h"
+#include "delta.h"
+#include "exceptions.h"
+#include "extraction.h"
 #include "langmap.h"
+#include "thread_pool.h"
 
 namespace wikiopencite::citescoop::cli::dump {
 
-namespace cs = wikiopencite::citescoop;
-namespace fs = std::filesystem;
 namespace options = boost::program_options;
-namespace proto = wikiopencite::proto;
 
 ExtractCommand::ExtractCommand()
     // NOLINTNEXTLINE(whitespace/indent_namespace)
     : Command("extract", "Extract citations from") {
   // clang-format off
   cli_options_.add_options()
-    ("input,i", options::value<std::string>(), "Input file.")
+    ("input,i", options::value<std::vector<std::string>>()->multitoken(),
+      "Input file. May be given more than once, or as a glob pattern,"
+      " for a dump split into chunks.")
     ("pages,p", options::value<std::string>()->required(),
       "Filename for pages output.")
     ("revisions,r", options::value<std::string>()->required(),
@@ -48,7 +45,19 @@ ExtractCommand::ExtractCommand()
     ("wiki", options::value<std::string>()->required(),
       "Name of wiki being processed. Used to set the language indicator"
       " of the file header.")
-    ("bz2", "The input is compressed using bzip2 compression.");
+    ("bz2", "The input is compressed using bzip2 compression.")
+    ("compress", "Write the payload as zstd compressed blocks.")
+    ("delta", "Store each revision as the citations it adds and removes"
+      " relative to the previous revision of its page.")
+    ("keyframe-interval",
+      options::value<uint32_t>()->default_value(
+        delta::kDefaultKeyframeInterval),
+      "With --delta, revisions from one full revision of a page to the"
+      " next.")
+    ("jobs,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of input chunks to extract at once.");
   // clang-format on
 }
 
@@ -57,151 +66,89 @@ ExitCode ExtractCommand::Run(
     std::vector<std::string> args,
     // NOLINTNEXTLINE(whitespace/indent_namespace)
     struct GlobalOptions /*globals*/) {
-  LoadArgs(args);
-  parser_ = std::make_shared<cs::Parser>(
-      cs::ParserOptions{.ignore_invalid_ident = true});
-  SetExtractor();
-
-  OpenStreams();
-  std::pair<uint64_t, uint64_t> counts;
-  if (args_.stdin) {
-    spdlog::trace("Reading from stdin");
-    counts =
-        extractor_->Extract(std::cin, &streams_.pages, &streams_.revisions);
-  } else {
-    spdlog::trace("Reading from file: {}", args_.input);
-    counts = extractor_->Extract(streams_.input, &streams_.pages,
-                                 &streams_.revisions);
+  try {
+    LoadArgs(args);
+
+    std::vector<std::string> inputs = args_.inputs;
+    if (args_.stdin)
+      inputs = {""};
+    Extraction extraction(std::move(inputs), args_.pages, args_.revisions,
+                          args_.language, args_.options);
+    ExtractChunks(&extraction);
+
+    const auto kCounts = extraction.counts();
+    spdlog::info("Extracted {} pages and {} revisions", kCounts.first,
+                 kCounts.second);
+
+    extraction.WriteOutputs();
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to extract dump: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
   }
 
-  spdlog::info("Extracted {} pages and {} revisions", counts.first,
-               counts.second);
-
-  CloseStreams();
-  AddHeaders(counts);
-
   return ExitCode::kOk;
 }
 
-void ExtractCommand::SetExtractor() {
-  if (args_.bz2) {
-    spdlog::debug("Using bz2 extractor");
-    extractor_ = std::unique_ptr<cs::Extractor>(new cs::Bz2Extractor(parser_));
-  } else {
-    spdlog::debug("Using plain text extractor");
-    extractor_ = std::unique_ptr<cs::Extractor>(new cs::TextExtractor(parser_));
-  }
-}
-
-std::string ExtractCommand::ExtractLangCode(const std::string& input) {
-  const std::string kSuffix = "wiki";
-  auto pos = input.rfind(kSuffix);
-
-  if (pos != std::string::npos && pos == input.size() - kSuffix.size()) {
-    return input.substr(0, pos);
-  }
-
-  return input;
-}
-
 void ExtractCommand::LoadArgs(const std::vector<std::string>& args) {
   auto parsed_args = ParseArgs(args);
 
   args_.stdin = parsed_args.first.contains("stdin");
-  if (!args_.stdin)
-    args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  if (!args_.stdin) {
+    args_.inputs =
+        Extraction::ExpandInputs(EnsureArgument<std::vector<std::string>>(
+            "input", parsed_args.first));
+  } else if (parsed_args.first.contains("input")) {
+    throw exceptions::UserInputException(
+        "stdin cannot be combined with input files");
+  }
 
   args_.pages = EnsureArgument<std::string>("pages", parsed_args.first);
   args_.revisions = EnsureArgument<std::string>("revisions", parsed_args.first);
-  args_.bz2 = parsed_args.first.contains("bz2");
-  args_.language = WikipediaCodeToLanguage(
-      ExtractLangCode(EnsureArgument<std::string>("wiki", parsed_args.first)));
+  args_.options.bz2 = parsed_args.first.contains("bz2");
+  args_.options.compress = parsed_args.first.contains("compress");
+  args_.options.delta = parsed_args.first.contains("delta");
+  args_.options.keyframe_interval =
+      EnsureArgument<uint32_t>("keyframe-interval", parsed_args.first);
+  if (args_.options.keyframe_interval == 0)
+    throw exceptions::UserInputException(
+        "keyframe interval must be at least 1");
+  args_.jobs = EnsureArgument<unsigned>("jobs", parsed_args.first);
+  args_.options.threads = args_.jobs;
+  args_.language = WikipediaCodeToLanguage(Extraction::ExtractLangCode(
+      EnsureArgument<std::string>("wiki", parsed_args.first)));
 
   spdlog::debug(
-      "Parsed arguments: input={}, pages={}, revisions={}, stdin={}, bz2={}, "
-      "language={}",
-      args_.input, args_.pages, args_.revisions, args_.stdin, args_.bz2,
-      static_cast<int>(args_.language));
+      "Parsed arguments: inputs={}, pages={}, revisions={}, stdin={}, "
+      "bz2={}, language={}, jobs={}",
+      args_.inputs.size(), args_.pages, args_.revisions, args_.stdin,
+      args_.options.bz2, static_cast<int>(args_.language), args_.jobs);
 }
 
-void ExtractCommand::OpenStreams() {
-  if (!args_.stdin) {
-    spdlog::debug("Opening input file: {}", args_.input);
-    streams_.input = std::ifstream(args_.input);
+void ExtractCommand::ExtractChunks(Extraction* extraction) const {
+  if (extraction->chunks() == 1) {
+    extraction->ExtractChunk(0);
+    return;
   }
 
-  spdlog::debug("Opening output file: {}", args_.pages);
-  streams_.pages = std::ofstream(
-      args_.pages + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
-
-  spdlog::debug("Opening output file: {}", args_.revisions);
-  streams_.revisions =
-      std::ofstream(args_.revisions + ".tmp",
-                    std::ios::out | std::ios::binary | std::ios::trunc);
-}
-
-void ExtractCommand::CloseStreams() {
-  if (!args_.stdin) {
-    spdlog::trace("Closing input file: {}", args_.input);
-    streams_.input.close();
+  const auto kJobs = static_cast<unsigned>(
+      std::min<size_t>(std::max(args_.jobs, 1U), extraction->chunks()));
+  spdlog::info("Extracting {} chunks, {} at a time", extraction->chunks(),
+               kJobs);
+
+  std::vector<std::future<void>> pending;
+  {
+    ThreadPool pool(kJobs);
+    for (size_t i = 0; i < extraction->chunks(); ++i) {
+      pending.push_back(
+          pool.Submit([extraction, i]() { extraction->ExtractChunk(i); }));
+    }
+  }
+  // The pool has joined, so every chunk is done before an error is
+  // rethrown and the temporary files are removed.
+  for (auto& result : pending) {
+    result.get();
   }
-
-  spdlog::trace("Closing output file: {}", args_.pages);
-  streams_.pages.close();
-
-  spdlog::trace("Closing output file: {}", args_.revisions);
-  streams_.revisions.close();
-}
-
-void ExtractCommand::AddHeaders(std::pair<uint64_t, uint64_t> counts) const {
-  spdlog::debug("Adding headers to output files");
-  spdlog::trace("Opening temporary pages file: {}", args_.pages + ".tmp");
-  std::ifstream tmp_pages(args_.pages + ".tmp");
-
-  spdlog::trace("Opening temporary revisions file: {}",
-                args_.revisions + ".tmp");
-  std::ifstream tmp_revisions(args_.revisions + ".tmp");
-
-  spdlog::trace("Opening final pages file: {}", args_.pages);
-  std::ofstream pages(args_.pages,
-                      std::ios::out | std::ios::binary | std::ios::trunc);
-
-  spdlog::trace("Opening final revisions file: {}", args_.revisions);
-  std::ofstream revisions(args_.revisions,
-                          std::ios::out | std::ios::binary | std::ios::trunc);
-
-  auto header = proto::FileHeader();
-  header.set_count(counts.first);
-  header.set_type(proto::FileType::FILE_TYPE_PAGES);
-  header.mutable_dump_file_attributes()->set_language(args_.language);
-  io::PrependHeader(header, tmp_pages, &pages);
-
-  header.set_count(counts.second);
-  header.set_type(proto::FileType::FILE_TYPE_REVISIONS);
-  io::PrependHeader(header, tmp_revisions, &revisions);
-
-  spdlog::debug("Closing temporary and final files");
-  spdlog::trace("Closing temporary pages file: {}", args_.pages + ".tmp");
-  tmp_pages.close();
-
-  spdlog::trace("Closing temporary revisions file: {}",
-                args_.revisions + ".tmp");
-  tmp_revisions.close();
-
-  spdlog::trace("Closing final pages file: {}", args_.pages);
-  pages.close();
-
-  spdlog::trace("Closing final revisions file: {}", args_.revisions);
-  revisions.close();
-
-  spdlog::debug("Removing temporary files");
-  spdlog::trace("Removing temporary pages file: {}", args_.pages + ".tmp");
-  fs::remove(args_.pages + ".tmp");
-
-  spdlog::trace("Removing temporary revisions file: {}",
-                args_.revisions + ".tmp");
-  fs::remove(args_.revisions + ".tmp");
-
-  spdlog::info("Added headers to output files");
 }
 }  // namespace wikiopencite::citescoop::cli::dump
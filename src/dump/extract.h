@@ -5,61 +5,46 @@
 #define SRC_DUMP_EXTRACT_H_
 
 #include <cstdint>
-#include <fstream>
-#include <ios>
 #include <memory>
 #include <string>
-#include <utility>
 #include <vector>
 
-#include "citescoop/extract.h"
-#include "citescoop/parser.h"
 #include "citescoop/proto/language.pb.h"
 
 #include "cli.h"
+#include "extraction.h"
 
 namespace wikiopencite::citescoop::cli::dump {
 
+/// @brief Command to extract the pages and revisions of a Wikimedia
+/// dump.
+///
+/// Large wikis are published as many chunk files, which may be given
+/// together as several inputs or as glob patterns. Each chunk is
+/// extracted on its own thread, up to --jobs at once, with its own
+/// parser and extractor, see extraction.h.
 class ExtractCommand : public Command {
  public:
   ExtractCommand();
   ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
 
  private:
-  struct Streams {
-    std::ifstream input;
-    std::ofstream pages;
-    std::ofstream revisions;
-  };
-
   struct Args {
-    std::string input;
+    std::vector<std::string> inputs;  ///< Chunk files, globs expanded.
     std::string pages;
     std::string revisions;
     bool stdin;
     wikiopencite::proto::Language language;
-    bool bz2;
+    ExtractionOptions options;
+    unsigned jobs;  ///< Chunks extracted at once.
   };
 
-  void SetExtractor();
-
-  static std::string ExtractLangCode(const std::string& input);
-
   void LoadArgs(const std::vector<std::string>& args);
-  void OpenStreams();
-  void CloseStreams();
-  void AddHeaders(std::pair<uint64_t, uint64_t> counts) const;
 
-  Args args_;
-  Streams streams_;
-  std::shared_ptr<wikiopencite::citescoop::Parser> parser_;
-
-  std::unique_ptr<wikiopencite::citescoop::Extractor> extractor_;
+  /// @brief Extract every chunk, up to jobs at once.
+  void ExtractChunks(Extraction* extraction) const;
 
-  static const std::ios_base::openmode kWriteOpenMode =
-      std::ios::out | std::ios::binary | std::ios::trunc;
-  static const std::ios_base::openmode kReadOpenMode =
-      std::ios::in | std::ios::binary;
+  Args args_;
 };
 
 }  // namespace wikiopencite::citescoop::cli::dump
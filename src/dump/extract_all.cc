@@ -0,0 +1,335 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "extract_all.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/language.pb.h"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "delta.h"
+#include "exceptions.h"
+#include "extraction.h"
+#include "langmap.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::dump {
+
+namespace {
+namespace options = boost::program_options;
+namespace proto = wikiopencite::proto;
+
+constexpr size_t kManifestColumns = 4;
+
+/// @brief Seconds in a duration.
+double Seconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+/// @brief Bytes in MiB.
+double Mib(uint64_t bytes) {
+  constexpr double kMib = 1024.0 * 1024.0;
+  return static_cast<double>(bytes) / kMib;
+}
+
+/// @brief MiB per second, 0 for an empty duration.
+double MibPerSecond(uint64_t bytes, double seconds) {
+  return seconds > 0 ? Mib(bytes) / seconds : 0;
+}
+}  // namespace
+
+ExtractAllCommand::ExtractAllCommand()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("extract-all", "Extract citations from many wikis listed in "
+                             "a manifest") {
+  // clang-format off
+  cli_options_.add_options()
+    ("manifest,m", options::value<std::string>()->required(),
+      "Manifest file. Each line holds a wiki, its input file or glob"
+      " pattern, and its pages and revisions outputs, separated by"
+      " tabs.")
+    ("bz2", "The inputs are compressed using bzip2 compression.")
+    ("compress", "Write the payloads as zstd compressed blocks.")
+    ("delta", "Store each revision as the citations it adds and removes"
+      " relative to the previous revision of its page.")
+    ("keyframe-interval",
+      options::value<uint32_t>()->default_value(
+        delta::kDefaultKeyframeInterval),
+      "With --delta, revisions from one full revision of a page to the"
+      " next.")
+    ("jobs,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of input chunks to extract at once, over all wikis.");
+  // clang-format on
+
+  positional_options_.add("manifest", 1);
+}
+
+ExitCode ExtractAllCommand::Run(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    std::vector<std::string> args,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    struct GlobalOptions /*globals*/) {
+  try {
+    LoadArgs(args);
+    ReadManifest();
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to read manifest: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  const auto kStart = Clock::now();
+  Schedule();
+  PrintSummary(Clock::now() - kStart);
+
+  for (const auto& wiki : wikis_) {
+    if (wiki->error)
+      return ExitCode::kGeneralError;
+  }
+  return ExitCode::kOk;
+}
+
+void ExtractAllCommand::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.manifest = EnsureArgument<std::string>("manifest", parsed_args.first);
+  args_.options.bz2 = parsed_args.first.contains("bz2");
+  args_.options.compress = parsed_args.first.contains("compress");
+  args_.options.delta = parsed_args.first.contains("delta");
+  args_.options.keyframe_interval =
+      EnsureArgument<uint32_t>("keyframe-interval", parsed_args.first);
+  if (args_.options.keyframe_interval == 0)
+    throw exceptions::UserInputException(
+        "keyframe interval must be at least 1");
+  args_.jobs = std::max(EnsureArgument<unsigned>("jobs", parsed_args.first),
+                        1U);
+  // Outputs are compressed on the shared pool, which has a fixed number
+  // of threads, so letting a wiki's outputs keep as many blocks in
+  // flight as there are jobs does not oversubscribe the machine. Most
+  // jobs have finished by the time the largest wikis write theirs.
+  args_.options.threads = args_.jobs;
+
+  spdlog::debug("Parsed arguments: manifest={}, bz2={}, jobs={}",
+                args_.manifest, args_.options.bz2, args_.jobs);
+}
+
+void ExtractAllCommand::ReadManifest() {
+  std::ifstream manifest(args_.manifest);
+  if (!manifest) {
+    throw exceptions::UserInputException(
+        fmt::format("failed to open manifest {}", args_.manifest).c_str());
+  }
+
+  std::set<std::string> names;
+  std::set<std::string> outputs;
+  std::string line;
+  for (size_t number = 1; std::getline(manifest, line); ++number) {
+    if (line.empty() || line.front() == '#')
+      continue;
+
+    std::vector<std::string> columns;
+    std::istringstream row(line);
+    for (std::string column; std::getline(row, column, '\t');) {
+      columns.push_back(column);
+    }
+    if (columns.size() != kManifestColumns) {
+      throw exceptions::UserInputException(
+          fmt::format("line {} of {} has {} columns, expected {}", number,
+                      args_.manifest, columns.size(), kManifestColumns)
+              .c_str());
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+      if (columns[i].empty()) {
+        throw exceptions::UserInputException(
+            fmt::format("column {} of line {} of {} is empty", i + 1, number,
+                        args_.manifest)
+                .c_str());
+      }
+    }
+
+    const auto& name = columns[0];
+    const auto kLanguage =
+        WikipediaCodeToLanguage(Extraction::ExtractLangCode(name));
+    if (kLanguage == proto::Language::LANGUAGE_UNSPECIFIED) {
+      throw exceptions::UserInputException(
+          fmt::format("unknown wiki {} on line {}", name, number).c_str());
+    }
+    if (!names.insert(name).second) {
+      throw exceptions::UserInputException(
+          fmt::format("wiki {} is listed twice", name).c_str());
+    }
+    for (const auto& output : {columns[2], columns[3]}) {
+      if (!outputs.insert(output).second) {
+        throw exceptions::UserInputException(
+            fmt::format("output {} is used twice", output).c_str());
+      }
+    }
+
+    auto wiki = std::make_unique<Wiki>();
+    wiki->name = name;
+    wiki->inputs = Extraction::ExpandInputs({columns[1]});
+    wiki->extraction = std::make_unique<Extraction>(
+        wiki->inputs, columns[2], columns[3], kLanguage, args_.options);
+    wiki->input_size = 0;
+    for (size_t i = 0; i < wiki->extraction->chunks(); ++i) {
+      wiki->input_size += wiki->extraction->InputSize(i);
+    }
+    wiki->remaining = wiki->extraction->chunks();
+    wiki->counts = {0, 0};
+    wikis_.push_back(std::move(wiki));
+  }
+
+  spdlog::info("Read {} wikis from {}", wikis_.size(), args_.manifest);
+}
+
+void ExtractAllCommand::Schedule() {
+  // Largest chunks first, whichever wiki they belong to, so the last
+  // jobs to start are the shortest.
+  struct Job {
+    Wiki* wiki;
+    size_t chunk;
+    uint64_t size;
+  };
+  std::vector<Job> jobs;
+  for (const auto& wiki : wikis_) {
+    for (size_t i = 0; i < wiki->extraction->chunks(); ++i) {
+      jobs.push_back({wiki.get(), i, wiki->extraction->InputSize(i)});
+    }
+  }
+  std::ranges::stable_sort(jobs, [](const Job& lhs, const Job& rhs) {
+    return lhs.size > rhs.size;
+  });
+
+  spdlog::info("Extracting {} chunks of {} wikis, {} at a time", jobs.size(),
+               wikis_.size(), args_.jobs);
+
+  std::vector<std::future<void>> pending;
+  ThreadPool pool(args_.jobs);
+  for (const auto& job : jobs) {
+    pending.push_back(pool.Submit(
+        [this, job]() { RunJob(job.wiki, job.chunk); }));
+  }
+  for (auto& result : pending) {
+    result.get();
+  }
+}
+
+void ExtractAllCommand::RunJob(Wiki* wiki, size_t chunk) {
+  bool skip;
+  {
+    const std::lock_guard<std::mutex> kLock(mutex_);
+    if (!wiki->started)
+      wiki->started = Clock::now();
+    skip = wiki->error.has_value();
+  }
+
+  // Any error is recorded rather than thrown, so one wiki failing
+  // leaves the others running.
+  std::optional<std::string> error;
+  if (!skip) {
+    try {
+      wiki->extraction->ExtractChunk(chunk);
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+  }
+
+  bool last;
+  {
+    const std::lock_guard<std::mutex> kLock(mutex_);
+    if (error && !wiki->error)
+      wiki->error = error;
+    last = --wiki->remaining == 0;
+    if (last)
+      error = wiki->error;
+  }
+  if (!last)
+    return;
+
+  // Every other chunk of the wiki is done, so this job alone touches
+  // its extraction from here on.
+  if (!error) {
+    try {
+      wiki->extraction->WriteOutputs();
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+  }
+  const auto kCounts = wiki->extraction->counts();
+  wiki->extraction.reset();
+
+  const std::lock_guard<std::mutex> kLock(mutex_);
+  wiki->finished = Clock::now();
+  wiki->counts = kCounts;
+  wiki->error = error;
+  if (error) {
+    spdlog::critical("Failed to extract {}: {}", wiki->name, *error);
+  } else {
+    spdlog::info("Extracted {} pages and {} revisions of {} in {:.1f}s",
+                 kCounts.first, kCounts.second, wiki->name,
+                 Seconds(wiki->finished - *wiki->started));
+  }
+}
+
+void ExtractAllCommand::PrintSummary(Clock::duration elapsed) const {
+  std::cout << fmt::format("{:<20} {:>6} {:>12} {:>12} {:>14} {:>10} {:>10}\n",
+                           "Wiki", "Chunks", "Input (MiB)", "Pages",
+                           "Revisions", "Time (s)", "MiB/s");
+
+  uint64_t total_size = 0;
+  std::pair<uint64_t, uint64_t> total_counts{0, 0};
+  size_t failed = 0;
+  for (const auto& wiki : wikis_) {
+    const double kSeconds = Seconds(wiki->finished - *wiki->started);
+    std::cout << fmt::format(
+        "{:<20} {:>6} {:>12.1f} {:>12} {:>14} {:>10.1f} {:>10.1f}", wiki->name,
+        wiki->inputs.size(), Mib(wiki->input_size), wiki->counts.first,
+        wiki->counts.second, kSeconds,
+        MibPerSecond(wiki->input_size, kSeconds));
+    if (wiki->error) {
+      std::cout << "  failed: " << *wiki->error;
+      failed++;
+    }
+    std::cout << '\n';
+
+    total_size += wiki->input_size;
+    total_counts.first += wiki->counts.first;
+    total_counts.second += wiki->counts.second;
+  }
+
+  const double kSeconds = Seconds(elapsed);
+  std::cout << fmt::format(
+      "{:<20} {:>6} {:>12.1f} {:>12} {:>14} {:>10.1f} {:>10.1f}\n", "Total",
+      "", Mib(total_size), total_counts.first, total_counts.second,
+      kSeconds, MibPerSecond(total_size, kSeconds));
+  if (failed > 0)
+    std::cout << fmt::format("{} of {} wikis failed\n", failed, wikis_.size());
+}
+
+}  // namespace wikiopencite::citescoop::cli::dump
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_DUMP_EXTRACT_ALL_H_
+#define SRC_DUMP_EXTRACT_ALL_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cli.h"
+#include "extraction.h"
+
+namespace wikiopencite::citescoop::cli::dump {
+
+/// @brief Command to extract many wikis in one process, from a
+/// manifest listing each wiki with its input and outputs.
+///
+/// Every chunk of every wiki is a job on one pool of --jobs threads.
+/// Chunks are scheduled largest first whichever wiki they belong to, so
+/// the last to start are the shortest and the threads stay busy until
+/// the run ends. A wiki's outputs are written by whichever job finishes
+/// its last chunk. A wiki that fails does not stop the others.
+class ExtractAllCommand : public Command {
+ public:
+  ExtractAllCommand();
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Args {
+    std::string manifest;       ///< Manifest file path.
+    ExtractionOptions options;  ///< Options shared by every wiki.
+    unsigned jobs;              ///< Chunks extracted at once.
+  };
+
+  /// @brief A manifest row and the progress of its extraction.
+  struct Wiki {
+    std::string name;
+    std::vector<std::string> inputs;  ///< Chunk files, globs expanded.
+    uint64_t input_size;              ///< Bytes over all chunks.
+    std::unique_ptr<Extraction> extraction;
+    size_t remaining;                 ///< Chunks not yet done.
+    std::optional<Clock::time_point> started;
+    Clock::time_point finished;
+    std::pair<uint64_t, uint64_t> counts;  ///< Pages and revisions.
+    std::optional<std::string> error;
+  };
+
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Read the manifest, one tab separated row of wiki, input,
+  /// pages output and revisions output per line. The input may be a
+  /// glob pattern. Blank lines and lines starting with # are skipped.
+  /// @throws exceptions::UserInputException for a malformed row or an
+  /// empty column, a wiki whose language is unknown or outputs used
+  /// twice.
+  void ReadManifest();
+
+  /// @brief Run every chunk of every wiki on the shared pool.
+  void Schedule();
+
+  /// @brief Extract one chunk, writing the outputs of its wiki if it
+  /// is the last.
+  void RunJob(Wiki* wiki, size_t chunk);
+
+  /// @brief Print the throughput of each wiki and of the whole run.
+  void PrintSummary(Clock::duration elapsed) const;
+
+  Args args_;
+  std::vector<std::unique_ptr<Wiki>> wikis_;
+  std::mutex mutex_;  ///< Guards the progress fields of wikis_.
+};
+
+}  // namespace wikiopencite::citescoop::cli::dump
+
+#endif  // SRC_DUMP_EXTRACT_ALL_H_
@@ -0,0 +1,290 @@
+// SPDX-FileCopyrightText: 2025-2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "extraction.h"
+
+#include <glob.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "citescoop/extract.h"
+#include "citescoop/io.h"
+#include "citescoop/parser.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/revision.pb.h"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "container.h"
+#include "delta.h"
+#include "exceptions.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::dump {
+
+namespace cs = wikiopencite::citescoop;
+namespace fs = std::filesystem;
+namespace proto = wikiopencite::proto;
+
+namespace {
+bool IsDigit(char chr) { return chr >= '0' && chr <= '9'; }
+
+/// @brief Order paths comparing runs of digits by their numeric value,
+/// so pages-meta-history2 comes before pages-meta-history10.
+bool NaturalLess(std::string_view lhs, std::string_view rhs) {
+  size_t i = 0;
+  size_t j = 0;
+  while (i < lhs.size() && j < rhs.size()) {
+    if (!IsDigit(lhs[i]) || !IsDigit(rhs[j])) {
+      if (lhs[i] != rhs[j])
+        return lhs[i] < rhs[j];
+      i++;
+      j++;
+      continue;
+    }
+
+    // Compare the runs without leading zeros, first by length.
+    while (i < lhs.size() && lhs[i] == '0')
+      i++;
+    while (j < rhs.size() && rhs[j] == '0')
+      j++;
+    const size_t kLhsStart = i;
+    const size_t kRhsStart = j;
+    while (i < lhs.size() && IsDigit(lhs[i]))
+      i++;
+    while (j < rhs.size() && IsDigit(rhs[j]))
+      j++;
+    const auto kLhsRun = lhs.substr(kLhsStart, i - kLhsStart);
+    const auto kRhsRun = rhs.substr(kRhsStart, j - kRhsStart);
+    if (kLhsRun.size() != kRhsRun.size())
+      return kLhsRun.size() < kRhsRun.size();
+    if (kLhsRun != kRhsRun)
+      return kLhsRun < kRhsRun;
+  }
+  if (lhs.size() - i != rhs.size() - j)
+    return lhs.size() - i < rhs.size() - j;
+
+  // Equal up to leading zeros, so fall back to plain order.
+  return lhs < rhs;
+}
+}  // namespace
+
+Extraction::Extraction(std::vector<std::string> inputs, std::string pages,
+                       // NOLINTNEXTLINE(whitespace/indent_namespace)
+                       std::string revisions, proto::Language language,
+                       // NOLINTNEXTLINE(whitespace/indent_namespace)
+                       ExtractionOptions options)
+    : pages_(std::move(pages)),
+      revisions_(std::move(revisions)),
+      language_(language),
+      options_(options) {
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    chunks_.push_back({.input = std::move(inputs[i]),
+                       .pages = fmt::format("{}.{}.tmp", pages_, i),
+                       .revisions = fmt::format("{}.{}.tmp", revisions_, i),
+                       .counts = {0, 0}});
+  }
+}
+
+Extraction::~Extraction() { RemoveTempFiles(); }
+
+uint64_t Extraction::InputSize(size_t chunk) const {
+  if (chunks_[chunk].input.empty())
+    return 0;
+  std::error_code error;
+  const auto kSize = fs::file_size(chunks_[chunk].input, error);
+  return error ? 0 : kSize;
+}
+
+void Extraction::ExtractChunk(size_t chunk) {
+  auto& current = chunks_[chunk];
+  auto extractor = NewExtractor();
+
+  spdlog::debug("Opening output files: {}, {}", current.pages,
+                current.revisions);
+  std::ofstream pages(current.pages, kWriteOpenMode);
+  std::ofstream revisions(current.revisions, kWriteOpenMode);
+
+  if (current.input.empty()) {
+    spdlog::trace("Reading from stdin");
+    current.counts = extractor->Extract(std::cin, &pages, &revisions);
+  } else {
+    spdlog::trace("Reading from file: {}", current.input);
+    std::ifstream input(current.input, kReadOpenMode);
+    if (!input) {
+      throw exceptions::UserInputException(
+          fmt::format("failed to open input file {}", current.input)
+              .c_str());
+    }
+    current.counts = extractor->Extract(input, &pages, &revisions);
+  }
+
+  pages.close();
+  revisions.close();
+  if (!pages || !revisions) {
+    throw exceptions::CliException(
+        fmt::format("failed to write extract of {}", current.input).c_str());
+  }
+
+  if (options_.delta)
+    EncodeRevisions(current);
+
+  spdlog::info("Extracted {} pages and {} revisions from {}",
+               current.counts.first, current.counts.second,
+               current.input.empty() ? "stdin" : current.input);
+}
+
+std::pair<uint64_t, uint64_t> Extraction::counts() const {
+  std::pair<uint64_t, uint64_t> counts{0, 0};
+  for (const auto& chunk : chunks_) {
+    counts.first += chunk.counts.first;
+    counts.second += chunk.counts.second;
+  }
+  return counts;
+}
+
+void Extraction::WriteOutputs() {
+  spdlog::debug("Adding headers to output files");
+  const auto kCounts = counts();
+  std::vector<std::string> pages;
+  std::vector<std::string> revisions;
+  for (const auto& chunk : chunks_) {
+    pages.push_back(chunk.pages);
+    revisions.push_back(chunk.revisions);
+  }
+
+  auto header = proto::FileHeader();
+  header.set_count(kCounts.first);
+  header.set_type(proto::FileType::FILE_TYPE_PAGES);
+  header.mutable_dump_file_attributes()->set_language(language_);
+  if (options_.compress)
+    container::MarkCompressed(&header);
+  WriteOutput(pages_, header, pages);
+
+  header.set_count(kCounts.second);
+  header.set_type(proto::FileType::FILE_TYPE_REVISIONS);
+  if (options_.delta)
+    delta::MarkEncoded(&header);
+  WriteOutput(revisions_, header, revisions);
+
+  RemoveTempFiles();
+  spdlog::info("Added headers to {} and {}", pages_, revisions_);
+}
+
+std::vector<std::string> Extraction::ExpandInputs(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::vector<std::string>& inputs) {
+  std::vector<std::string> expanded;
+  for (const auto& input : inputs) {
+    if (input.find_first_of("*?[") == std::string::npos) {
+      expanded.push_back(input);
+      continue;
+    }
+
+    // Matches are sorted by the numbers in their names, which keeps
+    // chunks named pages-meta-history2.xml-p1p812 and so on in dump
+    // order, where glob's own sort would put history10 before history2.
+    glob_t matches{};
+    const int kResult = glob(input.c_str(), GLOB_NOSORT, nullptr, &matches);
+    std::vector<std::string> paths;
+    if (kResult == 0) {
+      paths.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    }
+    globfree(&matches);
+    if (kResult != 0) {
+      throw exceptions::UserInputException(
+          fmt::format("no input files match {}", input).c_str());
+    }
+
+    std::sort(paths.begin(), paths.end(), NaturalLess);
+    expanded.insert(expanded.end(), std::make_move_iterator(paths.begin()),
+                    std::make_move_iterator(paths.end()));
+  }
+  return expanded;
+}
+
+std::string Extraction::ExtractLangCode(const std::string& wiki) {
+  const std::string kSuffix = "wiki";
+  auto pos = wiki.rfind(kSuffix);
+
+  if (pos != std::string::npos && pos == wiki.size() - kSuffix.size()) {
+    return wiki.substr(0, pos);
+  }
+
+  return wiki;
+}
+
+std::unique_ptr<cs::Extractor> Extraction::NewExtractor() const {
+  auto parser = std::make_shared<cs::Parser>(
+      cs::ParserOptions{.ignore_invalid_ident = true});
+
+  if (options_.bz2) {
+    spdlog::debug("Using bz2 extractor");
+    return std::unique_ptr<cs::Extractor>(new cs::Bz2Extractor(parser));
+  }
+  spdlog::debug("Using plain text extractor");
+  return std::unique_ptr<cs::Extractor>(new cs::TextExtractor(parser));
+}
+
+void Extraction::WriteOutput(const std::string& path,
+                             // NOLINTNEXTLINE(whitespace/indent_namespace)
+                             const proto::FileHeader& header,
+                             // NOLINTNEXTLINE(whitespace/indent_namespace)
+                             const std::vector<std::string>& parts) const {
+  spdlog::trace("Opening final file: {}", path);
+  io::PbfWriter output(path, header, options_.threads);
+  for (const auto& part : parts) {
+    spdlog::trace("Copying temporary file: {}", part);
+    std::ifstream input(part, kReadOpenMode);
+    // An empty chunk would leave operator<< with nothing to copy and
+    // set failbit on the payload.
+    if (input.peek() != std::ifstream::traits_type::eof())
+      *output.payload() << input.rdbuf();
+  }
+  output.Close();
+}
+
+void Extraction::EncodeRevisions(const Chunk& chunk) const {
+  const std::string kPath = chunk.revisions + ".delta";
+  spdlog::debug("Delta encoding revisions into {}", kPath);
+
+  std::ifstream revisions(chunk.revisions, kReadOpenMode);
+  std::ofstream encoded(kPath, kWriteOpenMode);
+  delta::RevisionEncoder encoder(&encoded, options_.keyframe_interval);
+  cs::MessageReader reader(&revisions);
+  for (uint64_t i = 0; i < chunk.counts.second; ++i) {
+    encoder.Write(*reader.ReadMessage<proto::Revision>());
+  }
+  encoded.close();
+  if (!encoded)
+    throw exceptions::CliException("failed to write delta encoded revisions");
+
+  spdlog::debug("Delta encoded revisions into {} keyframes and {} deltas",
+                encoder.keyframes(), encoder.deltas());
+
+  revisions.close();
+  fs::rename(kPath, chunk.revisions);
+}
+
+void Extraction::RemoveTempFiles() const {
+  spdlog::debug("Removing temporary files");
+  std::error_code error;
+  for (const auto& chunk : chunks_) {
+    fs::remove(chunk.pages, error);
+    fs::remove(chunk.revisions, error);
+    fs::remove(chunk.revisions + ".delta", error);
+  }
+}
+}  // namespace wikiopencite::citescoop::cli::dump
@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_DUMP_EXTRACTION_H_
+#define SRC_DUMP_EXTRACTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "citescoop/extract.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/language.pb.h"
+
+#include "delta.h"
+
+namespace wikiopencite::citescoop::cli::dump {
+
+/// @brief How an extraction reads its inputs and writes its outputs.
+struct ExtractionOptions {
+  bool bz2 = false;       ///< The inputs are bzip2 compressed.
+  bool compress = false;  ///< Block compress the outputs.
+  bool delta = false;     ///< Delta encode the revisions.
+  /// Revisions between keyframes.
+  uint32_t keyframe_interval = delta::kDefaultKeyframeInterval;
+  unsigned threads = 1;  ///< Compression threads for the outputs.
+};
+
+/// @brief Extraction of one wiki, whose dump may be split into chunks,
+/// into a pages and a revisions file.
+///
+/// Each chunk is extracted with its own parser and extractor into
+/// temporary files, so distinct chunks may be extracted on separate
+/// threads. WriteOutputs then copies these in input order behind one
+/// header per output. Temporary files left behind are removed when the
+/// extraction is destroyed.
+class Extraction {
+ public:
+  /// @param inputs Chunk files in dump order. An empty path reads stdin.
+  /// @param pages Pages output path.
+  /// @param revisions Revisions output path.
+  /// @param language Language set in the output headers.
+  /// @param options Input and output options.
+  Extraction(std::vector<std::string> inputs, std::string pages,
+             std::string revisions, wikiopencite::proto::Language language,
+             ExtractionOptions options);
+  ~Extraction();
+
+  Extraction(const Extraction&) = delete;
+  Extraction& operator=(const Extraction&) = delete;
+
+  [[nodiscard]] size_t chunks() const { return chunks_.size(); }
+
+  /// @brief Size of the input of a chunk in bytes, 0 for stdin.
+  [[nodiscard]] uint64_t InputSize(size_t chunk) const;
+
+  /// @brief Extract one chunk into its temporary files. Distinct chunks
+  /// may be extracted concurrently.
+  /// @throws exceptions::CliException if the chunk cannot be read or
+  /// its output written.
+  void ExtractChunk(size_t chunk);
+
+  /// @brief Total pages and revisions of the chunks extracted so far.
+  [[nodiscard]] std::pair<uint64_t, uint64_t> counts() const;
+
+  /// @brief Write the final files once every chunk is extracted.
+  void WriteOutputs();
+
+  /// @brief Expand the glob patterns among some inputs, each into its
+  /// matches in natural order, comparing runs of digits as numbers.
+  /// @throws exceptions::UserInputException if a pattern matches
+  /// nothing.
+  static std::vector<std::string> ExpandInputs(
+      const std::vector<std::string>& inputs);
+
+  /// @brief Language code of a wiki name such as enwiki.
+  static std::string ExtractLangCode(const std::string& wiki);
+
+ private:
+  /// @brief One input and the temporary files it is extracted into.
+  struct Chunk {
+    std::string input;      ///< Input path, empty for stdin.
+    std::string pages;      ///< Temporary pages payload.
+    std::string revisions;  ///< Temporary revisions payload.
+    std::pair<uint64_t, uint64_t> counts;  ///< Pages and revisions.
+  };
+
+  [[nodiscard]] std::unique_ptr<wikiopencite::citescoop::Extractor>
+  NewExtractor() const;
+
+  /// @brief Copy temporary payloads into a PBF file.
+  void WriteOutput(const std::string& path,
+                   const wikiopencite::proto::FileHeader& header,
+                   const std::vector<std::string>& parts) const;
+
+  /// @brief Delta encode the revisions of a chunk, replacing its
+  /// temporary file. See delta.h.
+  void EncodeRevisions(const Chunk& chunk) const;
+
+  void RemoveTempFiles() const;
+
+  std::vector<Chunk> chunks_;
+  std::string pages_;
+  std::string revisions_;
+  wikiopencite::proto::Language language_;
+  ExtractionOptions options_;
+
+  static const std::ios_base::openmode kWriteOpenMode =
+      std::ios::out | std::ios::binary | std::ios::trunc;
+  static const std::ios_base::openmode kReadOpenMode =
+      std::ios::in | std::ios::binary;
+};
+
+}  // namespace wikiopencite::citescoop::cli::dump
+
+#endif  // SRC_DUMP_EXTRACTION_H_
@@ -9,6 +9,7 @@
 #include "cli.h"
 // #include "combine.h"
 #include "extract.h"
+#include "extract_all.h"
 
 // #include "meta.h"
 
@@ -19,6 +20,7 @@ std::unique_ptr<Topic> NewDumpTopic() {
       "dump", "Process and inspect Wikimedia dump files");
 
   topic->Register(std::shared_ptr<Command>(new ExtractCommand()));
+  topic->Register(std::shared_ptr<Command>(new ExtractAllCommand()));
   return topic;
 }
 }  // namespace wikiopencite::citescoop::cli::dump
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "field_sizes.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+
+#include "binary.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace pb = google::protobuf;
+}  // namespace
+
+FieldSizes::FieldSizes(const pb::Descriptor* descriptor)
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : descriptor_(descriptor) {}
+
+void FieldSizes::Add(std::string_view serialized) {
+  root_.bytes += serialized.size();
+  root_.count++;
+  Walk(serialized, descriptor_, &root_);
+}
+
+void FieldSizes::Merge(const FieldSizes& other) {
+  root_.Merge(other.root_);
+}
+
+void FieldSizes::Node::Merge(const Node& other) {
+  bytes += other.bytes;
+  count += other.count;
+  for (const auto& [number, field] : other.fields) {
+    fields[number].Merge(field);
+  }
+}
+
+std::vector<FieldSizes::Row> FieldSizes::Rows() const {
+  std::vector<Row> rows;
+  Flatten(root_, descriptor_, "", &rows);
+  std::sort(rows.begin(), rows.end(), [](const Row& lhs, const Row& rhs) {
+    if (lhs.bytes != rhs.bytes)
+      return lhs.bytes > rhs.bytes;
+    return lhs.path < rhs.path;
+  });
+  return rows;
+}
+
+void FieldSizes::Walk(std::string_view data, const pb::Descriptor* descriptor,
+                      // NOLINTNEXTLINE(whitespace/indent_namespace)
+                      Node* node) {
+  binary::Reader reader(data);
+  while (!reader.empty()) {
+    const size_t kStart = reader.position();
+    const uint64_t kTag = reader.Varint();
+    const auto kNumber = static_cast<uint32_t>(kTag >> binary::kTagTypeBits);
+    const auto kType = static_cast<uint32_t>(kTag & binary::kTagTypeMask);
+    Node& field = node->fields[kNumber];
+
+    // Only nested messages are descended into, everything else is
+    // measured by skipping over it.
+    const pb::FieldDescriptor* kField =
+        descriptor == nullptr ? nullptr
+                              : descriptor->FindFieldByNumber(
+                                    static_cast<int>(kNumber));
+    if (kType == binary::kLengthDelimited && kField != nullptr &&
+        kField->type() == pb::FieldDescriptor::TYPE_MESSAGE) {
+      Walk(reader.String(), kField->message_type(), &field);
+    } else {
+      binary::SkipWireValue(&reader, kNumber, kType);
+    }
+
+    field.bytes += reader.position() - kStart;
+    field.count++;
+  }
+}
+
+void FieldSizes::Flatten(const Node& node, const pb::Descriptor* descriptor,
+                         const std::string& prefix,
+                         // NOLINTNEXTLINE(whitespace/indent_namespace)
+                         std::vector<Row>* rows) {
+  for (const auto& [number, field] : node.fields) {
+    const pb::FieldDescriptor* kField =
+        descriptor == nullptr ? nullptr
+                              : descriptor->FindFieldByNumber(
+                                    static_cast<int>(number));
+    const std::string kName =
+        kField == nullptr ? fmt::format("#{}", number) : kField->name();
+    const std::string kPath = prefix.empty() ? kName : prefix + "." + kName;
+
+    rows->push_back({kPath, field.bytes, field.count});
+    Flatten(field,
+            kField != nullptr &&
+                    kField->type() == pb::FieldDescriptor::TYPE_MESSAGE
+                ? kField->message_type()
+                : nullptr,
+            kPath, rows);
+  }
+}
+
+}  // namespace wikiopencite::citescoop::cli
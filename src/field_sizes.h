@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_FIELD_SIZES_H_
+#define SRC_FIELD_SIZES_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Bytes taken by each field path of serialized messages,
+/// found by walking their wire format rather than decoding them.
+///
+/// A field's bytes include its tags and length prefixes, so the bytes
+/// of the top level fields of a message add up to its serialized size
+/// and a nested message's bytes include those of its own fields.
+/// Instances can be merged, allowing one per thread.
+class FieldSizes {
+ public:
+  /// @brief Bytes and occurrences of one field path.
+  struct Row {
+    std::string path;  ///< Dotted path, #N for fields the type lacks.
+    uint64_t bytes;
+    uint64_t count;
+  };
+
+  explicit FieldSizes(const google::protobuf::Descriptor* descriptor);
+
+  /// @brief Account for one serialized message.
+  /// @throws exceptions::UserInputException if it is malformed.
+  void Add(std::string_view serialized);
+
+  void Merge(const FieldSizes& other);
+
+  /// @brief Every field path seen, largest first.
+  [[nodiscard]] std::vector<Row> Rows() const;
+
+ private:
+  struct Node {
+    uint64_t bytes = 0;
+    uint64_t count = 0;
+    std::map<uint32_t, Node> fields;
+
+    void Merge(const Node& other);
+  };
+
+  static void Walk(std::string_view data,
+                   const google::protobuf::Descriptor* descriptor,
+                   Node* node);
+
+  static void Flatten(const Node& node,
+                      const google::protobuf::Descriptor* descriptor,
+                      const std::string& prefix, std::vector<Row>* rows);
+
+  const google::protobuf::Descriptor* descriptor_;
+  Node root_;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_FIELD_SIZES_H_
@@ -0,0 +1,377 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "fields.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "boost/algorithm/string/split.hpp"
+#include "boost/algorithm/string/trim.hpp"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#include "exceptions.h"
+
+namespace wikiopencite::citescoop::cli::fields {
+
+namespace {
+namespace pb = google::protobuf;
+
+const char* const kTimestampType = "google.protobuf.Timestamp";
+
+bool IsTimestamp(const pb::FieldDescriptor* field) {
+  return field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE &&
+         field->message_type()->full_name() == kTimestampType;
+}
+
+int64_t TimestampSeconds(const pb::Message& timestamp) {
+  const auto* seconds = timestamp.GetDescriptor()->FindFieldByName("seconds");
+  return timestamp.GetReflection()->GetInt64(timestamp, seconds);
+}
+
+/// Read a singular (index < 0) or repeated element as a Value.
+Value ReadValue(const pb::Message& message, const pb::FieldDescriptor* field,
+                int index) {
+  const auto* reflection = message.GetReflection();
+  const bool kRepeated = index >= 0;
+
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+      return static_cast<int64_t>(
+          kRepeated ? reflection->GetRepeatedInt32(message, field, index)
+                    : reflection->GetInt32(message, field));
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<int64_t>(
+          kRepeated ? reflection->GetRepeatedInt64(message, field, index)
+                    : reflection->GetInt64(message, field));
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+      return static_cast<uint64_t>(
+          kRepeated ? reflection->GetRepeatedUInt32(message, field, index)
+                    : reflection->GetUInt32(message, field));
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      return static_cast<uint64_t>(
+          kRepeated ? reflection->GetRepeatedUInt64(message, field, index)
+                    : reflection->GetUInt64(message, field));
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+      return kRepeated ? reflection->GetRepeatedDouble(message, field, index)
+                       : reflection->GetDouble(message, field);
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+      return static_cast<double>(
+          kRepeated ? reflection->GetRepeatedFloat(message, field, index)
+                    : reflection->GetFloat(message, field));
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      return kRepeated ? reflection->GetRepeatedBool(message, field, index)
+                       : reflection->GetBool(message, field);
+    case pb::FieldDescriptor::CPPTYPE_ENUM:
+      return static_cast<int64_t>(
+          kRepeated ? reflection->GetRepeatedEnumValue(message, field, index)
+                    : reflection->GetEnumValue(message, field));
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      return kRepeated ? reflection->GetRepeatedString(message, field, index)
+                       : reflection->GetString(message, field);
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE: {
+      const auto& nested =
+          kRepeated ? reflection->GetRepeatedMessage(message, field, index)
+                    : reflection->GetMessage(message, field);
+      if (IsTimestamp(field))
+        return TimestampSeconds(nested);
+      return nested.SerializeAsString();
+    }
+  }
+  return std::monostate();
+}
+
+/// Rank used to order values of different kinds.
+int KindRank(const Value& value) {
+  if (std::holds_alternative<std::monostate>(value))
+    return 0;
+  if (std::holds_alternative<std::string>(value))
+    return 2;
+  return 1;
+}
+
+/// Numeric view of a non-string value, split so that the full range of
+/// both int64 and uint64 is ordered correctly.
+struct Numeric {
+  bool negative;
+  uint64_t magnitude;
+  double real;
+  bool is_real;
+};
+
+Numeric ToNumeric(const Value& value) {
+  return std::visit(
+      [](const auto& inner) -> Numeric {
+        using T = std::decay_t<decltype(inner)>;
+        if constexpr (std::is_same_v<T, int64_t>) {
+          return {.negative = inner < 0,
+                  .magnitude = inner < 0 ? 0 - static_cast<uint64_t>(inner)
+                                         : static_cast<uint64_t>(inner),
+                  .real = static_cast<double>(inner),
+                  .is_real = false};
+        } else if constexpr (std::is_same_v<T, uint64_t>) {
+          return {.negative = false,
+                  .magnitude = inner,
+                  .real = static_cast<double>(inner),
+                  .is_real = false};
+        } else if constexpr (std::is_same_v<T, double>) {
+          return {.negative = inner < 0,
+                  .magnitude = 0,
+                  .real = inner,
+                  .is_real = true};
+        } else if constexpr (std::is_same_v<T, bool>) {
+          return {.negative = false,
+                  .magnitude = inner ? 1U : 0U,
+                  .real = inner ? 1.0 : 0.0,
+                  .is_real = false};
+        } else {
+          return {
+              .negative = false, .magnitude = 0, .real = 0, .is_real = false};
+        }
+      },
+      value);
+}
+
+int CompareNumeric(const Numeric& lhs, const Numeric& rhs) {
+  if (lhs.is_real || rhs.is_real) {
+    if (lhs.real < rhs.real)
+      return -1;
+    return lhs.real > rhs.real ? 1 : 0;
+  }
+
+  if (lhs.negative != rhs.negative)
+    return lhs.negative ? -1 : 1;
+
+  int order = 0;
+  if (lhs.magnitude < rhs.magnitude) {
+    order = -1;
+  } else if (lhs.magnitude > rhs.magnitude) {
+    order = 1;
+  }
+  return lhs.negative ? -order : order;
+}
+}  // namespace
+
+std::string ToString(const Value& value) {
+  return std::visit(
+      [](const auto& inner) -> std::string {
+        using T = std::decay_t<decltype(inner)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return "";
+        } else if constexpr (std::is_same_v<T, std::string>) {
+          return inner;
+        } else if constexpr (std::is_same_v<T, bool>) {
+          return inner ? "true" : "false";
+        } else {
+          return fmt::format("{}", inner);
+        }
+      },
+      value);
+}
+
+int Compare(const Value& lhs, const Value& rhs) {
+  const int kLhsRank = KindRank(lhs);
+  const int kRhsRank = KindRank(rhs);
+  if (kLhsRank != kRhsRank)
+    return kLhsRank < kRhsRank ? -1 : 1;
+
+  if (kLhsRank == 0)
+    return 0;
+
+  if (kLhsRank == 2)
+    return std::get<std::string>(lhs).compare(std::get<std::string>(rhs));
+
+  return CompareNumeric(ToNumeric(lhs), ToNumeric(rhs));
+}
+
+FieldPath FieldPath::Parse(const pb::Descriptor* descriptor,
+                           // NOLINTNEXTLINE(whitespace/indent_namespace)
+                           const std::string& path) {
+  std::vector<std::string> names;
+  boost::algorithm::split(names, path, [](char chr) { return chr == '.'; });
+
+  FieldPath result;
+  result.path_ = path;
+
+  const pb::Descriptor* current = descriptor;
+  for (const auto& name : names) {
+    if (current == nullptr) {
+      throw exceptions::UserInputException(
+          fmt::format("field path {} descends into scalar field", path)
+              .c_str());
+    }
+
+    const auto* field = current->FindFieldByName(name);
+    if (field == nullptr) {
+      throw exceptions::UserInputException(
+          fmt::format("message {} has no field {}", current->full_name(), name)
+              .c_str());
+    }
+
+    result.fields_.push_back(field);
+    result.repeated_ = result.repeated_ || field->is_repeated();
+    current = field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE &&
+                      !IsTimestamp(field)
+                  ? field->message_type()
+                  : nullptr;
+  }
+
+  return result;
+}
+
+std::optional<FieldPath> FieldPath::Find(const pb::Descriptor* descriptor,
+                                         // NOLINTNEXTLINE
+                                         const std::string& path) {
+  try {
+    return Parse(descriptor, path);
+  } catch (const exceptions::UserInputException&) {
+    return std::nullopt;
+  }
+}
+
+void FieldPath::Visit(const pb::Message& message,
+                      // NOLINTNEXTLINE(whitespace/indent_namespace)
+                      const std::function<void(const Value&)>& visitor) const {
+  VisitFrom(message, 0, visitor);
+}
+
+void FieldPath::VisitFrom(
+    const pb::Message& message, size_t depth,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::function<void(const Value&)>& visitor) const {
+  const auto* field = fields_[depth];
+  const auto* reflection = message.GetReflection();
+  const bool kLast = depth + 1 == fields_.size();
+
+  if (field->is_repeated()) {
+    const int kSize = reflection->FieldSize(message, field);
+    for (int i = 0; i < kSize; ++i) {
+      if (kLast) {
+        visitor(ReadValue(message, field, i));
+      } else {
+        VisitFrom(reflection->GetRepeatedMessage(message, field, i), depth + 1,
+                  visitor);
+      }
+    }
+    return;
+  }
+
+  const bool kIsMessage =
+      field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE;
+  if (kIsMessage && !reflection->HasField(message, field))
+    return;
+
+  if (kLast) {
+    visitor(ReadValue(message, field, -1));
+  } else {
+    VisitFrom(reflection->GetMessage(message, field), depth + 1, visitor);
+  }
+}
+
+void FieldPath::VisitParents(
+    const pb::Message& message,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::function<void(const pb::Message&)>& visitor) const {
+  VisitParentsFrom(message, 0, visitor);
+}
+
+void FieldPath::VisitParentsFrom(
+    const pb::Message& message, size_t depth,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::function<void(const pb::Message&)>& visitor) const {
+  if (depth + 1 == fields_.size()) {
+    visitor(message);
+    return;
+  }
+
+  const auto* field = fields_[depth];
+  const auto* reflection = message.GetReflection();
+  if (field->is_repeated()) {
+    const int kSize = reflection->FieldSize(message, field);
+    for (int i = 0; i < kSize; ++i) {
+      VisitParentsFrom(reflection->GetRepeatedMessage(message, field, i),
+                       depth + 1, visitor);
+    }
+  } else if (reflection->HasField(message, field)) {
+    VisitParentsFrom(reflection->GetMessage(message, field), depth + 1,
+                     visitor);
+  }
+}
+
+std::vector<Value> FieldPath::Values(const pb::Message& message) const {
+  std::vector<Value> values;
+  Visit(message, [&values](const Value& value) { values.push_back(value); });
+  return values;
+}
+
+Value FieldPath::First(const pb::Message& message) const {
+  if (!repeated_) {
+    Value value;
+    Visit(message, [&value](const Value& found) { value = found; });
+    return value;
+  }
+
+  auto values = Values(message);
+  if (values.empty())
+    return std::monostate();
+  return values.front();
+}
+
+size_t FieldPath::Count(const pb::Message& message) const {
+  const pb::Message* current = &message;
+  // Walk singular prefixes directly, fan out only where needed.
+  for (size_t depth = 0; depth < fields_.size(); ++depth) {
+    const auto* field = fields_[depth];
+    const auto* reflection = current->GetReflection();
+    const bool kLast = depth + 1 == fields_.size();
+
+    if (field->is_repeated()) {
+      if (kLast)
+        return static_cast<size_t>(reflection->FieldSize(*current, field));
+
+      size_t count = 0;
+      Visit(message, [&count](const Value&) { count++; });
+      return count;
+    }
+
+    if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE &&
+        !reflection->HasField(*current, field)) {
+      return 0;
+    }
+
+    if (kLast)
+      return 1;
+
+    current = &reflection->GetMessage(*current, field);
+  }
+  return 0;
+}
+
+std::vector<FieldPath> ParseFieldPaths(const pb::Descriptor* descriptor,
+                                       // NOLINTNEXTLINE
+                                       const std::string& paths) {
+  std::vector<std::string> names;
+  boost::algorithm::split(names, paths, [](char chr) { return chr == ','; });
+
+  std::vector<FieldPath> result;
+  for (auto& name : names) {
+    boost::algorithm::trim(name);
+    if (!name.empty())
+      result.push_back(FieldPath::Parse(descriptor, name));
+  }
+
+  if (result.empty())
+    throw exceptions::UserInputException("no field paths given");
+
+  return result;
+}
+
+}  // namespace wikiopencite::citescoop::cli::fields
@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_FIELDS_H_
+#define SRC_FIELDS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+namespace wikiopencite::citescoop::cli::fields {
+
+/// Names of the fields commands rely on when interpreting messages.
+/// They are looked up through reflection, the same way
+/// Combine looks up openalex_id, so a message type that lacks one of
+/// them simply does not support the feature that needs it.
+inline constexpr const char* kCitationsField = "citations";
+inline constexpr const char* kTemplateField = "citations.template";
+inline constexpr const char* kTimestampField = "timestamp";
+inline constexpr const char* kPageIdField = "page_id";
+inline constexpr const char* kRevisionIdField = "revision_id";
+inline constexpr const char* kOpenAlexIdField = "openalex_id";
+inline constexpr const char* kDoiField = "doi";
+
+/// A scalar value read from a message. Enums are stored as their
+/// number, google.protobuf.Timestamp as whole seconds and any other
+/// message as its serialized bytes.
+using Value =
+    std::variant<std::monostate, int64_t, uint64_t, double, bool, std::string>;
+
+/// @brief Render a value as plain text. std::monostate renders as an
+/// empty string.
+std::string ToString(const Value& value);
+
+/// @brief Total ordering over values. Numbers of different types
+/// compare numerically, strings compare bytewise and sort after
+/// numbers, missing values sort first.
+int Compare(const Value& lhs, const Value& rhs);
+
+/// @brief A dotted path of fields resolved against a message type,
+/// for example "page_id" or "citations.doi".
+class FieldPath {
+ public:
+  /// @brief Resolve a path against a message type.
+  ///
+  /// @param descriptor Message type the path starts at.
+  /// @param path Dotted field names.
+  /// @return The resolved path.
+  /// @throws exceptions::UserInputException if a component does not
+  /// exist or descends into a scalar field.
+  static FieldPath Parse(const google::protobuf::Descriptor* descriptor,
+                         const std::string& path);
+
+  /// @brief Like Parse but returns std::nullopt rather than throwing.
+  static std::optional<FieldPath> Find(
+      const google::protobuf::Descriptor* descriptor, const std::string& path);
+
+  /// @brief Call visitor for each value the path reaches in a message.
+  /// Repeated fields anywhere along the path fan out.
+  void Visit(const google::protobuf::Message& message,
+             const std::function<void(const Value&)>& visitor) const;
+
+  /// @brief Call visitor for each message holding the final field of
+  /// the path, for callers reading that field themselves.
+  void VisitParents(
+      const google::protobuf::Message& message,
+      const std::function<void(const google::protobuf::Message&)>& visitor)
+      const;
+
+  /// @brief Collect all values the path reaches in a message.
+  [[nodiscard]] std::vector<Value> Values(
+      const google::protobuf::Message& message) const;
+
+  /// @brief The first value the path reaches, or std::monostate.
+  [[nodiscard]] Value First(const google::protobuf::Message& message) const;
+
+  /// @brief Number of values the path reaches in a message. Unlike
+  /// Values this does not materialise them.
+  [[nodiscard]] size_t Count(const google::protobuf::Message& message) const;
+
+  /// @brief The path as given by the user.
+  [[nodiscard]] const std::string& path() const { return path_; }
+
+  /// @brief Whether any field along the path is repeated.
+  [[nodiscard]] bool repeated() const { return repeated_; }
+
+  /// @brief The final field of the path.
+  [[nodiscard]] const google::protobuf::FieldDescriptor* leaf() const {
+    return fields_.back();
+  }
+
+ private:
+  FieldPath() = default;
+
+  void VisitFrom(const google::protobuf::Message& message, size_t depth,
+                 const std::function<void(const Value&)>& visitor) const;
+  void VisitParentsFrom(
+      const google::protobuf::Message& message, size_t depth,
+      const std::function<void(const google::protobuf::Message&)>& visitor)
+      const;
+
+  std::string path_;
+  std::vector<const google::protobuf::FieldDescriptor*> fields_;
+  bool repeated_ = false;
+};
+
+/// @brief Parse a comma separated list of field paths, for example
+/// "page_id,timestamp".
+std::vector<FieldPath> ParseFieldPaths(
+    const google::protobuf::Descriptor* descriptor, const std::string& paths);
+
+}  // namespace wikiopencite::citescoop::cli::fields
+
+#endif  // SRC_FIELDS_H_
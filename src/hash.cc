@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "hash.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "xxhash.h"
+
+namespace wikiopencite::citescoop::cli::hash {
+
+Hash128 Bytes128(std::string_view data) {
+  const XXH128_hash_t kHash = XXH3_128bits(data.data(), data.size());
+  return {kHash.low64, kHash.high64};
+}
+
+uint64_t Bytes64(std::string_view data, uint64_t seed) {
+  return XXH3_64bits_withSeed(data.data(), data.size(), seed);
+}
+
+std::string SerializeDeterministic(const google::protobuf::Message& message) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream stream(&bytes);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    message.SerializeToCodedStream(&coded);
+  }
+  return bytes;
+}
+
+Hash128 Content(const google::protobuf::Message& message) {
+  return Bytes128(SerializeDeterministic(message));
+}
+
+}  // namespace wikiopencite::citescoop::cli::hash
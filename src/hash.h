@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_HASH_H_
+#define SRC_HASH_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "google/protobuf/message.h"
+
+namespace wikiopencite::citescoop::cli::hash {
+
+/// @brief A 128 bit hash, wide enough that collisions between distinct
+/// records can be ignored.
+struct Hash128 {
+  uint64_t low;
+  uint64_t high;
+
+  bool operator==(const Hash128& other) const = default;
+};
+
+/// @brief XXH3 128 bit hash of a byte string.
+Hash128 Bytes128(std::string_view data);
+
+/// @brief XXH3 64 bit hash of a byte string.
+uint64_t Bytes64(std::string_view data, uint64_t seed = 0);
+
+/// @brief Serialize a message deterministically, so that equal
+/// messages always give equal bytes, including map fields.
+std::string SerializeDeterministic(const google::protobuf::Message& message);
+
+/// @brief Stable hash of the content of a message.
+Hash128 Content(const google::protobuf::Message& message);
+
+}  // namespace wikiopencite::citescoop::cli::hash
+
+#endif  // SRC_HASH_H_
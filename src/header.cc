@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "header.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/unknown_field_set.h"
+
+namespace wikiopencite::citescoop::cli::header {
+
+namespace {
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+const pb::UnknownField* Find(const proto::FileHeader& header, int number,
+                             pb::UnknownField::Type type) {
+  const auto& unknown = header.GetReflection()->GetUnknownFields(header);
+  // The last occurrence wins, as it would for a known field.
+  for (int i = unknown.field_count() - 1; i >= 0; --i) {
+    const auto& field = unknown.field(i);
+    if (field.number() == number && field.type() == type)
+      return &field;
+  }
+  return nullptr;
+}
+}  // namespace
+
+std::optional<uint64_t> GetVarint(const proto::FileHeader& header,
+                                  int number) {
+  const auto* field = Find(header, number, pb::UnknownField::TYPE_VARINT);
+  if (field == nullptr)
+    return std::nullopt;
+  return field->varint();
+}
+
+void SetVarint(proto::FileHeader* header, int number, uint64_t value) {
+  Clear(header, number);
+  header->GetReflection()->MutableUnknownFields(header)->AddVarint(number,
+                                                                   value);
+}
+
+std::optional<std::string> GetBytes(const proto::FileHeader& header,
+                                    int number) {
+  const auto* field =
+      Find(header, number, pb::UnknownField::TYPE_LENGTH_DELIMITED);
+  if (field == nullptr)
+    return std::nullopt;
+  return field->length_delimited();
+}
+
+void SetBytes(proto::FileHeader* header, int number,
+              const std::string& value) {
+  Clear(header, number);
+  header->GetReflection()->MutableUnknownFields(header)->AddLengthDelimited(
+      number, value);
+}
+
+void Clear(proto::FileHeader* header, int number) {
+  header->GetReflection()->MutableUnknownFields(header)->DeleteByNumber(
+      number);
+}
+
+void ClearLayout(proto::FileHeader* header) {
+  Clear(header, kContainerField);
+  Clear(header, kRevisionEncodingField);
+  Clear(header, kStringDictionaryField);
+}
+
+}  // namespace wikiopencite::citescoop::cli::header
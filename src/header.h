@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_HEADER_H_
+#define SRC_HEADER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "citescoop/proto/file_header.pb.h"
+
+/// Attributes the CLI records in a FileHeader beyond those defined by
+/// citescoop-proto.
+///
+/// They are stored as unknown fields with numbers well above any the
+/// schema uses. Protobuf keeps unknown fields when a header is parsed
+/// and serialized again, so other tools built against the schema still
+/// read these files and simply ignore the extra attributes.
+namespace wikiopencite::citescoop::cli::header {
+
+/// Layout of the payload following the header, see container.h.
+inline constexpr int kContainerField = 1000;
+
+/// Comma separated field paths the messages are sorted by, set by
+/// pbf sort. Absent if the order is unknown.
+inline constexpr int kSortKeyField = 1001;
+
+/// How the messages of a revisions file are encoded, see delta.h.
+/// Absent if every revision is stored in full.
+inline constexpr int kRevisionEncodingField = 1002;
+
+/// Strings the messages refer to by id, see string_dictionary.h.
+inline constexpr int kStringDictionaryField = 1003;
+
+/// @brief The varint attribute with the given field number, if set.
+std::optional<uint64_t> GetVarint(const wikiopencite::proto::FileHeader& header,
+                                  int number);
+
+/// @brief Set a varint attribute, replacing any previous value.
+void SetVarint(wikiopencite::proto::FileHeader* header, int number,
+               uint64_t value);
+
+/// @brief The length delimited attribute with the given field number,
+/// if set.
+std::optional<std::string> GetBytes(
+    const wikiopencite::proto::FileHeader& header, int number);
+
+/// @brief Set a length delimited attribute, replacing any previous
+/// value.
+void SetBytes(wikiopencite::proto::FileHeader* header, int number,
+              const std::string& value);
+
+/// @brief Remove an attribute.
+void Clear(wikiopencite::proto::FileHeader* header, int number);
+
+/// @brief Remove the attributes describing how the payload is stored:
+/// its container, revision encoding and string dictionary. Used by
+/// commands writing a header copied from their input, as they write
+/// messages in full whatever the input's layout. The sort key is kept,
+/// being a property of the messages rather than of how they are stored.
+void ClearLayout(wikiopencite::proto::FileHeader* header);
+
+}  // namespace wikiopencite::citescoop::cli::header
+
+#endif  // SRC_HEADER_H_
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+/// Rank (1 based) of the nearest rank quantile among count values.
+uint64_t NearestRank(double quantile, uint64_t count) {
+  quantile = std::clamp(quantile, 0.0, 1.0);
+  auto rank = static_cast<uint64_t>(
+      std::ceil(quantile * static_cast<double>(count)));
+  return std::max<uint64_t>(rank, 1);
+}
+}  // namespace
+
+void Distribution::Add(uint64_t value) {
+  counts_[value]++;
+  count_++;
+  sum_ += value;
+}
+
+void Distribution::Merge(const Distribution& other) {
+  for (const auto& [value, count] : other.counts_) {
+    counts_[value] += count;
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+}
+
+uint64_t Distribution::min() const {
+  return counts_.empty() ? 0 : counts_.begin()->first;
+}
+
+uint64_t Distribution::max() const {
+  return counts_.empty() ? 0 : counts_.rbegin()->first;
+}
+
+double Distribution::mean() const {
+  if (count_ == 0)
+    return 0;
+  return static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+uint64_t Distribution::Quantile(double quantile) const {
+  if (count_ == 0)
+    return 0;
+
+  const uint64_t kRank = NearestRank(quantile, count_);
+  uint64_t seen = 0;
+  for (const auto& [value, count] : counts_) {
+    seen += count;
+    if (seen >= kRank)
+      return value;
+  }
+  return max();
+}
+
+void Log2Histogram::Add(uint64_t value) {
+  buckets_[BucketFor(value)]++;
+  count_++;
+  sum_ += value;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void Log2Histogram::Merge(const Log2Histogram& other) {
+  for (size_t i = 0; i < kBuckets; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+double Log2Histogram::mean() const {
+  if (count_ == 0)
+    return 0;
+  return static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+uint64_t Log2Histogram::Quantile(double quantile) const {
+  if (count_ == 0)
+    return 0;
+
+  const uint64_t kRank = NearestRank(quantile, count_);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= kRank) {
+      const uint64_t kUpper =
+          i + 1 < kBuckets ? BucketLowerBound(i + 1) - 1 : max_;
+      return std::clamp(kUpper, min(), max_);
+    }
+  }
+  return max_;
+}
+
+uint64_t Log2Histogram::BucketLowerBound(size_t index) {
+  if (index == 0)
+    return 0;
+  return uint64_t{1} << (index - 1);
+}
+
+size_t Log2Histogram::BucketFor(uint64_t value) {
+  return static_cast<size_t>(std::bit_width(value));
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_HISTOGRAM_H_
+#define SRC_HISTOGRAM_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Exact distribution of a small integer quantity, such as
+/// citations per message. Stores one counter per distinct value so
+/// quantiles are exact. Instances can be merged, allowing one per
+/// thread.
+class Distribution {
+ public:
+  void Add(uint64_t value);
+  void Merge(const Distribution& other);
+
+  [[nodiscard]] uint64_t count() const { return count_; }
+  [[nodiscard]] uint64_t sum() const { return sum_; }
+  [[nodiscard]] uint64_t min() const;
+  [[nodiscard]] uint64_t max() const;
+  [[nodiscard]] double mean() const;
+
+  /// @brief Nearest rank quantile.
+  /// @param quantile Quantile in [0, 1].
+  [[nodiscard]] uint64_t Quantile(double quantile) const;
+
+ private:
+  std::map<uint64_t, uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+};
+
+/// @brief Histogram with power of two buckets, for quantities such as
+/// message sizes that span many orders of magnitude. Bucket 0 holds
+/// zero and bucket i holds values in [2^(i-1), 2^i).
+class Log2Histogram {
+ public:
+  static constexpr size_t kBuckets = 65;
+
+  void Add(uint64_t value);
+  void Merge(const Log2Histogram& other);
+
+  [[nodiscard]] uint64_t count() const { return count_; }
+  [[nodiscard]] uint64_t sum() const { return sum_; }
+  [[nodiscard]] uint64_t min() const { return count_ == 0 ? 0 : min_; }
+  [[nodiscard]] uint64_t max() const { return max_; }
+  [[nodiscard]] double mean() const;
+
+  /// @brief Quantile estimate, the upper bound of the bucket holding
+  /// the nearest rank, clamped to the observed maximum.
+  [[nodiscard]] uint64_t Quantile(double quantile) const;
+
+  /// @brief Number of values in a bucket.
+  [[nodiscard]] uint64_t bucket(size_t index) const {
+    return buckets_[index];
+  }
+
+  /// @brief Smallest value that falls into a bucket.
+  static uint64_t BucketLowerBound(size_t index);
+
+ private:
+  static size_t BucketFor(uint64_t value);
+
+  std::array<uint64_t, kBuckets> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_HISTOGRAM_H_
@@ -0,0 +1,425 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "http.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "exceptions.h"
+#include "json.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::http {
+
+namespace {
+/// Largest request line and headers accepted.
+constexpr size_t kMaxHeadSize = size_t{16} << 10U;
+
+/// How long a persistent connection may sit idle before it is closed.
+constexpr std::chrono::seconds kIdleTimeout{5};
+
+/// Most connections open at once, idle or being served.
+constexpr size_t kMaxConnections = 1024;
+
+/// Milliseconds between checks of the stop flag while no connection
+/// is ready.
+constexpr int kPollInterval = 200;
+
+constexpr int kListenBacklog = 128;
+
+constexpr std::string_view kHeadEnd = "\r\n\r\n";
+
+std::string_view StatusText(int status) {
+  switch (status) {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 405:
+      return "Method Not Allowed";
+    case 431:
+      return "Request Header Fields Too Large";
+    default:
+      return "Internal Server Error";
+  }
+}
+
+int HexValue(char digit) {
+  if (digit >= '0' && digit <= '9')
+    return digit - '0';
+  if (digit >= 'a' && digit <= 'f')
+    return digit - 'a' + 10;
+  if (digit >= 'A' && digit <= 'F')
+    return digit - 'A' + 10;
+  return -1;
+}
+
+std::string Lower(std::string_view value) {
+  std::string lower(value);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  });
+  return lower;
+}
+
+std::string_view Trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+    value.remove_prefix(1);
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+    value.remove_suffix(1);
+  return value;
+}
+
+bool SendAll(int connection, std::string_view data) {
+  while (!data.empty()) {
+    const ssize_t kSent =
+        send(connection, data.data(), data.size(), MSG_NOSIGNAL);
+    if (kSent < 0 && errno == EINTR)
+      continue;
+    if (kSent <= 0)
+      return false;
+    data.remove_prefix(static_cast<size_t>(kSent));
+  }
+  return true;
+}
+}  // namespace
+
+std::optional<std::string> UrlDecode(std::string_view encoded) {
+  std::string decoded;
+  decoded.reserve(encoded.size());
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    if (encoded[i] == '+') {
+      decoded += ' ';
+    } else if (encoded[i] == '%') {
+      if (i + 2 >= encoded.size())
+        return std::nullopt;
+      const int kHigh = HexValue(encoded[i + 1]);
+      const int kLow = HexValue(encoded[i + 2]);
+      if (kHigh < 0 || kLow < 0)
+        return std::nullopt;
+      decoded += static_cast<char>(kHigh * 16 + kLow);
+      i += 2;
+    } else {
+      decoded += encoded[i];
+    }
+  }
+  return decoded;
+}
+
+std::optional<Request> ParseRequest(std::string_view head) {
+  Request request;
+
+  const size_t kLineEnd = head.find("\r\n");
+  const std::string_view kLine = head.substr(0, kLineEnd);
+  const size_t kMethodEnd = kLine.find(' ');
+  const size_t kTargetEnd = kLine.rfind(' ');
+  if (kMethodEnd == std::string_view::npos || kTargetEnd <= kMethodEnd)
+    return std::nullopt;
+
+  request.method = kLine.substr(0, kMethodEnd);
+  const std::string_view kTarget =
+      kLine.substr(kMethodEnd + 1, kTargetEnd - kMethodEnd - 1);
+  const std::string_view kVersion = kLine.substr(kTargetEnd + 1);
+  if (!kVersion.starts_with("HTTP/1."))
+    return std::nullopt;
+  request.keep_alive = kVersion == "HTTP/1.1";
+
+  const size_t kQueryStart = kTarget.find('?');
+  auto path = UrlDecode(kTarget.substr(0, kQueryStart));
+  if (!path)
+    return std::nullopt;
+  request.path = std::move(*path);
+
+  if (kQueryStart != std::string_view::npos) {
+    std::string_view query = kTarget.substr(kQueryStart + 1);
+    while (!query.empty()) {
+      const size_t kEnd = std::min(query.find('&'), query.size());
+      const std::string_view kPair = query.substr(0, kEnd);
+      const size_t kEquals = std::min(kPair.find('='), kPair.size());
+      auto name = UrlDecode(kPair.substr(0, kEquals));
+      auto value =
+          UrlDecode(kPair.substr(std::min(kEquals + 1, kPair.size())));
+      if (!name || !value)
+        return std::nullopt;
+      if (!name->empty())
+        request.query.emplace(std::move(*name), std::move(*value));
+      query.remove_prefix(std::min(kEnd + 1, query.size()));
+    }
+  }
+
+  // Only the Connection header matters to a server without bodies.
+  std::string_view headers =
+      kLineEnd == std::string_view::npos ? "" : head.substr(kLineEnd + 2);
+  while (!headers.empty()) {
+    const size_t kEnd = std::min(headers.find("\r\n"), headers.size());
+    const std::string_view kHeader = headers.substr(0, kEnd);
+    const size_t kColon = kHeader.find(':');
+    if (kColon != std::string_view::npos &&
+        Lower(Trim(kHeader.substr(0, kColon))) == "connection") {
+      const auto kValue = Lower(Trim(kHeader.substr(kColon + 1)));
+      if (kValue == "close") {
+        request.keep_alive = false;
+      } else if (kValue == "keep-alive") {
+        request.keep_alive = true;
+      }
+    }
+    headers.remove_prefix(std::min(kEnd + 2, headers.size()));
+  }
+
+  return request;
+}
+
+std::string FormatResponse(const Response& response, bool keep_alive) {
+  return fmt::format(
+      "HTTP/1.1 {} {}\r\nContent-Type: {}\r\nContent-Length: {}\r\n"
+      "Connection: {}\r\n\r\n{}",
+      response.status, StatusText(response.status), response.content_type,
+      response.body.size(), keep_alive ? "keep-alive" : "close",
+      response.body);
+}
+
+Response Error(int status, std::string_view message) {
+  return {status, fmt::format(R"({{"error":"{}"}})", json::Escape(message))};
+}
+
+Server::Server(const std::string& host, uint16_t port, Handler handler)
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : handler_(std::move(handler)) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+    throw exceptions::UserInputException(
+        fmt::format("invalid IPv4 address: {}", host).c_str());
+  }
+
+  listener_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  const int kReuse = 1;
+  if (listener_ < 0 ||
+      setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &kReuse,
+                 sizeof(kReuse)) != 0 ||
+      bind(listener_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listener_, kListenBacklog) != 0) {
+    const std::string kReason = std::strerror(errno);
+    if (listener_ >= 0)
+      close(listener_);
+    throw exceptions::CliException(
+        fmt::format("cannot listen on {}:{}: {}", host, port, kReason));
+  }
+
+  socklen_t length = sizeof(address);
+  getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+  port_ = ntohs(address.sin_port);
+}
+
+Server::~Server() {
+  if (listener_ >= 0)
+    close(listener_);
+}
+
+struct Server::Connection {
+  int socket = -1;
+  std::string buffer;  ///< Bytes read but not yet answered.
+  std::chrono::steady_clock::time_point active;  ///< Time of the last read.
+};
+
+void Server::Run(unsigned threads, const std::atomic<bool>& stop) {
+  // Workers hand back connections that stay open through returned and
+  // wake the poll loop with a byte on the pipe.
+  std::array<int, 2> wake{};
+  if (pipe2(wake.data(), O_CLOEXEC | O_NONBLOCK) != 0) {
+    throw exceptions::CliException(
+        fmt::format("cannot create pipe: {}", std::strerror(errno)));
+  }
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Connection>> returned;
+  size_t busy = 0;
+
+  std::vector<std::unique_ptr<Connection>> idle;
+  {
+    ThreadPool pool(threads);
+    std::vector<pollfd> polled;
+
+    while (!stop.load()) {
+      size_t open = 0;
+      {
+        const std::lock_guard<std::mutex> kLock(mutex);
+        std::move(returned.begin(), returned.end(), std::back_inserter(idle));
+        returned.clear();
+        open = busy;
+      }
+
+      const auto kNow = std::chrono::steady_clock::now();
+      std::erase_if(idle, [&kNow](const std::unique_ptr<Connection>& conn) {
+        if (kNow - conn->active < kIdleTimeout)
+          return false;
+        close(conn->socket);
+        return true;
+      });
+      open += idle.size();
+
+      // At the connection limit further clients wait in the backlog.
+      polled.clear();
+      polled.push_back({wake[0], POLLIN, 0});
+      polled.push_back({open < kMaxConnections ? listener_ : -1, POLLIN, 0});
+      for (const auto& connection : idle)
+        polled.push_back({connection->socket, POLLIN, 0});
+
+      if (poll(polled.data(), polled.size(), kPollInterval) <= 0)
+        continue;
+
+      if (polled[0].revents != 0) {
+        std::array<char, 64> drain{};
+        while (read(wake[0], drain.data(), drain.size()) > 0) {
+        }
+      }
+
+      // Only connections with something to read take a worker.
+      size_t kept = 0;
+      for (size_t i = 0; i < idle.size(); ++i) {
+        if (polled[i + 2].revents == 0) {
+          idle[kept++] = std::move(idle[i]);
+          continue;
+        }
+
+        {
+          const std::lock_guard<std::mutex> kLock(mutex);
+          ++busy;
+        }
+        pool.Submit([this, &mutex, &returned, &busy, kWake = wake[1],
+                     connection = std::move(idle[i])]() mutable {
+          const bool kOpen = Serve(connection.get());
+          const std::lock_guard<std::mutex> kLock(mutex);
+          --busy;
+          if (kOpen) {
+            returned.push_back(std::move(connection));
+          } else {
+            close(connection->socket);
+          }
+          const char kByte = 0;
+          if (write(kWake, &kByte, 1) < 0) {
+            // The pipe is full, so the loop is already due to wake.
+          }
+        });
+      }
+      idle.resize(kept);
+
+      if (polled[1].revents != 0) {
+        const int kSocket = accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (kSocket >= 0) {
+          const int kNoDelay = 1;
+          setsockopt(kSocket, IPPROTO_TCP, TCP_NODELAY, &kNoDelay,
+                     sizeof(kNoDelay));
+          // Bound how long a client that stops reading holds a worker.
+          timeval timeout{kIdleTimeout.count(), 0};
+          setsockopt(kSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                     sizeof(timeout));
+          auto connection = std::make_unique<Connection>();
+          connection->socket = kSocket;
+          connection->active = std::chrono::steady_clock::now();
+          idle.push_back(std::move(connection));
+        }
+      }
+    }
+  }
+
+  for (const auto& connection : idle)
+    close(connection->socket);
+  for (const auto& connection : returned)
+    close(connection->socket);
+  close(wake[0]);
+  close(wake[1]);
+}
+
+bool Server::Serve(Connection* connection) const {
+  std::string& buffer = connection->buffer;
+  bool open = true;
+  char chunk[4096];
+
+  // The socket is readable, so take what has arrived without waiting
+  // for more; a partial request goes back to the poll loop.
+  while (buffer.size() <= kMaxHeadSize) {
+    const ssize_t kRead =
+        recv(connection->socket, chunk, sizeof(chunk), MSG_DONTWAIT);
+    if (kRead < 0 && errno == EINTR)
+      continue;
+    if (kRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (kRead <= 0) {
+      open = false;
+      break;
+    }
+    buffer.append(chunk, static_cast<size_t>(kRead));
+  }
+  connection->active = std::chrono::steady_clock::now();
+
+  while (true) {
+    const size_t kHeadEndAt = buffer.find(kHeadEnd);
+    if (kHeadEndAt == std::string::npos) {
+      if (buffer.size() > kMaxHeadSize) {
+        SendAll(connection->socket,
+                FormatResponse(Error(431, "request head too large"), false));
+        return false;
+      }
+      return open;
+    }
+
+    const auto kRequest =
+        ParseRequest(std::string_view(buffer).substr(0, kHeadEndAt));
+    buffer.erase(0, kHeadEndAt + kHeadEnd.size());
+
+    Response response;
+    bool keep_alive = kRequest && kRequest->keep_alive;
+    if (!kRequest) {
+      response = Error(400, "malformed request");
+    } else if (kRequest->method != "GET") {
+      response = Error(405, "only GET is supported");
+      keep_alive = false;
+    } else {
+      try {
+        response = handler_(*kRequest);
+      } catch (const std::exception& e) {
+        spdlog::error("Failed to answer {}: {}", kRequest->path, e.what());
+        response = Error(500, e.what());
+      }
+    }
+
+    if (!SendAll(connection->socket, FormatResponse(response, keep_alive)) ||
+        !keep_alive)
+      return false;
+  }
+}
+
+}  // namespace wikiopencite::citescoop::cli::http
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_HTTP_H_
+#define SRC_HTTP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// Minimal HTTP/1.1 server for local lookup services. It answers GET
+/// requests without bodies over persistent connections, which is all a
+/// JSON lookup API needs. Idle connections wait in a single poll loop
+/// and only those with a request to read are handed to a worker, so
+/// open connections do not hold threads.
+namespace wikiopencite::citescoop::cli::http {
+
+struct Request {
+  std::string method;
+  std::string path;  ///< Path without the query string.
+  std::unordered_map<std::string, std::string> query;
+  /// Whether the connection stays open after the response: the default
+  /// for HTTP/1.1, and only on request for HTTP/1.0.
+  bool keep_alive = false;
+};
+
+struct Response {
+  int status = 200;
+  std::string body;
+  std::string content_type = "application/json";
+};
+
+/// @brief Decode a percent encoded URL component, with + as a space.
+/// @return The decoded string, or std::nullopt if an escape is invalid.
+std::optional<std::string> UrlDecode(std::string_view encoded);
+
+/// @brief Parse the request line and headers of a request, up to but
+/// excluding the blank line ending them.
+/// @return The request, or std::nullopt if it is malformed.
+std::optional<Request> ParseRequest(std::string_view head);
+
+/// @brief Serialize a response with its status line and headers.
+std::string FormatResponse(const Response& response, bool keep_alive);
+
+/// @brief JSON error response.
+Response Error(int status, std::string_view message);
+
+class Server {
+ public:
+  using Handler = std::function<Response(const Request&)>;
+
+  /// @brief Bind and listen on an address.
+  /// @param host IPv4 address to listen on.
+  /// @param port Port to listen on, or 0 for any free port.
+  /// @throws exceptions::CliException if the socket cannot be bound.
+  Server(const std::string& host, uint16_t port, Handler handler);
+
+  ~Server();
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+
+  /// @brief Accept connections and serve their requests on a pool of
+  /// threads until stop is set. Handler exceptions become 500
+  /// responses.
+  void Run(unsigned threads, const std::atomic<bool>& stop);
+
+  /// @brief Port the server listens on.
+  [[nodiscard]] uint16_t port() const { return port_; }
+
+ private:
+  struct Connection;
+
+  /// @brief Read what has arrived on a readable connection and answer
+  /// every complete request buffered on it.
+  /// @return Whether the connection stays open for further requests.
+  bool Serve(Connection* connection) const;
+
+  int listener_ = -1;
+  uint16_t port_ = 0;
+  Handler handler_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::http
+
+#endif  // SRC_HTTP_H_
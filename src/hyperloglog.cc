@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "hyperloglog.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "fmt/format.h"
+
+#include "binary.h"
+#include "exceptions.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+/// Bias correction constant of Flajolet et al. for 2^precision
+/// registers, valid from 2^7 registers up.
+double Alpha(size_t registers) {
+  switch (registers) {
+    case 16:
+      return 0.673;
+    case 32:
+      return 0.697;
+    case 64:
+      return 0.709;
+    default:
+      return 0.7213 / (1.0 + 1.079 / static_cast<double>(registers));
+  }
+}
+}  // namespace
+
+HyperLogLog::HyperLogLog(uint8_t precision)
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : precision_(precision) {
+  if (precision < kMinPrecision || precision > kMaxPrecision) {
+    throw exceptions::UserInputException(
+        fmt::format("HyperLogLog precision must be between {} and {}",
+                    kMinPrecision, kMaxPrecision)
+            .c_str());
+  }
+  registers_.assign(size_t{1} << precision, 0);
+}
+
+std::string HyperLogLog::PathFor(const std::string& pbf_path) {
+  return pbf_path + ".hll";
+}
+
+void HyperLogLog::Add(uint64_t hash) {
+  const uint64_t kIndex = hash >> (64U - precision_);
+  // The sentinel bit caps the rank when the remaining bits are all 0.
+  const uint64_t kRest =
+      (hash << precision_) | (uint64_t{1} << (precision_ - 1U));
+  const auto kRank = static_cast<uint8_t>(std::countl_zero(kRest) + 1);
+  registers_[kIndex] = std::max(registers_[kIndex], kRank);
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+  if (other.precision_ != precision_) {
+    throw exceptions::UserInputException(
+        fmt::format("cannot merge sketches of precision {} and {}",
+                    precision_, other.precision_)
+            .c_str());
+  }
+  for (size_t i = 0; i < registers_.size(); ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+double HyperLogLog::Estimate() const {
+  const auto kRegisters = static_cast<double>(registers_.size());
+  double sum = 0;
+  size_t zeros = 0;
+  for (const uint8_t kRegister : registers_) {
+    sum += std::ldexp(1.0, -kRegister);
+    if (kRegister == 0)
+      zeros++;
+  }
+
+  const double kRaw = Alpha(registers_.size()) * kRegisters * kRegisters / sum;
+  // Linear counting is more accurate while many registers are empty.
+  // With 64 bit hashes no large range correction is needed.
+  if (kRaw <= 2.5 * kRegisters && zeros > 0)
+    return kRegisters * std::log(kRegisters / static_cast<double>(zeros));
+  return kRaw;
+}
+
+double HyperLogLog::StandardError() const {
+  return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+}
+
+void SketchSidecar::Save(const std::string& path) const {
+  std::string buffer(HyperLogLog::kMagic);
+  binary::PutFixed64(&buffer, file_size);
+  binary::PutVarint(&buffer, sketches.size());
+  for (const auto& [field, sketch] : sketches) {
+    binary::PutString(&buffer, field);
+    binary::PutVarint(&buffer, sketch.precision_);
+    buffer.append(sketch.registers_.begin(), sketch.registers_.end());
+  }
+
+  std::ofstream stream(path,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  stream.close();
+  if (!stream) {
+    throw exceptions::CliException(
+        fmt::format("failed to write {}", path));
+  }
+}
+
+SketchSidecar SketchSidecar::Load(const std::string& path) {
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  const std::string kBuffer((std::istreambuf_iterator<char>(stream)),
+                            std::istreambuf_iterator<char>());
+  if (!stream.eof() && !stream) {
+    throw exceptions::UserInputException(
+        fmt::format("cannot read {}", path).c_str());
+  }
+
+  binary::Reader reader(kBuffer);
+  if (kBuffer.size() < HyperLogLog::kMagic.size() ||
+      reader.Bytes(HyperLogLog::kMagic.size()) != HyperLogLog::kMagic) {
+    throw exceptions::UserInputException(
+        fmt::format("{} is not a sketch file", path).c_str());
+  }
+
+  SketchSidecar sidecar;
+  sidecar.file_size = reader.Fixed64();
+  const uint64_t kSketches = reader.Varint();
+  for (uint64_t i = 0; i < kSketches; ++i) {
+    std::string field(reader.String());
+    const uint64_t kPrecision = reader.Varint();
+    if (kPrecision < HyperLogLog::kMinPrecision ||
+        kPrecision > HyperLogLog::kMaxPrecision) {
+      throw exceptions::UserInputException(
+          fmt::format("{} is corrupt", path).c_str());
+    }
+    HyperLogLog sketch(static_cast<uint8_t>(kPrecision));
+    const auto kRegisters = reader.Bytes(sketch.registers_.size());
+    std::copy(kRegisters.begin(), kRegisters.end(), sketch.registers_.begin());
+    sidecar.sketches.emplace(std::move(field), std::move(sketch));
+  }
+  return sidecar;
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -3,12 +3,16 @@
 
 #include "io.h"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <istream>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <utility>
 
 #include "citescoop/io.h"
 #include "citescoop/proto/file_header.pb.h"
@@ -18,12 +22,22 @@
 #include "citescoop/proto/page.pb.h"
 #include "citescoop/proto/revision.pb.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
 #include "spdlog/spdlog.h"
 
+#include "checksum.h"
+#include "container.h"
+#include "delta.h"
 #include "exceptions.h"
+#include "thread_pool.h"
 
 namespace wikiopencite::citescoop::cli::io {
 
+namespace {
+/// Bytes of the big endian length starting every frame.
+constexpr size_t kFrameLengthSize = 4;
+}  // namespace
+
 std::unique_ptr<PbfFile> OpenPbfFile(const std::string& path) {
   auto file = std::make_unique<PbfFile>();
   file->stream = std::ifstream(path, std::ios::in | std::ios::binary);
@@ -32,6 +46,9 @@ std::unique_ptr<PbfFile> OpenPbfFile(const std::string& path) {
 }
 
 void ClosePbfFile(std::unique_ptr<PbfFile> file) {
+  file->reader.reset();
+  file->payload.reset();
+  file->buffer.reset();
   file->stream.close();
 }
 
@@ -51,16 +68,84 @@ std::unique_ptr<proto::FileHeader> ReadPbfHeader(PbfFile* file) {
         "file type not specified or pbf file corrupt");
   }
 
+  if (container::IsCompressed(*header)) {
+    spdlog::trace("Payload is block compressed");
+    file->buffer = std::make_unique<container::DecompressingBuffer>(
+        &file->stream, kDefaultReadAhead);
+    file->payload = std::make_unique<std::istream>(file->buffer.get());
+    file->payload->exceptions(std::ios::badbit);
+    file->reader = std::make_unique<MessageReader>(file->payload.get());
+  }
+
+  file->delta_revisions = delta::IsEncoded(*header);
+  if (file->delta_revisions)
+    spdlog::trace("Revisions are delta encoded");
+
+  if (auto dictionary = StringDictionary::FromHeader(*header)) {
+    spdlog::trace("Got string dictionary of {} strings", dictionary->size());
+    file->dictionary =
+        std::make_shared<const StringDictionary>(std::move(*dictionary));
+  }
+
   return header;
 }
 
-std::unique_ptr<google::protobuf::Message> ReadGenericMessage(
+void SetReadAhead(PbfFile* file, unsigned threads) {
+  if (file->buffer)
+    file->buffer->SetReadAhead(threads);
+}
+
+namespace {
+/// @brief Read a revision of a delta encoded file in full.
+std::unique_ptr<proto::Revision> ReadDeltaRevision(PbfFile* file) {
+  // Without a previous revision a delta can only be rebuilt by going
+  // back to its keyframe, found from where the delta starts.
+  const bool kCold = !file->previous_revision;
+  const uint64_t kStart = kCold ? TellPayload(file) : 0;
+
+  auto revision = file->reader->ReadMessage<proto::Revision>();
+  const auto kDistance = delta::KeyframeDistance(*revision);
+  if (kDistance) {
+    if (kCold) {
+      if (*kDistance > kStart)
+        throw exceptions::UserInputException(
+            "delta encoded revision refers to a keyframe before the "
+            "payload");
+      spdlog::trace("Replaying revisions from keyframe at {}",
+                    kStart - *kDistance);
+      SeekPayload(file, kStart - *kDistance);
+      revision = file->reader->ReadMessage<proto::Revision>();
+      if (delta::KeyframeDistance(*revision))
+        throw exceptions::UserInputException(
+            "delta encoded revision does not refer to a keyframe");
+      while (TellPayload(file) <= kStart) {
+        auto next = file->reader->ReadMessage<proto::Revision>();
+        delta::Apply(revision.get(), next.get());
+        revision = std::move(next);
+      }
+    } else {
+      delta::Apply(file->previous_revision.get(), revision.get());
+    }
+  }
+
+  // The caller owns the revision, so the next delta needs its own copy
+  // of the citations, the only part of a revision a delta refers to.
+  if (!file->previous_revision)
+    file->previous_revision = std::make_unique<proto::Revision>();
+  *file->previous_revision->mutable_citations() = revision->citations();
+  return revision;
+}
+
+/// @brief Read the next message as it is stored, apart from deltas.
+std::unique_ptr<google::protobuf::Message> ReadStoredMessage(
     PbfFile* file, proto::FileType file_type) {
   switch (file_type) {
     case proto::FileType::FILE_TYPE_PAGES:
       return file->reader->ReadMessage<proto::Page>();
 
     case proto::FileType::FILE_TYPE_REVISIONS:
+      if (file->delta_revisions)
+        return ReadDeltaRevision(file);
       return file->reader->ReadMessage<proto::Revision>();
 
     case proto::FileType::FILE_TYPE_OPENALEX_AUTHORS:
@@ -81,6 +166,118 @@ std::unique_ptr<google::protobuf::Message> ReadGenericMessage(
   }
   return std::unique_ptr<google::protobuf::Message>();
 }
+}  // namespace
+
+std::unique_ptr<google::protobuf::Message> ReadGenericMessage(
+    PbfFile* file, proto::FileType file_type) {
+  auto message = ReadStoredMessage(file, file_type);
+  if (file->dictionary && file->rehydrate_strings)
+    file->dictionary->Rehydrate(message.get());
+  return message;
+}
+
+void ReadFrame(PbfFile* file, std::string* frame) {
+  std::istream* stream = PayloadStream(file);
+  std::array<unsigned char, kFrameLengthSize> length{};
+  stream->read(reinterpret_cast<char*>(length.data()), length.size());
+  const uint32_t kSize = (uint32_t{length[0]} << 24U) |
+                         (uint32_t{length[1]} << 16U) |
+                         (uint32_t{length[2]} << 8U) | uint32_t{length[3]};
+
+  frame->resize(kSize);
+  if (*stream)
+    stream->read(frame->data(), kSize);
+  if (!*stream)
+    throw exceptions::UserInputException("truncated message in pbf file");
+}
+
+FrameDecoder::FrameDecoder(const PbfFile& file, proto::FileType file_type)
+    : file_type_(file_type),
+      delta_revisions_(file.delta_revisions &&
+                       file_type == proto::FileType::FILE_TYPE_REVISIONS),
+      dictionary_(file.rehydrate_strings ? file.dictionary : nullptr),
+      message_(NewGenericMessage(file_type)) {}
+
+const google::protobuf::Message& FrameDecoder::Decode(std::string_view frame) {
+  // The previous revision is only needed until the delta after it has
+  // been rebuilt, so the two messages take turns.
+  if (delta_revisions_)
+    std::swap(message_, previous_);
+  if (!message_)
+    message_ = NewGenericMessage(file_type_);
+
+  message_->Clear();
+  if (!message_->ParseFromArray(frame.data(),
+                                static_cast<int>(frame.size())))
+    throw exceptions::UserInputException("corrupt message in pbf file");
+
+  if (delta_revisions_) {
+    auto* revision = static_cast<proto::Revision*>(message_.get());
+    if (delta::KeyframeDistance(*revision)) {
+      if (!previous_)
+        throw exceptions::UserInputException(
+            "delta encoded revision read without its keyframe");
+      delta::Apply(static_cast<proto::Revision*>(previous_.get()), revision);
+    }
+  }
+
+  if (dictionary_)
+    dictionary_->Rehydrate(message_.get());
+  return *message_;
+}
+
+std::istream* PayloadStream(PbfFile* file) {
+  return file->payload ? file->payload.get()
+                       : static_cast<std::istream*>(&file->stream);
+}
+
+uint64_t TellPayload(PbfFile* file) {
+  return static_cast<uint64_t>(PayloadStream(file)->tellg());
+}
+
+void SeekPayload(PbfFile* file, uint64_t position) {
+  std::istream* stream = PayloadStream(file);
+  stream->clear();
+  stream->seekg(static_cast<std::streamoff>(position));
+  if (!*stream)
+    throw exceptions::UserInputException("failed to seek in pbf file");
+
+  // A fresh reader, so nothing read before the seek is left buffered.
+  file->reader = std::make_unique<MessageReader>(stream);
+  file->previous_revision.reset();
+}
+
+const google::protobuf::Descriptor* DescriptorForFileType(
+    proto::FileType file_type) {
+  switch (file_type) {
+    case proto::FileType::FILE_TYPE_PAGES:
+      return proto::Page::descriptor();
+
+    case proto::FileType::FILE_TYPE_REVISIONS:
+      return proto::Revision::descriptor();
+
+    case proto::FileType::FILE_TYPE_OPENALEX_AUTHORS:
+      return proto::openalex::Author::descriptor();
+
+    case proto::FileType::FILE_TYPE_OPENALEX_INSTITUTIONS:
+      return proto::openalex::Institution::descriptor();
+
+    case proto::FileType::FILE_TYPE_OPENALEX_WORKS:
+      return proto::openalex::Work::descriptor();
+
+    default:
+      throw exceptions::UnsupportedFileType();
+  }
+}
+
+std::unique_ptr<google::protobuf::Message> NewGenericMessage(
+    proto::FileType file_type) {
+  const auto* descriptor = DescriptorForFileType(file_type);
+  return std::unique_ptr<google::protobuf::Message>(
+      google::protobuf::MessageFactory::generated_factory()
+          ->GetPrototype(descriptor)
+          ->New());
+}
 
 void PrependHeader(uint64_t message_count, proto::FileType file_type,
                    const std::istream& input, std::ostream* output) {
@@ -92,13 +289,62 @@ void PrependHeader(uint64_t message_count, proto::FileType file_type,
 
 void PrependHeader(const wikiopencite::proto::FileHeader& header,
                    const std::istream& input, std::ostream* output) {
-  auto writer = MessageWriter(output);
+  checksum::ChecksummingBuffer checksummer(output->rdbuf());
+  std::ostream checksummed(&checksummer);
+
+  auto writer = MessageWriter(&checksummed);
   spdlog::trace("Writing header to output stream");
   writer.WriteMessage(header);
 
   spdlog::trace("Copying messages to output");
-  *output << input.rdbuf();
+  if (container::IsCompressed(header)) {
+    container::CompressingBuffer buffer(&checksummed,
+                                        ThreadPool::DefaultThreadCount());
+    std::ostream compressed(&buffer);
+    compressed << input.rdbuf();
+    buffer.Finish();
+  } else {
+    checksummed << input.rdbuf();
+  }
+
+  checksummed.flush();
+  if (!checksummer.Finish())
+    output->setstate(std::ios::badbit);
 
   spdlog::trace("Finished writing header and messages to output stream");
 }
+
+PbfWriter::PbfWriter(const std::string& path, const proto::FileHeader& header,
+                     // NOLINTNEXTLINE(whitespace/indent_namespace)
+                     unsigned threads)
+    : stream_(path, std::ios::out | std::ios::binary | std::ios::trunc),
+      checksummer_(std::make_unique<checksum::ChecksummingBuffer>(
+          stream_.rdbuf())),
+      file_(std::make_unique<std::ostream>(checksummer_.get())) {
+  MessageWriter(file_.get()).WriteMessage(header);
+
+  if (container::IsCompressed(header)) {
+    compressor_ =
+        std::make_unique<container::CompressingBuffer>(file_.get(), threads);
+    payload_ = std::make_unique<std::ostream>(compressor_.get());
+  } else {
+    payload_ = std::make_unique<std::ostream>(checksummer_.get());
+  }
+  writer_ = std::make_unique<MessageWriter>(payload_.get());
+}
+
+void PbfWriter::Write(const google::protobuf::Message& message) {
+  writer_->WriteMessage(message);
+}
+
+void PbfWriter::Close() {
+  if (compressor_)
+    compressor_->Finish();
+  payload_->flush();
+  file_->flush();
+  const bool kChecksummed = checksummer_->Finish();
+  stream_.close();
+  if (!*payload_ || !*file_ || !kChecksummed || !stream_)
+    throw exceptions::CliException("failed to write output file");
+}
 }  // namespace wikiopencite::citescoop::cli::io
@@ -9,32 +9,167 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <streambuf>
 #include <string>
+#include <string_view>
 
 #include "citescoop/io.h"
 #include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/revision.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#include "checksum.h"
+#include "container.h"
+#include "string_dictionary.h"
+#include "thread_pool.h"
 
 namespace wikiopencite::citescoop::cli::io {
 
 struct PbfFile {
   std::ifstream stream;
+  /// Decompressing layer over stream, set by ReadPbfHeader when the
+  /// payload is block compressed. See container.h.
+  std::unique_ptr<container::DecompressingBuffer> buffer;
+  std::unique_ptr<std::istream> payload;
   std::unique_ptr<wikiopencite::citescoop::MessageReader> reader;
+  /// Set by ReadPbfHeader when the revisions are delta encoded, see
+  /// delta.h.
+  bool delta_revisions = false;
+  /// Citations of the last revision read from a delta encoded file, the
+  /// base of the next delta. Reset by SeekPayload.
+  std::unique_ptr<wikiopencite::proto::Revision> previous_revision;
+  /// Set by ReadPbfHeader when the file has a string dictionary.
+  std::shared_ptr<const StringDictionary> dictionary;
+  /// Whether messages are returned with their interned strings put
+  /// back. Callers grouping by an interned field may clear it and use
+  /// StringDictionary::IdOf instead.
+  bool rehydrate_strings = true;
 };
 
 std::unique_ptr<PbfFile> OpenPbfFile(const std::string& path);
 
 void ClosePbfFile(std::unique_ptr<PbfFile> file);
 
+/// @brief Read the header of a PBF file. If the payload is block
+/// compressed the file's reader is switched to decompress it, so that
+/// messages are read the same way whatever the layout. Blocks are
+/// decompressed kDefaultReadAhead at a time, see SetReadAhead.
 std::unique_ptr<wikiopencite::proto::FileHeader> ReadPbfHeader(PbfFile* file);
 
+/// Blocks of a compressed file decompressed at once by default. Kept
+/// small as commands may hold many files open, each only read a little.
+inline constexpr unsigned kDefaultReadAhead = 2;
+
+/// @brief Decompress up to threads blocks of a compressed file at once,
+/// for callers about to read all of it. Does nothing for other files.
+void SetReadAhead(PbfFile* file, unsigned threads);
+
+/// @brief Read the next message. Delta encoded revisions are returned
+/// in full, replaying from their keyframe if read right after a seek,
+/// and interned strings are put back (see PbfFile::rehydrate_strings).
 std::unique_ptr<google::protobuf::Message> ReadGenericMessage(
     PbfFile* file, wikiopencite::proto::FileType file_type);
 
+/// @brief Read the next message as the bytes it is stored as, without
+/// decoding it. A frame is a 4 byte big endian length followed by the
+/// serialized message, of which only the message is returned. Deltas
+/// and interned ids are left as they are stored, see FrameDecoder.
+/// @throws exceptions::UserInputException if the payload is truncated.
+void ReadFrame(PbfFile* file, std::string* frame);
+
+/// @brief Turns frames read by ReadFrame into the messages
+/// ReadGenericMessage would return, so that decoding can happen away
+/// from the thread reading the file. In a delta encoded file a revision
+/// is rebuilt from the one decoded before it, so frames must be decoded
+/// in order starting at a keyframe (see delta::IsKeyframe). Separate
+/// decoders of one file may run on separate threads.
+class FrameDecoder {
+ public:
+  FrameDecoder(const PbfFile& file, wikiopencite::proto::FileType file_type);
+
+  /// @brief Decode the next frame. The message is reused by the next
+  /// call, so it is only valid until then.
+  /// @throws exceptions::UserInputException if the frame is corrupt or
+  /// is a delta with no revision decoded before it.
+  const google::protobuf::Message& Decode(std::string_view frame);
+
+ private:
+  wikiopencite::proto::FileType file_type_;
+  bool delta_revisions_;
+  /// Set if interned strings are to be put back.
+  std::shared_ptr<const StringDictionary> dictionary_;
+  std::unique_ptr<google::protobuf::Message> message_;
+  /// Revision decoded before message_ in a delta encoded file.
+  std::unique_ptr<google::protobuf::Message> previous_;
+};
+
+/// @brief Stream the messages of a file are read from, decompressing
+/// the payload if it is block compressed.
+std::istream* PayloadStream(PbfFile* file);
+
+/// @brief Position of the next message, for returning to it with
+/// SeekPayload. Positions are opaque: in a block compressed file they
+/// count uncompressed payload bytes rather than bytes on disk.
+uint64_t TellPayload(PbfFile* file);
+
+/// @brief Move to a position previously returned by TellPayload.
+void SeekPayload(PbfFile* file, uint64_t position);
+
+/// @brief Message type stored in a file of the given type.
+/// @throws exceptions::UnsupportedFileType for unknown file types.
+const google::protobuf::Descriptor* DescriptorForFileType(
+    wikiopencite::proto::FileType file_type);
+
+/// @brief Create an empty message of the type stored in a file of the
+/// given type.
+/// @throws exceptions::UnsupportedFileType for unknown file types.
+std::unique_ptr<google::protobuf::Message> NewGenericMessage(
+    wikiopencite::proto::FileType file_type);
+
+/// @brief Write a header followed by the framed messages in input,
+/// then a checksum trailer (see checksum.h). If the header is flagged
+/// by container::MarkCompressed the messages are written block
+/// compressed. output must be positioned at the start of the file.
 void PrependHeader(uint64_t message_count,
                    wikiopencite::proto::FileType file_type,
                    const std::istream& input, std::ostream* output);
 void PrependHeader(const wikiopencite::proto::FileHeader& header,
                    const std::istream& input, std::ostream* output);
+
+/// @brief PBF file written message by message, for commands that know
+/// the final message count before they start writing. The payload is
+/// block compressed if the header is flagged by
+/// container::MarkCompressed, and the file ends with a checksum
+/// trailer.
+class PbfWriter {
+ public:
+  /// @param path Output file path.
+  /// @param header Header to write, holding the final count.
+  /// @param threads Number of compression threads.
+  PbfWriter(const std::string& path,
+            const wikiopencite::proto::FileHeader& header,
+            unsigned threads = ThreadPool::DefaultThreadCount());
+
+  /// @brief Append a message to the payload.
+  void Write(const google::protobuf::Message& message);
+
+  /// @brief Stream receiving the framed payload, for callers writing
+  /// already framed messages.
+  [[nodiscard]] std::ostream* payload() { return payload_.get(); }
+
+  /// @brief Finish the payload and close the file.
+  /// @throws exceptions::CliException if the file could not be written.
+  void Close();
+
+ private:
+  std::ofstream stream_;
+  std::unique_ptr<checksum::ChecksummingBuffer> checksummer_;
+  std::unique_ptr<std::ostream> file_;  ///< Checksummed file contents.
+  std::unique_ptr<container::CompressingBuffer> compressor_;
+  std::unique_ptr<std::ostream> payload_;
+  std::unique_ptr<wikiopencite::citescoop::MessageWriter> writer_;
+};
 }  // namespace wikiopencite::citescoop::cli::io
 
 #endif  // SRC_IO_H_
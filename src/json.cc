@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "json.h"
+
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "fmt/format.h"
+
+namespace wikiopencite::citescoop::cli::json {
+
+std::string Escape(std::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+
+  for (const char kChr : value) {
+    switch (kChr) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(kChr) < 0x20) {
+          escaped += fmt::format("\\u{:04x}", static_cast<int>(kChr));
+        } else {
+          escaped += kChr;
+        }
+    }
+  }
+  return escaped;
+}
+
+Writer::Writer(std::ostream* output) : output_(output) {}
+
+void Writer::Separate() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+
+  if (has_elements_.empty())
+    return;
+
+  if (has_elements_.back())
+    *output_ << ',';
+  has_elements_.back() = true;
+}
+
+void Writer::BeginObject() {
+  Separate();
+  *output_ << '{';
+  has_elements_.push_back(false);
+}
+
+void Writer::EndObject() {
+  has_elements_.pop_back();
+  *output_ << '}';
+}
+
+void Writer::BeginArray() {
+  Separate();
+  *output_ << '[';
+  has_elements_.push_back(false);
+}
+
+void Writer::EndArray() {
+  has_elements_.pop_back();
+  *output_ << ']';
+}
+
+void Writer::Key(std::string_view key) {
+  Separate();
+  *output_ << '"' << Escape(key) << "\":";
+  after_key_ = true;
+}
+
+void Writer::String(std::string_view value) {
+  Separate();
+  *output_ << '"' << Escape(value) << '"';
+}
+
+void Writer::Int(int64_t value) {
+  Separate();
+  *output_ << value;
+}
+
+void Writer::Uint(uint64_t value) {
+  Separate();
+  *output_ << value;
+}
+
+void Writer::Double(double value) {
+  Separate();
+  if (std::isfinite(value)) {
+    *output_ << fmt::format("{}", value);
+  } else {
+    *output_ << "null";
+  }
+}
+
+void Writer::Bool(bool value) {
+  Separate();
+  *output_ << (value ? "true" : "false");
+}
+
+void Writer::Null() {
+  Separate();
+  *output_ << "null";
+}
+
+void Writer::Raw(std::string_view json) {
+  Separate();
+  *output_ << json;
+}
+
+}  // namespace wikiopencite::citescoop::cli::json
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_JSON_H_
+#define SRC_JSON_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wikiopencite::citescoop::cli::json {
+
+/// @brief Escape a string for inclusion in a JSON document, without
+/// the surrounding quotes.
+std::string Escape(std::string_view value);
+
+/// @brief Minimal streaming JSON writer used for machine readable
+/// command output. Commas are inserted automatically; the caller is
+/// responsible for balancing Begin and End calls.
+class Writer {
+ public:
+  explicit Writer(std::ostream* output);
+
+  void BeginObject();
+  void EndObject();
+  void BeginArray();
+  void EndArray();
+
+  /// @brief Write an object key. Must be followed by a value.
+  void Key(std::string_view key);
+
+  void String(std::string_view value);
+  void Int(int64_t value);
+  void Uint(uint64_t value);
+  void Double(double value);
+  void Bool(bool value);
+  void Null();
+
+  /// @brief Write a value that is already encoded as JSON.
+  void Raw(std::string_view json);
+
+ private:
+  /// Emit a separator if this is not the first element in the current
+  /// container.
+  void Separate();
+
+  std::ostream* output_;
+
+  /// One entry per open container, true once it has an element.
+  std::vector<bool> has_elements_;
+
+  /// Set after Key so the following value is not preceded by a comma.
+  bool after_key_ = false;
+};
+
+}  // namespace wikiopencite::citescoop::cli::json
+
+#endif  // SRC_JSON_H_
@@ -0,0 +1,414 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "key_index.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "container.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "io.h"
+#include "loser_tree.h"
+#include "spill.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace fs = std::filesystem;
+
+using Entry = std::pair<std::string, uint64_t>;
+
+constexpr size_t kFooterSize = 6 * sizeof(uint64_t) + KeyIndex::kMagic.size();
+
+/// Bookkeeping per buffered entry beyond its key bytes.
+constexpr size_t kEntryOverhead = sizeof(Entry) + sizeof(void*) * 2;
+
+/// @brief Modification time of a file, as recorded in the footer.
+uint64_t ModificationTime(const fs::path& path) {
+  return static_cast<uint64_t>(
+      fs::last_write_time(path).time_since_epoch().count());
+}
+
+bool ReadVarint(std::istream* input, uint64_t* value) {
+  *value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    const auto kByte = input->get();
+    if (kByte == std::istream::traits_type::eof())
+      return false;
+    *value |= static_cast<uint64_t>(kByte & 0x7F) << shift;
+    if ((kByte & 0x80) == 0)
+      return true;
+  }
+  throw exceptions::UserInputException("key index run is corrupt");
+}
+
+/// @brief Writes sorted entries into compressed blocks and the fence.
+class IndexWriter {
+ public:
+  IndexWriter(const std::string& path, uint64_t file_size,
+              uint64_t modified, uint64_t count)
+      : stream_(path, std::ios::out | std::ios::binary | std::ios::trunc),
+        file_size_(file_size),
+        modified_(modified),
+        count_(count) {
+    stream_.write(KeyIndex::kMagic.data(),
+                  static_cast<std::streamsize>(KeyIndex::kMagic.size()));
+    offset_ = KeyIndex::kMagic.size();
+  }
+
+  /// @brief Add the next entry in sorted order. Repeats are dropped.
+  void Add(const std::string& key, uint64_t position) {
+    if (entries_ > 0 && key == previous_ && position == previous_position_)
+      return;
+
+    if (in_block_ == 0)
+      first_key_ = key;
+
+    size_t shared = 0;
+    if (in_block_ > 0) {
+      const size_t kLimit = std::min(key.size(), previous_.size());
+      while (shared < kLimit && key[shared] == previous_[shared]) {
+        shared++;
+      }
+    }
+    binary::PutVarint(&block_, shared);
+    binary::PutString(&block_, std::string_view(key).substr(shared));
+    binary::PutVarint(&block_, position);
+
+    previous_ = key;
+    previous_position_ = position;
+    entries_++;
+    if (++in_block_ == KeyIndex::kEntriesPerBlock)
+      FlushBlock();
+  }
+
+  void Finish() {
+    FlushBlock();
+
+    std::string footer;
+    binary::PutFixed64(&footer, file_size_);
+    binary::PutFixed64(&footer, modified_);
+    binary::PutFixed64(&footer, count_);
+    binary::PutFixed64(&footer, entries_);
+    binary::PutFixed64(&footer, blocks_);
+    binary::PutFixed64(&footer, offset_);
+    footer.append(KeyIndex::kMagic);
+    stream_.write(fence_.data(), static_cast<std::streamsize>(fence_.size()));
+    stream_.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+    stream_.close();
+    if (!stream_)
+      throw exceptions::CliException("failed to write key index");
+  }
+
+  [[nodiscard]] uint64_t entries() const { return entries_; }
+
+ private:
+  void FlushBlock() {
+    if (in_block_ == 0)
+      return;
+
+    const auto kCompressed = container::CompressBlock(block_);
+    stream_.write(kCompressed.data(),
+                  static_cast<std::streamsize>(kCompressed.size()));
+
+    binary::PutString(&fence_, first_key_);
+    binary::PutFixed64(&fence_, offset_);
+    binary::PutFixed32(&fence_, static_cast<uint32_t>(kCompressed.size()));
+    binary::PutFixed32(&fence_, static_cast<uint32_t>(block_.size()));
+
+    offset_ += kCompressed.size();
+    blocks_++;
+    block_.clear();
+    in_block_ = 0;
+  }
+
+  std::ofstream stream_;
+  uint64_t file_size_;
+  uint64_t modified_;
+  uint64_t count_;
+  std::string block_;
+  std::string fence_;
+  std::string first_key_;
+  std::string previous_;
+  uint64_t previous_position_ = 0;
+  size_t in_block_ = 0;
+  uint64_t offset_ = 0;
+  uint64_t entries_ = 0;
+  uint64_t blocks_ = 0;
+};
+
+/// @brief Cursor over a sorted run of entries on disk.
+struct RunCursor {
+  std::unique_ptr<std::ifstream> stream;
+  Entry entry;
+  bool done = false;
+
+  void Next() {
+    uint64_t size;
+    if (!ReadVarint(stream.get(), &size)) {
+      done = true;
+      return;
+    }
+    entry.first.resize(size);
+    stream->read(entry.first.data(), static_cast<std::streamsize>(size));
+    if (!ReadVarint(stream.get(), &entry.second))
+      throw exceptions::UserInputException("key index run is truncated");
+  }
+};
+
+void WriteRun(std::vector<Entry>* entries, const fs::path& path) {
+  std::sort(entries->begin(), entries->end());
+
+  std::ofstream stream(path,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  std::string buffer;
+  for (const auto& [key, position] : *entries) {
+    binary::PutString(&buffer, key);
+    binary::PutVarint(&buffer, position);
+    if (buffer.size() >= size_t{1} << 20U) {
+      stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      buffer.clear();
+    }
+  }
+  stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  stream.close();
+  if (!stream)
+    throw exceptions::CliException("failed to write key index run");
+
+  entries->clear();
+}
+}  // namespace
+
+std::string KeyIndex::PathFor(const std::string& pbf_path,
+                              // NOLINTNEXTLINE(whitespace/indent_namespace)
+                              const std::string& key) {
+  return fmt::format("{}.{}.kidx", pbf_path, key);
+}
+
+uint64_t KeyIndex::Build(const std::string& pbf_path, const std::string& key,
+                         size_t memory_limit,
+                         // NOLINTNEXTLINE(whitespace/indent_namespace)
+                         const fs::path& tmp_dir) {
+  auto file = io::OpenPbfFile(pbf_path);
+  auto header = io::ReadPbfHeader(file.get());
+  const auto kPath = fields::FieldPath::Parse(
+      io::DescriptorForFileType(header->type()), key);
+
+  // Removed with its runs however the build ends.
+  const spill::Directory kRunDir(tmp_dir, "citescoop-index");
+  std::vector<fs::path> runs;
+  std::vector<Entry> entries;
+  size_t memory = 0;
+
+  for (uint64_t i = 0; i < header->count(); ++i) {
+    const uint64_t kPosition = io::TellPayload(file.get());
+    const auto kMessage = io::ReadGenericMessage(file.get(), header->type());
+    kPath.Visit(*kMessage, [&](const fields::Value& value) {
+      if (std::holds_alternative<std::monostate>(value))
+        return;
+      entries.emplace_back(fields::ToString(value), kPosition);
+      memory += entries.back().first.capacity() + kEntryOverhead;
+    });
+
+    if (memory >= memory_limit) {
+      runs.push_back(kRunDir.path() / fmt::format("{}.run", runs.size()));
+      WriteRun(&entries, runs.back());
+      memory = 0;
+    }
+  }
+  io::ClosePbfFile(std::move(file));
+
+  IndexWriter writer(PathFor(pbf_path, key), fs::file_size(pbf_path),
+                     ModificationTime(pbf_path), header->count());
+  if (runs.empty()) {
+    std::sort(entries.begin(), entries.end());
+    for (const auto& [value, position] : entries) {
+      writer.Add(value, position);
+    }
+  } else {
+    if (!entries.empty()) {
+      runs.push_back(kRunDir.path() / fmt::format("{}.run", runs.size()));
+      WriteRun(&entries, runs.back());
+    }
+    spdlog::debug("Merging {} sorted runs", runs.size());
+
+    std::vector<RunCursor> cursors(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+      cursors[i].stream = std::make_unique<std::ifstream>(
+          runs[i], std::ios::in | std::ios::binary);
+      cursors[i].Next();
+    }
+    auto less = [&cursors](size_t lhs, size_t rhs) {
+      if (cursors[lhs].done || cursors[rhs].done)
+        return !cursors[lhs].done || (cursors[rhs].done && lhs < rhs);
+      if (cursors[lhs].entry != cursors[rhs].entry)
+        return cursors[lhs].entry < cursors[rhs].entry;
+      return lhs < rhs;
+    };
+
+    LoserTree<decltype(less)> tree(cursors.size(), less);
+    while (!cursors[tree.Winner()].done) {
+      auto& cursor = cursors[tree.Winner()];
+      writer.Add(cursor.entry.first, cursor.entry.second);
+      cursor.Next();
+      tree.Replay();
+    }
+  }
+  writer.Finish();
+
+  return writer.entries();
+}
+
+std::optional<KeyIndex> KeyIndex::Load(const std::string& pbf_path,
+                                       // NOLINTNEXTLINE
+                                       const std::string& key) {
+  KeyIndex index;
+  index.path_ = PathFor(pbf_path, key);
+  std::ifstream stream(index.path_, std::ios::in | std::ios::binary);
+  if (!stream)
+    return std::nullopt;
+
+  std::error_code err;
+  const uint64_t kSize = fs::file_size(index.path_, err);
+  if (err || kSize < kMagic.size() + kFooterSize)
+    throw exceptions::UserInputException("key index is corrupt");
+
+  std::string buffer(kFooterSize, '\0');
+  stream.seekg(static_cast<std::streamoff>(kSize - kFooterSize));
+  stream.read(buffer.data(), static_cast<std::streamsize>(kFooterSize));
+  binary::Reader footer(buffer);
+  const uint64_t kFileSize = footer.Fixed64();
+  const uint64_t kModified = footer.Fixed64();
+  footer.Fixed64();  // Message count, kept for inspection.
+  index.entries_ = footer.Fixed64();
+  const uint64_t kBlocks = footer.Fixed64();
+  const uint64_t kFenceOffset = footer.Fixed64();
+  if (!stream || footer.Bytes(kMagic.size()) != kMagic ||
+      kFenceOffset > kSize - kFooterSize)
+    throw exceptions::UserInputException("key index is corrupt");
+
+  // A rewritten file of the same size is caught by its modification
+  // time.
+  if (kFileSize != fs::file_size(pbf_path, err) || err ||
+      kModified != ModificationTime(pbf_path))
+    return std::nullopt;
+
+  buffer.resize(kSize - kFooterSize - kFenceOffset);
+  stream.seekg(static_cast<std::streamoff>(kFenceOffset));
+  stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  if (!stream)
+    throw exceptions::UserInputException("key index is truncated");
+
+  binary::Reader fence(buffer);
+  index.fences_.reserve(kBlocks);
+  for (uint64_t i = 0; i < kBlocks; ++i) {
+    Fence entry;
+    entry.first_key = std::string(fence.String());
+    entry.offset = fence.Fixed64();
+    entry.compressed_size = fence.Fixed32();
+    entry.raw_size = fence.Fixed32();
+    index.fences_.push_back(std::move(entry));
+  }
+
+  index.fd_ = open(index.path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (index.fd_ < 0) {
+    throw exceptions::UserInputException(
+        fmt::format("cannot open {}", index.path_).c_str());
+  }
+  return index;
+}
+
+KeyIndex::~KeyIndex() {
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+KeyIndex::KeyIndex(KeyIndex&& other) noexcept { *this = std::move(other); }
+
+KeyIndex& KeyIndex::operator=(KeyIndex&& other) noexcept {
+  if (this != &other) {
+    if (fd_ >= 0)
+      close(fd_);
+    path_ = std::move(other.path_);
+    fd_ = std::exchange(other.fd_, -1);
+    entries_ = other.entries_;
+    fences_ = std::move(other.fences_);
+  }
+  return *this;
+}
+
+std::vector<uint64_t> KeyIndex::Lookup(std::string_view key) const {
+  std::vector<uint64_t> positions;
+
+  // Entries for key may start in the block before the first one whose
+  // first key is not below it, and run on through the following blocks.
+  auto block = std::lower_bound(
+      fences_.begin(), fences_.end(), key,
+      [](const Fence& fence, std::string_view target) {
+        return fence.first_key < target;
+      });
+  if (block != fences_.begin())
+    --block;
+
+  std::string compressed;
+  bool past = false;
+  for (; !past && block != fences_.end() && block->first_key <= key; ++block) {
+    compressed.resize(block->compressed_size);
+    size_t filled = 0;
+    while (filled < compressed.size()) {
+      const ssize_t kRead =
+          pread(fd_, compressed.data() + filled, compressed.size() - filled,
+                static_cast<off_t>(block->offset + filled));
+      if (kRead < 0 && errno == EINTR)
+        continue;
+      if (kRead <= 0)
+        throw exceptions::UserInputException("key index is truncated");
+      filled += static_cast<size_t>(kRead);
+    }
+
+    const auto kRaw = container::DecompressBlock(compressed, block->raw_size);
+    binary::Reader reader(kRaw);
+    std::string current;
+    while (!reader.empty()) {
+      const uint64_t kShared = reader.Varint();
+      if (kShared > current.size())
+        throw exceptions::UserInputException("key index is corrupt");
+      current.resize(kShared);
+      current += reader.String();
+      const uint64_t kPosition = reader.Varint();
+
+      if (current == key) {
+        positions.push_back(kPosition);
+      } else if (current > key) {
+        past = true;
+        break;
+      }
+    }
+  }
+
+  return positions;
+}
+
+}  // namespace wikiopencite::citescoop::cli
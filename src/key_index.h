@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_KEY_INDEX_H_
+#define SRC_KEY_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Sorted index from the value of a field to the positions of the
+/// messages holding it, stored next to a PBF file as
+/// <file>.<field>.kidx:
+///
+///     magic | block ... | fence entry ... | footer
+///
+/// Each block is a zstd frame of up to kEntriesPerBlock entries sorted
+/// by key then position. An entry is the length of the prefix it shares
+/// with the previous key in the block, the rest of the key and the
+/// position of the message as returned by io::TellPayload, all varint
+/// encoded. A fence entry gives the first key of a block (varint length
+/// and bytes), its offset (fixed64) and its compressed and raw sizes
+/// (fixed32 each). The footer holds the size and modification time of
+/// the indexed file, its message count, the number of entries and
+/// blocks and the offset of the fence (fixed64 each), followed by the
+/// magic again. The index is only used while the file's size and
+/// modification time still match.
+///
+/// Only the fence is read into memory and the file is kept open, so a
+/// lookup costs a binary search, one or two block reads and a seek per
+/// message found.
+namespace wikiopencite::citescoop::cli {
+
+class KeyIndex {
+ public:
+  /// Magic bytes at the start and end of an index file.
+  static constexpr std::string_view kMagic = "CSKEYIX2";
+
+  /// Entries per compressed block.
+  static constexpr size_t kEntriesPerBlock = 1024;
+
+  /// @brief Path of the index of a PBF file over a field path.
+  static std::string PathFor(const std::string& pbf_path,
+                             const std::string& key);
+
+  /// @brief Index a PBF file by every value a field path reaches in
+  /// each message, and write the index next to it.
+  ///
+  /// Entries are sorted in memory; beyond memory_limit bytes they are
+  /// written to sorted runs in tmp_dir and merged.
+  ///
+  /// @return Number of entries indexed.
+  static uint64_t Build(const std::string& pbf_path, const std::string& key,
+                        size_t memory_limit,
+                        const std::filesystem::path& tmp_dir);
+
+  /// @brief Load the fence of an index.
+  /// @return The index, or std::nullopt if there is none or it no
+  /// longer matches the file.
+  /// @throws exceptions::UserInputException if the index is corrupt.
+  static std::optional<KeyIndex> Load(const std::string& pbf_path,
+                                      const std::string& key);
+
+  ~KeyIndex();
+  KeyIndex(const KeyIndex&) = delete;
+  KeyIndex& operator=(const KeyIndex&) = delete;
+  KeyIndex(KeyIndex&& other) noexcept;
+  KeyIndex& operator=(KeyIndex&& other) noexcept;
+
+  /// @brief Positions of the messages holding a key, in file order.
+  /// Safe to call from several threads at once.
+  [[nodiscard]] std::vector<uint64_t> Lookup(std::string_view key) const;
+
+  [[nodiscard]] uint64_t entries() const { return entries_; }
+
+ private:
+  struct Fence {
+    std::string first_key;
+    uint64_t offset;
+    uint32_t compressed_size;
+    uint32_t raw_size;
+  };
+
+  KeyIndex() = default;
+
+  std::string path_;
+  int fd_ = -1;  ///< The index file, read with pread.
+  uint64_t entries_ = 0;
+  std::vector<Fence> fences_;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_KEY_INDEX_H_
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_LOSER_TREE_H_
+#define SRC_LOSER_TREE_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Tournament tree of losers for k-way merging.
+///
+/// The tree tracks which of k sources holds the smallest current item.
+/// After the winning source advances, Replay restores the invariant in
+/// log2(k) comparisons, against 2 log2(k) for a binary heap, as it only
+/// compares along the path from the winner's leaf to the root.
+///
+/// @tparam Less Callable taking two source indices, returning whether
+/// the current item of the first sorts before that of the second. An
+/// exhausted source must sort after every other source, and ties should
+/// be broken by index to keep the merge stable.
+template <typename Less>
+class LoserTree {
+ public:
+  /// @brief Build the tree over sources [0, sources).
+  LoserTree(size_t sources, Less less)
+      : size_(sources), less_(std::move(less)), losers_(sources) {
+    if (size_ == 0)
+      return;
+
+    // Winners of the subtrees rooted at each node, with the leaf of
+    // source i at node size_ + i.
+    std::vector<size_t> winners(2 * size_);
+    for (size_t i = 0; i < size_; ++i) {
+      winners[size_ + i] = i;
+    }
+    for (size_t node = size_ - 1; node >= 1; --node) {
+      const size_t kLeft = winners[2 * node];
+      const size_t kRight = winners[2 * node + 1];
+      if (less_(kRight, kLeft)) {
+        winners[node] = kRight;
+        losers_[node] = kLeft;
+      } else {
+        winners[node] = kLeft;
+        losers_[node] = kRight;
+      }
+    }
+    winner_ = size_ > 1 ? winners[1] : 0;
+  }
+
+  /// @brief Index of the source holding the smallest item.
+  [[nodiscard]] size_t Winner() const { return winner_; }
+
+  /// @brief Restore the tree after the winning source has advanced.
+  void Replay() {
+    size_t current = winner_;
+    for (size_t node = (size_ + current) / 2; node >= 1; node /= 2) {
+      if (less_(losers_[node], current))
+        std::swap(losers_[node], current);
+    }
+    winner_ = current;
+  }
+
+ private:
+  size_t size_;
+  Less less_;
+  std::vector<size_t> losers_;  ///< Loser at each internal node.
+  size_t winner_ = 0;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_LOSER_TREE_H_
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "offset_index.h"
+
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "exceptions.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace fs = std::filesystem;
+
+constexpr size_t kHeaderSize =
+    OffsetIndex::kMagic.size() + 3 * sizeof(uint64_t);
+}  // namespace
+
+std::string OffsetIndex::PathFor(const std::string& pbf_path) {
+  return pbf_path + ".idx";
+}
+
+OffsetIndex OffsetIndex::Build(const std::string& pbf_path, uint64_t stride) {
+  if (stride == 0)
+    throw exceptions::UserInputException("index stride must be positive");
+
+  auto file = io::OpenPbfFile(pbf_path);
+  auto header = io::ReadPbfHeader(file.get());
+
+  OffsetIndex index;
+  index.file_size_ = fs::file_size(pbf_path);
+  index.count_ = header->count();
+  index.stride_ = stride;
+  index.positions_.reserve(index.count_ / stride + 1);
+  for (uint64_t i = 0; i < index.count_; ++i) {
+    if (i % stride == 0)
+      index.positions_.push_back(io::TellPayload(file.get()));
+    io::ReadGenericMessage(file.get(), header->type());
+  }
+
+  io::ClosePbfFile(std::move(file));
+  return index;
+}
+
+std::optional<OffsetIndex> OffsetIndex::Load(const std::string& pbf_path) {
+  const auto kPath = PathFor(pbf_path);
+  std::ifstream stream(kPath, std::ios::in | std::ios::binary);
+  if (!stream)
+    return std::nullopt;
+
+  const std::string kData((std::istreambuf_iterator<char>(stream)),
+                          std::istreambuf_iterator<char>());
+  binary::Reader reader(kData);
+  if (kData.size() < kHeaderSize || reader.Bytes(kMagic.size()) != kMagic)
+    throw exceptions::UserInputException("offset index is corrupt");
+
+  OffsetIndex index;
+  index.file_size_ = reader.Fixed64();
+  index.count_ = reader.Fixed64();
+  index.stride_ = reader.Fixed64();
+  if (index.stride_ == 0 ||
+      reader.remaining() !=
+          (index.count_ + index.stride_ - 1) / index.stride_ * sizeof(uint64_t))
+    throw exceptions::UserInputException("offset index is corrupt");
+
+  std::error_code err;
+  if (fs::file_size(pbf_path, err) != index.file_size_ || err) {
+    spdlog::warn("Ignoring offset index {} as it does not match the file",
+                 kPath);
+    return std::nullopt;
+  }
+
+  index.positions_.reserve(reader.remaining() / sizeof(uint64_t));
+  while (!reader.empty()) {
+    index.positions_.push_back(reader.Fixed64());
+  }
+  return index;
+}
+
+void OffsetIndex::Save(const std::string& pbf_path) const {
+  std::string data(kMagic);
+  binary::PutFixed64(&data, file_size_);
+  binary::PutFixed64(&data, count_);
+  binary::PutFixed64(&data, stride_);
+  for (const uint64_t kPosition : positions_) {
+    binary::PutFixed64(&data, kPosition);
+  }
+
+  std::ofstream stream(PathFor(pbf_path),
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+  stream.close();
+  if (!stream)
+    throw exceptions::CliException("failed to write offset index");
+}
+
+std::pair<uint64_t, uint64_t> OffsetIndex::Locate(uint64_t ordinal) const {
+  const uint64_t kSlot = ordinal / stride_;
+  return {kSlot * stride_, positions_.at(kSlot)};
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_OFFSET_INDEX_H_
+#define SRC_OFFSET_INDEX_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Sparse index from message ordinal to position in a PBF file, stored
+/// next to the file as <file>.idx:
+///
+///     magic | file size | message count | stride | position ...
+///
+/// All integers are fixed64. The position of every stride-th message
+/// is recorded, as returned by io::TellPayload, so reaching any message
+/// takes one seek and fewer than stride reads.
+namespace wikiopencite::citescoop::cli {
+
+class OffsetIndex {
+ public:
+  /// Magic bytes at the start of an index file.
+  static constexpr std::string_view kMagic = "CSOFFIX1";
+
+  /// Messages between recorded positions.
+  static constexpr uint64_t kDefaultStride = 64;
+
+  /// @brief Path of the index belonging to a PBF file.
+  static std::string PathFor(const std::string& pbf_path);
+
+  /// @brief Index a PBF file by reading it once.
+  static OffsetIndex Build(const std::string& pbf_path, uint64_t stride);
+
+  /// @brief Load the index of a PBF file.
+  /// @return The index, or std::nullopt if there is none or it no
+  /// longer matches the file.
+  /// @throws exceptions::UserInputException if the index is corrupt.
+  static std::optional<OffsetIndex> Load(const std::string& pbf_path);
+
+  /// @brief Write the index next to the PBF file it was built from.
+  void Save(const std::string& pbf_path) const;
+
+  [[nodiscard]] uint64_t count() const { return count_; }
+  [[nodiscard]] uint64_t stride() const { return stride_; }
+
+  /// @brief The recorded message at or before ordinal.
+  /// @return Its ordinal and position.
+  [[nodiscard]] std::pair<uint64_t, uint64_t> Locate(uint64_t ordinal) const;
+
+ private:
+  OffsetIndex() = default;
+
+  uint64_t file_size_ = 0;
+  uint64_t count_ = 0;
+  uint64_t stride_ = kDefaultStride;
+  std::vector<uint64_t> positions_;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_OFFSET_INDEX_H_
@@ -19,6 +19,7 @@
 #include "citescoop/proto/file_header.pb.h"
 
 #include "cli.h"
+#include "container.h"
 #include "io.h"
 
 namespace {
@@ -38,7 +39,8 @@ Process::Process() : Command("process", "Process OpenAlex dump files") {
     ("institutions,I", options::value<std::string>()->required(),
       "Output file for institutions.")
     ("works,w", options::value<std::string>()->required(),
-      "Output file for works.");
+      "Output file for works.")
+    ("compress", "Write the payload as zstd compressed blocks.");
   // clang-format on
 }
 
@@ -99,6 +101,8 @@ void Process::AddHeaders(
       args_.institutions, std::ios::out | std::ios::binary | std::ios::trunc);
 
   auto header = proto::FileHeader();
+  if (args_.compress)
+    container::MarkCompressed(&header);
   header.set_count(std::get<0>(counts));
   header.set_type(proto::FileType::FILE_TYPE_OPENALEX_AUTHORS);
   io::PrependHeader(header, tmp_authors, &authors);
@@ -134,5 +138,6 @@ void Process::LoadArgs(const std::vector<std::string>& args) {
   args_.works = EnsureArgument<std::string>("works", parsed_args.first);
   args_.institutions =
       EnsureArgument<std::string>("institutions", parsed_args.first);
+  args_.compress = parsed_args.first.contains("compress");
 }
 }  // namespace wikiopencite::citescoop::cli::openalex
@@ -26,6 +26,7 @@ class Process : public Command {
     std::string authors;
     std::string institutions;
     std::string works;
+    bool compress;
   };
 
   /// @brief Open the output streams
@@ -0,0 +1,411 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "as_of.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/io.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "header.h"
+#include "io.h"
+#include "scan.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace cs = wikiopencite::citescoop;
+namespace fs = std::filesystem;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+constexpr std::string_view kDatePlaceholder = "{date}";
+}  // namespace
+
+AsOf::AsOf()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("as-of",
+              "Write the newest revision of every page at or before a "
+              "date") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::string>()->required(), "Revisions file.")
+    ("date,d", options::value<std::vector<std::string>>()->required(),
+      "Date to take a snapshot at, as YYYY-MM-DD (midnight UTC),"
+      " YYYY-MM-DDTHH:MM[:SS][Z] or seconds since the epoch. May be given"
+      " several times to take several snapshots in one pass.")
+    ("output,o", options::value<std::string>()->required(),
+      "Output pages file. With several dates it must contain {date},"
+      " which is replaced by each date as given.")
+    ("grouped",
+      "Input is grouped by page, as dump extract writes it, so it can be"
+      " streamed in one pass. Implied by files pbf sort ordered by"
+      " page_id.")
+    ("compress", "Write the payload as zstd compressed blocks.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  positional_options_.add("input", 1);
+  // clang-format on
+}
+
+ExitCode AsOf::Run(std::vector<std::string> args,
+                   // NOLINTNEXTLINE(whitespace/indent_namespace)
+                   struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    input_ = io::OpenPbfFile(args_.input);
+    header_ = io::ReadPbfHeader(input_.get());
+    if (header_->type() != proto::FileType::FILE_TYPE_REVISIONS) {
+      throw exceptions::UnsupportedFileType(
+          "as-of needs a revisions file");
+    }
+
+    const auto kSortKey = header::GetBytes(*header_, header::kSortKeyField);
+    const bool kSortedByPage =
+        kSortKey &&
+        (*kSortKey == "page_id" || kSortKey->starts_with("page_id,"));
+    if (args_.grouped || kSortedByPage) {
+      StreamGrouped();
+    } else {
+      ScanTable();
+    }
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to take snapshot: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    std::error_code err;
+    for (size_t i = 0; i < args_.dates.size(); ++i) {
+      fs::remove(OutputPath(i) + ".tmp", err);
+      if (outputs_created_)
+        fs::remove(OutputPath(i), err);
+    }
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void AsOf::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.dates =
+      EnsureArgument<std::vector<std::string>>("date", parsed_args.first);
+  args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.grouped = parsed_args.first.contains("grouped");
+  args_.compress = parsed_args.first.contains("compress");
+
+  args_.cutoffs.clear();
+  for (const auto& date : args_.dates) {
+    args_.cutoffs.push_back(ParseDate(date));
+  }
+
+  if (args_.dates.size() > 1 &&
+      args_.output.find(kDatePlaceholder) == std::string::npos) {
+    throw exceptions::UserInputException(
+        "output must contain {date} when several dates are given");
+  }
+
+  spdlog::debug("As-of arguments: input={} dates={} output={} threads={}",
+                args_.input, args_.dates.size(), args_.output, args_.threads);
+}
+
+void AsOf::StreamGrouped() {
+  const size_t kDates = args_.cutoffs.size();
+
+  // Held revisions are shared, as one revision is often the answer for
+  // several dates.
+  std::vector<std::shared_ptr<const proto::Revision>> chosen(kDates);
+  std::vector<uint64_t> counts(kDates, 0);
+  std::vector<std::ofstream> temps;
+  std::vector<cs::MessageWriter> writers;
+  temps.reserve(kDates);
+  writers.reserve(kDates);
+  outputs_created_ = true;
+  for (size_t i = 0; i < kDates; ++i) {
+    temps.emplace_back(OutputPath(i) + ".tmp",
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    writers.emplace_back(&temps.back());
+  }
+
+  auto end_page = [&]() {
+    for (size_t i = 0; i < kDates; ++i) {
+      if (!chosen[i])
+        continue;
+      writers[i].WriteMessage(ToPage(*chosen[i]));
+      counts[i]++;
+      chosen[i].reset();
+    }
+  };
+
+  std::optional<uint64_t> page;
+  for (uint64_t ordinal = 0; ordinal < header_->count(); ++ordinal) {
+    std::shared_ptr<const proto::Revision> revision(
+        static_cast<proto::Revision*>(
+            io::ReadGenericMessage(input_.get(), header_->type()).release()));
+    if (page != revision->page_id()) {
+      end_page();
+      page = revision->page_id();
+    }
+
+    for (size_t i = 0; i < kDates; ++i) {
+      if (revision->timestamp() > args_.cutoffs[i])
+        continue;
+      if (!chosen[i] ||
+          std::pair(chosen[i]->timestamp(), chosen[i]->revision_id()) <
+              std::pair(revision->timestamp(), revision->revision_id())) {
+        chosen[i] = revision;
+      }
+    }
+  }
+  end_page();
+  io::ClosePbfFile(std::move(input_));
+
+  for (size_t i = 0; i < kDates; ++i) {
+    const auto kPath = OutputPath(i);
+    temps[i].close();
+    if (!temps[i]) {
+      throw exceptions::CliException(
+          fmt::format("failed to write {}.tmp", kPath).c_str());
+    }
+
+    std::ifstream payload(kPath + ".tmp", std::ios::in | std::ios::binary);
+    std::ofstream output(kPath,
+                         std::ios::out | std::ios::binary | std::ios::trunc);
+    io::PrependHeader(OutputHeader(counts[i]), payload, &output);
+    payload.close();
+    output.close();
+    if (!output) {
+      throw exceptions::CliException(
+          fmt::format("failed to write {}", kPath).c_str());
+    }
+    fs::remove(kPath + ".tmp");
+
+    spdlog::info("Wrote {} pages as of {} to {}", counts[i], args_.dates[i],
+                 kPath);
+  }
+}
+
+void AsOf::ScanTable() {
+  const size_t kDates = args_.cutoffs.size();
+  const unsigned kWorkers = std::max(args_.threads, 1U);
+  using Table = std::unordered_map<uint64_t, std::vector<Choice>>;
+
+  // Pass 1: the newest revision per page and date, found by each worker
+  // for the revisions it saw, then merged.
+  std::vector<Table> tables(kWorkers);
+  scan::ParallelScan(
+      input_.get(), *header_, args_.threads,
+      [&](unsigned worker, uint64_t ordinal, const pb::Message& message) {
+        const auto& revision = static_cast<const proto::Revision&>(message);
+        std::vector<Choice>* choices = nullptr;
+        for (size_t i = 0; i < kDates; ++i) {
+          if (revision.timestamp() > args_.cutoffs[i])
+            continue;
+          if (choices == nullptr) {
+            choices = &tables[worker][revision.page_id()];
+            choices->resize(kDates);
+          }
+          auto& choice = (*choices)[i];
+          if (choice.IsOlderThan(revision.timestamp(),
+                                 revision.revision_id())) {
+            choice = {revision.timestamp(), revision.revision_id(), ordinal,
+                      true};
+          }
+        }
+      });
+  io::ClosePbfFile(std::move(input_));
+
+  Table& table = tables[0];
+  for (unsigned worker = 1; worker < kWorkers; ++worker) {
+    for (auto& [page, choices] : tables[worker]) {
+      auto [merged, added] = table.try_emplace(page, std::move(choices));
+      if (added)
+        continue;
+      for (size_t i = 0; i < kDates; ++i) {
+        const auto& other = choices[i];
+        if (other.found &&
+            merged->second[i].IsOlderThan(other.timestamp, other.revision_id))
+          merged->second[i] = other;
+      }
+    }
+    Table().swap(tables[worker]);
+  }
+
+  // Pass 2: copy the chosen revisions out in file order.
+  std::vector<std::pair<uint64_t, size_t>> wanted;
+  std::vector<uint64_t> counts(kDates, 0);
+  for (const auto& [page, choices] : table) {
+    for (size_t i = 0; i < kDates; ++i) {
+      if (!choices[i].found)
+        continue;
+      wanted.emplace_back(choices[i].ordinal, i);
+      counts[i]++;
+    }
+  }
+  spdlog::debug("Chose {} revisions of {} pages", wanted.size(),
+                table.size());
+  Table().swap(table);
+  std::sort(wanted.begin(), wanted.end());
+
+  std::vector<std::unique_ptr<io::PbfWriter>> writers;
+  outputs_created_ = true;
+  for (size_t i = 0; i < kDates; ++i) {
+    writers.push_back(std::make_unique<io::PbfWriter>(
+        OutputPath(i), OutputHeader(counts[i]), args_.threads));
+  }
+
+  input_ = io::OpenPbfFile(args_.input);
+  io::ReadPbfHeader(input_.get());
+  uint64_t ordinal = 0;
+  for (auto next = wanted.begin(); next != wanted.end();) {
+    const auto kMessage = io::ReadGenericMessage(input_.get(), header_->type());
+    const auto kPage =
+        ToPage(static_cast<const proto::Revision&>(*kMessage));
+    for (; next != wanted.end() && next->first == ordinal; ++next) {
+      writers[next->second]->Write(kPage);
+    }
+    ordinal++;
+  }
+  io::ClosePbfFile(std::move(input_));
+
+  for (size_t i = 0; i < kDates; ++i) {
+    writers[i]->Close();
+    spdlog::info("Wrote {} pages as of {} to {}", counts[i], args_.dates[i],
+                 OutputPath(i));
+  }
+}
+
+bool AsOf::Choice::IsOlderThan(int64_t other_timestamp,
+                               // NOLINTNEXTLINE(whitespace/indent_namespace)
+                               uint64_t other_revision_id) const {
+  return !found || std::pair(timestamp, revision_id) <
+                       std::pair(other_timestamp, other_revision_id);
+}
+
+std::string AsOf::OutputPath(size_t date) const {
+  std::string path = args_.output;
+  const auto kAt = path.find(kDatePlaceholder);
+  if (kAt != std::string::npos)
+    path.replace(kAt, kDatePlaceholder.size(), args_.dates[date]);
+  return path;
+}
+
+proto::FileHeader AsOf::OutputHeader(uint64_t count) const {
+  auto header = *header_;
+  header.set_type(proto::FileType::FILE_TYPE_PAGES);
+  header.set_count(count);
+  header::ClearLayout(&header);
+  header::Clear(&header, header::kSortKeyField);
+  if (args_.compress)
+    container::MarkCompressed(&header);
+  return header;
+}
+
+int64_t AsOf::ParseDate(const std::string& date) {
+  const auto kInvalid = [&date]() {
+    return exceptions::UserInputException(
+        fmt::format("invalid date: {}", date).c_str());
+  };
+
+  if (!date.empty() && date.find_first_not_of("0123456789-") ==
+                           std::string::npos &&
+      date.find('-', 1) == std::string::npos) {
+    int64_t seconds = 0;
+    const auto kResult =
+        std::from_chars(date.data(), date.data() + date.size(), seconds);
+    if (kResult.ec != std::errc() || kResult.ptr != date.data() + date.size())
+      throw kInvalid();
+    return seconds;
+  }
+
+  int year = 0;
+  unsigned month = 0;
+  unsigned day = 0;
+  unsigned hour = 0;
+  unsigned minute = 0;
+  unsigned second = 0;
+  int used = 0;
+  // NOLINTNEXTLINE(cert-err34-c)
+  if (std::sscanf(date.c_str(), "%4d-%2u-%2u%n", &year, &month, &day,
+                  &used) != 3)
+    throw kInvalid();
+
+  std::string_view rest = std::string_view(date).substr(used);
+  if (!rest.empty() && (rest.front() == 'T' || rest.front() == ' ')) {
+    const std::string kTime(rest.substr(1));
+    int time_used = 0;
+    // NOLINTNEXTLINE(cert-err34-c)
+    if (std::sscanf(kTime.c_str(), "%2u:%2u%n", &hour, &minute,
+                    &time_used) != 2)
+      throw kInvalid();
+    rest.remove_prefix(1 + time_used);
+    if (!rest.empty() && rest.front() == ':') {
+      const std::string kSeconds(rest.substr(1));
+      int seconds_used = 0;
+      // NOLINTNEXTLINE(cert-err34-c)
+      if (std::sscanf(kSeconds.c_str(), "%2u%n", &second, &seconds_used) != 1)
+        throw kInvalid();
+      rest.remove_prefix(1 + seconds_used);
+    }
+    if (rest == "Z")
+      rest.remove_prefix(1);
+  }
+
+  const std::chrono::year_month_day kDay{std::chrono::year(year),
+                                         std::chrono::month(month),
+                                         std::chrono::day(day)};
+  if (!rest.empty() || !kDay.ok() || hour > 23 || minute > 59 || second > 60)
+    throw kInvalid();
+
+  const auto kTime = std::chrono::sys_days(kDay) + std::chrono::hours(hour) +
+                     std::chrono::minutes(minute) +
+                     std::chrono::seconds(second);
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             kTime.time_since_epoch())
+      .count();
+}
+
+proto::Page AsOf::ToPage(const proto::Revision& revision) {
+  proto::Page page;
+  page.set_page_id(revision.page_id());
+  page.set_revision_id(revision.revision_id());
+  page.set_timestamp(revision.timestamp());
+  *page.mutable_citations() = revision.citations();
+  return page;
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_AS_OF_H_
+#define SRC_PBF_AS_OF_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/page.pb.h"
+#include "citescoop/proto/revision.pb.h"
+
+#include "cli.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to take a snapshot of the citations of every page as
+/// of one or more dates.
+///
+/// For each date the newest revision of each page at or before it is
+/// written to a pages file. All dates are answered by the same scan.
+///
+/// Input grouped by page, as dump extract writes it, is streamed: only
+/// the current page's best revision per date is held. Other input is
+/// read twice, first to fill a table of the newest qualifying revision
+/// of every page and date, then to copy the chosen revisions out.
+class AsOf : public Command {
+ public:
+  AsOf();
+
+  /// @brief Execute the as-of command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;               ///< Revisions file path.
+    std::vector<std::string> dates;  ///< Dates as given.
+    std::vector<int64_t> cutoffs;    ///< Dates in seconds since the epoch.
+    std::string output;              ///< Output path, may contain {date}.
+    bool grouped;                    ///< Input is grouped by page.
+    bool compress;                   ///< Compress output payloads.
+    unsigned threads;                ///< Number of worker threads.
+  };
+
+  /// @brief Newest revision of a page found so far for one date.
+  struct Choice {
+    int64_t timestamp = 0;
+    uint64_t revision_id = 0;
+    uint64_t ordinal = 0;
+    bool found = false;
+
+    /// @brief Whether a revision should replace this choice, because
+    /// nothing was found yet or it is newer. Ties on timestamp go to the
+    /// higher revision id.
+    [[nodiscard]] bool IsOlderThan(int64_t other_timestamp,
+                                   uint64_t other_revision_id) const;
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Answer every date in one pass over page grouped input.
+  void StreamGrouped();
+
+  /// @brief Answer every date with a table of the newest revision per
+  /// page and a second pass copying the chosen revisions.
+  void ScanTable();
+
+  /// @brief Output file of the date at an index.
+  [[nodiscard]] std::string OutputPath(size_t date) const;
+
+  /// @brief Header of an output file holding count pages.
+  [[nodiscard]] wikiopencite::proto::FileHeader OutputHeader(
+      uint64_t count) const;
+
+  /// @brief Parse a date given as YYYY-MM-DD, YYYY-MM-DDTHH:MM[:SS][Z] or
+  /// seconds since the epoch.
+  /// @throws exceptions::UserInputException if it is none of these.
+  static int64_t ParseDate(const std::string& date);
+
+  /// @brief Page state as of a revision.
+  static wikiopencite::proto::Page ToPage(
+      const wikiopencite::proto::Revision& revision);
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+
+  /// Whether output files were created, and so must be removed should
+  /// the command fail.
+  bool outputs_created_ = false;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_AS_OF_H_
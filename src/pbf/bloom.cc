@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "bloom.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "spdlog/spdlog.h"
+
+#include "bloom_filter.h"
+#include "cli.h"
+#include "exceptions.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+
+constexpr double kDefaultFalsePositiveRate = 0.01;
+}  // namespace
+
+Bloom::Bloom()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("bloom", "Build Bloom filters over a field of PBF files") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::vector<std::string>>()->required(),
+      "Input files.")
+    ("key,k", options::value<std::string>()->required(),
+      "Field path whose values the filters hold.")
+    ("false-positive-rate,p",
+      options::value<double>()->default_value(kDefaultFalsePositiveRate),
+      "Target rate at which a filter claims a value its file does not"
+      " hold. Lower rates cost more bits per value.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of threads scanning each file.");
+  positional_options_.add("input", -1);
+  // clang-format on
+}
+
+ExitCode Bloom::Run(std::vector<std::string> args,
+                    // NOLINTNEXTLINE(whitespace/indent_namespace)
+                    struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    for (const auto& input : args_.inputs) {
+      const auto kEntries = BloomFilter::Build(
+          input, args_.key, args_.false_positive_rate, args_.threads);
+      spdlog::info("Added about {} distinct keys to {}", kEntries,
+                   BloomFilter::PathFor(input, args_.key));
+    }
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to build Bloom filter: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Bloom::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.inputs =
+      EnsureArgument<std::vector<std::string>>("input", parsed_args.first);
+  args_.key = EnsureArgument<std::string>("key", parsed_args.first);
+  args_.false_positive_rate =
+      EnsureArgument<double>("false-positive-rate", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+
+  spdlog::trace("Bloom command arguments: Inputs: {} Key: {} Rate: {}",
+                args_.inputs.size(), args_.key, args_.false_positive_rate);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_BLOOM_H_
+#define SRC_PBF_BLOOM_H_
+
+#include <string>
+#include <vector>
+
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to build Bloom filters over the values of a field in
+/// one or more PBF files, letting get skip files that cannot hold a
+/// value without opening them.
+class Bloom : public Command {
+ public:
+  Bloom();
+
+  /// @brief Execute the bloom command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::vector<std::string> inputs;  ///< Input file paths.
+    std::string key;                  ///< Key field path.
+    double false_positive_rate;       ///< Target false positive rate.
+    unsigned threads;                 ///< Scanning threads per file.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_BLOOM_H_
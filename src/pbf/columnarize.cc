@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "columnarize.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "columnar.h"
+#include "exceptions.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace fs = std::filesystem;
+}  // namespace
+
+Columnarize::Columnarize()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("columnarize", "Convert a PBF file into a columnar file") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::string>()->required(), "Input file.")
+    ("output,o", options::value<std::string>()->required(), "Output file.")
+    ("row-group-size",
+      options::value<size_t>()->default_value(columnar::kDefaultRowGroupSize),
+      "Number of messages stored in each row group.");
+  // clang-format on
+
+  positional_options_.add("input", 1);
+  positional_options_.add("output", 1);
+}
+
+ExitCode Columnarize::Run(std::vector<std::string> args,
+                          // NOLINTNEXTLINE(whitespace/indent_namespace)
+                          struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    Convert();
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to convert input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    std::error_code err;
+    fs::remove(args_.output, err);
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Columnarize::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.row_group_size =
+      EnsureArgument<size_t>("row-group-size", parsed_args.first);
+
+  if (args_.row_group_size == 0)
+    throw exceptions::UserInputException("row group size must be positive");
+
+  spdlog::trace(
+      "Columnarize command arguments: Input: {} Output: {} Row group size: {}",
+      args_.input, args_.output, args_.row_group_size);
+}
+
+void Columnarize::Convert() {
+  auto input = io::OpenPbfFile(args_.input);
+  auto header = io::ReadPbfHeader(input.get());
+
+  std::ofstream output(args_.output,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  columnar::Writer writer(&output, header->type(), args_.row_group_size);
+
+  for (uint64_t i = 0; i < header->count(); i++) {
+    auto message = io::ReadGenericMessage(input.get(), header->type());
+    if (!message)
+      break;
+    writer.Add(*message);
+  }
+
+  writer.Finish();
+  output.close();
+  io::ClosePbfFile(std::move(input));
+
+  spdlog::info("Wrote {} rows to {}", header->count(), args_.output);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
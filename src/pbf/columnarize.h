@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_COLUMNARIZE_H_
+#define SRC_PBF_COLUMNARIZE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to convert a PBF file into the columnar layout, so
+/// that analytical commands such as group-by only read the columns
+/// they need.
+class Columnarize : public Command {
+ public:
+  Columnarize();
+
+  /// @brief Execute the columnarize command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;      ///< Input file path.
+    std::string output;     ///< Output file path.
+    size_t row_group_size;  ///< Rows per row group.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Copy every message of the input into the columnar writer.
+  void Convert();
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_COLUMNARIZE_H_
@@ -3,17 +3,23 @@
 
 #include "combine.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>  // NOLINT(build/c++17)
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <ostream>
 #include <string>
 #include <system_error>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "boost/program_options/options_description.hpp"
@@ -25,14 +31,20 @@
 #include "citescoop/proto/language.pb.h"
 #include "citescoop/proto/page.pb.h"
 #include "citescoop/proto/revision.pb.h"
+#include "fmt/format.h"
 #include "fmt/ranges.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
+#include "roaring/roaring64map.hh"
 #include "spdlog/spdlog.h"
 
 #include "cli.h"
+#include "container.h"
 #include "exceptions.h"
+#include "fields.h"
 #include "io.h"
+#include "scan.h"
+#include "thread_pool.h"
 
 namespace wikiopencite::citescoop::cli::pbf {
 
@@ -40,7 +52,15 @@ namespace {
 namespace options = boost::program_options;
 namespace cs = wikiopencite::citescoop;
 namespace fs = std::filesystem;
+namespace pb = google::protobuf;
 namespace proto = wikiopencite::proto;
+
+constexpr size_t kDefaultFanIn = 64;
+constexpr size_t kDefaultMaxOpenFiles = 256;
+
+/// Files a single combine holds open: the input being read, its
+/// temporary payload and its output.
+constexpr size_t kFilesPerCombine = 3;
 }  // namespace
 
 Combine::Combine()
@@ -50,7 +70,20 @@ Combine::Combine()
   cli_options_.add_options()
     ("input,i", options::value<std::vector<std::string>>()->required(),
       "Input files to be combined.")
-    ("output,o", options::value<std::string>()->required(), "Output file");
+    ("output,o", options::value<std::string>()->required(), "Output file")
+    ("compress", "Write the payload as zstd compressed blocks.")
+    ("keep-duplicates", "Copy every message, skipping the pass over the"
+      " inputs that finds duplicates.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.")
+    ("fan-in", options::value<size_t>()->default_value(kDefaultFanIn),
+      "Inputs combined at once. More inputs are first combined into"
+      " intermediate files, in parallel.")
+    ("max-open-files",
+      options::value<size_t>()->default_value(kDefaultMaxOpenFiles),
+      "Most files to hold open at once.");
   // clang-format on
 
   positional_options_.add("output", 1);
@@ -66,23 +99,24 @@ ExitCode Combine::Run(
   file_type_ = proto::FileType::FILE_TYPE_UNSPECIFIED;
 
   LoadArgs(args);
-  OpenStreams();
   try {
     ReadHeaders();
-    CopyData();
+    const uint64_t kWritten = MergeTree();
+    if (kWritten < total_messages_)
+      spdlog::info("Dropped {} duplicate messages",
+                   total_messages_ - kWritten);
   } catch (const exceptions::UnsupportedFileType& e) {
     spdlog::critical("Failed to read input file: {}", e.what());
     std::cerr << e.what() << '\n';
 
-    CloseStreams();
-    streams_.tmp_output.close();
-    CleanupTempFile();
+    return e.code();
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to combine input files: {}", e.what());
+    std::cerr << e.what() << '\n';
 
     return e.code();
   }
 
-  CloseStreams();
-
   return ExitCode::kOk;
 }
 
@@ -91,40 +125,48 @@ void Combine::LoadArgs(const std::vector<std::string>& args) {
   args_.inputs =
       EnsureArgument<std::vector<std::string>>("input", parsed_args.first);
   args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.compress = parsed_args.first.contains("compress");
+  args_.keep_duplicates = parsed_args.first.contains("keep-duplicates");
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.fan_in = EnsureArgument<size_t>("fan-in", parsed_args.first);
+  args_.max_open_files =
+      EnsureArgument<size_t>("max-open-files", parsed_args.first);
+
+  if (args_.fan_in < 2)
+    throw exceptions::UserInputException("fan-in must be at least 2");
+  if (args_.max_open_files < kFilesPerCombine) {
+    throw exceptions::UserInputException(
+        fmt::format("max-open-files must be at least {}", kFilesPerCombine)
+            .c_str());
+  }
 
   spdlog::trace("Combine command arguments: Inputs: {} Output: {}",
                 fmt::join(args_.inputs, ", "), args_.output);
 }
 
-void Combine::OpenStreams() {
-  streams_.inputs = std::vector<std::unique_ptr<io::PbfFile>>();
-  for (const auto& file : args_.inputs) {
-    streams_.inputs.push_back(io::OpenPbfFile(file));
+void Combine::ReadHeaders() {
+  std::vector<std::future<std::unique_ptr<proto::FileHeader>>> headers;
+  {
+    ThreadPool pool(static_cast<unsigned>(std::min<size_t>(
+        std::max(args_.threads, 1U), args_.max_open_files)));
+    for (const auto& input : args_.inputs) {
+      headers.push_back(pool.Submit([&input]() {
+        auto file = io::OpenPbfFile(input);
+        auto header = io::ReadPbfHeader(file.get());
+        io::ClosePbfFile(std::move(file));
+        return header;
+      }));
+    }
   }
 
-  streams_.output = std::ofstream(
-      args_.output, std::ios::out | std::ios::binary | std::ios::trunc);
-  streams_.tmp_output =
-      std::ofstream(args_.output + ".tmp",
-                    std::ios::out | std::ios::binary | std::ios::trunc);
-}
-
-void Combine::CloseStreams() {
-  for (auto& stream : streams_.inputs) {
-    io::ClosePbfFile(std::move(stream));
-  }
-
-  streams_.output.close();
-}
-
-void Combine::ReadHeaders() {
-  for (auto& stream : streams_.inputs) {
-    auto header = io::ReadPbfHeader(stream.get());
-    ValidateFileType(header->type());
-    ValidateFileSpecificAttributes(*header);
-    total_messages_ += header->count();
-    message_counts_.push_back(header->count());
+  for (auto& pending : headers) {
+    const auto kHeader = pending.get();
+    ValidateFileType(kHeader->type());
+    ValidateFileSpecificAttributes(*kHeader);
+    total_messages_ += kHeader->count();
   }
+  spdlog::debug("Read the headers of {} inputs holding {} messages",
+                args_.inputs.size(), total_messages_);
 }
 
 void Combine::ValidateFileType(proto::FileType type) {
@@ -190,69 +232,268 @@ bool IsUniqueOpenAlexId(
   return seen_ids->insert(kOpenAlexId).second;
 }
 
+/// @brief The page or revision id of a message, or std::nullopt if it
+/// has none. Protobuf cannot tell an unset id from 0, so 0 is none.
+std::optional<uint64_t> KeyOf(const fields::FieldPath& key,
+                              const google::protobuf::Message& message) {
+  const auto kValue = key.First(message);
+  if (const auto* id = std::get_if<uint64_t>(&kValue); id && *id != 0)
+    return *id;
+  if (const auto* id = std::get_if<int64_t>(&kValue); id && *id > 0)
+    return static_cast<uint64_t>(*id);
+  return std::nullopt;
+}
+
 }  // namespace
 
-std::function<bool(const google::protobuf::Message&)>
-Combine::PredicateFactory() const {
+Combine::KeyedDedupe Combine::IndexKeys(
+    const std::vector<std::string>& inputs,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    unsigned threads) const {
+  KeyedDedupe dedupe;
+  if (args_.keep_duplicates ||
+      (file_type_ != proto::FileType::FILE_TYPE_PAGES &&
+       file_type_ != proto::FileType::FILE_TYPE_REVISIONS))
+    return dedupe;
+
+  dedupe.key = fields::FieldPath::Parse(
+      io::DescriptorForFileType(file_type_),
+      file_type_ == proto::FileType::FILE_TYPE_PAGES
+          ? fields::kPageIdField
+          : fields::kRevisionIdField);
+
+  struct Worker {
+    roaring::Roaring64Map ids;
+    std::unordered_map<uint64_t, uint64_t> repeats;
+  };
+
+  // Inputs are indexed last first against the union of the ids after
+  // them, so only that union and the superseded ids of each input are
+  // held rather than every input's ids.
+  const size_t kInputs = inputs.size();
+  roaring::Roaring64Map later;
+  dedupe.superseded.resize(kInputs);
+  dedupe.repeats.resize(kInputs);
+  size_t bytes = 0;
+  for (size_t i = kInputs; i-- > 0;) {
+    std::vector<Worker> workers(std::max(threads, 1U));
+    auto file = io::OpenPbfFile(inputs[i]);
+    const auto kHeader = io::ReadPbfHeader(file.get());
+    scan::ParallelScan(
+        file.get(), *kHeader, threads,
+        [&](unsigned worker, uint64_t, const pb::Message& message) {
+          const auto kId = KeyOf(*dedupe.key, message);
+          if (!kId)
+            return;
+          auto& state = workers[worker];
+          if (state.ids.contains(*kId)) {
+            state.repeats.try_emplace(*kId, 1).first->second++;
+          } else {
+            state.ids.add(*kId);
+          }
+        });
+    io::ClosePbfFile(std::move(file));
+
+    // An id seen by several workers occurs as often as they saw it in
+    // total, one occurrence for each worker without a repeat count.
+    auto& merged = workers[0];
+    for (size_t w = 1; w < workers.size(); ++w) {
+      const auto& other = workers[w];
+      const auto kOccurrences = [](const Worker& state, uint64_t id) {
+        const auto kFound = state.repeats.find(id);
+        return kFound == state.repeats.end() ? uint64_t{1} : kFound->second;
+      };
+      for (const uint64_t kId : merged.ids & other.ids) {
+        merged.repeats[kId] = kOccurrences(merged, kId) +
+                              kOccurrences(other, kId);
+      }
+      for (const auto& [id, count] : other.repeats) {
+        if (!merged.ids.contains(id))
+          merged.repeats.emplace(id, count);
+      }
+      merged.ids |= other.ids;
+    }
+
+    dedupe.repeats[i] = std::move(merged.repeats);
+    spdlog::debug("{} holds {} distinct ids, {} of them repeated", inputs[i],
+                  merged.ids.cardinality(), dedupe.repeats[i].size());
+
+    dedupe.superseded[i] = merged.ids & later;
+    dedupe.superseded[i].runOptimize();
+    bytes += dedupe.superseded[i].getSizeInBytes();
+    later |= merged.ids;
+    later.runOptimize();
+  }
+
+  spdlog::debug("Indexed the ids of {} inputs in {} bytes of bitmaps",
+                kInputs, bytes + later.getSizeInBytes());
+  return dedupe;
+}
+
+std::function<bool(size_t, const google::protobuf::Message&)>
+Combine::PredicateFactory(KeyedDedupe* dedupe) const {
   switch (file_type_) {
     case proto::FileType::FILE_TYPE_OPENALEX_WORKS:
     case proto::FileType::FILE_TYPE_OPENALEX_INSTITUTIONS:
     case proto::FileType::FILE_TYPE_OPENALEX_AUTHORS: {
+      if (args_.keep_duplicates)
+        break;
       auto seen_ids = std::make_shared<std::unordered_set<std::string>>();
-      return [seen_ids](const google::protobuf::Message& message) {
+      return [seen_ids](size_t, const google::protobuf::Message& message) {
         return IsUniqueOpenAlexId(message, seen_ids);
       };
     }
-    default:
-      return [](const google::protobuf::Message&) {
-        return true;
+    case proto::FileType::FILE_TYPE_PAGES:
+    case proto::FileType::FILE_TYPE_REVISIONS: {
+      if (!dedupe->key)
+        break;
+      return [dedupe](size_t input, const google::protobuf::Message& message) {
+        const auto kId = KeyOf(*dedupe->key, message);
+        if (!kId)
+          return true;
+        if (dedupe->superseded[input].contains(*kId))
+          return false;
+        auto& repeats = dedupe->repeats[input];
+        const auto kFound = repeats.find(*kId);
+        return kFound == repeats.end() || --kFound->second == 0;
       };
+    }
+    default:
+      break;
+  }
+  return [](size_t, const google::protobuf::Message&) {
+    return true;
+  };
+}
+
+uint64_t Combine::MergeTree() {
+  std::vector<std::string> level = args_.inputs;
+  std::vector<std::string> intermediates;
+  const auto kCleanup = [](const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+      CleanupTempFile(path);
+    }
+  };
+
+  try {
+    for (size_t depth = 0; level.size() > args_.fan_in; ++depth) {
+      const size_t kGroups = (level.size() + args_.fan_in - 1) / args_.fan_in;
+      const auto kConcurrent = static_cast<unsigned>(
+          std::min({static_cast<size_t>(std::max(args_.threads, 1U)),
+                    kGroups, args_.max_open_files / kFilesPerCombine}));
+      spdlog::info("Combining {} files into {} on {} threads", level.size(),
+                   kGroups, kConcurrent);
+
+      std::vector<std::string> next;
+      for (size_t group = 0; group < kGroups; ++group) {
+        next.push_back(fmt::format("{}.{}-{}.tmp", args_.output, depth, group));
+      }
+
+      try {
+        ThreadPool pool(kConcurrent);
+        std::vector<std::future<uint64_t>> pending;
+        for (size_t group = 0; group < kGroups; ++group) {
+          const auto kFirst =
+              level.begin() + static_cast<ptrdiff_t>(group * args_.fan_in);
+          const auto kLast =
+              level.begin() + static_cast<ptrdiff_t>(std::min(
+                                  level.size(), (group + 1) * args_.fan_in));
+          pending.push_back(pool.Submit(
+              [this, inputs = std::vector<std::string>(kFirst, kLast),
+               &output = next[group]]() {
+                return CombineFiles(inputs, output, false, 1);
+              }));
+        }
+        for (auto& combined : pending) {
+          combined.get();
+        }
+      } catch (...) {
+        kCleanup(next);
+        throw;
+      }
+
+      kCleanup(intermediates);
+      intermediates = next;
+      level = std::move(next);
+    }
+
+    const uint64_t kWritten =
+        CombineFiles(level, args_.output, args_.compress, args_.threads);
+    kCleanup(intermediates);
+    return kWritten;
+  } catch (...) {
+    kCleanup(intermediates);
+    throw;
   }
 }
 
-void Combine::CopyData() {
-  const auto kTempPath = args_.output + ".tmp";
+uint64_t Combine::CombineFiles(const std::vector<std::string>& inputs,
+                               const std::string& output, bool compress,
+                               // NOLINTNEXTLINE(whitespace/indent_namespace)
+                               unsigned threads) const {
+  const auto kTempPath = output + ".tmp";
+  auto dedupe = IndexKeys(inputs, threads);
 
-  const uint64_t kTotalWritten = CopyMessagesToTemp();
-  streams_.tmp_output.close();
+  std::ofstream tmp_output(kTempPath,
+                           std::ios::out | std::ios::binary | std::ios::trunc);
+  uint64_t total_written = 0;
+  try {
+    total_written = CopyMessagesToTemp(inputs, &dedupe, &tmp_output);
+  } catch (...) {
+    tmp_output.close();
+    CleanupTempFile(kTempPath);
+    throw;
+  }
+  tmp_output.close();
 
   auto fileheader = proto::FileHeader();
   fileheader.set_type(file_type_);
-  fileheader.set_count(kTotalWritten);
+  fileheader.set_count(total_written);
 
   SetAdditionalAttributes(&fileheader);
-
-  auto writer = cs::MessageWriter(&streams_.output);
-  writer.WriteMessage(fileheader);
+  if (compress)
+    container::MarkCompressed(&fileheader);
 
   std::ifstream tmp_input(kTempPath, std::ios::in | std::ios::binary);
-  streams_.output << tmp_input.rdbuf();
+  std::ofstream output_stream(
+      output, std::ios::out | std::ios::binary | std::ios::trunc);
+  io::PrependHeader(fileheader, tmp_input, &output_stream);
   tmp_input.close();
+  output_stream.close();
 
-  CleanupTempFile();
+  CleanupTempFile(kTempPath);
+  if (!output_stream) {
+    throw exceptions::CliException(
+        fmt::format("failed to write {}", output).c_str());
+  }
+  return total_written;
 }
 
-uint64_t Combine::CopyMessagesToTemp() {
+uint64_t Combine::CopyMessagesToTemp(
+    const std::vector<std::string>& inputs, KeyedDedupe* dedupe,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    std::ostream* output) const {
   uint64_t total_written = 0;
-  auto tmp_writer = cs::MessageWriter(&streams_.tmp_output);
-  auto predicate = PredicateFactory();
+  auto tmp_writer = cs::MessageWriter(output);
+  auto predicate = PredicateFactory(dedupe);
 
-  for (std::size_t i = 0; i < streams_.inputs.size(); ++i) {
-    auto& stream = streams_.inputs[i];
-    auto count = message_counts_[i];
-    for (uint64_t j = 0; j < count; ++j) {
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    auto stream = io::OpenPbfFile(inputs[i]);
+    const auto kHeader = io::ReadPbfHeader(stream.get());
+    for (uint64_t j = 0; j < kHeader->count(); ++j) {
       auto message = io::ReadGenericMessage(stream.get(), file_type_);
-      if (predicate(*message)) {
+      if (predicate(i, *message)) {
         tmp_writer.WriteMessage(*message);
         total_written++;
       }
     }
+    io::ClosePbfFile(std::move(stream));
   }
   return total_written;
 }
 
-void Combine::CleanupTempFile() const {
-  const fs::path kTempPath = args_.output + ".tmp";
+void Combine::CleanupTempFile(const std::string& path) {
+  const fs::path kTempPath = path;
   std::error_code err;
   fs::remove(kTempPath, err);
   if (err) {
@@ -260,13 +501,13 @@ void Combine::CleanupTempFile() const {
   }
 }
 
-void Combine::SetAdditionalAttributes(wikiopencite::proto::FileHeader* header) {
+void Combine::SetAdditionalAttributes(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    wikiopencite::proto::FileHeader* header) const {
   switch (file_type_) {
     case proto::FileType::FILE_TYPE_PAGES:
     case proto::FileType::FILE_TYPE_REVISIONS: {
-      auto attributes = proto::DumpFileAdditionalData();
-      attributes.set_language(language_);
-      header->set_allocated_dump_file_attributes(&attributes);
+      header->mutable_dump_file_attributes()->set_language(language_);
       break;
     }
     default:
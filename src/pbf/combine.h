@@ -4,24 +4,40 @@
 #ifndef SRC_PBF_COMBINE_H_
 #define SRC_PBF_COMBINE_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <fstream>
 #include <functional>
-#include <memory>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "citescoop/proto/file_header.pb.h"
 #include "citescoop/proto/language.pb.h"
-#include "citescoop/proto/page.pb.h"
-#include "citescoop/proto/revision.pb.h"
+#include "google/protobuf/message.h"
+#include "roaring/roaring64map.hh"
 
 #include "cli.h"
-#include "io.h"
+#include "fields.h"
 
 namespace wikiopencite::citescoop::cli::pbf {
 
 /// @brief Command to combine multiple PBF files into a single output file.
+///
+/// Duplicates are dropped. OpenAlex records keep their first copy. Pages
+/// and revisions keep their copy from the last input holding their
+/// page_id or revision_id, so an extract followed by incremental ones
+/// combine into the latest state. The ids of each input are collected
+/// into Roaring bitmaps by a parallel pre-pass, as wiki ids are dense
+/// integers that such bitmaps store in a few bits each.
+///
+/// Inputs are opened one at a time. When there are more than --fan-in
+/// of them, runs of fan_in consecutive inputs are first combined into
+/// intermediate files, independent runs on separate threads, and so on
+/// up a tree until one final combine remains. Both dedupes give the
+/// same result whether applied at once or run by run, so the tree
+/// output equals a flat one.
 class Combine : public Command {
  public:
   Combine();
@@ -36,27 +52,30 @@ class Combine : public Command {
   struct Args {
     std::vector<std::string> inputs;  ///< Input file paths.
     std::string output;               ///< Output file path.
+    bool compress;                    ///< Block compress the output.
+    bool keep_duplicates;             ///< Copy every message.
+    unsigned threads;                 ///< Number of worker threads.
+    size_t fan_in;                    ///< Inputs combined at once.
+    size_t max_open_files;            ///< Files open at once.
   };
 
-  struct Streams {
-    std::vector<std::unique_ptr<io::PbfFile>> inputs;  ///< Input file streams.
-    std::ofstream output;                              ///< Output file stream.
-    std::ofstream tmp_output;  ///< Temporary output file stream.
+  /// @brief Which copy of each page or revision to keep.
+  struct KeyedDedupe {
+    std::optional<fields::FieldPath> key;  ///< page_id or revision_id.
+    /// Ids of each input also found in a later input, whose copy wins.
+    std::vector<roaring::Roaring64Map> superseded;
+    /// Occurrences of ids found more than once within each input. Only
+    /// the last occurrence is kept and the count falls as they go by.
+    std::vector<std::unordered_map<uint64_t, uint64_t>> repeats;
   };
 
   /// @brief Parse command line arguments.
   /// @param args CLI arguments passed to the command.
   void LoadArgs(const std::vector<std::string>& args);
 
-  /// @brief Open all input streams and the output stream.
-  void OpenStreams();
-
-  /// @brief Close all open file streams. Note: Does not close the
-  /// temporary output stream, as it is closed after writing the file
-  /// header.
-  void CloseStreams();
-
   /// @brief Read headers from each input file to validate compatibility.
+  /// Headers are read on a thread pool, each thread opening one file at
+  /// a time.
   void ReadHeaders();
 
   /// @brief Validate that all input files have the same PBF file type.
@@ -72,27 +91,50 @@ class Combine : public Command {
   /// @param language Language from the current input header.
   void ValidateLanguage(wikiopencite::proto::Language language);
 
-  /// @brief Create a predicate used to filter messages during copy.
-  /// @return A function used to determine whether a message should be copied.
-  std::function<bool(const google::protobuf::Message&)> PredicateFactory()
-      const;
-
-  /// @brief Copy the payload of all input files to the output file.
-  void CopyData();
-
-  uint64_t CopyMessagesToTemp();
+  /// @brief Combine the inputs fan_in at a time, level by level, into
+  /// the output file.
+  /// @return Number of messages written to the output.
+  uint64_t MergeTree();
+
+  /// @brief Combine a run of files into one PBF file.
+  /// @param inputs Files to combine, in order.
+  /// @param output Path of the file to write.
+  /// @param compress Whether to block compress its payload.
+  /// @param threads Threads for the duplicate pre-pass.
+  /// @return Number of messages written.
+  uint64_t CombineFiles(const std::vector<std::string>& inputs,
+                        const std::string& output, bool compress,
+                        unsigned threads) const;
+
+  /// @brief Collect the ids of every input for the latest-wins dedupe
+  /// of pages and revisions.
+  KeyedDedupe IndexKeys(const std::vector<std::string>& inputs,
+                        unsigned threads) const;
 
-  void CleanupTempFile() const;
+  /// @brief Create a predicate used to filter messages during copy.
+  /// @param dedupe Ids collected by IndexKeys, updated as messages are
+  /// copied.
+  /// @return A function used to determine whether a message of the
+  /// given input should be copied.
+  std::function<bool(size_t, const google::protobuf::Message&)>
+  PredicateFactory(KeyedDedupe* dedupe) const;
+
+  /// @brief Copy the messages of the inputs that pass the dedupe to a
+  /// framed payload.
+  /// @return Number of messages copied.
+  uint64_t CopyMessagesToTemp(const std::vector<std::string>& inputs,
+                              KeyedDedupe* dedupe,
+                              std::ostream* output) const;
+
+  static void CleanupTempFile(const std::string& path);
 
   /// @brief Set additional attributes for the output file.
   /// @param header The file header to set additional attributes for.
-  void SetAdditionalAttributes(wikiopencite::proto::FileHeader* header);
+  void SetAdditionalAttributes(wikiopencite::proto::FileHeader* header) const;
 
   wikiopencite::proto::Language language_;
   Args args_;
-  Streams streams_;
   uint64_t total_messages_;
-  std::vector<uint64_t> message_counts_;
   wikiopencite::proto::FileType file_type_;
 };
 
@@ -0,0 +1,461 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "diff.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/json_util.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "hash.h"
+#include "header.h"
+#include "io.h"
+#include "json.h"
+#include "scan.h"
+#include "spill.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace fs = std::filesystem;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+constexpr size_t kBytesPerMebibyte = size_t{1} << 20U;
+constexpr size_t kDefaultMemoryLimit = 1024;
+
+/// Rough per entry overhead of an unordered_map node.
+constexpr size_t kEntryOverhead = 64;
+
+/// Separates the values of a compound key.
+constexpr char kKeySeparator = '\x1f';
+
+constexpr const char* kSideNames[] = {"old", "new"};
+
+/// @brief Writes one change per line as a JSON object.
+class JsonlSink {
+ public:
+  explicit JsonlSink(std::ostream* output) : output_(output) {}
+
+  void Write(std::string_view change, const std::string& key,
+             const pb::Message& message) {
+    std::string record;
+    const auto kStatus = pb::util::MessageToJsonString(message, &record);
+    if (!kStatus.ok()) {
+      throw exceptions::CliException(
+          fmt::format("failed to convert message to JSON: {}",
+                      std::string(kStatus.message())));
+    }
+
+    *output_ << R"({"change":")" << change << R"(","key":)";
+    if (key.find(kKeySeparator) == std::string::npos) {
+      *output_ << '"' << json::Escape(key) << '"';
+    } else {
+      *output_ << '[';
+      size_t start = 0;
+      for (size_t end = key.find(kKeySeparator);;
+           end = key.find(kKeySeparator, start)) {
+        if (start > 0)
+          *output_ << ',';
+        *output_ << '"' << json::Escape(key.substr(start, end - start))
+                 << '"';
+        if (end == std::string::npos)
+          break;
+        start = end + 1;
+      }
+      *output_ << ']';
+    }
+    *output_ << R"(,"record":)" << record << "}\n";
+  }
+
+ private:
+  std::ostream* output_;
+};
+}  // namespace
+
+Diff::Diff()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("diff", "Compare two snapshots of a PBF file by key") {
+  // clang-format off
+  cli_options_.add_options()
+    ("old", options::value<std::string>()->required(), "Old snapshot.")
+    ("new", options::value<std::string>()->required(), "New snapshot.")
+    ("key,k", options::value<std::string>()->required(),
+      "Comma separated field paths identifying a message, for example"
+      " page_id. Repeated fields use their first value.")
+    ("output,o", options::value<std::string>(),
+      "Output. A directory receiving added.pbf, removed.pbf and"
+      " changed.pbf for the pbf format, or a file for jsonl. Defaults to"
+      " standard output for jsonl.")
+    ("format,f", options::value<std::string>()->default_value("jsonl"),
+      "Output format: pbf or jsonl.")
+    ("memory-limit", options::value<size_t>()->default_value(
+        kDefaultMemoryLimit),
+      "Memory budget for the hash tables in MiB. Partitions are spilled to"
+      " disk when it is exceeded.")
+    ("tmp-dir", options::value<std::string>(),
+      "Directory for spill files. Defaults to the system temporary"
+      " directory.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.")
+    ("compress", "Write pbf output as zstd compressed blocks.");
+  // clang-format on
+
+  positional_options_.add("old", 1);
+  positional_options_.add("new", 1);
+}
+
+ExitCode Diff::Run(std::vector<std::string> args,
+                   // NOLINTNEXTLINE(whitespace/indent_namespace)
+                   struct GlobalOptions) {
+  LoadArgs(args);
+
+  // Declared first so it is removed last, whatever ends the command.
+  // Both sides are held at once, so each gets half of the budget.
+  const spill::Directory kSpillDir(args_.tmp_dir, "citescoop-diff");
+  Tables old_tables(kSpillDir.path(), kSideNames[kOld], args_.threads,
+                    kPartitions, args_.memory_limit / 2);
+  Tables new_tables(kSpillDir.path(), kSideNames[kNew], args_.threads,
+                    kPartitions, args_.memory_limit / 2);
+
+  try {
+    ScanSide(kOld, &old_tables);
+    ScanSide(kNew, &new_tables);
+
+    const auto kChanges = Compare(&old_tables, &new_tables);
+    spdlog::info("{} added, {} removed and {} changed messages",
+                 kChanges.added.size(), kChanges.removed.size(),
+                 kChanges.changed.size());
+    Output(kChanges);
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to compare input files: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Diff::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.old_input = EnsureArgument<std::string>("old", parsed_args.first);
+  args_.new_input = EnsureArgument<std::string>("new", parsed_args.first);
+  args_.key = EnsureArgument<std::string>("key", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.memory_limit =
+      EnsureArgument<size_t>("memory-limit", parsed_args.first) *
+      kBytesPerMebibyte;
+  args_.compress = parsed_args.first.contains("compress");
+
+  const auto kFormat = EnsureArgument<std::string>("format", parsed_args.first);
+  if (kFormat == "pbf") {
+    args_.format = Format::kPbf;
+  } else if (kFormat == "jsonl") {
+    args_.format = Format::kJsonl;
+  } else {
+    throw exceptions::UserInputException(
+        fmt::format("unknown output format: {}", kFormat).c_str());
+  }
+
+  args_.output = std::nullopt;
+  if (parsed_args.first.contains("output"))
+    args_.output = parsed_args.first["output"].as<std::string>();
+  if (args_.format == Format::kPbf && !args_.output)
+    throw exceptions::UserInputException("--output is required for pbf");
+
+  args_.tmp_dir = fs::temp_directory_path();
+  if (parsed_args.first.contains("tmp-dir"))
+    args_.tmp_dir = parsed_args.first["tmp-dir"].as<std::string>();
+
+  spdlog::debug("Diff arguments: old={} new={} key={} format={}",
+                args_.old_input, args_.new_input, args_.key, kFormat);
+}
+
+void Diff::ScanSide(Side side, Tables* tables) {
+  const auto& kPath = side == kOld ? args_.old_input : args_.new_input;
+  auto input = io::OpenPbfFile(kPath);
+  headers_[side] = io::ReadPbfHeader(input.get());
+
+  if (side == kOld) {
+    key_paths_ = fields::ParseFieldPaths(
+        io::DescriptorForFileType(headers_[side]->type()), args_.key);
+  } else if (headers_[kNew]->type() != headers_[kOld]->type()) {
+    throw exceptions::UserInputException(
+        "cannot compare files of different types");
+  }
+
+  duplicates_.assign(std::max(args_.threads, 1U), 0);
+  scan::ParallelScan(input.get(), *headers_[side], args_.threads,
+                     [this, tables](unsigned worker, uint64_t ordinal,
+                                    const pb::Message& message) {
+                       Add(tables, worker, ordinal, message);
+                     });
+  io::ClosePbfFile(std::move(input));
+  tables->Close();
+
+  uint64_t duplicates = 0;
+  for (const auto kCount : duplicates_) {
+    duplicates += kCount;
+  }
+  if (duplicates > 0) {
+    spdlog::warn("{} messages in {} repeat a key, keeping the first",
+                 duplicates, kPath);
+  }
+}
+
+void Diff::Add(Tables* tables, unsigned worker, uint64_t ordinal,
+               // NOLINTNEXTLINE(whitespace/indent_namespace)
+               const pb::Message& message) {
+  auto key = KeyOf(message);
+  if (!key)
+    return;
+
+  auto& table = tables->TableFor(worker, *key);
+  if (Insert(&table, *key, {hash::Content(message), ordinal})) {
+    duplicates_[worker]++;
+  } else {
+    tables->Grow(worker, EntrySize(*key));
+  }
+}
+
+Diff::Changes Diff::Compare(Tables* old_tables, Tables* new_tables) {
+  Tables* const kSets[] = {old_tables, new_tables};
+  auto compare = [&kSets](size_t partition) {
+    Changes changes;
+    // A partition too large to merge is visited in parts, each holding
+    // the same keys on both sides.
+    Tables::Merge(kSets, partition, [&changes](std::vector<Table>* merged) {
+      const Table& old_table = (*merged)[kOld];
+      const Table& new_table = (*merged)[kNew];
+      for (const auto& [key, entry] : old_table) {
+        if (!new_table.contains(key))
+          changes.removed.push_back(entry.ordinal);
+      }
+      for (const auto& [key, entry] : new_table) {
+        auto old_entry = old_table.find(key);
+        if (old_entry == old_table.end()) {
+          changes.added.push_back(entry.ordinal);
+        } else if (!(old_entry->second.hash == entry.hash)) {
+          changes.changed.push_back(entry.ordinal);
+        }
+      }
+    });
+    return changes;
+  };
+
+  // Compare partitions in waves of one per thread so that at most that
+  // many merged partitions are held in memory at once. Each fits in a
+  // thread's share of the memory limit, see spill.h.
+  const size_t kWorkers = std::max(args_.threads, 1U);
+  ThreadPool pool(static_cast<unsigned>(kWorkers));
+  Changes changes;
+  for (size_t first = 0; first < kPartitions; first += kWorkers) {
+    std::vector<std::future<Changes>> compared;
+    for (size_t p = first; p < std::min(first + kWorkers, kPartitions); ++p) {
+      compared.push_back(pool.Submit([&compare, p]() { return compare(p); }));
+    }
+
+    for (auto& future : compared) {
+      auto partition = future.get();
+      changes.removed.insert(changes.removed.end(), partition.removed.begin(),
+                             partition.removed.end());
+      changes.added.insert(changes.added.end(), partition.added.begin(),
+                           partition.added.end());
+      changes.changed.insert(changes.changed.end(), partition.changed.begin(),
+                             partition.changed.end());
+    }
+  }
+
+  std::sort(changes.removed.begin(), changes.removed.end());
+  std::sort(changes.added.begin(), changes.added.end());
+  std::sort(changes.changed.begin(), changes.changed.end());
+  return changes;
+}
+
+void Diff::Output(const Changes& changes) {
+  auto output_header = [this](uint64_t count) {
+    auto header = *headers_[kNew];
+    header.set_count(count);
+    header::ClearLayout(&header);
+    header::Clear(&header, header::kSortKeyField);
+    if (args_.compress)
+      container::MarkCompressed(&header);
+    return header;
+  };
+
+  std::unique_ptr<io::PbfWriter> added;
+  std::unique_ptr<io::PbfWriter> removed;
+  std::unique_ptr<io::PbfWriter> changed;
+  std::ofstream file;
+  std::unique_ptr<JsonlSink> jsonl;
+  if (args_.format == Format::kPbf) {
+    const fs::path kDirectory = *args_.output;
+    fs::create_directories(kDirectory);
+    added = std::make_unique<io::PbfWriter>(
+        (kDirectory / "added.pbf").string(),
+        output_header(changes.added.size()));
+    removed = std::make_unique<io::PbfWriter>(
+        (kDirectory / "removed.pbf").string(),
+        output_header(changes.removed.size()));
+    changed = std::make_unique<io::PbfWriter>(
+        (kDirectory / "changed.pbf").string(),
+        output_header(changes.changed.size()));
+  } else if (args_.output) {
+    file = std::ofstream(*args_.output, std::ios::out | std::ios::trunc);
+    jsonl = std::make_unique<JsonlSink>(&file);
+  } else {
+    jsonl = std::make_unique<JsonlSink>(&std::cout);
+  }
+
+  // Removed messages come from the old file, the rest from the new one.
+  // Both lists are sorted so each file is read once from the front.
+  auto old_input = io::OpenPbfFile(args_.old_input);
+  io::ReadPbfHeader(old_input.get());
+  auto next = changes.removed.begin();
+  for (uint64_t i = 0; next != changes.removed.end(); ++i) {
+    auto message = io::ReadGenericMessage(old_input.get(),
+                                          headers_[kOld]->type());
+    if (i != *next)
+      continue;
+
+    if (jsonl) {
+      jsonl->Write("removed", KeyOf(*message).value_or(""), *message);
+    } else {
+      removed->Write(*message);
+    }
+    ++next;
+  }
+  io::ClosePbfFile(std::move(old_input));
+
+  auto new_input = io::OpenPbfFile(args_.new_input);
+  io::ReadPbfHeader(new_input.get());
+  auto next_added = changes.added.begin();
+  auto next_changed = changes.changed.begin();
+  for (uint64_t i = 0; next_added != changes.added.end() ||
+                       next_changed != changes.changed.end();
+       ++i) {
+    auto message = io::ReadGenericMessage(new_input.get(),
+                                          headers_[kNew]->type());
+    const bool kAdded = next_added != changes.added.end() && i == *next_added;
+    const bool kChanged =
+        next_changed != changes.changed.end() && i == *next_changed;
+    if (!kAdded && !kChanged)
+      continue;
+
+    if (jsonl) {
+      jsonl->Write(kAdded ? "added" : "changed", KeyOf(*message).value_or(""),
+                   *message);
+    } else {
+      (kAdded ? added : changed)->Write(*message);
+    }
+    if (kAdded) {
+      ++next_added;
+    } else {
+      ++next_changed;
+    }
+  }
+  io::ClosePbfFile(std::move(new_input));
+
+  if (args_.format == Format::kPbf) {
+    added->Close();
+    removed->Close();
+    changed->Close();
+  } else if (args_.output) {
+    file.close();
+    if (!file) {
+      throw exceptions::CliException(
+          fmt::format("failed to write {}", *args_.output));
+    }
+  } else {
+    std::cout.flush();
+  }
+}
+
+std::optional<std::string> Diff::KeyOf(const pb::Message& message) const {
+  std::string key;
+  bool found = false;
+  for (size_t i = 0; i < key_paths_.size(); ++i) {
+    const auto kValue = key_paths_[i].First(message);
+    if (i > 0)
+      key.push_back(kKeySeparator);
+    if (!std::holds_alternative<std::monostate>(kValue)) {
+      key += fields::ToString(kValue);
+      found = true;
+    }
+  }
+
+  if (!found)
+    return std::nullopt;
+  return key;
+}
+
+bool Diff::Insert(Table* table, const std::string& key, const Entry& entry) {
+  auto [existing, inserted] = table->try_emplace(key, entry);
+  if (!inserted && entry.ordinal < existing->second.ordinal)
+    existing->second = entry;
+  return !inserted;
+}
+
+size_t Diff::EntrySize(const std::string& key) {
+  return key.capacity() + sizeof(Entry) + kEntryOverhead;
+}
+
+void Diff::EntryCodec::Encode(const Entry& entry, std::string* output) {
+  binary::PutFixed64(output, entry.hash.low);
+  binary::PutFixed64(output, entry.hash.high);
+  binary::PutVarint(output, entry.ordinal);
+}
+
+Diff::Entry Diff::EntryCodec::Decode(std::string_view encoded) {
+  binary::Reader reader(encoded);
+  Entry entry{};
+  entry.hash.low = reader.Fixed64();
+  entry.hash.high = reader.Fixed64();
+  entry.ordinal = reader.Varint();
+  return entry;
+}
+
+void Diff::EntryCodec::Merge(Entry* into, Entry&& from) {
+  if (from.ordinal < into->ordinal)
+    *into = from;
+}
+
+size_t Diff::EntryCodec::Size(const std::string& key, const Entry&) {
+  return EntrySize(key);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_DIFF_H_
+#define SRC_PBF_DIFF_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "fields.h"
+#include "hash.h"
+#include "io.h"
+#include "spill.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to compare two snapshots of a PBF file keyed by one
+/// or more fields, reporting added, removed and changed messages.
+///
+/// Each side is scanned into per worker hash tables mapping key to the
+/// 128 bit hash of the message's serialized bytes and its position in
+/// the file. The tables are split into partitions by key hash, and the
+/// largest partition is spilled to disk when a worker passes its share
+/// of the memory limit, see spill.h. Partitions are then compared in
+/// parallel and the selected messages are read back from both files in
+/// order.
+class Diff : public Command {
+ public:
+  Diff();
+
+  /// @brief Execute the diff command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  enum class Format : std::uint8_t {
+    kPbf,
+    kJsonl,
+  };
+
+  enum Side : std::uint8_t {
+    kOld = 0,
+    kNew = 1,
+  };
+
+  struct Args {
+    std::string old_input;              ///< Old snapshot path.
+    std::string new_input;              ///< New snapshot path.
+    std::string key;                    ///< Comma separated key paths.
+    std::optional<std::string> output;  ///< Output file or directory.
+    Format format;                      ///< Output format.
+    size_t memory_limit;                ///< Memory budget in bytes.
+    std::filesystem::path tmp_dir;      ///< Directory for spill files.
+    unsigned threads;                   ///< Number of worker threads.
+    bool compress;                      ///< Block compress PBF output.
+  };
+
+  /// @brief What is remembered about each message.
+  struct Entry {
+    hash::Hash128 hash;
+    uint64_t ordinal;
+  };
+
+  /// @brief How an Entry is spilled, see spill::PartitionedTables.
+  struct EntryCodec {
+    static void Encode(const Entry& entry, std::string* output);
+    static Entry Decode(std::string_view encoded);
+    static void Merge(Entry* into, Entry&& from);
+    static size_t Size(const std::string& key, const Entry& entry);
+  };
+
+  using Tables = spill::PartitionedTables<Entry, EntryCodec>;
+  using Table = Tables::Table;
+
+  /// @brief Ordinals selected from each file, sorted.
+  struct Changes {
+    std::vector<uint64_t> removed;
+    std::vector<uint64_t> added;
+    std::vector<uint64_t> changed;
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Hash every message of one side into the worker tables.
+  void ScanSide(Side side, Tables* tables);
+
+  /// @brief Remember a message in its worker's tables.
+  void Add(Tables* tables, unsigned worker, uint64_t ordinal,
+           const google::protobuf::Message& message);
+
+  /// @brief Compare every partition of both sides.
+  Changes Compare(Tables* old_tables, Tables* new_tables);
+
+  /// @brief Read the selected messages back and write them out.
+  void Output(const Changes& changes);
+
+  /// @brief Key of a message, with the values of each key path joined.
+  [[nodiscard]] std::optional<std::string> KeyOf(
+      const google::protobuf::Message& message) const;
+
+  /// @brief Insert an entry, keeping the first occurrence of a key.
+  /// @return Whether the key was already present.
+  static bool Insert(Table* table, const std::string& key,
+                     const Entry& entry);
+
+  /// @brief Estimated memory held by an entry.
+  static size_t EntrySize(const std::string& key);
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> headers_[2];
+  std::vector<fields::FieldPath> key_paths_;
+  /// Keys repeated within the side being scanned, per worker.
+  std::vector<uint64_t> duplicates_;
+
+  /// Number of hash partitions per worker.
+  static constexpr size_t kPartitions = 256;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_DIFF_H_
@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "generate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <future>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "citescoop/io.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/language.pb.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "io.h"
+#include "langmap.h"
+#include "synthetic.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace cs = wikiopencite::citescoop;
+namespace fs = std::filesystem;
+namespace proto = wikiopencite::proto;
+
+/// Messages generated by one task. Large enough to amortise the task
+/// overhead, small enough to keep every thread busy near the end.
+constexpr uint64_t kShardSize = 4096;
+
+/// Shards queued per thread before the writer waits for the oldest.
+constexpr size_t kShardsPerThread = 2;
+
+const std::map<std::string, proto::FileType>& FileTypeNames() {
+  static const std::map<std::string, proto::FileType> kNames = {
+      {"pages", proto::FileType::FILE_TYPE_PAGES},
+      {"revisions", proto::FileType::FILE_TYPE_REVISIONS},
+      {"openalex-works", proto::FileType::FILE_TYPE_OPENALEX_WORKS},
+      {"openalex-authors", proto::FileType::FILE_TYPE_OPENALEX_AUTHORS},
+      {"openalex-institutions",
+       proto::FileType::FILE_TYPE_OPENALEX_INSTITUTIONS},
+  };
+  return kNames;
+}
+
+bool IsOpenAlexType(proto::FileType type) {
+  return type == proto::FileType::FILE_TYPE_OPENALEX_WORKS ||
+         type == proto::FileType::FILE_TYPE_OPENALEX_AUTHORS ||
+         type == proto::FileType::FILE_TYPE_OPENALEX_INSTITUTIONS;
+}
+}  // namespace
+
+Generate::Generate()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("generate", "Generate a PBF file of synthetic data") {
+  // clang-format off
+  cli_options_.add_options()
+    ("output,o", options::value<std::string>()->required(), "Output file.")
+    ("type,t", options::value<std::string>()->required(),
+      "Type of file: pages, revisions, openalex-works, openalex-authors"
+      " or openalex-institutions.")
+    ("count,n", options::value<uint64_t>()->required(),
+      "Number of messages to generate.")
+    ("seed", options::value<uint64_t>()->default_value(0),
+      "Random seed. The same seed always produces the same file.")
+    ("duplicate-rate", options::value<double>()->default_value(0.0),
+      "Share of OpenAlex messages that repeat an earlier id.")
+    ("language", options::value<std::string>()->default_value("en"),
+      "Wikipedia language code recorded for pages and revisions.")
+    ("compress", "Write the payload as zstd compressed blocks.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  // clang-format on
+
+  positional_options_.add("output", 1);
+}
+
+ExitCode Generate::Run(std::vector<std::string> args,
+                       // NOLINTNEXTLINE(whitespace/indent_namespace)
+                       struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    Write();
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to generate file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    std::error_code err;
+    fs::remove(args_.output, err);
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Generate::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.count = EnsureArgument<uint64_t>("count", parsed_args.first);
+  args_.seed = EnsureArgument<uint64_t>("seed", parsed_args.first);
+  args_.duplicate_rate =
+      EnsureArgument<double>("duplicate-rate", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.compress = parsed_args.first.contains("compress");
+
+  const auto kType = EnsureArgument<std::string>("type", parsed_args.first);
+  const auto kFound = FileTypeNames().find(kType);
+  if (kFound == FileTypeNames().end())
+    throw exceptions::UserInputException("unknown file type");
+  args_.type = kFound->second;
+
+  if (args_.duplicate_rate < 0 || args_.duplicate_rate > 1)
+    throw exceptions::UserInputException(
+        "duplicate rate must be between 0 and 1");
+  if (args_.duplicate_rate > 0 && !IsOpenAlexType(args_.type))
+    spdlog::warn("Duplicate rate only applies to OpenAlex files");
+
+  args_.language = WikipediaCodeToLanguage(
+      EnsureArgument<std::string>("language", parsed_args.first));
+  if (args_.language == proto::Language::LANGUAGE_UNSPECIFIED)
+    throw exceptions::UserInputException("unknown language code");
+
+  spdlog::trace(
+      "Generate command arguments: Output: {} Type: {} Count: {} Seed: {}",
+      args_.output, kType, args_.count, args_.seed);
+}
+
+std::string Generate::GenerateShard(
+    const synthetic::Synthesizer& synthesizer, uint64_t first,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    uint64_t count) const {
+  std::ostringstream buffer;
+  auto writer = cs::MessageWriter(&buffer);
+  auto message = io::NewGenericMessage(args_.type);
+  for (uint64_t ordinal = first; ordinal < first + count; ++ordinal) {
+    message->Clear();
+    synthesizer.Fill(ordinal, message.get());
+    writer.WriteMessage(*message);
+  }
+  return std::move(buffer).str();
+}
+
+void Generate::Write() {
+  auto header = proto::FileHeader();
+  header.set_type(args_.type);
+  header.set_count(args_.count);
+  if (!IsOpenAlexType(args_.type))
+    header.mutable_dump_file_attributes()->set_language(args_.language);
+  if (args_.compress)
+    container::MarkCompressed(&header);
+
+  io::PbfWriter output(args_.output, header, args_.threads);
+
+  const synthetic::Synthesizer kSynthesizer(args_.type, args_.seed,
+                                            args_.duplicate_rate);
+
+  // Shards are generated on the pool and written in order, keeping a
+  // bounded number in flight so memory stays flat for any count.
+  ThreadPool pool(args_.threads);
+  const size_t kMaxInFlight = std::max<size_t>(pool.size(), 1) *
+                              kShardsPerThread;
+  std::deque<std::future<std::string>> pending;
+  uint64_t next = 0;
+  while (next < args_.count || !pending.empty()) {
+    while (next < args_.count && pending.size() < kMaxInFlight) {
+      const uint64_t kFirst = next;
+      const uint64_t kSize = std::min(kShardSize, args_.count - next);
+      pending.push_back(pool.Submit([this, &kSynthesizer, kFirst, kSize]() {
+        return GenerateShard(kSynthesizer, kFirst, kSize);
+      }));
+      next += kSize;
+    }
+
+    const std::string kShard = pending.front().get();
+    pending.pop_front();
+    output.payload()->write(kShard.data(),
+                            static_cast<std::streamsize>(kShard.size()));
+  }
+
+  output.Close();
+
+  spdlog::info("Generated {} messages in {}", args_.count, args_.output);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
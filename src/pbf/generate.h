@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_GENERATE_H_
+#define SRC_PBF_GENERATE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "citescoop/proto/language.pb.h"
+
+#include "cli.h"
+#include "synthetic.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to generate a PBF file of synthetic messages, for
+/// benchmarking without a real dump.
+class Generate : public Command {
+ public:
+  Generate();
+
+  /// @brief Execute the generate command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string output;                      ///< Output file path.
+    wikiopencite::proto::FileType type;      ///< Type of file to generate.
+    uint64_t count;                          ///< Number of messages.
+    uint64_t seed;                           ///< Random seed.
+    double duplicate_rate;                   ///< Share of repeated ids.
+    wikiopencite::proto::Language language;  ///< Language for dump files.
+    unsigned threads;                        ///< Number of worker threads.
+    bool compress;                           ///< Block compress the output.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Generate messages first to first + count and serialize
+  /// them, length prefixed, into a buffer.
+  [[nodiscard]] std::string GenerateShard(
+      const synthetic::Synthesizer& synthesizer, uint64_t first,
+      uint64_t count) const;
+
+  /// @brief Write the header and all messages to the output file.
+  void Write();
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_GENERATE_H_
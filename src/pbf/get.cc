@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "get.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+#include "spdlog/spdlog.h"
+
+#include "bloom_filter.h"
+#include "cli.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "io.h"
+#include "key_index.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+}  // namespace
+
+Get::Get()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("get", "Display the messages of pbf files with given keys") {
+  // clang-format off
+  cli_options_.add_options()
+    ("file", options::value<std::vector<std::string>>()->required(),
+      "Input file. Give --file again to look up several files.")
+    ("key,k", options::value<std::string>()->required(),
+      "Field path to look values up in. Build an index over it with"
+      " pbf index --key to avoid scanning each file, and Bloom filters"
+      " with pbf bloom to skip files without the values.")
+    ("value", options::value<std::vector<std::string>>()->required(),
+      "Values to look up.");
+  positional_options_.add("file", 1);
+  positional_options_.add("value", -1);
+  // clang-format on
+}
+
+ExitCode Get::Run(std::vector<std::string> args,
+                  // NOLINTNEXTLINE(whitespace/indent_namespace)
+                  struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    size_t skipped = 0;
+    for (const auto& input : args_.inputs) {
+      const auto kMayContain =
+          BloomFilter::Probe(input, args_.key, args_.values);
+      if (!kMayContain) {
+        LookUp(input, args_.values);
+        continue;
+      }
+
+      std::vector<std::string> values;
+      for (size_t i = 0; i < args_.values.size(); ++i) {
+        if ((*kMayContain)[i])
+          values.push_back(args_.values[i]);
+      }
+      if (values.empty()) {
+        spdlog::debug("Bloom filter rules out every value in {}", input);
+        skipped++;
+        continue;
+      }
+      LookUp(input, values);
+    }
+
+    if (skipped > 0) {
+      spdlog::info("Skipped {} of {} files using Bloom filters", skipped,
+                   args_.inputs.size());
+    }
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to look up keys: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Get::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.inputs =
+      EnsureArgument<std::vector<std::string>>("file", parsed_args.first);
+  args_.key = EnsureArgument<std::string>("key", parsed_args.first);
+  args_.values =
+      EnsureArgument<std::vector<std::string>>("value", parsed_args.first);
+
+  spdlog::trace("Get command arguments: Inputs: {} Key: {} Values: {}",
+                args_.inputs.size(), args_.key, args_.values.size());
+}
+
+void Get::LookUp(const std::string& input,
+                 // NOLINTNEXTLINE(whitespace/indent_namespace)
+                 const std::vector<std::string>& values) const {
+  auto file = io::OpenPbfFile(input);
+  const auto kHeader = io::ReadPbfHeader(file.get());
+  const auto kPath = fields::FieldPath::Parse(
+      io::DescriptorForFileType(kHeader->type()), args_.key);
+
+  const auto kIndex = KeyIndex::Load(input, args_.key);
+  if (kIndex) {
+    for (const auto& value : values) {
+      const auto kPositions = kIndex->Lookup(value);
+      if (kPositions.empty())
+        spdlog::debug("No message in {} has {} {}", input, args_.key, value);
+
+      for (const uint64_t kPosition : kPositions) {
+        io::SeekPayload(file.get(), kPosition);
+        PrintMessage(*io::ReadGenericMessage(file.get(), kHeader->type()));
+      }
+    }
+  } else {
+    spdlog::warn("No index over {} for {}, scanning the whole file",
+                 args_.key, input);
+
+    const std::unordered_set<std::string> kValues(values.begin(),
+                                                  values.end());
+    for (uint64_t i = 0; i < kHeader->count(); ++i) {
+      const auto kMessage = io::ReadGenericMessage(file.get(), kHeader->type());
+      bool found = false;
+      kPath.Visit(*kMessage, [&](const fields::Value& value) {
+        found = found || kValues.contains(fields::ToString(value));
+      });
+      if (found)
+        PrintMessage(*kMessage);
+    }
+  }
+
+  io::ClosePbfFile(std::move(file));
+}
+
+void Get::PrintMessage(const google::protobuf::Message& message) {
+  google::protobuf::io::OstreamOutputStream output(&std::cout);
+
+  std::cout << "# " << message.GetTypeName() << '\n';
+  google::protobuf::TextFormat::Print(message, &output);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_GET_H_
+#define SRC_PBF_GET_H_
+
+#include <string>
+#include <vector>
+
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to print the messages of PBF files whose key field
+/// holds one of the given values.
+///
+/// Files whose Bloom filter, built by pbf bloom, rules out every value
+/// are skipped without being opened. In the rest, with a key index
+/// built by pbf index --key, each value costs a binary search of the
+/// index fence, a block read and a seek per message. Without one the
+/// file is scanned.
+class Get : public Command {
+ public:
+  Get();
+
+  /// @brief Execute the get command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::vector<std::string> inputs;  ///< Input file paths.
+    std::string key;                  ///< Key field path.
+    std::vector<std::string> values;  ///< Key values to look up.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Print the messages of one file holding any of the values.
+  void LookUp(const std::string& input,
+              const std::vector<std::string>& values) const;
+
+  static void PrintMessage(const google::protobuf::Message& message);
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_GET_H_
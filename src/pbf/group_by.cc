@@ -0,0 +1,687 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "group_by.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "boost/algorithm/string/trim.hpp"
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "cli.h"
+#include "columnar.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "hash.h"
+#include "io.h"
+#include "scan.h"
+#include "spill.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace fs = std::filesystem;
+namespace pb = google::protobuf;
+
+/// Rough per entry overhead of an unordered_map node holding a State.
+constexpr size_t kEntryOverhead = 128;
+
+/// Rough per element overhead of an unordered_set<uint64_t> node.
+constexpr size_t kDistinctOverhead = 32;
+
+constexpr size_t kBytesPerMebibyte = 1024 * 1024;
+constexpr size_t kDefaultMemoryLimit = 1024;
+
+/// @brief Parse the whole of a text as a number.
+template <typename T>
+std::optional<T> ParseNumber(std::string_view text) {
+  T number{};
+  const auto kResult =
+      std::from_chars(text.data(), text.data() + text.size(), number);
+  if (kResult.ec != std::errc() || kResult.ptr != text.data() + text.size())
+    return std::nullopt;
+  return number;
+}
+
+/// @brief Parse a constant as the kind of value a field is read as,
+/// see fields::Value.
+std::optional<fields::Value> ParseConstant(const pb::FieldDescriptor* field,
+                                           std::string_view text) {
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      return ParseNumber<int64_t>(text);
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      return ParseNumber<uint64_t>(text);
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+      return ParseNumber<double>(text);
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      if (text == "true" || text == "false")
+        return text == "true";
+      return std::nullopt;
+    case pb::FieldDescriptor::CPPTYPE_ENUM: {
+      const auto* kValue =
+          field->enum_type()->FindValueByName(std::string(text));
+      if (kValue != nullptr)
+        return static_cast<int64_t>(kValue->number());
+      return ParseNumber<int64_t>(text);
+    }
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      return std::string(text);
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      // Timestamps are read as whole seconds, other messages cannot be
+      // compared meaningfully.
+      if (field->message_type()->full_name() == "google.protobuf.Timestamp")
+        return ParseNumber<int64_t>(text);
+      return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+GroupBy::GroupBy()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("group-by", "Group messages by a field and aggregate them") {
+  // clang-format off
+  cli_options_.add_options()
+    ("file", options::value<std::string>()->required(),
+      "Input file. May be a PBF file or a columnar file written by"
+      " pbf columnarize.")
+    ("key,k", options::value<std::string>()->required(),
+      "Field path to group by. May be wrapped in day(), month() or year()"
+      " to bucket a timestamp.")
+    ("agg,a", options::value<std::string>()->default_value("count"),
+      "Aggregate to compute: count, sum(field) or distinct(field).")
+    ("where,w", options::value<std::vector<std::string>>(),
+      "Only group messages where some value of a field compares to a"
+      " constant, given as field=c, field<c, field<=c, field>c or"
+      " field>=c. Timestamps compare as seconds since the epoch. May be"
+      " given several times, and every condition must hold.")
+    ("top", options::value<size_t>(),
+      "Only print the K groups with the largest aggregate.")
+    ("memory-limit", options::value<size_t>()->default_value(
+        kDefaultMemoryLimit),
+      "Memory budget for the hash tables in MiB. Partitions are spilled to"
+      " disk beyond it.")
+    ("tmp-dir", options::value<std::string>(),
+      "Directory for spill files. Defaults to the system temporary"
+      " directory.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  positional_options_.add("file", 1);
+  // clang-format on
+}
+
+ExitCode GroupBy::Run(std::vector<std::string> args,
+                      // NOLINTNEXTLINE(whitespace/indent_namespace)
+                      struct GlobalOptions) {
+  LoadArgs(args);
+
+  // Declared first so it is removed last, whatever ends the command.
+  const spill::Directory kSpillDir(args_.tmp_dir, "citescoop-group-by");
+  Tables tables(kSpillDir.path(), "groups", args_.threads, kPartitions,
+                args_.memory_limit);
+
+  try {
+    if (columnar::IsColumnarFile(args_.input)) {
+      ScanColumnar(&tables);
+    } else {
+      ScanPbf(&tables);
+    }
+    tables.Close();
+
+    Output(&tables);
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to group input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+GroupBy::Condition GroupBy::ParseCondition(
+    const pb::Descriptor* descriptor,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::string& condition) {
+  const auto kInvalid = [&condition]() {
+    return exceptions::UserInputException(
+        fmt::format("invalid condition {}", condition).c_str());
+  };
+
+  const size_t kOperator = condition.find_first_of("=<>");
+  if (kOperator == std::string::npos)
+    throw kInvalid();
+
+  Comparison comparison = Comparison::kEqual;
+  size_t operator_size = 1;
+  const bool kOrEqual = condition.compare(kOperator + 1, 1, "=") == 0;
+  if (condition[kOperator] == '<') {
+    comparison = kOrEqual ? Comparison::kLessEqual : Comparison::kLess;
+    operator_size += kOrEqual ? 1 : 0;
+  } else if (condition[kOperator] == '>') {
+    comparison = kOrEqual ? Comparison::kGreaterEqual : Comparison::kGreater;
+    operator_size += kOrEqual ? 1 : 0;
+  }
+
+  const auto kField =
+      boost::algorithm::trim_copy(condition.substr(0, kOperator));
+  if (kField.empty())
+    throw kInvalid();
+
+  auto path = fields::FieldPath::Parse(descriptor, kField);
+  auto constant = ParseConstant(
+      path.leaf(), boost::algorithm::trim_copy(
+                       condition.substr(kOperator + operator_size)));
+  if (!constant)
+    throw kInvalid();
+
+  return {std::move(path), comparison, std::move(*constant)};
+}
+
+bool GroupBy::Matches(const Condition& condition,
+                      // NOLINTNEXTLINE(whitespace/indent_namespace)
+                      std::span<const fields::Value> values) {
+  return std::any_of(
+      values.begin(), values.end(), [&condition](const fields::Value& value) {
+        const int kOrder = fields::Compare(value, condition.constant);
+        switch (condition.comparison) {
+          case Comparison::kLess:
+            return kOrder < 0;
+          case Comparison::kLessEqual:
+            return kOrder <= 0;
+          case Comparison::kGreater:
+            return kOrder > 0;
+          case Comparison::kGreaterEqual:
+            return kOrder >= 0;
+          default:
+            return kOrder == 0;
+        }
+      });
+}
+
+bool GroupBy::MayMatch(const Condition& condition,
+                       // NOLINTNEXTLINE(whitespace/indent_namespace)
+                       const columnar::ChunkInfo& chunk) {
+  if (chunk.values == 0)
+    return false;
+
+  const auto& kConstant = condition.constant;
+  switch (condition.comparison) {
+    case Comparison::kLess:
+      return fields::Compare(chunk.min, kConstant) < 0;
+    case Comparison::kLessEqual:
+      return fields::Compare(chunk.min, kConstant) <= 0;
+    case Comparison::kGreater:
+      return fields::Compare(chunk.max, kConstant) > 0;
+    case Comparison::kGreaterEqual:
+      return fields::Compare(chunk.max, kConstant) >= 0;
+    default:
+      return fields::Compare(chunk.min, kConstant) <= 0 &&
+             fields::Compare(chunk.max, kConstant) >= 0;
+  }
+}
+
+void GroupBy::ScanPbf(Tables* tables) {
+  input_ = io::OpenPbfFile(args_.input);
+  header_ = io::ReadPbfHeader(input_.get());
+  ParseExpressions(io::DescriptorForFileType(header_->type()));
+
+  scan::ParallelScan(
+      input_.get(), *header_, args_.threads,
+      [this, tables](unsigned worker, uint64_t, const pb::Message& message) {
+        Accumulate(tables, worker, message);
+      });
+
+  io::ClosePbfFile(std::move(input_));
+}
+
+void GroupBy::ScanColumnar(Tables* tables) {
+  const columnar::Reader kReader(args_.input);
+  ParseExpressions(io::DescriptorForFileType(kReader.footer().file_type));
+
+  auto find_column = [&kReader](const std::string& path) {
+    auto column = kReader.FindColumn(path);
+    if (!column) {
+      throw exceptions::UserInputException(
+          fmt::format("columnar file has no column {}", path).c_str());
+    }
+    return *column;
+  };
+
+  const size_t kKeyColumn = find_column(key_path_->path());
+  std::optional<size_t> value_column;
+  if (value_path_)
+    value_column = find_column(value_path_->path());
+  std::vector<size_t> condition_columns;
+  for (const auto& condition : conditions_) {
+    condition_columns.push_back(find_column(condition.path.path()));
+  }
+
+  spdlog::debug("Grouping columnar file using columns {} and {}", kKeyColumn,
+                value_column ? static_cast<int64_t>(*value_column) : -1);
+
+  // Only the key, value and condition chunks of each row group are
+  // read, and only for row groups whose statistics allow every
+  // condition. Workers take row groups in turn so each keeps its own
+  // tables.
+  const auto& kRowGroups = kReader.footer().row_groups;
+  const size_t kGroups = kRowGroups.size();
+  const unsigned kWorkers = std::max(args_.threads, 1U);
+  std::atomic<size_t> skipped = 0;
+  ThreadPool pool(kWorkers);
+  std::vector<std::future<void>> done;
+  for (unsigned worker = 0; worker < kWorkers; ++worker) {
+    done.push_back(pool.Submit([&, worker]() {
+      for (size_t group = worker; group < kGroups; group += kWorkers) {
+        bool may_match = true;
+        for (size_t i = 0; i < conditions_.size() && may_match; ++i) {
+          may_match = MayMatch(
+              conditions_[i], kRowGroups[group].chunks[condition_columns[i]]);
+        }
+        if (!may_match) {
+          skipped++;
+          continue;
+        }
+
+        const auto kKeys = kReader.ReadChunk(group, kKeyColumn);
+        columnar::ColumnChunk values;
+        if (value_column)
+          values = kReader.ReadChunk(group, *value_column);
+        std::vector<columnar::ColumnChunk> filters;
+        for (const auto kColumn : condition_columns) {
+          filters.push_back(kReader.ReadChunk(group, kColumn));
+        }
+
+        const size_t kRows = kKeys.offsets.size() - 1;
+        for (size_t row = 0; row < kRows; ++row) {
+          bool matches = true;
+          for (size_t i = 0; i < filters.size() && matches; ++i) {
+            matches = Matches(
+                conditions_[i],
+                std::span<const fields::Value>(filters[i].values)
+                    .subspan(filters[i].offsets[row],
+                             filters[i].offsets[row + 1] -
+                                 filters[i].offsets[row]));
+          }
+          if (!matches)
+            continue;
+
+          std::span<const fields::Value> row_values;
+          if (value_column) {
+            row_values = std::span<const fields::Value>(values.values)
+                             .subspan(values.offsets[row],
+                                      values.offsets[row + 1] -
+                                          values.offsets[row]);
+          }
+          AccumulateRow(tables, worker,
+                        std::span<const fields::Value>(kKeys.values)
+                            .subspan(kKeys.offsets[row],
+                                     kKeys.offsets[row + 1] -
+                                         kKeys.offsets[row]),
+                        row_values);
+        }
+      }
+    }));
+  }
+
+  for (auto& future : done) {
+    future.get();
+  }
+
+  spdlog::debug("Skipped {} of {} row groups by their statistics",
+                skipped.load(), kGroups);
+}
+
+void GroupBy::Output(Tables* tables) {
+  using Ranked = std::tuple<double, std::string, State>;
+  auto by_rank = [](const Ranked& lhs, const Ranked& rhs) {
+    return std::get<0>(lhs) > std::get<0>(rhs);
+  };
+  std::priority_queue<Ranked, std::vector<Ranked>, decltype(by_rank)> heap(
+      by_rank);
+
+  std::mutex mutex;
+  auto visit = [&](std::vector<Table>* merged) {
+    const std::lock_guard<std::mutex> kLock(mutex);
+    for (auto& [key, state] : merged->front()) {
+      if (!args_.top) {
+        PrintGroup(key, state);
+        continue;
+      }
+
+      const double kRank = Rank(state);
+      if (heap.size() < *args_.top) {
+        heap.emplace(kRank, key, std::move(state));
+      } else if (*args_.top > 0 && kRank > std::get<0>(heap.top())) {
+        heap.pop();
+        heap.emplace(kRank, key, std::move(state));
+      }
+    }
+  };
+
+  // Merge partitions in waves of one per thread so that at most that
+  // many merged partitions are held in memory at once. Each fits in a
+  // thread's share of the memory limit, see spill.h.
+  const size_t kWorkers = std::max(args_.threads, 1U);
+  Tables* const kSets[] = {tables};
+  ThreadPool pool(static_cast<unsigned>(kWorkers));
+  for (size_t first = 0; first < kPartitions; first += kWorkers) {
+    std::vector<std::future<void>> merged;
+    for (size_t p = first; p < std::min(first + kWorkers, kPartitions); ++p) {
+      merged.push_back(pool.Submit(
+          [&kSets, &visit, p]() { Tables::Merge(kSets, p, visit); }));
+    }
+
+    for (auto& future : merged) {
+      future.get();
+    }
+  }
+
+  if (args_.top) {
+    std::vector<Ranked> ranked;
+    while (!heap.empty()) {
+      ranked.push_back(heap.top());
+      heap.pop();
+    }
+    for (auto it = ranked.rbegin(); it != ranked.rend(); ++it) {
+      PrintGroup(std::get<1>(*it), std::get<2>(*it));
+    }
+  }
+}
+
+void GroupBy::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
+  args_.key = EnsureArgument<std::string>("key", parsed_args.first);
+  args_.aggregate = EnsureArgument<std::string>("agg", parsed_args.first);
+  if (parsed_args.first.contains("where"))
+    args_.where = parsed_args.first["where"].as<std::vector<std::string>>();
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.memory_limit =
+      EnsureArgument<size_t>("memory-limit", parsed_args.first) *
+      kBytesPerMebibyte;
+
+  args_.top = std::nullopt;
+  if (parsed_args.first.contains("top"))
+    args_.top = parsed_args.first["top"].as<size_t>();
+
+  args_.tmp_dir = fs::temp_directory_path();
+  if (parsed_args.first.contains("tmp-dir"))
+    args_.tmp_dir = parsed_args.first["tmp-dir"].as<std::string>();
+
+  spdlog::debug("Group by arguments: key={} agg={} memory_limit={} threads={}",
+                args_.key, args_.aggregate, args_.memory_limit, args_.threads);
+}
+
+std::pair<std::string, std::string> GroupBy::SplitExpression(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::string& expression) {
+  auto open = expression.find('(');
+  if (open == std::string::npos || expression.back() != ')')
+    return {"", boost::algorithm::trim_copy(expression)};
+
+  return {boost::algorithm::trim_copy(expression.substr(0, open)),
+          boost::algorithm::trim_copy(
+              expression.substr(open + 1, expression.size() - open - 2))};
+}
+
+void GroupBy::ParseExpressions(const pb::Descriptor* descriptor) {
+  conditions_.clear();
+  for (const auto& condition : args_.where) {
+    conditions_.push_back(ParseCondition(descriptor, condition));
+  }
+
+  auto [key_function, key_field] = SplitExpression(args_.key);
+  if (key_function.empty()) {
+    key_transform_ = KeyTransform::kNone;
+  } else if (key_function == "day") {
+    key_transform_ = KeyTransform::kDay;
+  } else if (key_function == "month") {
+    key_transform_ = KeyTransform::kMonth;
+  } else if (key_function == "year") {
+    key_transform_ = KeyTransform::kYear;
+  } else {
+    throw exceptions::UserInputException(
+        fmt::format("unknown key function {}", key_function).c_str());
+  }
+  key_path_ = fields::FieldPath::Parse(descriptor, key_field);
+
+  auto [agg_function, agg_field] = SplitExpression(args_.aggregate);
+  if (agg_function.empty() && agg_field == "count") {
+    aggregate_ = Aggregate::kCount;
+    return;
+  }
+
+  if (agg_function == "sum") {
+    aggregate_ = Aggregate::kSum;
+  } else if (agg_function == "distinct") {
+    aggregate_ = Aggregate::kDistinct;
+  } else {
+    throw exceptions::UserInputException(
+        fmt::format("unknown aggregate {}", args_.aggregate).c_str());
+  }
+
+  value_path_ = fields::FieldPath::Parse(descriptor, agg_field);
+
+  const auto kCppType = value_path_->leaf()->cpp_type();
+  real_sum_ = kCppType == pb::FieldDescriptor::CPPTYPE_DOUBLE ||
+              kCppType == pb::FieldDescriptor::CPPTYPE_FLOAT;
+  if (aggregate_ == Aggregate::kSum &&
+      (kCppType == pb::FieldDescriptor::CPPTYPE_STRING ||
+       (kCppType == pb::FieldDescriptor::CPPTYPE_MESSAGE &&
+        value_path_->leaf()->message_type()->full_name() !=
+            "google.protobuf.Timestamp"))) {
+    throw exceptions::UserInputException(
+        fmt::format("cannot sum non numeric field {}", agg_field).c_str());
+  }
+}
+
+std::optional<std::string> GroupBy::FormatKey(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const fields::Value& value) const {
+  if (std::holds_alternative<std::monostate>(value))
+    return std::nullopt;
+
+  if (key_transform_ == KeyTransform::kNone)
+    return fields::ToString(value);
+
+  int64_t seconds;
+  if (const auto* signed_value = std::get_if<int64_t>(&value)) {
+    seconds = *signed_value;
+  } else if (const auto* unsigned_value = std::get_if<uint64_t>(&value)) {
+    seconds = static_cast<int64_t>(*unsigned_value);
+  } else {
+    return std::nullopt;
+  }
+
+  const auto kDays = std::chrono::floor<std::chrono::days>(
+      std::chrono::sys_seconds(std::chrono::seconds(seconds)));
+  const std::chrono::year_month_day kDate(kDays);
+  const int kYear = static_cast<int>(kDate.year());
+  const unsigned kMonth = static_cast<unsigned>(kDate.month());
+  const unsigned kDay = static_cast<unsigned>(kDate.day());
+
+  switch (key_transform_) {
+    case KeyTransform::kDay:
+      return fmt::format("{:04}-{:02}-{:02}", kYear, kMonth, kDay);
+    case KeyTransform::kMonth:
+      return fmt::format("{:04}-{:02}", kYear, kMonth);
+    case KeyTransform::kYear:
+      return fmt::format("{:04}", kYear);
+    default:
+      return fields::ToString(value);
+  }
+}
+
+void GroupBy::Accumulate(Tables* tables, unsigned worker,
+                         // NOLINTNEXTLINE(whitespace/indent_namespace)
+                         const pb::Message& message) {
+  for (const auto& condition : conditions_) {
+    if (!Matches(condition, condition.path.Values(message)))
+      return;
+  }
+
+  std::vector<fields::Value> values;
+  if (value_path_)
+    values = value_path_->Values(message);
+
+  AccumulateRow(tables, worker, key_path_->Values(message), values);
+}
+
+void GroupBy::AccumulateRow(Tables* tables, unsigned worker,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            std::span<const fields::Value> keys,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            std::span<const fields::Value> values) {
+  size_t grown = 0;
+  for (const auto& key_value : keys) {
+    auto key = FormatKey(key_value);
+    if (!key)
+      continue;
+
+    auto& table = tables->TableFor(worker, *key);
+    auto [entry, inserted] = table.try_emplace(*key);
+    if (inserted)
+      grown += EstimateSize(*key, State());
+
+    State& state = entry->second;
+    state.count++;
+
+    for (const auto& value : values) {
+      if (aggregate_ == Aggregate::kSum) {
+        if (const auto* real = std::get_if<double>(&value)) {
+          state.real_sum += *real;
+        } else if (const auto* signed_value = std::get_if<int64_t>(&value)) {
+          state.int_sum += *signed_value;
+        } else if (const auto* unsigned_value =
+                       std::get_if<uint64_t>(&value)) {
+          state.int_sum += static_cast<int64_t>(*unsigned_value);
+        } else if (const auto* flag = std::get_if<bool>(&value)) {
+          state.int_sum += *flag ? 1 : 0;
+        }
+      } else if (aggregate_ == Aggregate::kDistinct) {
+        if (state.distinct.insert(hash::Bytes64(fields::ToString(value)))
+                .second) {
+          grown += kDistinctOverhead;
+        }
+      }
+    }
+  }
+
+  tables->Grow(worker, grown);
+}
+
+void GroupBy::State::Merge(const State& other) {
+  count += other.count;
+  int_sum += other.int_sum;
+  real_sum += other.real_sum;
+  distinct.insert(other.distinct.begin(), other.distinct.end());
+}
+
+void GroupBy::StateCodec::Encode(const State& state, std::string* output) {
+  binary::PutVarint(output, state.count);
+  binary::PutSignedVarint(output, state.int_sum);
+  binary::PutDouble(output, state.real_sum);
+  binary::PutVarint(output, state.distinct.size());
+  for (const auto kHash : state.distinct) {
+    binary::PutFixed64(output, kHash);
+  }
+}
+
+GroupBy::State GroupBy::StateCodec::Decode(std::string_view encoded) {
+  binary::Reader reader(encoded);
+  State state;
+  state.count = reader.Varint();
+  state.int_sum = reader.SignedVarint();
+  state.real_sum = reader.Double();
+  const uint64_t kDistinct = reader.Varint();
+  state.distinct.reserve(std::min<uint64_t>(kDistinct, reader.remaining()));
+  for (uint64_t i = 0; i < kDistinct; ++i) {
+    state.distinct.insert(reader.Fixed64());
+  }
+  return state;
+}
+
+void GroupBy::StateCodec::Merge(State* into, State&& from) {
+  if (into->distinct.size() < from.distinct.size())
+    into->distinct.swap(from.distinct);
+  into->Merge(from);
+}
+
+size_t GroupBy::StateCodec::Size(const std::string& key, const State& state) {
+  return EstimateSize(key, state);
+}
+
+double GroupBy::Rank(const State& state) const {
+  switch (aggregate_) {
+    case Aggregate::kSum:
+      return real_sum_ ? state.real_sum : static_cast<double>(state.int_sum);
+    case Aggregate::kDistinct:
+      return static_cast<double>(state.distinct.size());
+    default:
+      return static_cast<double>(state.count);
+  }
+}
+
+void GroupBy::PrintGroup(const std::string& key, const State& state) const {
+  switch (aggregate_) {
+    case Aggregate::kSum:
+      if (real_sum_) {
+        std::cout << key << '\t' << state.real_sum << '\n';
+      } else {
+        std::cout << key << '\t' << state.int_sum << '\n';
+      }
+      break;
+    case Aggregate::kDistinct:
+      std::cout << key << '\t' << state.distinct.size() << '\n';
+      break;
+    default:
+      std::cout << key << '\t' << state.count << '\n';
+  }
+}
+
+size_t GroupBy::EstimateSize(const std::string& key, const State& state) {
+  return kEntryOverhead + key.size() +
+         (state.distinct.size() * kDistinctOverhead);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_GROUP_BY_H_
+#define SRC_PBF_GROUP_BY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "columnar.h"
+#include "fields.h"
+#include "io.h"
+#include "spill.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to group the messages of a PBF file by a field and
+/// aggregate each group.
+///
+/// Every worker thread owns a hash table split into partitions by key
+/// hash. When the tables grow past the memory limit the largest
+/// partition is spilled to disk. Once the scan has finished each
+/// partition is merged independently across workers and spill files,
+/// see spill.h. Row groups of a columnar input whose statistics rule
+/// out every --where condition are skipped without being read.
+class GroupBy : public Command {
+ public:
+  GroupBy();
+
+  /// @brief Execute the group-by command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  /// @brief How a key value is transformed before grouping.
+  enum class KeyTransform : std::uint8_t {
+    kNone,
+    kDay,
+    kMonth,
+    kYear,
+  };
+
+  /// @brief The aggregate computed for every group.
+  enum class Aggregate : std::uint8_t {
+    kCount,
+    kSum,
+    kDistinct,
+  };
+
+  /// @brief How a --where condition compares a field to its constant.
+  enum class Comparison : std::uint8_t {
+    kEqual,
+    kLess,
+    kLessEqual,
+    kGreater,
+    kGreaterEqual,
+  };
+
+  /// @brief A --where condition, met by a message when any value of its
+  /// field compares to the constant.
+  struct Condition {
+    fields::FieldPath path;
+    Comparison comparison;
+    fields::Value constant;
+  };
+
+  struct Args {
+    std::string input;               ///< Input file path.
+    std::string key;                 ///< Key expression, e.g. month(timestamp).
+    std::string aggregate;           ///< Aggregate expression, e.g. sum(x).
+    std::vector<std::string> where;  ///< Conditions, e.g. page_id>=10.
+    std::optional<size_t> top;       ///< Only print the K largest groups.
+    size_t memory_limit;             ///< Memory budget in bytes.
+    std::filesystem::path tmp_dir;   ///< Directory for spill files.
+    unsigned threads;                ///< Number of worker threads.
+  };
+
+  /// @brief Running aggregate of a single group.
+  struct State {
+    uint64_t count = 0;
+    int64_t int_sum = 0;
+    double real_sum = 0;
+    std::unordered_set<uint64_t> distinct;
+
+    void Merge(const State& other);
+  };
+
+  /// @brief How a State is spilled, see spill::PartitionedTables.
+  struct StateCodec {
+    static void Encode(const State& state, std::string* output);
+    static State Decode(std::string_view encoded);
+    static void Merge(State* into, State&& from);
+    static size_t Size(const std::string& key, const State& state);
+  };
+
+  using Tables = spill::PartitionedTables<State, StateCodec>;
+  using Table = Tables::Table;
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Resolve the key and aggregate expressions against the
+  /// message type of the input file.
+  void ParseExpressions(const google::protobuf::Descriptor* descriptor);
+
+  /// @brief Resolve a --where condition of the form field<op>constant.
+  /// @throws exceptions::UserInputException if it is malformed or the
+  /// constant does not suit the field.
+  static Condition ParseCondition(
+      const google::protobuf::Descriptor* descriptor,
+      const std::string& condition);
+
+  /// @brief Whether any of a row's values of a field meets a condition.
+  static bool Matches(const Condition& condition,
+                      std::span<const fields::Value> values);
+
+  /// @brief Whether a column chunk may hold a value meeting a
+  /// condition, judged from its minimum and maximum.
+  static bool MayMatch(const Condition& condition,
+                       const columnar::ChunkInfo& chunk);
+
+  /// @brief Accumulate every message of a PBF input.
+  void ScanPbf(Tables* tables);
+
+  /// @brief Accumulate a columnar input, reading only the key, value
+  /// and condition columns of the row groups that may match.
+  void ScanColumnar(Tables* tables);
+
+  /// @brief Merge the worker tables and print the groups.
+  void Output(Tables* tables);
+
+  /// @brief Split an expression of the form name(field) or field.
+  /// @return The function name, empty if there is none, and the field.
+  static std::pair<std::string, std::string> SplitExpression(
+      const std::string& expression);
+
+  /// @brief Turn a key value into the string that is grouped on.
+  [[nodiscard]] std::optional<std::string> FormatKey(
+      const fields::Value& value) const;
+
+  /// @brief Add one message to a worker's tables.
+  void Accumulate(Tables* tables, unsigned worker,
+                  const google::protobuf::Message& message);
+
+  /// @brief Add one row, given as its key values and aggregated values,
+  /// to a worker's tables.
+  void AccumulateRow(Tables* tables, unsigned worker,
+                     std::span<const fields::Value> keys,
+                     std::span<const fields::Value> values);
+
+  /// @brief Value used to rank groups for --top.
+  [[nodiscard]] double Rank(const State& state) const;
+
+  /// @brief Print a group as a tab separated line.
+  void PrintGroup(const std::string& key, const State& state) const;
+
+  static size_t EstimateSize(const std::string& key, const State& state);
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+  std::optional<fields::FieldPath> key_path_;
+  std::optional<fields::FieldPath> value_path_;
+  std::vector<Condition> conditions_;
+  KeyTransform key_transform_ = KeyTransform::kNone;
+  Aggregate aggregate_ = Aggregate::kCount;
+  bool real_sum_ = false;
+
+  /// Number of hash partitions per worker.
+  static constexpr size_t kPartitions = 64;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_GROUP_BY_H_
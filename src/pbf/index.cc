@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "index.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "exceptions.h"
+#include "key_index.h"
+#include "offset_index.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace fs = std::filesystem;
+
+constexpr size_t kDefaultMemoryLimit = 1024;
+constexpr size_t kBytesPerMebibyte = size_t{1} << 20U;
+}  // namespace
+
+Index::Index()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("index", "Build the offset index of a PBF file") {
+  // clang-format off
+  cli_options_.add_options()
+    ("file", options::value<std::string>()->required(), "Input file.")
+    ("stride", options::value<uint64_t>()->default_value(
+        OffsetIndex::kDefaultStride),
+      "Record the position of every Nth message. Smaller strides make"
+      " seeks cheaper and the index larger.")
+    ("key,k", options::value<std::string>(),
+      "Also build a sorted index over the values of this field path, for"
+      " pbf get.")
+    ("memory-limit", options::value<size_t>()->default_value(
+        kDefaultMemoryLimit),
+      "Memory budget for sorting key index entries in MiB.")
+    ("tmp-dir", options::value<std::string>(),
+      "Directory for sorted runs. Defaults to the system temporary"
+      " directory.");
+  positional_options_.add("file", 1);
+  // clang-format on
+}
+
+ExitCode Index::Run(std::vector<std::string> args,
+                    // NOLINTNEXTLINE(whitespace/indent_namespace)
+                    struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    const auto kIndex = OffsetIndex::Build(args_.input, args_.stride);
+    kIndex.Save(args_.input);
+    spdlog::info("Indexed {} messages into {}", kIndex.count(),
+                 OffsetIndex::PathFor(args_.input));
+
+    if (args_.key) {
+      const auto kEntries = KeyIndex::Build(args_.input, *args_.key,
+                                            args_.memory_limit, args_.tmp_dir);
+      spdlog::info("Indexed {} keys into {}", kEntries,
+                   KeyIndex::PathFor(args_.input, *args_.key));
+    }
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to index input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Index::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
+  args_.stride = EnsureArgument<uint64_t>("stride", parsed_args.first);
+  args_.memory_limit =
+      EnsureArgument<size_t>("memory-limit", parsed_args.first) *
+      kBytesPerMebibyte;
+
+  args_.key = std::nullopt;
+  if (parsed_args.first.contains("key"))
+    args_.key = parsed_args.first["key"].as<std::string>();
+
+  args_.tmp_dir = fs::temp_directory_path();
+  if (parsed_args.first.contains("tmp-dir"))
+    args_.tmp_dir = parsed_args.first["tmp-dir"].as<std::string>();
+
+  spdlog::trace("Index command arguments: Input: {} Stride: {}", args_.input,
+                args_.stride);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
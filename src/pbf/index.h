@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_INDEX_H_
+#define SRC_PBF_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to build the offset index of a PBF file, letting
+/// commands such as sample seek to messages by ordinal, and with --key
+/// also the key index used by get to seek to messages by field value.
+class Index : public Command {
+ public:
+  Index();
+
+  /// @brief Execute the index command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;               ///< Input file path.
+    uint64_t stride;                 ///< Messages between recorded positions.
+    std::optional<std::string> key;  ///< Field path for a key index.
+    size_t memory_limit;             ///< Sort budget in bytes.
+    std::filesystem::path tmp_dir;   ///< Directory for sorted runs.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_INDEX_H_
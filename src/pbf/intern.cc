@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "intern.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "header.h"
+#include "io.h"
+#include "scan.h"
+#include "space_saving.h"
+#include "string_dictionary.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+constexpr uint64_t kDefaultMinCount = 16;
+constexpr size_t kDefaultMaxStrings = size_t{1} << 20U;
+constexpr size_t kDefaultCapacity = size_t{1} << 20U;
+
+/// @brief Bytes taken by a value as a varint.
+size_t VarintSize(uint64_t value) {
+  size_t size = 1;
+  for (; value >= 0x80; value >>= 7U) {
+    size++;
+  }
+  return size;
+}
+
+/// @brief Call visitor with every non-empty value a message and the
+/// messages nested in it hold in fields that can be interned.
+void VisitStrings(const pb::Message& message,
+                  // NOLINTNEXTLINE(whitespace/indent_namespace)
+                  const std::function<void(const std::string&)>& visitor) {
+  const auto* reflection = message.GetReflection();
+  std::vector<const pb::FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+
+  std::string scratch;
+  for (const auto* field : fields) {
+    if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        const int kSize = reflection->FieldSize(message, field);
+        for (int i = 0; i < kSize; ++i) {
+          VisitStrings(reflection->GetRepeatedMessage(message, field, i),
+                       visitor);
+        }
+      } else {
+        VisitStrings(reflection->GetMessage(message, field), visitor);
+      }
+    } else if (StringDictionary::Internable(field)) {
+      const std::string& value =
+          reflection->GetStringReference(message, field, &scratch);
+      if (!value.empty())
+        visitor(value);
+    }
+  }
+}
+}  // namespace
+
+Intern::Intern()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("intern", "Store the repeated strings of a PBF file once, in "
+                        "a dictionary") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::string>()->required(), "Input file.")
+    ("output,o", options::value<std::string>()->required(), "Output file.")
+    ("min-count",
+      options::value<uint64_t>()->default_value(kDefaultMinCount),
+      "Occurrences a value needs to be interned.")
+    ("max-strings",
+      options::value<size_t>()->default_value(kDefaultMaxStrings),
+      "Most strings to put in the dictionary.")
+    ("capacity",
+      options::value<size_t>()->default_value(kDefaultCapacity),
+      "Values each worker keeps counts for. Larger values find more"
+      " strings worth interning but use more memory.")
+    ("compress", "Write the payload as zstd compressed blocks.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  // clang-format on
+
+  positional_options_.add("input", 1);
+  positional_options_.add("output", 1);
+}
+
+ExitCode Intern::Run(std::vector<std::string> args,
+                     // NOLINTNEXTLINE(whitespace/indent_namespace)
+                     struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    input_ = io::OpenPbfFile(args_.input);
+    header_ = io::ReadPbfHeader(input_.get());
+    auto dictionary = BuildDictionary();
+    io::ClosePbfFile(std::move(input_));
+
+    WriteOutput(dictionary);
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to intern strings: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Intern::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.min_count = EnsureArgument<uint64_t>("min-count", parsed_args.first);
+  args_.max_strings =
+      EnsureArgument<size_t>("max-strings", parsed_args.first);
+  args_.capacity = EnsureArgument<size_t>("capacity", parsed_args.first);
+  args_.compress = parsed_args.first.contains("compress");
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+
+  if (args_.capacity == 0)
+    throw exceptions::UserInputException("capacity must be at least 1");
+
+  spdlog::debug("Intern arguments: min-count={} max-strings={} capacity={} "
+                "threads={}",
+                args_.min_count, args_.max_strings, args_.capacity,
+                args_.threads);
+}
+
+StringDictionary Intern::BuildDictionary() {
+  std::vector<SpaceSaving> summaries(std::max(args_.threads, 1U),
+                                     SpaceSaving(args_.capacity));
+
+  scan::ParallelScan(
+      input_.get(), *header_, args_.threads,
+      [&](unsigned worker, uint64_t, const pb::Message& message) {
+        VisitStrings(message, [&](const std::string& value) {
+          summaries[worker].Add(value);
+        });
+      });
+
+  for (size_t i = 1; i < summaries.size(); ++i) {
+    summaries[0].Merge(summaries[i]);
+  }
+
+  // Values are taken most frequent first, each only if the bytes its
+  // id saves over all its occurrences outweigh its dictionary entry.
+  StringDictionary dictionary;
+  uint64_t saved = 0;
+  for (const auto& entry : summaries[0].Top(summaries[0].size())) {
+    if (dictionary.size() >= args_.max_strings)
+      break;
+
+    const uint64_t kCount = entry.count - entry.error;
+    const size_t kStored = entry.key.size() + VarintSize(entry.key.size());
+    const size_t kId = VarintSize(dictionary.size());
+    if (kCount < args_.min_count || kStored <= kId ||
+        kCount * (kStored - kId) <= kStored)
+      continue;
+
+    dictionary.Add(entry.key);
+    saved += kCount * (kStored - kId) - kStored;
+  }
+
+  spdlog::info("Interning {} strings, saving at least {} bytes",
+               dictionary.size(), saved);
+  return dictionary;
+}
+
+void Intern::WriteOutput(const StringDictionary& dictionary) {
+  input_ = io::OpenPbfFile(args_.input);
+  io::ReadPbfHeader(input_.get());
+
+  auto header = *header_;
+  header::ClearLayout(&header);
+  dictionary.Save(&header);
+  if (args_.compress)
+    container::MarkCompressed(&header);
+
+  io::PbfWriter output(args_.output, header, args_.threads);
+  for (uint64_t i = 0; i < header_->count(); ++i) {
+    auto message = io::ReadGenericMessage(input_.get(), header_->type());
+    dictionary.Encode(message.get());
+    output.Write(*message);
+  }
+  output.Close();
+  io::ClosePbfFile(std::move(input_));
+
+  spdlog::info("Wrote {} messages to {}", header_->count(), args_.output);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_INTERN_H_
+#define SRC_PBF_INTERN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+
+#include "cli.h"
+#include "io.h"
+#include "string_dictionary.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to rewrite a PBF file with its most repeated strings
+/// stored once in a dictionary and referred to by id, see
+/// string_dictionary.h.
+///
+/// A first parallel scan finds the most frequent values of every
+/// singular string field with a Space-Saving summary per worker, so
+/// memory does not grow with the number of distinct values. Values
+/// repeated often enough to pay for their entry are interned, the most
+/// frequent first so they get the shortest ids, and a second scan
+/// writes the messages with those values replaced.
+class Intern : public Command {
+ public:
+  Intern();
+
+  /// @brief Execute the intern command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;   ///< Input file path.
+    std::string output;  ///< Output file path.
+    uint64_t min_count;  ///< Occurrences needed to intern a value.
+    size_t max_strings;  ///< Largest dictionary to build.
+    size_t capacity;     ///< Values monitored per worker.
+    bool compress;       ///< Block compress the output.
+    unsigned threads;    ///< Number of worker threads.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Find the values worth interning in one parallel scan.
+  StringDictionary BuildDictionary();
+
+  /// @brief Write every message of the input with its interned values
+  /// replaced by ids.
+  void WriteOutput(const StringDictionary& dictionary);
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_INTERN_H_
@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "join.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "doi.h"
+#include "doi_index.h"
+#include "doi_table.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "io.h"
+#include "json.h"
+#include "scan.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace pb = google::protobuf;
+
+/// Bytes a worker buffers before taking the output lock.
+constexpr size_t kFlushSize = size_t{1} << 20U;
+
+/// Citation field holding a URL, which may be a DOI resolver link.
+constexpr const char* kUrlField = "url";
+
+/// Fields identifying a citing message, where its type has them.
+constexpr std::array<const char*, 3> kIdFields = {
+    fields::kPageIdField, fields::kRevisionIdField, fields::kTimestampField};
+
+void AppendJsonValue(std::string* output, const fields::Value& value) {
+  if (std::holds_alternative<std::monostate>(value)) {
+    *output += "null";
+  } else if (const auto* text = std::get_if<std::string>(&value)) {
+    *output += '"';
+    *output += json::Escape(*text);
+    *output += '"';
+  } else {
+    *output += fields::ToString(value);
+  }
+}
+}  // namespace
+
+Join::Join()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("join", "Link citations to OpenAlex works by DOI") {
+  // clang-format off
+  cli_options_.add_options()
+    ("works", options::value<std::string>()->required(),
+      "OpenAlex works file to index, or a DOI table built from one by"
+      " pbf doi-table.")
+    ("input", options::value<std::string>()->required(),
+      "Pages or revisions file whose citations are linked.")
+    ("output,o", options::value<std::string>(),
+      "Output file. Defaults to standard output.")
+    ("format,f", options::value<std::string>()->default_value("jsonl"),
+      "Output format: jsonl or tsv.")
+    ("unmatched",
+      "Also emit citations whose DOI matches no work, with an empty"
+      " work.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  // clang-format on
+
+  positional_options_.add("works", 1);
+  positional_options_.add("input", 1);
+}
+
+ExitCode Join::Run(std::vector<std::string> args,
+                   // NOLINTNEXTLINE(whitespace/indent_namespace)
+                   struct GlobalOptions) {
+  LoadArgs(args);
+
+  std::ofstream file;
+  try {
+    if (DoiTable::IsTable(args_.works)) {
+      table_ = std::make_unique<DoiTable>(args_.works);
+      spdlog::info("Mapped {} DOIs from {} ({} MiB)", table_->size(),
+                   args_.works, table_->MappedSize() >> 20U);
+    } else {
+      const auto kStart = std::chrono::steady_clock::now();
+      index_ = std::make_unique<DoiIndex>(DoiIndex::Build(args_.works));
+      spdlog::info(
+          "Indexed {} DOIs of {} works in {:.1f}s using {} MiB",
+          index_->size(), index_->works(),
+          std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                        kStart)
+              .count(),
+          index_->MemoryUsage() >> 20U);
+    }
+
+    auto input = io::OpenPbfFile(args_.input);
+    auto header = io::ReadPbfHeader(input.get());
+    ResolveFields(io::DescriptorForFileType(header->type()));
+
+    output_ = &std::cout;
+    if (args_.output) {
+      file = std::ofstream(*args_.output, std::ios::out | std::ios::trunc);
+      output_ = &file;
+    }
+
+    if (args_.format == Format::kTsv) {
+      std::string columns;
+      for (const auto& path : id_paths_) {
+        columns += path.path() + '\t';
+      }
+      *output_ << columns << "citation\tdoi\twork\topenalex_id\n";
+    }
+
+    std::vector<WorkerState> workers(std::max(args_.threads, 1U));
+    scan::ParallelScan(input.get(), *header, args_.threads,
+                       [this, &workers](unsigned worker, uint64_t,
+                                        const pb::Message& message) {
+                         Probe(&workers[worker], message);
+                       });
+    io::ClosePbfFile(std::move(input));
+
+    WorkerState total;
+    for (auto& worker : workers) {
+      Flush(&worker);
+      total.citations += worker.citations;
+      total.with_doi += worker.with_doi;
+      total.matched += worker.matched;
+    }
+
+    output_->flush();
+    if (!*output_)
+      throw exceptions::CliException("failed to write output");
+
+    spdlog::info("Linked {} of {} citations with a DOI ({} citations read)",
+                 total.matched, total.with_doi, total.citations);
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to join input files: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Join::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.works = EnsureArgument<std::string>("works", parsed_args.first);
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.unmatched = parsed_args.first.contains("unmatched");
+
+  const auto kFormat = EnsureArgument<std::string>("format", parsed_args.first);
+  if (kFormat == "jsonl") {
+    args_.format = Format::kJsonl;
+  } else if (kFormat == "tsv") {
+    args_.format = Format::kTsv;
+  } else {
+    throw exceptions::UserInputException(
+        fmt::format("unknown output format: {}", kFormat).c_str());
+  }
+
+  args_.output = std::nullopt;
+  if (parsed_args.first.contains("output"))
+    args_.output = parsed_args.first["output"].as<std::string>();
+
+  spdlog::debug("Join arguments: works={} input={} format={}", args_.works,
+                args_.input, kFormat);
+}
+
+void Join::ResolveFields(const pb::Descriptor* descriptor) {
+  citations_field_ = descriptor->FindFieldByName(fields::kCitationsField);
+  if (citations_field_ == nullptr || !citations_field_->is_repeated() ||
+      citations_field_->message_type() == nullptr) {
+    throw exceptions::UnsupportedFileType(
+        "join needs a file of messages with citations");
+  }
+
+  const auto* citation = citations_field_->message_type();
+  doi_field_ = citation->FindFieldByName(fields::kDoiField);
+  url_field_ = citation->FindFieldByName(kUrlField);
+  if (doi_field_ == nullptr)
+    throw exceptions::UnsupportedFileType("citations have no DOI field");
+
+  id_paths_.clear();
+  for (const auto* name : kIdFields) {
+    if (auto path = fields::FieldPath::Find(descriptor, name))
+      id_paths_.push_back(std::move(*path));
+  }
+}
+
+void Join::Probe(WorkerState* state, const pb::Message& message) {
+  const auto* reflection = message.GetReflection();
+  const int kCitations = reflection->FieldSize(message, citations_field_);
+  for (int i = 0; i < kCitations; ++i) {
+    const auto& citation =
+        reflection->GetRepeatedMessage(message, citations_field_, i);
+    const auto* citation_reflection = citation.GetReflection();
+    state->citations++;
+
+    // Fall back to the URL when it points at a DOI resolver.
+    auto normalized =
+        doi::Normalize(citation_reflection->GetString(citation, doi_field_));
+    if (!normalized && url_field_ != nullptr) {
+      normalized =
+          doi::Normalize(citation_reflection->GetString(citation, url_field_));
+    }
+    if (!normalized)
+      continue;
+
+    state->with_doi++;
+    const auto kMatch = Resolve(*normalized);
+    if (kMatch)
+      state->matched++;
+    if (kMatch || args_.unmatched)
+      AppendLink(state, message, i, *normalized, kMatch);
+  }
+
+  if (state->buffer.size() >= kFlushSize)
+    Flush(state);
+}
+
+std::optional<Join::Match> Join::Resolve(const std::string& doi) const {
+  if (table_) {
+    const auto kSlot = table_->Find(doi);
+    if (!kSlot)
+      return std::nullopt;
+    return Match{table_->Work(*kSlot), table_->OpenAlexId(*kSlot)};
+  }
+
+  const auto kWork = index_->Find(doi);
+  if (!kWork)
+    return std::nullopt;
+  return Match{*kWork, std::string(index_->OpenAlexId(*kWork))};
+}
+
+void Join::AppendLink(WorkerState* state, const pb::Message& message,
+                      int citation, const std::string& doi,
+                      // NOLINTNEXTLINE(whitespace/indent_namespace)
+                      const std::optional<Match>& match) const {
+  std::string& out = state->buffer;
+  if (args_.format == Format::kTsv) {
+    for (const auto& path : id_paths_) {
+      out += fields::ToString(path.First(message));
+      out += '\t';
+    }
+    fmt::format_to(std::back_inserter(out), "{}\t{}\t", citation, doi);
+    if (match) {
+      fmt::format_to(std::back_inserter(out), "{}\t{}", match->work,
+                     match->openalex_id);
+    } else {
+      out += '\t';
+    }
+    out += '\n';
+    return;
+  }
+
+  out += '{';
+  for (const auto& path : id_paths_) {
+    fmt::format_to(std::back_inserter(out), "\"{}\":", path.path());
+    AppendJsonValue(&out, path.First(message));
+    out += ',';
+  }
+  fmt::format_to(std::back_inserter(out), R"("citation":{},"doi":"{}",)",
+                 citation, json::Escape(doi));
+  if (match) {
+    fmt::format_to(std::back_inserter(out), R"("work":{},"openalex_id":"{}")",
+                   match->work, json::Escape(match->openalex_id));
+  } else {
+    out += R"("work":null,"openalex_id":null)";
+  }
+  out += "}\n";
+}
+
+void Join::Flush(WorkerState* state) {
+  if (state->buffer.empty())
+    return;
+
+  const std::lock_guard<std::mutex> kLock(output_mutex_);
+  output_->write(state->buffer.data(),
+                 static_cast<std::streamsize>(state->buffer.size()));
+  state->buffer.clear();
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
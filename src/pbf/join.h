@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_JOIN_H_
+#define SRC_PBF_JOIN_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "doi_index.h"
+#include "doi_table.h"
+#include "fields.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to link the citations of a pages or revisions file
+/// to OpenAlex works by DOI.
+///
+/// The works file is loaded into a DoiIndex, unless it is a DoiTable
+/// built by pbf doi-table, which is mapped instead. The citing file is
+/// then streamed across a thread pool, each worker normalizing and
+/// probing the DOI of every citation and buffering the links it finds,
+/// which are written out in chunks under a lock.
+class Join : public Command {
+ public:
+  Join();
+
+  /// @brief Execute the join command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  enum class Format : std::uint8_t {
+    kJsonl,
+    kTsv,
+  };
+
+  struct Args {
+    std::string works;                  ///< Works file or DOI table path.
+    std::string input;                  ///< Pages or revisions file path.
+    std::optional<std::string> output;  ///< Output file, else stdout.
+    Format format;                      ///< Output format.
+    unsigned threads;                   ///< Number of worker threads.
+    bool unmatched;                     ///< Also emit unmatched DOIs.
+  };
+
+  /// @brief The work a DOI resolved to.
+  struct Match {
+    uint64_t work;            ///< Ordinal in the works file.
+    std::string openalex_id;  ///< OpenAlex id of the work.
+  };
+
+  /// @brief Output and counters owned by one worker.
+  struct WorkerState {
+    std::string buffer;
+    uint64_t citations = 0;
+    uint64_t with_doi = 0;
+    uint64_t matched = 0;
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Resolve the fields read from citing messages.
+  void ResolveFields(const google::protobuf::Descriptor* descriptor);
+
+  /// @brief Probe every citation of a message.
+  void Probe(WorkerState* state, const google::protobuf::Message& message);
+
+  /// @brief Look a normalized DOI up in the index or table.
+  [[nodiscard]] std::optional<Match> Resolve(const std::string& doi) const;
+
+  /// @brief Append one link record to a worker's buffer.
+  void AppendLink(WorkerState* state, const google::protobuf::Message& message,
+                  int citation, const std::string& doi,
+                  const std::optional<Match>& match) const;
+
+  /// @brief Write out a worker's buffer.
+  void Flush(WorkerState* state);
+
+  Args args_;
+  std::unique_ptr<DoiIndex> index_;
+  std::unique_ptr<DoiTable> table_;
+  std::ostream* output_ = nullptr;
+  std::mutex output_mutex_;
+
+  const google::protobuf::FieldDescriptor* citations_field_ = nullptr;
+  const google::protobuf::FieldDescriptor* doi_field_ = nullptr;
+  const google::protobuf::FieldDescriptor* url_field_ = nullptr;
+
+  /// Fields identifying the citing message, copied into every link.
+  std::vector<fields::FieldPath> id_paths_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_JOIN_H_
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "make_doi_table.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "doi_table.h"
+#include "exceptions.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+
+constexpr const char* kTableExtension = ".doit";
+}  // namespace
+
+MakeDoiTable::MakeDoiTable()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("doi-table",
+              "Build a memory mapped DOI to OpenAlex id table from works") {
+  // clang-format off
+  cli_options_.add_options()
+    ("works", options::value<std::string>()->required(),
+      "OpenAlex works file.")
+    ("output,o", options::value<std::string>(),
+      "Table file. Defaults to the works file with a .doit extension"
+      " appended.");
+  positional_options_.add("works", 1);
+  // clang-format on
+}
+
+ExitCode MakeDoiTable::Run(std::vector<std::string> args,
+                           // NOLINTNEXTLINE(whitespace/indent_namespace)
+                           struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    const auto kStart = std::chrono::steady_clock::now();
+    const auto kKeys = DoiTable::Build(args_.works, args_.output);
+    const DoiTable kTable(args_.output);
+    spdlog::info("Wrote {} DOIs to {} in {:.1f}s, {:.1f} bytes per DOI",
+                 kKeys, args_.output,
+                 std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - kStart)
+                     .count(),
+                 kKeys == 0 ? 0.0
+                            : static_cast<double>(kTable.MappedSize()) /
+                                  static_cast<double>(kKeys));
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to build DOI table: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void MakeDoiTable::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.works = EnsureArgument<std::string>("works", parsed_args.first);
+  args_.output = args_.works + kTableExtension;
+  if (parsed_args.first.contains("output"))
+    args_.output = parsed_args.first["output"].as<std::string>();
+
+  spdlog::trace("Doi-table command arguments: Works: {} Output: {}",
+                args_.works, args_.output);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_MAKE_DOI_TABLE_H_
+#define SRC_PBF_MAKE_DOI_TABLE_H_
+
+#include <string>
+#include <vector>
+
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to build a DoiTable from an OpenAlex works file, which
+/// join and other processes map to resolve DOIs without loading the
+/// works file.
+class MakeDoiTable : public Command {
+ public:
+  MakeDoiTable();
+
+  /// @brief Execute the doi-table command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string works;   ///< OpenAlex works file path.
+    std::string output;  ///< Table file path.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_MAKE_DOI_TABLE_H_
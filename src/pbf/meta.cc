@@ -1,19 +1,25 @@
-// SPDX-FileCopyrightText: 2025 The University of St Andrews
+// SPDX-FileCopyrightText: 2025-2026 The University of St Andrews
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "meta.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>  // NOLINT(build/c++17)
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "boost/program_options/options_description.hpp"
@@ -25,18 +31,32 @@
 #include "citescoop/proto/language.pb.h"
 #include "citescoop/proto/page.pb.h"
 #include "citescoop/proto/revision.pb.h"
+#include "fmt/format.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
 #include "spdlog/spdlog.h"
 
 #include "cli.h"
+#include "delta.h"
+#include "doi.h"
 #include "exceptions.h"
+#include "fields.h"
+#include "hash.h"
+#include "hyperloglog.h"
 #include "io.h"
+#include "scan.h"
+#include "string_dictionary.h"
+#include "thread_pool.h"
 
 namespace wikiopencite::citescoop::cli::pbf {
 
 namespace {
 namespace options = boost::program_options;
+namespace fs = std::filesystem;
 namespace proto = wikiopencite::proto;
+
+constexpr double kMedian = 0.5;
+constexpr double kP99 = 0.99;
 }  // namespace
 
 namespace {
@@ -82,6 +102,24 @@ std::string FormatFileSize(size_t size) {
 
   return oss.str();
 }
+
+/// @brief Hash of a value for a cardinality sketch. DOIs are normalized
+/// first so that differently written DOIs count once.
+std::optional<uint64_t> HashValue(const fields::Value& value, bool is_doi) {
+  if (std::holds_alternative<std::monostate>(value))
+    return std::nullopt;
+
+  const auto* text = std::get_if<std::string>(&value);
+  if (text == nullptr)
+    return hash::Bytes64(fields::ToString(value));
+  if (!is_doi)
+    return hash::Bytes64(*text);
+
+  const auto kDoi = doi::Normalize(*text);
+  if (!kDoi)
+    return std::nullopt;
+  return hash::Bytes64(*kDoi);
+}
 }  // namespace
 
 Meta::Meta()
@@ -89,9 +127,30 @@ Meta::Meta()
     : Command("meta", "Display metainformation about a PBF file") {
   // clang-format off
   cli_options_.add_options()
-    ("file", options::value<std::string>()->required(), "Input file.")
+    ("file", options::value<std::string>(), "Input file.")
     ("pretty,p", options::value<bool>()->zero_tokens()->default_value(false),
-    "Display sizes like 1K 234M 2G etc. Uses powers of 1024");
+    "Display sizes like 1K 234M 2G etc. Uses powers of 1024")
+    ("breakdown",
+      "Report the bytes taken by each field path and a histogram of"
+      " message sizes.")
+    ("disk-only",
+      "Only report sizes on disk, skipping the decoding needed to measure"
+      " messages in memory. Without --cardinality the file is then only"
+      " read, not decoded.")
+    ("cardinality,c",
+      options::value<std::vector<std::string>>()->multitoken(),
+      "Field paths to estimate the number of distinct values of, for"
+      " example citations.doi, using a HyperLogLog sketch per field.")
+    ("save-sketches",
+      "Write the --cardinality sketches next to the input as <file>.hll.")
+    ("combine", options::value<std::vector<std::string>>()->multitoken(),
+      "Sketch files written by --save-sketches to merge instead of reading"
+      " an input file. Prints distinct counts over all of their files,"
+      " for the --cardinality fields or else every field they share.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
   positional_options_.add("file", 1);
 
   // clang-format on
@@ -102,6 +161,9 @@ ExitCode Meta::Run(std::vector<std::string> args,
                    struct GlobalOptions) {
   LoadArgs(args);
 
+  if (!args_.combine.empty())
+    return CombineSketches();
+
   OpenFile();
 
   try {
@@ -117,10 +179,16 @@ ExitCode Meta::Run(std::vector<std::string> args,
   size_t size_in_mem;
 
   try {
+    cardinality_paths_.clear();
+    for (const auto& field : args_.cardinality) {
+      cardinality_paths_.push_back(fields::FieldPath::Parse(
+          io::DescriptorForFileType(header_->type()), field));
+    }
+
     auto sizes = CalculateSize();
     size_on_disk = sizes.first;
     size_in_mem = sizes.second;
-  } catch (const exceptions::UnsupportedFileType& e) {
+  } catch (const exceptions::UserInputException& e) {
     spdlog::critical("Failed to read input file: {}", e.what());
     std::cerr << e.what() << '\n';
 
@@ -133,8 +201,32 @@ ExitCode Meta::Run(std::vector<std::string> args,
 
   std::cout << "Attributes: " << attributes_str << '\n';
   std::cout << "Total messages: " << header_->count() << '\n';
+  if (const auto kDictionary = StringDictionary::FromHeader(*header_))
+    std::cout << "Interned strings: " << kDictionary->size() << '\n';
   std::cout << "Total message size (disk): " << size_on_disk_str << '\n';
-  std::cout << "Total message size (memory): " << size_in_mem_str << '\n';
+  if (!args_.disk_only) {
+    std::cout << "Total message size (memory): " << size_in_mem_str
+              << '\n';
+  }
+  PrintCardinality(args_.cardinality, sketches_);
+  if (args_.breakdown)
+    PrintBreakdown(size_on_disk);
+
+  if (args_.save_sketches) {
+    SketchSidecar sidecar;
+    sidecar.file_size = fs::file_size(args_.input);
+    for (size_t i = 0; i < sketches_.size(); ++i) {
+      sidecar.sketches.insert_or_assign(args_.cardinality[i], sketches_[i]);
+    }
+    try {
+      sidecar.Save(HyperLogLog::PathFor(args_.input));
+    } catch (const exceptions::CliException& e) {
+      spdlog::critical("Failed to save sketches: {}", e.what());
+      std::cerr << e.what() << '\n';
+
+      return e.code();
+    }
+  }
 
   return ExitCode::kOk;
 }
@@ -142,8 +234,30 @@ ExitCode Meta::Run(std::vector<std::string> args,
 void Meta::LoadArgs(const std::vector<std::string>& args) {
   auto parsed_args = ParseArgs(args);
 
-  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
   args_.pretty = parsed_args.first.contains("pretty");
+  args_.breakdown = parsed_args.first.contains("breakdown");
+  args_.disk_only = parsed_args.first.contains("disk-only");
+  args_.save_sketches = parsed_args.first.contains("save-sketches");
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+
+  args_.cardinality.clear();
+  if (parsed_args.first.contains("cardinality")) {
+    args_.cardinality =
+        parsed_args.first["cardinality"].as<std::vector<std::string>>();
+  }
+
+  args_.combine.clear();
+  if (parsed_args.first.contains("combine")) {
+    args_.combine =
+        parsed_args.first["combine"].as<std::vector<std::string>>();
+    return;
+  }
+
+  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
+  if (args_.save_sketches && args_.cardinality.empty()) {
+    throw exceptions::UserInputException(
+        "--save-sketches needs fields given by --cardinality");
+  }
 }
 
 void Meta::OpenFile() {
@@ -155,15 +269,159 @@ void Meta::LoadHeader() {
 }
 
 std::pair<size_t, size_t> Meta::CalculateSize() {
-  size_t mem_size = 0;
-  size_t disk_size = 0;
+  struct Totals {
+    size_t mem_size = 0;
+    size_t disk_size = 0;
+    std::vector<HyperLogLog> sketches;
+    Log2Histogram sizes;
+    std::optional<FieldSizes> field_sizes;
+  };
+
+  const auto* descriptor = io::DescriptorForFileType(header_->type());
+  std::vector<Totals> workers(std::max(args_.threads, 1U));
+  for (auto& worker : workers) {
+    worker.sketches.resize(cardinality_paths_.size());
+    if (args_.breakdown)
+      worker.field_sizes.emplace(descriptor);
+  }
+
+  std::vector<bool> is_doi;
+  for (const auto& path : cardinality_paths_) {
+    is_doi.push_back(path.leaf()->name() == fields::kDoiField);
+  }
 
-  for (uint64_t i = 0; i < header_->count(); i++) {
-    auto message = io::ReadGenericMessage(input_.get(), header_->type());
-    disk_size += message->ByteSizeLong();
-    mem_size += message->SpaceUsedLong();
+  // Sizes on disk and the breakdown come from the stored frames, so
+  // messages are only decoded for what needs their fields.
+  const bool kDecode = !args_.disk_only || !cardinality_paths_.empty();
+  scan::ParallelScanFrames(
+      input_.get(), *header_, args_.threads, kDecode,
+      [&](unsigned worker, uint64_t, std::string_view frame,
+          const google::protobuf::Message* message) {
+        auto& totals = workers[worker];
+        totals.disk_size += frame.size();
+        totals.sizes.Add(frame.size());
+        if (totals.field_sizes)
+          totals.field_sizes->Add(frame);
+        if (message == nullptr)
+          return;
+
+        totals.mem_size += message->SpaceUsedLong();
+        for (size_t i = 0; i < cardinality_paths_.size(); ++i) {
+          cardinality_paths_[i].Visit(
+              *message, [&](const fields::Value& value) {
+                if (auto hash = HashValue(value, is_doi[i]))
+                  totals.sketches[i].Add(*hash);
+              });
+        }
+      });
+
+  for (size_t i = 1; i < workers.size(); ++i) {
+    workers[0].disk_size += workers[i].disk_size;
+    workers[0].mem_size += workers[i].mem_size;
+    workers[0].sizes.Merge(workers[i].sizes);
+    if (workers[0].field_sizes)
+      workers[0].field_sizes->Merge(*workers[i].field_sizes);
+    for (size_t j = 0; j < cardinality_paths_.size(); ++j) {
+      workers[0].sketches[j].Merge(workers[i].sketches[j]);
+    }
   }
-  return std::make_pair(disk_size, mem_size);
+  sketches_ = std::move(workers[0].sketches);
+  sizes_ = workers[0].sizes;
+  field_sizes_ = std::move(workers[0].field_sizes);
+  return std::make_pair(workers[0].disk_size, workers[0].mem_size);
+}
+
+void Meta::PrintCardinality(const std::vector<std::string>& fields,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            const std::vector<HyperLogLog>& sketches) const {
+  for (size_t i = 0; i < fields.size(); ++i) {
+    std::cout << fmt::format("Distinct {}: {} (+/- {:.2f}%)\n", fields[i],
+                             std::llround(sketches[i].Estimate()),
+                             100 * sketches[i].StandardError());
+  }
+}
+
+void Meta::PrintBreakdown(size_t size_on_disk) const {
+  std::cout << fmt::format("Message size: p50 {} p99 {} max {}\n",
+                           FormatSize(sizes_.Quantile(kMedian)),
+                           FormatSize(sizes_.Quantile(kP99)),
+                           FormatSize(sizes_.max()));
+  std::cout << "Message size histogram:" << '\n';
+  for (size_t i = 0; i < Log2Histogram::kBuckets; ++i) {
+    if (sizes_.bucket(i) == 0)
+      continue;
+
+    std::cout << fmt::format("  >= {:<12} {}",
+                             FormatSize(Log2Histogram::BucketLowerBound(i)),
+                             sizes_.bucket(i))
+              << '\n';
+  }
+
+  std::cout << "Bytes by field:" << '\n';
+  for (const auto& row : field_sizes_->Rows()) {
+    const double kShare =
+        size_on_disk == 0 ? 0
+                          : 100.0 * static_cast<double>(row.bytes) /
+                                static_cast<double>(size_on_disk);
+    std::cout << fmt::format("  {:<40} {:>12} {:>6.2f}% {:>12} values\n",
+                             row.path, FormatSize(row.bytes), kShare,
+                             row.count);
+  }
+}
+
+ExitCode Meta::CombineSketches() {
+  std::vector<SketchSidecar> sidecars;
+  try {
+    for (const auto& path : args_.combine) {
+      sidecars.push_back(SketchSidecar::Load(path));
+    }
+
+    // Without --cardinality, every field sketched in all of the files.
+    std::vector<std::string> fields = args_.cardinality;
+    if (fields.empty()) {
+      for (const auto& [field, sketch] : sidecars.front().sketches) {
+        if (std::all_of(sidecars.begin(), sidecars.end(),
+                        [&field](const SketchSidecar& sidecar) {
+                          return sidecar.sketches.contains(field);
+                        }))
+          fields.push_back(field);
+      }
+    }
+
+    std::vector<HyperLogLog> merged;
+    for (const auto& field : fields) {
+      std::optional<HyperLogLog> sketch;
+      for (size_t i = 0; i < sidecars.size(); ++i) {
+        auto found = sidecars[i].sketches.find(field);
+        if (found == sidecars[i].sketches.end()) {
+          throw exceptions::UserInputException(
+              fmt::format("{} has no sketch of {}", args_.combine[i], field)
+                  .c_str());
+        }
+        if (sketch) {
+          sketch->Merge(found->second);
+        } else {
+          sketch = found->second;
+        }
+      }
+      merged.push_back(std::move(*sketch));
+    }
+    uint64_t total_size = 0;
+    for (const auto& sidecar : sidecars) {
+      total_size += sidecar.file_size;
+    }
+
+    std::cout << "Files: " << sidecars.size() << '\n';
+    std::cout << "Total file size: " << FormatSize(total_size) << '\n';
+    PrintCardinality(fields, merged);
+  } catch (const exceptions::UserInputException& e) {
+    spdlog::critical("Failed to combine sketches: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
 }
 
 std::string Meta::FormatAdditionalAttributes() {
@@ -172,11 +430,15 @@ std::string Meta::FormatAdditionalAttributes() {
     case proto::FileType::FILE_TYPE_REVISIONS: {
       const google::protobuf::EnumDescriptor* descriptor =
           proto::Language_descriptor();
-      return "Language: " +
-             std::string(descriptor
-                             ->FindValueByNumber(
-                                 header_->dump_file_attributes().language())
-                             ->name());
+      std::string attributes =
+          "Language: " +
+          std::string(descriptor
+                          ->FindValueByNumber(
+                              header_->dump_file_attributes().language())
+                          ->name());
+      if (delta::IsEncoded(*header_))
+        attributes += ", Encoding: delta";
+      return attributes;
     }
 
     default:
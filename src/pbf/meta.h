@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -13,6 +14,10 @@
 #include "citescoop/proto/file_header.pb.h"
 
 #include "cli.h"
+#include "field_sizes.h"
+#include "fields.h"
+#include "histogram.h"
+#include "hyperloglog.h"
 #include "io.h"
 
 namespace wikiopencite::citescoop::cli::pbf {
@@ -26,12 +31,35 @@ class Meta : public Command {
   struct Args {
     std::string input;
     bool pretty;
+    bool breakdown;                        ///< Report bytes per field.
+    bool disk_only;                        ///< Skip sizes in memory.
+    std::vector<std::string> cardinality;  ///< Fields to count values of.
+    bool save_sketches;                    ///< Write the sketch sidecar.
+    std::vector<std::string> combine;      ///< Sketch files to combine.
+    unsigned threads;
   };
 
   void LoadArgs(const std::vector<std::string>& args);
   void OpenFile();
   void LoadHeader();
+
+  /// @brief Read every message, summing their sizes and sketching the
+  /// distinct values of the --cardinality fields into sketches_. With
+  /// --breakdown the sizes are also recorded in sizes_ and field_sizes_,
+  /// walking the stored bytes of each message rather than decoding it.
   std::pair<size_t, size_t> CalculateSize();
+
+  /// @brief Print the message size histogram and bytes per field.
+  void PrintBreakdown(size_t size_on_disk) const;
+
+  /// @brief Print the distinct counts of a set of sketches.
+  void PrintCardinality(const std::vector<std::string>& fields,
+                        const std::vector<HyperLogLog>& sketches) const;
+
+  /// @brief Merge the sketch files given by --combine and print the
+  /// distinct counts of their union.
+  ExitCode CombineSketches();
+
   [[nodiscard]] std::string FormatAdditionalAttributes();
   [[nodiscard]] std::string FormatSize(size_t size) const;
 
@@ -39,6 +67,10 @@ class Meta : public Command {
   wikiopencite::proto::FileType file_type_;
   std::unique_ptr<wikiopencite::proto::FileHeader> header_;
   std::unique_ptr<wikiopencite::citescoop::cli::io::PbfFile> input_;
+  std::vector<fields::FieldPath> cardinality_paths_;
+  std::vector<HyperLogLog> sketches_;
+  Log2Histogram sizes_;
+  std::optional<FieldSizes> field_sizes_;
 };
 
 }  // namespace wikiopencite::citescoop::cli::pbf
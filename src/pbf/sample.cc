@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/io.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "header.h"
+#include "io.h"
+#include "offset_index.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace cs = wikiopencite::citescoop;
+namespace fs = std::filesystem;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+}  // namespace
+
+Sample::Sample()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("sample", "Draw a random sample of the messages of a PBF file") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::string>()->required(), "Input file.")
+    ("output,o", options::value<std::string>()->required(), "Output file.")
+    ("n,n", options::value<uint64_t>(),
+      "Number of messages to sample, or per stratum with --by.")
+    ("fraction", options::value<double>(),
+      "Share of messages to sample, between 0 and 1.")
+    ("seed", options::value<uint64_t>(),
+      "Random seed. Defaults to a random one.")
+    ("by", options::value<std::string>(),
+      "Field path to stratify by. Every distinct value is sampled"
+      " separately.")
+    ("compress", "Write the payload as zstd compressed blocks.");
+  // clang-format on
+
+  positional_options_.add("input", 1);
+  positional_options_.add("output", 1);
+}
+
+ExitCode Sample::Run(std::vector<std::string> args,
+                     // NOLINTNEXTLINE(whitespace/indent_namespace)
+                     struct GlobalOptions) {
+  LoadArgs(args);
+  random_.seed(args_.seed);
+
+  try {
+    input_ = io::OpenPbfFile(args_.input);
+    header_ = io::ReadPbfHeader(input_.get());
+
+    by_path_ = std::nullopt;
+    if (args_.by) {
+      by_path_ = fields::FieldPath::Parse(
+          io::DescriptorForFileType(header_->type()), *args_.by);
+    }
+
+    std::optional<OffsetIndex> index;
+    if (!args_.by)
+      index = OffsetIndex::Load(args_.input);
+    if (index && index->count() != header_->count()) {
+      spdlog::warn("Ignoring offset index as its message count differs");
+      index = std::nullopt;
+    }
+
+    if (index) {
+      SampleIndexed(*index);
+    } else if (args_.size) {
+      SampleReservoir();
+    } else {
+      SampleFraction();
+    }
+
+    io::ClosePbfFile(std::move(input_));
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to sample input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    std::error_code err;
+    fs::remove(args_.output + ".tmp", err);
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Sample::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.compress = parsed_args.first.contains("compress");
+
+  args_.size = std::nullopt;
+  if (parsed_args.first.contains("n"))
+    args_.size = parsed_args.first["n"].as<uint64_t>();
+
+  args_.fraction = std::nullopt;
+  if (parsed_args.first.contains("fraction"))
+    args_.fraction = parsed_args.first["fraction"].as<double>();
+
+  if (args_.size.has_value() == args_.fraction.has_value())
+    throw exceptions::UserInputException(
+        "exactly one of --n and --fraction is required");
+  if (args_.fraction && (*args_.fraction < 0 || *args_.fraction > 1))
+    throw exceptions::UserInputException("fraction must be between 0 and 1");
+
+  args_.seed = std::random_device()();
+  if (parsed_args.first.contains("seed"))
+    args_.seed = parsed_args.first["seed"].as<uint64_t>();
+
+  args_.by = std::nullopt;
+  if (parsed_args.first.contains("by")) {
+    args_.by = parsed_args.first["by"].as<std::string>();
+    if (args_.fraction)
+      spdlog::warn("--by has no effect when sampling a fraction");
+  }
+
+  spdlog::debug("Sample arguments: input={} output={} seed={}", args_.input,
+                args_.output, args_.seed);
+}
+
+void Sample::SampleReservoir() {
+  std::map<std::string, Reservoir> strata;
+  for (uint64_t i = 0; i < header_->count(); ++i) {
+    auto message = io::ReadGenericMessage(input_.get(), header_->type());
+    const std::string kStratum =
+        by_path_ ? fields::ToString(by_path_->First(*message)) : std::string();
+    Offer(&strata[kStratum], i, std::move(message));
+  }
+
+  Sampled sampled;
+  for (auto& [stratum, reservoir] : strata) {
+    for (auto& item : reservoir.items) {
+      sampled.push_back(std::move(item));
+    }
+  }
+  std::sort(sampled.begin(), sampled.end(),
+            [](const auto& lhs, const auto& rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  io::PbfWriter output(args_.output, OutputHeader(sampled.size()));
+  for (const auto& [ordinal, message] : sampled) {
+    output.Write(*message);
+  }
+  output.Close();
+
+  spdlog::info("Sampled {} of {} messages from {} strata", sampled.size(),
+               header_->count(), strata.size());
+}
+
+void Sample::Offer(Reservoir* reservoir, uint64_t ordinal,
+                   // NOLINTNEXTLINE(whitespace/indent_namespace)
+                   std::unique_ptr<pb::Message> message) {
+  const uint64_t kSize = *args_.size;
+  const uint64_t kSeen = reservoir->seen++;
+  if (kSize == 0)
+    return;
+
+  std::uniform_real_distribution<double> real(0.0, 1.0);
+  auto advance = [&]() {
+    reservoir->weight *=
+        std::exp(std::log(1.0 - real(random_)) / static_cast<double>(kSize));
+    reservoir->next =
+        kSeen + 1 +
+        static_cast<uint64_t>(std::floor(std::log(1.0 - real(random_)) /
+                                         std::log1p(-reservoir->weight)));
+  };
+
+  if (reservoir->items.size() < kSize) {
+    reservoir->items.emplace_back(ordinal, std::move(message));
+    if (reservoir->items.size() == kSize) {
+      reservoir->weight = 1.0;
+      advance();
+    }
+    return;
+  }
+
+  if (kSeen < reservoir->next)
+    return;
+
+  std::uniform_int_distribution<uint64_t> slot(0, kSize - 1);
+  reservoir->items[slot(random_)] = {ordinal, std::move(message)};
+  advance();
+}
+
+void Sample::SampleFraction() {
+  const auto kTempPath = args_.output + ".tmp";
+  std::ofstream temp(kTempPath,
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+  auto writer = cs::MessageWriter(&temp);
+
+  uint64_t count = 0;
+  uint64_t next = NextGap();
+  for (uint64_t i = 0; i < header_->count(); ++i) {
+    auto message = io::ReadGenericMessage(input_.get(), header_->type());
+    if (i != next)
+      continue;
+
+    writer.WriteMessage(*message);
+    count++;
+    next = i + 1 + NextGap();
+  }
+  temp.close();
+
+  std::ifstream payload(kTempPath, std::ios::in | std::ios::binary);
+  std::ofstream output(args_.output,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  io::PrependHeader(OutputHeader(count), payload, &output);
+  payload.close();
+  output.close();
+  fs::remove(kTempPath);
+
+  spdlog::info("Sampled {} of {} messages", count, header_->count());
+}
+
+void Sample::SampleIndexed(const OffsetIndex& index) {
+  const uint64_t kCount = header_->count();
+
+  std::vector<uint64_t> ordinals;
+  if (args_.size) {
+    // Floyd's algorithm draws k distinct ordinals with k random numbers.
+    const uint64_t kSize = std::min(*args_.size, kCount);
+    std::unordered_set<uint64_t> chosen;
+    for (uint64_t j = kCount - kSize; j < kCount; ++j) {
+      std::uniform_int_distribution<uint64_t> pick(0, j);
+      const uint64_t kPick = pick(random_);
+      chosen.insert(chosen.contains(kPick) ? j : kPick);
+    }
+    ordinals.assign(chosen.begin(), chosen.end());
+    std::sort(ordinals.begin(), ordinals.end());
+  } else {
+    for (uint64_t i = NextGap(); i < kCount; i += 1 + NextGap()) {
+      ordinals.push_back(i);
+    }
+  }
+
+  io::PbfWriter output(args_.output, OutputHeader(ordinals.size()));
+  uint64_t position = 0;
+  uint64_t seeks = 0;
+  for (const uint64_t kOrdinal : ordinals) {
+    if (kOrdinal - position >= index.stride()) {
+      const auto [kIndexed, kOffset] = index.Locate(kOrdinal);
+      io::SeekPayload(input_.get(), kOffset);
+      position = kIndexed;
+      seeks++;
+    }
+
+    for (; position < kOrdinal; ++position) {
+      io::ReadGenericMessage(input_.get(), header_->type());
+    }
+    output.Write(*io::ReadGenericMessage(input_.get(), header_->type()));
+    position++;
+  }
+  output.Close();
+
+  spdlog::info("Sampled {} of {} messages using {} seeks", ordinals.size(),
+               kCount, seeks);
+}
+
+uint64_t Sample::NextGap() {
+  const double kFraction = *args_.fraction;
+  if (kFraction >= 1)
+    return 0;
+  if (kFraction <= 0)
+    return header_->count();
+
+  std::uniform_real_distribution<double> real(0.0, 1.0);
+  return static_cast<uint64_t>(
+      std::floor(std::log(1.0 - real(random_)) / std::log1p(-kFraction)));
+}
+
+proto::FileHeader Sample::OutputHeader(uint64_t count) const {
+  auto header = *header_;
+  header.set_count(count);
+  header::ClearLayout(&header);
+  if (args_.compress)
+    container::MarkCompressed(&header);
+  return header;
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_SAMPLE_H_
+#define SRC_PBF_SAMPLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "fields.h"
+#include "io.h"
+#include "offset_index.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to draw a uniform random sample of the messages of a
+/// PBF file, optionally stratified by a field.
+///
+/// A fixed size sample is drawn by reservoir sampling in one pass, a
+/// fraction by skipping a geometrically distributed number of messages
+/// between picks. When the file has an offset index (see pbf index) and
+/// no stratification is requested, the ordinals are chosen up front and
+/// only the chosen messages are read. Messages keep their input order.
+class Sample : public Command {
+ public:
+  Sample();
+
+  /// @brief Execute the sample command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;                ///< Input file path.
+    std::string output;               ///< Output file path.
+    std::optional<uint64_t> size;     ///< Messages to sample.
+    std::optional<double> fraction;   ///< Share of messages to sample.
+    uint64_t seed;                    ///< Random seed.
+    std::optional<std::string> by;    ///< Field to stratify by.
+    bool compress;                    ///< Block compress the output.
+  };
+
+  using Sampled = std::vector<
+      std::pair<uint64_t, std::unique_ptr<google::protobuf::Message>>>;
+
+  /// @brief Reservoir for Algorithm L, which draws the gap to the next
+  /// replacement instead of a random number per message.
+  struct Reservoir {
+    Sampled items;
+    double weight = 0;
+    uint64_t seen = 0;  ///< Messages offered so far.
+    uint64_t next = 0;  ///< Offer that replaces an item next.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Sample a fixed number of messages per stratum in one pass.
+  void SampleReservoir();
+
+  /// @brief Stream a fraction of the messages to the output.
+  void SampleFraction();
+
+  /// @brief Read only the chosen ordinals, seeking through the index.
+  void SampleIndexed(const OffsetIndex& index);
+
+  /// @brief Offer the message at ordinal to a reservoir.
+  void Offer(Reservoir* reservoir, uint64_t ordinal,
+             std::unique_ptr<google::protobuf::Message> message);
+
+  /// @brief Messages to skip before the next pick when sampling a
+  /// fraction.
+  uint64_t NextGap();
+
+  /// @brief Header for an output holding count messages.
+  [[nodiscard]] wikiopencite::proto::FileHeader OutputHeader(
+      uint64_t count) const;
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+  std::optional<fields::FieldPath> by_path_;
+  std::mt19937_64 random_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_SAMPLE_H_
@@ -0,0 +1,414 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "serve.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "fmt/format.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/json_util.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "doi.h"
+#include "exceptions.h"
+#include "json.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace fs = std::filesystem;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+constexpr uint16_t kDefaultPort = 8080;
+constexpr const char* kDefaultHost = "127.0.0.1";
+constexpr uint64_t kDefaultMaxRange = 1000;
+
+/// Set by SIGINT and SIGTERM to shut the server down.
+std::atomic<bool> stop_requested = false;
+
+void RequestStop(int) { stop_requested.store(true); }
+
+std::optional<uint64_t> ParseUint(const std::string& text) {
+  uint64_t value = 0;
+  const auto kResult =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (kResult.ec != std::errc() || kResult.ptr != text.data() + text.size())
+    return std::nullopt;
+  return value;
+}
+
+const std::string* QueryValue(const http::Request& request,
+                              const std::string& name) {
+  const auto kFound = request.query.find(name);
+  return kFound == request.query.end() ? nullptr : &kFound->second;
+}
+
+void WriteMessage(json::Writer* writer, const pb::Message& message) {
+  std::string record;
+  const auto kStatus = pb::util::MessageToJsonString(message, &record);
+  if (!kStatus.ok()) {
+    throw exceptions::CliException(
+        fmt::format("failed to convert message to JSON: {}",
+                    std::string(kStatus.message())));
+  }
+  writer->Raw(record);
+}
+}  // namespace
+
+Serve::Serve()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("serve", "Answer lookups over indexed PBF files over HTTP") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::vector<std::string>>()->required(),
+      "Input files.")
+    ("key,k", options::value<std::vector<std::string>>(),
+      "Field path whose key index, built by pbf index --key, serves"
+      " /get. May be given more than once.")
+    ("doi-table", options::value<std::string>(),
+      "DOI table built by pbf doi-table, serving /doi.")
+    ("host", options::value<std::string>()->default_value(kDefaultHost),
+      "IPv4 address to listen on.")
+    ("port,p", options::value<uint16_t>()->default_value(kDefaultPort),
+      "Port to listen on.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads answering requests.")
+    ("max-range", options::value<uint64_t>()->default_value(
+        kDefaultMaxRange),
+      "Most messages returned by one /range request.");
+  positional_options_.add("input", -1);
+  // clang-format on
+}
+
+ExitCode Serve::Run(std::vector<std::string> args,
+                    // NOLINTNEXTLINE(whitespace/indent_namespace)
+                    struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    for (const auto& input : args_.inputs) {
+      AddFile(input);
+    }
+    if (args_.doi_table) {
+      doi_table_ = std::make_unique<DoiTable>(*args_.doi_table);
+      spdlog::info("Mapped {} DOIs from {}", doi_table_->size(),
+                   *args_.doi_table);
+    }
+
+    http::Server server(args_.host, args_.port,
+                        [this](const http::Request& request) {
+                          return Handle(request);
+                        });
+    spdlog::info("Serving {} files on http://{}:{}", files_.size(),
+                 args_.host, server.port());
+
+    stop_requested.store(false);
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+    server.Run(args_.threads, stop_requested);
+    spdlog::info("Stopped serving");
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to serve input files: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Serve::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.inputs =
+      EnsureArgument<std::vector<std::string>>("input", parsed_args.first);
+  args_.host = EnsureArgument<std::string>("host", parsed_args.first);
+  args_.port = EnsureArgument<uint16_t>("port", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.max_range = EnsureArgument<uint64_t>("max-range", parsed_args.first);
+
+  args_.keys.clear();
+  if (parsed_args.first.contains("key"))
+    args_.keys = parsed_args.first["key"].as<std::vector<std::string>>();
+
+  args_.doi_table = std::nullopt;
+  if (parsed_args.first.contains("doi-table"))
+    args_.doi_table = parsed_args.first["doi-table"].as<std::string>();
+
+  spdlog::trace("Serve command arguments: Inputs: {} Port: {} Threads: {}",
+                args_.inputs.size(), args_.port, args_.threads);
+}
+
+void Serve::AddFile(const std::string& path) {
+  auto file = std::make_unique<ServedFile>();
+  file->path = path;
+  file->name = fs::path(path).filename().string();
+  if (FindFile(file->name) != nullptr) {
+    throw exceptions::UserInputException(
+        fmt::format("two inputs are named {}", file->name).c_str());
+  }
+
+  auto handle = io::OpenPbfFile(path);
+  const auto kHeader = io::ReadPbfHeader(handle.get());
+  file->type = kHeader->type();
+  file->count = kHeader->count();
+  file->idle.push_back(std::move(handle));
+  file->max_idle = std::max<size_t>(args_.threads, 1);
+
+  for (const auto& key : args_.keys) {
+    auto index = KeyIndex::Load(path, key);
+    if (index) {
+      file->keys.emplace(key, std::move(*index));
+    } else {
+      spdlog::warn("{} has no key index over {}, build one with pbf index"
+                   " --key",
+                   path, key);
+    }
+  }
+
+  file->offsets = OffsetIndex::Load(path);
+  if (!file->offsets)
+    spdlog::warn("{} has no offset index, /range is disabled for it", path);
+
+  files_.push_back(std::move(file));
+}
+
+http::Response Serve::Handle(const http::Request& request) const {
+  const auto kStart = std::chrono::steady_clock::now();
+
+  http::Response response;
+  if (request.path == "/files") {
+    response = ListFiles();
+  } else if (request.path == "/get") {
+    response = Lookup(request);
+  } else if (request.path == "/range") {
+    response = ReadRange(request);
+  } else if (request.path == "/doi") {
+    response = ResolveDoi(request);
+  } else {
+    response = http::Error(404, "unknown endpoint");
+  }
+
+  spdlog::debug("{} {} {} in {}us", request.method, request.path,
+                response.status,
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - kStart)
+                    .count());
+  return response;
+}
+
+http::Response Serve::ListFiles() const {
+  std::ostringstream body;
+  json::Writer writer(&body);
+  writer.BeginObject();
+  writer.Key("files");
+  writer.BeginArray();
+  for (const auto& file : files_) {
+    writer.BeginObject();
+    writer.Key("name");
+    writer.String(file->name);
+    writer.Key("type");
+    writer.String(proto::FileType_Name(file->type));
+    writer.Key("count");
+    writer.Uint(file->count);
+    writer.Key("keys");
+    writer.BeginArray();
+    for (const auto& [key, index] : file->keys) {
+      writer.String(key);
+    }
+    writer.EndArray();
+    writer.Key("range");
+    writer.Bool(file->offsets.has_value());
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return {200, body.str()};
+}
+
+http::Response Serve::Lookup(const http::Request& request) const {
+  const auto* key = QueryValue(request, "key");
+  const auto* value = QueryValue(request, "value");
+  const auto* name = QueryValue(request, "file");
+  if (key == nullptr || value == nullptr)
+    return http::Error(400, "key and value are required");
+  if (name != nullptr && FindFile(*name) == nullptr)
+    return http::Error(404, "no such file");
+
+  std::ostringstream body;
+  json::Writer writer(&body);
+  writer.BeginObject();
+  writer.Key("key");
+  writer.String(*key);
+  writer.Key("value");
+  writer.String(*value);
+  writer.Key("messages");
+  writer.BeginArray();
+
+  bool indexed = false;
+  for (const auto& file : files_) {
+    if (name != nullptr && file->name != *name)
+      continue;
+    const auto kIndex = file->keys.find(*key);
+    if (kIndex == file->keys.end())
+      continue;
+
+    indexed = true;
+    const auto kPositions = kIndex->second.Lookup(*value);
+    if (kPositions.empty())
+      continue;
+
+    auto handle = Acquire(file.get());
+    for (const uint64_t kPosition : kPositions) {
+      io::SeekPayload(handle.get(), kPosition);
+      writer.BeginObject();
+      writer.Key("file");
+      writer.String(file->name);
+      writer.Key("message");
+      WriteMessage(&writer, *io::ReadGenericMessage(handle.get(), file->type));
+      writer.EndObject();
+    }
+    Release(file.get(), std::move(handle));
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  if (!indexed)
+    return http::Error(400, fmt::format("no key index over {}", *key));
+  return {200, body.str()};
+}
+
+http::Response Serve::ReadRange(const http::Request& request) const {
+  const auto* name = QueryValue(request, "file");
+  const auto* start_text = QueryValue(request, "start");
+  if (name == nullptr || start_text == nullptr)
+    return http::Error(400, "file and start are required");
+
+  auto* file = FindFile(*name);
+  if (file == nullptr)
+    return http::Error(404, "no such file");
+  if (!file->offsets)
+    return http::Error(400, "file has no offset index");
+
+  const auto kStart = ParseUint(*start_text);
+  const auto* count_text = QueryValue(request, "count");
+  const auto kCount = count_text == nullptr ? std::optional<uint64_t>(1)
+                                            : ParseUint(*count_text);
+  if (!kStart || !kCount)
+    return http::Error(400, "start and count must be numbers");
+  if (*kCount > args_.max_range) {
+    return http::Error(
+        400, fmt::format("count is limited to {}", args_.max_range));
+  }
+
+  const uint64_t kEnd = std::min(file->count, *kStart + *kCount);
+  std::ostringstream body;
+  json::Writer writer(&body);
+  writer.BeginObject();
+  writer.Key("file");
+  writer.String(file->name);
+  writer.Key("start");
+  writer.Uint(*kStart);
+  writer.Key("messages");
+  writer.BeginArray();
+  if (*kStart < kEnd) {
+    auto handle = Acquire(file);
+    auto [position, offset] = file->offsets->Locate(*kStart);
+    io::SeekPayload(handle.get(), offset);
+    for (; position < *kStart; ++position) {
+      io::ReadGenericMessage(handle.get(), file->type);
+    }
+    for (; position < kEnd; ++position) {
+      WriteMessage(&writer, *io::ReadGenericMessage(handle.get(), file->type));
+    }
+    Release(file, std::move(handle));
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return {200, body.str()};
+}
+
+http::Response Serve::ResolveDoi(const http::Request& request) const {
+  if (!doi_table_)
+    return http::Error(400, "no DOI table is loaded");
+  const auto* text = QueryValue(request, "doi");
+  if (text == nullptr)
+    return http::Error(400, "doi is required");
+
+  const auto kDoi = doi::Normalize(*text);
+  if (!kDoi)
+    return http::Error(400, "not a DOI");
+  const auto kSlot = doi_table_->Find(*kDoi);
+  if (!kSlot)
+    return http::Error(404, "DOI not found");
+
+  std::ostringstream body;
+  json::Writer writer(&body);
+  writer.BeginObject();
+  writer.Key("doi");
+  writer.String(*kDoi);
+  writer.Key("work");
+  writer.Uint(doi_table_->Work(*kSlot));
+  writer.Key("openalex_id");
+  writer.String(doi_table_->OpenAlexId(*kSlot));
+  writer.EndObject();
+  return {200, body.str()};
+}
+
+Serve::ServedFile* Serve::FindFile(const std::string& name) const {
+  for (const auto& file : files_) {
+    if (file->name == name)
+      return file.get();
+  }
+  return nullptr;
+}
+
+std::unique_ptr<io::PbfFile> Serve::Acquire(ServedFile* file) {
+  {
+    const std::lock_guard<std::mutex> kLock(file->mutex);
+    if (!file->idle.empty()) {
+      auto handle = std::move(file->idle.back());
+      file->idle.pop_back();
+      return handle;
+    }
+  }
+
+  auto handle = io::OpenPbfFile(file->path);
+  io::ReadPbfHeader(handle.get());
+  return handle;
+}
+
+void Serve::Release(ServedFile* file, std::unique_ptr<io::PbfFile> handle) {
+  const std::lock_guard<std::mutex> kLock(file->mutex);
+  if (file->idle.size() < file->max_idle)
+    file->idle.push_back(std::move(handle));
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
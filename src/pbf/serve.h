@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_SERVE_H_
+#define SRC_PBF_SERVE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+
+#include "cli.h"
+#include "doi_table.h"
+#include "http.h"
+#include "io.h"
+#include "key_index.h"
+#include "offset_index.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to answer lookups over indexed PBF files as JSON
+/// over HTTP, so that tools query a long running process instead of
+/// starting one and scanning a file per lookup.
+///
+/// Endpoints, all GET:
+///
+///     /files                           files, types, counts, indexes
+///     /get?key=K&value=V[&file=F]      messages whose K is V, through
+///                                      the key indexes of pbf index
+///     /range?file=F&start=S[&count=N]  messages S to S+N-1, through
+///                                      the offset index of pbf index
+///     /doi?doi=D                       OpenAlex work of a DOI, with
+///                                      --doi-table
+///
+/// Indexes are loaded once at startup and shared by every worker. Each
+/// file keeps a pool of open handles, so a lookup costs an index probe
+/// and a seek rather than opening the file.
+class Serve : public Command {
+ public:
+  Serve();
+
+  /// @brief Execute the serve command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::vector<std::string> inputs;       ///< Input file paths.
+    std::vector<std::string> keys;         ///< Key index fields.
+    std::optional<std::string> doi_table;  ///< DOI table path.
+    std::string host;                      ///< Address to listen on.
+    uint16_t port;                         ///< Port to listen on.
+    unsigned threads;                      ///< Worker threads.
+    uint64_t max_range;                    ///< Most messages per range.
+  };
+
+  /// @brief A served file with its indexes and idle handles.
+  struct ServedFile {
+    std::string path;
+    std::string name;  ///< File name used in requests.
+    wikiopencite::proto::FileType type;
+    uint64_t count;
+    std::map<std::string, KeyIndex> keys;
+    std::optional<OffsetIndex> offsets;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<io::PbfFile>> idle;
+    size_t max_idle = 1;  ///< Most idle handles kept open.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Open a file and load its indexes.
+  void AddFile(const std::string& path);
+
+  [[nodiscard]] http::Response Handle(const http::Request& request) const;
+  [[nodiscard]] http::Response ListFiles() const;
+  [[nodiscard]] http::Response Lookup(const http::Request& request) const;
+  [[nodiscard]] http::Response ReadRange(const http::Request& request) const;
+  [[nodiscard]] http::Response ResolveDoi(const http::Request& request) const;
+
+  /// @brief The served file with a name, or nullptr.
+  [[nodiscard]] ServedFile* FindFile(const std::string& name) const;
+
+  /// @brief Take an open handle to a file, opening one if none is idle.
+  static std::unique_ptr<io::PbfFile> Acquire(ServedFile* file);
+
+  /// @brief Return a handle for reuse, or close it if enough are idle.
+  static void Release(ServedFile* file, std::unique_ptr<io::PbfFile> handle);
+
+  Args args_;
+  std::vector<std::unique_ptr<ServedFile>> files_;
+  std::unique_ptr<DoiTable> doi_table_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_SERVE_H_
@@ -0,0 +1,365 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sort.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/io.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "header.h"
+#include "io.h"
+#include "loser_tree.h"
+#include "spill.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace cs = wikiopencite::citescoop;
+namespace fs = std::filesystem;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+constexpr size_t kDefaultMemoryLimit = 1024;
+constexpr size_t kBytesPerMebibyte = size_t{1} << 20U;
+
+/// Most runs merged at once, keeping the number of open files bounded.
+constexpr size_t kMaxFanIn = 64;
+
+/// Bookkeeping per buffered record beyond the message itself.
+constexpr size_t kRecordOverhead = sizeof(void*) * 8;
+
+/// @brief Cursor over the messages of a run file.
+struct RunReader {
+  std::unique_ptr<io::PbfFile> file;
+  uint64_t remaining = 0;
+  std::unique_ptr<pb::Message> message;
+  std::vector<fields::Value> key;
+};
+}  // namespace
+
+Sort::Sort()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("sort", "Sort the messages of a PBF file by one or more fields") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input,i", options::value<std::string>()->required(), "Input file.")
+    ("output,o", options::value<std::string>()->required(), "Output file.")
+    ("key,k", options::value<std::string>()->required(),
+      "Comma separated field paths to sort by, for example"
+      " page_id,timestamp. Repeated fields sort by their first value.")
+    ("memory-limit", options::value<size_t>()->default_value(
+        kDefaultMemoryLimit),
+      "Memory budget for buffered messages in MiB.")
+    ("tmp-dir", options::value<std::string>(),
+      "Directory for run files. Defaults to the system temporary"
+      " directory.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of sorting threads.")
+    ("compress", "Write the payload as zstd compressed blocks.");
+  // clang-format on
+
+  positional_options_.add("input", 1);
+  positional_options_.add("output", 1);
+}
+
+ExitCode Sort::Run(std::vector<std::string> args,
+                   // NOLINTNEXTLINE(whitespace/indent_namespace)
+                   struct GlobalOptions) {
+  LoadArgs(args);
+
+  // Declared first so it is removed last, whatever ends the command.
+  const spill::Directory kRunDir(args_.tmp_dir, "citescoop-sort");
+  run_dir_ = kRunDir.path();
+  next_run_ = 0;
+
+  try {
+    input_ = io::OpenPbfFile(args_.input);
+    header_ = io::ReadPbfHeader(input_.get());
+    key_paths_ = fields::ParseFieldPaths(
+        io::DescriptorForFileType(header_->type()), args_.key);
+
+    auto runs = GenerateRuns();
+    io::ClosePbfFile(std::move(input_));
+
+    uint64_t count = 0;
+    for (const auto& run : runs) {
+      count += run.count;
+    }
+
+    runs = ReduceRuns(std::move(runs));
+    WriteOutput(runs, count);
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to sort input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Sort::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.output = EnsureArgument<std::string>("output", parsed_args.first);
+  args_.key = EnsureArgument<std::string>("key", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.memory_limit =
+      EnsureArgument<size_t>("memory-limit", parsed_args.first) *
+      kBytesPerMebibyte;
+  args_.compress = parsed_args.first.contains("compress");
+
+  args_.tmp_dir = fs::temp_directory_path();
+  if (parsed_args.first.contains("tmp-dir"))
+    args_.tmp_dir = parsed_args.first["tmp-dir"].as<std::string>();
+
+  spdlog::debug("Sort arguments: input={} output={} key={} memory_limit={}",
+                args_.input, args_.output, args_.key, args_.memory_limit);
+}
+
+std::vector<Sort::SortedRun> Sort::GenerateRuns() {
+  std::vector<SortedRun> runs;
+  std::vector<Record> records;
+  size_t memory = 0;
+
+  for (uint64_t i = 0; i < header_->count(); ++i) {
+    auto message = io::ReadGenericMessage(input_.get(), header_->type());
+    auto key = KeyOf(*message);
+    memory += message->SpaceUsedLong() + kRecordOverhead;
+    for (const auto& value : key) {
+      if (const auto* text = std::get_if<std::string>(&value))
+        memory += text->capacity();
+    }
+    records.push_back({std::move(key), std::move(message)});
+
+    if (memory >= args_.memory_limit) {
+      runs.push_back(WriteRun(&records));
+      records.clear();
+      memory = 0;
+    }
+  }
+
+  if (!records.empty() || runs.empty())
+    runs.push_back(WriteRun(&records));
+
+  spdlog::debug("Generated {} sorted runs", runs.size());
+  return runs;
+}
+
+Sort::SortedRun Sort::WriteRun(std::vector<Record>* records) {
+  auto by_key = [](const Record& lhs, const Record& rhs) {
+    return KeyLess(lhs.key, rhs.key);
+  };
+
+  // Sort one slice per thread, then merge the slices while writing.
+  const size_t kSlices = std::clamp<size_t>(
+      args_.threads, 1, std::max<size_t>(records->size(), 1));
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= kSlices; ++i) {
+    bounds.push_back(records->size() * i / kSlices);
+  }
+
+  {
+    ThreadPool pool(static_cast<unsigned>(kSlices));
+    std::vector<std::future<void>> sorted;
+    for (size_t i = 0; i < kSlices; ++i) {
+      sorted.push_back(pool.Submit([records, &bounds, &by_key, i]() {
+        std::stable_sort(
+            records->begin() + static_cast<std::ptrdiff_t>(bounds[i]),
+            records->begin() + static_cast<std::ptrdiff_t>(bounds[i + 1]),
+            by_key);
+      }));
+    }
+    for (auto& future : sorted) {
+      future.get();
+    }
+  }
+
+  SortedRun run{NextRunPath(), records->size()};
+  std::ofstream output(run.path,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+  auto writer = cs::MessageWriter(&output);
+
+  std::vector<size_t> cursors(bounds.begin(), bounds.end() - 1);
+  auto less = [&](size_t lhs, size_t rhs) {
+    if (cursors[lhs] == bounds[lhs + 1])
+      return false;
+    if (cursors[rhs] == bounds[rhs + 1])
+      return true;
+    const auto& kLhs = (*records)[cursors[lhs]].key;
+    const auto& kRhs = (*records)[cursors[rhs]].key;
+    if (KeyLess(kLhs, kRhs))
+      return true;
+    return !KeyLess(kRhs, kLhs) && lhs < rhs;
+  };
+
+  LoserTree<decltype(less)> tree(kSlices, less);
+  for (size_t i = 0; i < records->size(); ++i) {
+    const size_t kSlice = tree.Winner();
+    writer.WriteMessage(*(*records)[cursors[kSlice]].message);
+    cursors[kSlice]++;
+    tree.Replay();
+  }
+
+  output.close();
+  if (!output)
+    throw exceptions::CliException("failed to write run file");
+  return run;
+}
+
+std::vector<Sort::SortedRun> Sort::ReduceRuns(std::vector<SortedRun> runs) {
+  while (runs.size() > kMaxFanIn) {
+    spdlog::debug("Merging {} runs in groups of {}", runs.size(), kMaxFanIn);
+
+    // Merge consecutive groups so runs stay in input order and the sort
+    // stays stable.
+    std::vector<SortedRun> merged;
+    for (size_t first = 0; first < runs.size(); first += kMaxFanIn) {
+      const std::vector<SortedRun> kGroup(
+          runs.begin() + static_cast<std::ptrdiff_t>(first),
+          runs.begin() + static_cast<std::ptrdiff_t>(
+                             std::min(first + kMaxFanIn, runs.size())));
+
+      SortedRun run{NextRunPath(), 0};
+      std::ofstream output(run.path,
+                           std::ios::out | std::ios::binary | std::ios::trunc);
+      auto writer = cs::MessageWriter(&output);
+      MergeRuns(kGroup, [&](const pb::Message& message) {
+        writer.WriteMessage(message);
+        run.count++;
+      });
+      output.close();
+      if (!output)
+        throw exceptions::CliException("failed to write run file");
+
+      for (const auto& source : kGroup) {
+        fs::remove(source.path);
+      }
+      merged.push_back(run);
+    }
+    runs = std::move(merged);
+  }
+  return runs;
+}
+
+void Sort::MergeRuns(const std::vector<SortedRun>& runs, const Sink& sink) {
+  std::vector<RunReader> readers(runs.size());
+  auto advance = [this](RunReader* reader) {
+    if (reader->remaining == 0) {
+      reader->message.reset();
+      return;
+    }
+    reader->message =
+        io::ReadGenericMessage(reader->file.get(), header_->type());
+    reader->key = KeyOf(*reader->message);
+    reader->remaining--;
+  };
+
+  for (size_t i = 0; i < runs.size(); ++i) {
+    readers[i].file = io::OpenPbfFile(runs[i].path.string());
+    readers[i].remaining = runs[i].count;
+    advance(&readers[i]);
+  }
+
+  auto less = [&readers](size_t lhs, size_t rhs) {
+    if (!readers[lhs].message)
+      return false;
+    if (!readers[rhs].message)
+      return true;
+    if (KeyLess(readers[lhs].key, readers[rhs].key))
+      return true;
+    return !KeyLess(readers[rhs].key, readers[lhs].key) && lhs < rhs;
+  };
+
+  LoserTree<decltype(less)> tree(readers.size(), less);
+  while (!readers.empty() && readers[tree.Winner()].message) {
+    auto& reader = readers[tree.Winner()];
+    sink(*reader.message);
+    advance(&reader);
+    tree.Replay();
+  }
+
+  for (auto& reader : readers) {
+    io::ClosePbfFile(std::move(reader.file));
+  }
+}
+
+void Sort::WriteOutput(const std::vector<SortedRun>& runs, uint64_t count) {
+  auto header = *header_;
+  header.set_count(count);
+  header::ClearLayout(&header);
+  if (args_.compress)
+    container::MarkCompressed(&header);
+
+  std::vector<std::string> paths;
+  for (const auto& path : key_paths_) {
+    paths.push_back(path.path());
+  }
+  header::SetBytes(&header, header::kSortKeyField,
+                   fmt::format("{}", fmt::join(paths, ",")));
+
+  io::PbfWriter output(args_.output, header, args_.threads);
+  MergeRuns(runs, [&output](const pb::Message& message) {
+    output.Write(message);
+  });
+  output.Close();
+
+  spdlog::info("Sorted {} messages from {} runs", count, runs.size());
+}
+
+std::vector<fields::Value> Sort::KeyOf(const pb::Message& message) const {
+  std::vector<fields::Value> key;
+  key.reserve(key_paths_.size());
+  for (const auto& path : key_paths_) {
+    key.push_back(path.First(message));
+  }
+  return key;
+}
+
+bool Sort::KeyLess(const std::vector<fields::Value>& lhs,
+                   // NOLINTNEXTLINE(whitespace/indent_namespace)
+                   const std::vector<fields::Value>& rhs) {
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    const int kOrder = fields::Compare(lhs[i], rhs[i]);
+    if (kOrder != 0)
+      return kOrder < 0;
+  }
+  return false;
+}
+
+fs::path Sort::NextRunPath() {
+  return run_dir_ / fmt::format("{}.run", next_run_++);
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
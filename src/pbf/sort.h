@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_SORT_H_
+#define SRC_PBF_SORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "fields.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to sort the messages of a PBF file by one or more
+/// fields, using external memory for files larger than RAM.
+///
+/// Messages are read into runs that fit the memory budget. Each run is
+/// cut into one slice per thread, the slices are sorted in parallel and
+/// merged into a run file. The run files are then merged with a loser
+/// tree, in several passes if there are more than the merge fan in. The
+/// sort is stable and the key is recorded in the output header.
+class Sort : public Command {
+ public:
+  Sort();
+
+  /// @brief Execute the sort command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;              ///< Input file path.
+    std::string output;             ///< Output file path.
+    std::string key;                ///< Comma separated key field paths.
+    size_t memory_limit;            ///< Memory budget in bytes.
+    std::filesystem::path tmp_dir;  ///< Directory for run files.
+    unsigned threads;               ///< Number of sorting threads.
+    bool compress;                  ///< Block compress the output.
+  };
+
+  struct Record {
+    std::vector<fields::Value> key;
+    std::unique_ptr<google::protobuf::Message> message;
+  };
+
+  /// @brief A sorted run stored on disk as framed messages.
+  struct SortedRun {
+    std::filesystem::path path;
+    uint64_t count;
+  };
+
+  using Sink = std::function<void(const google::protobuf::Message&)>;
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Read the input into sorted runs.
+  /// @return The runs in input order.
+  std::vector<SortedRun> GenerateRuns();
+
+  /// @brief Sort records in memory and write them as a run.
+  SortedRun WriteRun(std::vector<Record>* records);
+
+  /// @brief Merge runs until at most the merge fan in remain.
+  std::vector<SortedRun> ReduceRuns(std::vector<SortedRun> runs);
+
+  /// @brief Merge runs in order, handing each message to sink.
+  void MergeRuns(const std::vector<SortedRun>& runs, const Sink& sink);
+
+  /// @brief Write the merged runs to the output file.
+  void WriteOutput(const std::vector<SortedRun>& runs, uint64_t count);
+
+  [[nodiscard]] std::vector<fields::Value> KeyOf(
+      const google::protobuf::Message& message) const;
+
+  [[nodiscard]] static bool KeyLess(const std::vector<fields::Value>& lhs,
+                                    const std::vector<fields::Value>& rhs);
+
+  [[nodiscard]] std::filesystem::path NextRunPath();
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+  std::vector<fields::FieldPath> key_paths_;
+  std::filesystem::path run_dir_;  ///< Held by a spill::Directory in Run.
+  size_t next_run_ = 0;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_SORT_H_
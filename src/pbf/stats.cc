@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "stats.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "histogram.h"
+#include "io.h"
+#include "json.h"
+#include "scan.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace proto = wikiopencite::proto;
+
+constexpr double kMedian = 0.5;
+constexpr double kP99 = 0.99;
+
+template <typename T>
+std::string FormatSummary(const T& summary) {
+  return fmt::format("min={} mean={:.2f} p50={} p99={} max={}", summary.min(),
+                     summary.mean(), summary.Quantile(kMedian),
+                     summary.Quantile(kP99), summary.max());
+}
+
+template <typename T>
+void WriteSummary(json::Writer* writer, const T& summary) {
+  writer->BeginObject();
+  writer->Key("count");
+  writer->Uint(summary.count());
+  writer->Key("sum");
+  writer->Uint(summary.sum());
+  writer->Key("min");
+  writer->Uint(summary.min());
+  writer->Key("mean");
+  writer->Double(summary.mean());
+  writer->Key("p50");
+  writer->Uint(summary.Quantile(kMedian));
+  writer->Key("p99");
+  writer->Uint(summary.Quantile(kP99));
+  writer->Key("max");
+  writer->Uint(summary.max());
+  writer->EndObject();
+}
+}  // namespace
+
+Stats::Stats()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("stats", "Compute aggregate statistics over a PBF file") {
+  // clang-format off
+  cli_options_.add_options()
+    ("file", options::value<std::string>()->required(), "Input file.")
+    ("json", "Output statistics as JSON.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  positional_options_.add("file", 1);
+  // clang-format on
+}
+
+ExitCode Stats::Run(std::vector<std::string> args,
+                    // NOLINTNEXTLINE(whitespace/indent_namespace)
+                    struct GlobalOptions) {
+  LoadArgs(args);
+
+  input_ = io::OpenPbfFile(args_.input);
+
+  Accumulator stats;
+  try {
+    header_ = io::ReadPbfHeader(input_.get());
+    ResolveFields();
+    stats = Collect();
+  } catch (const exceptions::UserInputException& e) {
+    spdlog::critical("Failed to read input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  io::ClosePbfFile(std::move(input_));
+
+  if (args_.json) {
+    PrintJson(stats);
+  } else {
+    PrintText(stats);
+  }
+
+  return ExitCode::kOk;
+}
+
+void Stats::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
+  args_.json = parsed_args.first.contains("json");
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+}
+
+void Stats::ResolveFields() {
+  const auto* descriptor = io::DescriptorForFileType(header_->type());
+  fields_.citations =
+      fields::FieldPath::Find(descriptor, fields::kCitationsField);
+  fields_.templates =
+      fields::FieldPath::Find(descriptor, fields::kTemplateField);
+  fields_.timestamp =
+      fields::FieldPath::Find(descriptor, fields::kTimestampField);
+
+  spdlog::debug("Stats fields: citations={} templates={} timestamp={}",
+                fields_.citations.has_value(), fields_.templates.has_value(),
+                fields_.timestamp.has_value());
+}
+
+Stats::Accumulator Stats::Collect() {
+  std::vector<Accumulator> accumulators(std::max(args_.threads, 1U));
+
+  scan::ParallelScan(
+      input_.get(), *header_, args_.threads,
+      [this, &accumulators](unsigned worker, uint64_t,
+                            const google::protobuf::Message& message) {
+        accumulators[worker].Add(message, fields_);
+      });
+
+  Accumulator merged;
+  for (const auto& accumulator : accumulators) {
+    merged.Merge(accumulator);
+  }
+  return merged;
+}
+
+void Stats::Accumulator::Add(const google::protobuf::Message& message,
+                             // NOLINTNEXTLINE(whitespace/indent_namespace)
+                             const Fields& paths) {
+  messages++;
+  sizes.Add(message.ByteSizeLong());
+
+  if (paths.citations)
+    citations.Add(paths.citations->Count(message));
+
+  if (paths.templates) {
+    paths.templates->Visit(message, [this](const fields::Value& value) {
+      if (const auto* name = std::get_if<std::string>(&value))
+        templates.insert(*name);
+    });
+  }
+
+  if (paths.timestamp) {
+    auto value = paths.timestamp->First(message);
+    if (const auto* seconds = std::get_if<int64_t>(&value)) {
+      timestamps++;
+      min_timestamp = std::min(min_timestamp, *seconds);
+      max_timestamp = std::max(max_timestamp, *seconds);
+    } else if (const auto* useconds = std::get_if<uint64_t>(&value)) {
+      const auto kSigned = static_cast<int64_t>(*useconds);
+      timestamps++;
+      min_timestamp = std::min(min_timestamp, kSigned);
+      max_timestamp = std::max(max_timestamp, kSigned);
+    }
+  }
+}
+
+void Stats::Accumulator::Merge(const Accumulator& other) {
+  messages += other.messages;
+  sizes.Merge(other.sizes);
+  citations.Merge(other.citations);
+  templates.insert(other.templates.begin(), other.templates.end());
+  timestamps += other.timestamps;
+  min_timestamp = std::min(min_timestamp, other.min_timestamp);
+  max_timestamp = std::max(max_timestamp, other.max_timestamp);
+}
+
+void Stats::PrintText(const Accumulator& stats) const {
+  const google::protobuf::EnumDescriptor* descriptor =
+      proto::FileType_descriptor();
+
+  std::cout << "File type: "
+            << descriptor->FindValueByNumber(header_->type())->name() << '\n';
+  std::cout << "Messages: " << stats.messages << '\n';
+  std::cout << "Message size (bytes): " << FormatSummary(stats.sizes) << '\n';
+
+  if (fields_.citations) {
+    std::cout << "Citations per message: " << FormatSummary(stats.citations)
+              << '\n';
+    std::cout << "Total citations: " << stats.citations.sum() << '\n';
+  }
+
+  if (fields_.templates)
+    std::cout << "Distinct templates: " << stats.templates.size() << '\n';
+
+  // Without any timestamp the range would show the sentinels it starts
+  // from.
+  if (fields_.timestamp && stats.timestamps == 0) {
+    std::cout << "Timestamp range: n/a" << '\n';
+  } else if (fields_.timestamp) {
+    std::cout << "Timestamp range: " << stats.min_timestamp << " - "
+              << stats.max_timestamp << '\n';
+  }
+
+  std::cout << "Message size histogram:" << '\n';
+  for (size_t i = 0; i < Log2Histogram::kBuckets; ++i) {
+    if (stats.sizes.bucket(i) == 0)
+      continue;
+
+    std::cout << fmt::format("  >= {:<12} {}",
+                             Log2Histogram::BucketLowerBound(i),
+                             stats.sizes.bucket(i))
+              << '\n';
+  }
+}
+
+void Stats::PrintJson(const Accumulator& stats) const {
+  const google::protobuf::EnumDescriptor* descriptor =
+      proto::FileType_descriptor();
+  json::Writer writer(&std::cout);
+
+  writer.BeginObject();
+  writer.Key("file_type");
+  writer.String(descriptor->FindValueByNumber(header_->type())->name());
+  writer.Key("messages");
+  writer.Uint(stats.messages);
+  writer.Key("message_size");
+  WriteSummary(&writer, stats.sizes);
+
+  if (fields_.citations) {
+    writer.Key("citations");
+    WriteSummary(&writer, stats.citations);
+  }
+
+  if (fields_.templates) {
+    writer.Key("distinct_templates");
+    writer.Uint(stats.templates.size());
+  }
+
+  if (fields_.timestamp && stats.timestamps == 0) {
+    writer.Key("timestamp");
+    writer.Null();
+  } else if (fields_.timestamp) {
+    writer.Key("timestamp");
+    writer.BeginObject();
+    writer.Key("min");
+    writer.Int(stats.min_timestamp);
+    writer.Key("max");
+    writer.Int(stats.max_timestamp);
+    writer.EndObject();
+  }
+
+  writer.Key("message_size_histogram");
+  writer.BeginArray();
+  for (size_t i = 0; i < Log2Histogram::kBuckets; ++i) {
+    if (stats.sizes.bucket(i) == 0)
+      continue;
+
+    writer.BeginObject();
+    writer.Key("lower_bound");
+    writer.Uint(Log2Histogram::BucketLowerBound(i));
+    writer.Key("count");
+    writer.Uint(stats.sizes.bucket(i));
+    writer.EndObject();
+  }
+  writer.EndArray();
+
+  writer.EndObject();
+  std::cout << '\n';
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_STATS_H_
+#define SRC_PBF_STATS_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "fields.h"
+#include "histogram.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to compute aggregate statistics over a PBF file in a
+/// single parallel pass.
+class Stats : public Command {
+ public:
+  Stats();
+
+  /// @brief Execute the stats command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;  ///< Input file path.
+    bool json;          ///< Output JSON rather than text.
+    unsigned threads;   ///< Number of worker threads.
+  };
+
+  /// @brief Fields used by the statistics, resolved once per file.
+  /// Fields the message type does not have are left empty and the
+  /// corresponding statistic is omitted.
+  struct Fields {
+    std::optional<fields::FieldPath> citations;
+    std::optional<fields::FieldPath> templates;
+    std::optional<fields::FieldPath> timestamp;
+  };
+
+  /// @brief Per thread accumulator. Merged into one once the scan has
+  /// finished.
+  struct Accumulator {
+    uint64_t messages = 0;
+    Log2Histogram sizes;
+    Distribution citations;
+    std::unordered_set<std::string> templates;
+    uint64_t timestamps = 0;  ///< Messages with a timestamp.
+    int64_t min_timestamp = std::numeric_limits<int64_t>::max();
+    int64_t max_timestamp = std::numeric_limits<int64_t>::min();
+
+    void Add(const google::protobuf::Message& message, const Fields& paths);
+    void Merge(const Accumulator& other);
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Resolve the fields used by the statistics for the message
+  /// type of the input file.
+  void ResolveFields();
+
+  /// @brief Read the whole file and accumulate statistics.
+  /// @return The merged accumulator.
+  Accumulator Collect();
+
+  /// @brief Print statistics as human readable text.
+  void PrintText(const Accumulator& stats) const;
+
+  /// @brief Print statistics as a JSON document.
+  void PrintJson(const Accumulator& stats) const;
+
+  Args args_;
+  Fields fields_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_STATS_H_
@@ -0,0 +1,308 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "timeline.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/citation.pb.h"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "cli.h"
+#include "exceptions.h"
+#include "hash.h"
+#include "io.h"
+#include "json.h"
+#include "scan.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+/// Bytes a worker buffers before taking the output lock.
+constexpr size_t kFlushSize = size_t{1} << 20U;
+
+/// @brief Make a value safe for a TSV column.
+std::string TsvValue(std::string value) {
+  std::replace_if(
+      value.begin(), value.end(),
+      [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+  return value;
+}
+}  // namespace
+
+Timeline::Timeline()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("timeline",
+              "List when each citation was added to and removed from its "
+              "page") {
+  // clang-format off
+  cli_options_.add_options()
+    ("input", options::value<std::string>()->required(),
+      "Revisions file, grouped by page and in time order within a page.")
+    ("output,o", options::value<std::string>(),
+      "Output file. Defaults to standard output.")
+    ("format,f", options::value<std::string>()->default_value("jsonl"),
+      "Output format: jsonl or tsv.")
+    ("by", options::value<std::string>(),
+      "Citation field identifying a citation, such as url or doi, also"
+      " printed as the value of each interval. Citations without it are"
+      " ignored. By default the whole citation is its identity, known"
+      " only by its fingerprint, so any edit to it ends one interval and"
+      " starts another.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  positional_options_.add("input", 1);
+  // clang-format on
+}
+
+ExitCode Timeline::Run(std::vector<std::string> args,
+                       // NOLINTNEXTLINE(whitespace/indent_namespace)
+                       struct GlobalOptions) {
+  LoadArgs(args);
+
+  std::ofstream file;
+  try {
+    auto input = io::OpenPbfFile(args_.input);
+    const auto kHeader = io::ReadPbfHeader(input.get());
+    if (kHeader->type() != proto::FileType::FILE_TYPE_REVISIONS) {
+      throw exceptions::UnsupportedFileType(
+          "timeline needs a revisions file");
+    }
+
+    by_field_ = nullptr;
+    if (args_.by) {
+      by_field_ = proto::Citation::descriptor()->FindFieldByName(*args_.by);
+      if (by_field_ == nullptr || by_field_->is_repeated() ||
+          by_field_->cpp_type() != pb::FieldDescriptor::CPPTYPE_STRING) {
+        throw exceptions::UserInputException(
+            fmt::format("{} is not a text field of citations", *args_.by)
+                .c_str());
+      }
+    }
+
+    output_ = &std::cout;
+    if (args_.output) {
+      file = std::ofstream(*args_.output, std::ios::out | std::ios::trunc);
+      output_ = &file;
+    }
+    if (args_.format == Format::kTsv) {
+      *output_ << "page_id\tfingerprint\tadded_revision\tadded_at\t"
+                  "removed_revision\tremoved_at"
+               << (by_field_ != nullptr ? "\tvalue\n" : "\n");
+    }
+
+    // Pages go to a fixed worker, so each worker sees the revisions of
+    // its pages in file order. The page id is read from the stored
+    // frame, leaving decoding to the workers.
+    std::vector<WorkerState> states(std::max(args_.threads, 1U));
+    scan::ParallelScanGrouped(
+        input.get(), *kHeader, args_.threads,
+        [](std::string_view frame) {
+          return binary::WireVarint(frame,
+                                    proto::Revision::kPageIdFieldNumber);
+        },
+        [this, &states](unsigned worker, uint64_t,
+                        const pb::Message& message) {
+          Apply(&states[worker], static_cast<const proto::Revision&>(message));
+        });
+    io::ClosePbfFile(std::move(input));
+
+    WorkerState total;
+    for (auto& state : states) {
+      EndPage(&state);
+      Flush(&state);
+      total.revisions += state.revisions;
+      total.pages += state.pages;
+      total.intervals += state.intervals;
+      total.out_of_order += state.out_of_order;
+    }
+
+    output_->flush();
+    if (!*output_)
+      throw exceptions::CliException("failed to write output");
+
+    if (total.out_of_order > 0) {
+      spdlog::warn("{} revisions are older than the revision before them on "
+                   "their page, so some intervals are wrong. Sort the input "
+                   "by page and timestamp first",
+                   total.out_of_order);
+    }
+    spdlog::info("Found {} citation intervals in {} pages ({} revisions)",
+                 total.intervals, total.pages, total.revisions);
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to build timeline: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Timeline::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("input", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+
+  const auto kFormat = EnsureArgument<std::string>("format", parsed_args.first);
+  if (kFormat == "jsonl") {
+    args_.format = Format::kJsonl;
+  } else if (kFormat == "tsv") {
+    args_.format = Format::kTsv;
+  } else {
+    throw exceptions::UserInputException(
+        fmt::format("unknown output format: {}", kFormat).c_str());
+  }
+
+  args_.output = std::nullopt;
+  if (parsed_args.first.contains("output"))
+    args_.output = parsed_args.first["output"].as<std::string>();
+
+  args_.by = std::nullopt;
+  if (parsed_args.first.contains("by"))
+    args_.by = parsed_args.first["by"].as<std::string>();
+
+  spdlog::debug("Timeline arguments: input={} format={} threads={}",
+                args_.input, kFormat, args_.threads);
+}
+
+void Timeline::Apply(WorkerState* state, const proto::Revision& revision) {
+  if (state->page != revision.page_id()) {
+    EndPage(state);
+    state->page = revision.page_id();
+    state->pages++;
+  } else if (revision.timestamp() < state->last_timestamp) {
+    state->out_of_order++;
+  }
+  state->last_timestamp = revision.timestamp();
+  state->revisions++;
+
+  for (auto& [fingerprint, citation] : state->open) {
+    citation.seen = false;
+  }
+
+  for (const auto& citation : revision.citations()) {
+    std::string_view value;
+    uint64_t fingerprint = 0;
+    if (by_field_ != nullptr) {
+      value = citation.GetReflection()->GetStringReference(
+          citation, by_field_, &state->scratch);
+      if (value.empty())
+        continue;
+      fingerprint = hash::Bytes64(value);
+    } else {
+      fingerprint = hash::Content(citation).low;
+    }
+
+    auto [open, added] = state->open.try_emplace(fingerprint);
+    if (added) {
+      open->second.added_revision = revision.revision_id();
+      open->second.added_at = revision.timestamp();
+      open->second.value = value;
+    }
+    open->second.seen = true;
+  }
+
+  for (auto open = state->open.begin(); open != state->open.end();) {
+    if (open->second.seen) {
+      ++open;
+      continue;
+    }
+    AppendInterval(state, open->first, open->second, &revision);
+    open = state->open.erase(open);
+  }
+
+  if (state->buffer.size() >= kFlushSize)
+    Flush(state);
+}
+
+void Timeline::EndPage(WorkerState* state) {
+  for (const auto& [fingerprint, citation] : state->open) {
+    AppendInterval(state, fingerprint, citation, nullptr);
+  }
+  state->open.clear();
+}
+
+void Timeline::AppendInterval(WorkerState* state, uint64_t fingerprint,
+                              const OpenCitation& citation,
+                              // NOLINTNEXTLINE(whitespace/indent_namespace)
+                              const proto::Revision* removed_by) {
+  std::string& out = state->buffer;
+  state->intervals++;
+
+  if (args_.format == Format::kTsv) {
+    fmt::format_to(std::back_inserter(out), "{}\t{:016x}\t{}\t{}\t",
+                   *state->page, fingerprint, citation.added_revision,
+                   citation.added_at);
+    if (removed_by != nullptr) {
+      fmt::format_to(std::back_inserter(out), "{}\t{}",
+                     removed_by->revision_id(), removed_by->timestamp());
+    } else {
+      out += "\t";
+    }
+    if (by_field_ != nullptr) {
+      out += '\t';
+      out += TsvValue(citation.value);
+    }
+    out += '\n';
+    return;
+  }
+
+  fmt::format_to(std::back_inserter(out),
+                 R"({{"page_id":{},"fingerprint":"{:016x}",)"
+                 R"("added_revision":{},"added_at":{},)",
+                 *state->page, fingerprint, citation.added_revision,
+                 citation.added_at);
+  if (removed_by != nullptr) {
+    fmt::format_to(std::back_inserter(out),
+                   R"("removed_revision":{},"removed_at":{})",
+                   removed_by->revision_id(), removed_by->timestamp());
+  } else {
+    out += R"("removed_revision":null,"removed_at":null)";
+  }
+  if (by_field_ != nullptr) {
+    fmt::format_to(std::back_inserter(out), R"(,"value":"{}")",
+                   json::Escape(citation.value));
+  }
+  out += "}\n";
+}
+
+void Timeline::Flush(WorkerState* state) {
+  if (state->buffer.empty())
+    return;
+
+  const std::lock_guard<std::mutex> kLock(output_mutex_);
+  output_->write(state->buffer.data(),
+                 static_cast<std::streamsize>(state->buffer.size()));
+  state->buffer.clear();
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_TIMELINE_H_
+#define SRC_PBF_TIMELINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "citescoop/proto/revision.pb.h"
+#include "google/protobuf/descriptor.h"
+
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to turn the revisions of pages into the intervals
+/// during which each citation was on its page.
+///
+/// Revisions must be grouped by page and in time order within a page,
+/// as dump extract writes them. Pages are spread across workers by
+/// page id, so all revisions of a page reach the same worker in order.
+/// A worker holds only the citations open on its current page, keyed
+/// by a 64 bit fingerprint, and emits an interval when a citation
+/// disappears or the page ends. A citation's text is not kept, only the
+/// value of the --by field when one is given. Memory is therefore
+/// bounded by the citations open on one page per worker rather than by
+/// page histories.
+class Timeline : public Command {
+ public:
+  Timeline();
+
+  /// @brief Execute the timeline command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  enum class Format : std::uint8_t {
+    kJsonl,
+    kTsv,
+  };
+
+  struct Args {
+    std::string input;                  ///< Revisions file path.
+    std::optional<std::string> output;  ///< Output file, else stdout.
+    Format format;                      ///< Output format.
+    std::optional<std::string> by;      ///< Citation field identity.
+    unsigned threads;                   ///< Number of worker threads.
+  };
+
+  /// @brief A citation on the current page since some revision.
+  struct OpenCitation {
+    uint64_t added_revision;
+    int64_t added_at;
+    std::string value;  ///< Value of the --by field, else empty.
+    bool seen;          ///< Present in the revision being applied.
+  };
+
+  /// @brief Running state of one worker.
+  struct WorkerState {
+    std::optional<uint64_t> page;
+    int64_t last_timestamp = 0;
+    std::unordered_map<uint64_t, OpenCitation> open;
+    std::string scratch;  ///< Storage for reading the --by field.
+    std::string buffer;
+    uint64_t revisions = 0;
+    uint64_t pages = 0;
+    uint64_t intervals = 0;
+    uint64_t out_of_order = 0;
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Apply the next revision of a worker's page, or start a new
+  /// page, emitting the intervals this closes.
+  void Apply(WorkerState* state,
+             const wikiopencite::proto::Revision& revision);
+
+  /// @brief Close every citation still open at the end of a page.
+  void EndPage(WorkerState* state);
+
+  /// @brief Append one interval to a worker's buffer.
+  void AppendInterval(WorkerState* state, uint64_t fingerprint,
+                      const OpenCitation& citation,
+                      const wikiopencite::proto::Revision* removed_by);
+
+  /// @brief Write out a worker's buffer.
+  void Flush(WorkerState* state);
+
+  Args args_;
+  const google::protobuf::FieldDescriptor* by_field_ = nullptr;
+  std::ostream* output_ = nullptr;
+  std::mutex output_mutex_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_TIMELINE_H_
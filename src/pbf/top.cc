@@ -0,0 +1,381 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "top.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "boost/program_options/variables_map.hpp"
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/message.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "doi.h"
+#include "exceptions.h"
+#include "fields.h"
+#include "io.h"
+#include "scan.h"
+#include "space_saving.h"
+#include "string_dictionary.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace pb = google::protobuf;
+
+constexpr size_t kDefaultK = 20;
+constexpr size_t kDefaultCapacity = 10000;
+
+std::string_view Trim(std::string_view value) {
+  while (!value.empty() &&
+         std::isspace(static_cast<unsigned char>(value.front())) != 0)
+    value.remove_prefix(1);
+  while (!value.empty() &&
+         std::isspace(static_cast<unsigned char>(value.back())) != 0)
+    value.remove_suffix(1);
+  return value;
+}
+
+std::string Lower(std::string_view value) {
+  std::string lower(value);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  });
+  return lower;
+}
+
+/// @brief Host of a URL, lower cased and without a leading www.
+std::optional<std::string> Domain(std::string_view url) {
+  url = Trim(url);
+  const size_t kScheme = url.find("://");
+  if (kScheme != std::string_view::npos) {
+    url.remove_prefix(kScheme + 3);
+  } else if (url.starts_with("//")) {
+    url.remove_prefix(2);
+  }
+  url = url.substr(0, url.find_first_of("/?#"));
+  const size_t kUser = url.rfind('@');
+  if (kUser != std::string_view::npos)
+    url.remove_prefix(kUser + 1);
+  url = url.substr(0, url.find(':'));
+  if (url.starts_with("www."))
+    url.remove_prefix(4);
+  while (url.ends_with('.'))
+    url.remove_suffix(1);
+
+  if (url.empty())
+    return std::nullopt;
+  return Lower(url);
+}
+
+/// @brief Template name as MediaWiki compares them: case and
+/// underscores versus spaces do not matter.
+std::optional<std::string> TemplateName(std::string_view name) {
+  std::string key = Lower(Trim(name));
+  std::replace(key.begin(), key.end(), '_', ' ');
+  if (key.empty())
+    return std::nullopt;
+  return key;
+}
+
+/// @brief Registrant prefix of a DOI, such as 10.1038.
+std::optional<std::string> DoiPrefix(std::string_view raw) {
+  auto normalized = doi::Normalize(raw);
+  if (!normalized)
+    return std::nullopt;
+  normalized->resize(normalized->find('/'));
+  return normalized;
+}
+}  // namespace
+
+Top::Top()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("top", "List the most frequent citation domains, templates, "
+                     "DOI prefixes or publishers") {
+  // clang-format off
+  cli_options_.add_options()
+    ("file", options::value<std::string>()->required(),
+      "Input file of pages or revisions.")
+    ("by,b", options::value<std::string>()->default_value("domain"),
+      "What to count citations by: domain, template, doi-prefix or"
+      " publisher.")
+    ("k,k", options::value<size_t>()->default_value(kDefaultK),
+      "Number of keys to list.")
+    ("capacity", options::value<size_t>()->default_value(kDefaultCapacity),
+      "Keys each worker keeps counts for. Larger values use more memory"
+      " but tighten the bounds.")
+    ("exact",
+      "Scan the file a second time, counting the keys that could be in"
+      " the top k exactly.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of worker threads.");
+  positional_options_.add("file", 1);
+  // clang-format on
+}
+
+ExitCode Top::Run(std::vector<std::string> args,
+                  // NOLINTNEXTLINE(whitespace/indent_namespace)
+                  struct GlobalOptions) {
+  LoadArgs(args);
+
+  try {
+    input_ = io::OpenPbfFile(args_.input);
+    header_ = io::ReadPbfHeader(input_.get());
+
+    std::string field;
+    switch (args_.by) {
+      case Key::kDomain:
+        field = "citations.url";
+        break;
+      case Key::kTemplate:
+        field = fields::kTemplateField;
+        break;
+      case Key::kDoiPrefix:
+        field = "citations.doi";
+        break;
+      case Key::kPublisher:
+        field = "citations.publisher";
+        break;
+    }
+    path_ = fields::FieldPath::Find(io::DescriptorForFileType(header_->type()),
+                                    field);
+    if (!path_) {
+      throw exceptions::UnsupportedFileType(
+          fmt::format("file messages have no {}", field).c_str());
+    }
+    KeyDictionary();
+
+    auto summary = Summarise();
+    io::ClosePbfFile(std::move(input_));
+
+    // The k-th largest lower bound is a count some k keys reach for
+    // certain, so only keys whose upper bound reaches it can be in the
+    // top k.
+    auto entries = summary.Top(summary.size());
+    std::vector<uint64_t> lower_bounds;
+    for (const auto& entry : entries) {
+      lower_bounds.push_back(entry.count - entry.error);
+    }
+    uint64_t threshold = 0;
+    if (lower_bounds.size() >= args_.k && args_.k > 0) {
+      std::nth_element(
+          lower_bounds.begin(),
+          lower_bounds.begin() + static_cast<ptrdiff_t>(args_.k - 1),
+          lower_bounds.end(), std::greater<>());
+      threshold = lower_bounds[args_.k - 1];
+    }
+    if (summary.MinCount() > threshold) {
+      spdlog::warn("Keys not tracked may have up to {} citations, more than "
+                   "the smallest certain top {} count of {}. Raise "
+                   "--capacity for a reliable answer",
+                   summary.MinCount(), args_.k, threshold);
+    }
+
+    if (args_.exact) {
+      std::unordered_set<std::string> candidates;
+      for (const auto& entry : entries) {
+        if (entry.count >= threshold)
+          candidates.insert(entry.key);
+      }
+      spdlog::info("Recounting {} candidates exactly", candidates.size());
+      for (const auto& entry : Recount(candidates)) {
+        std::cout << entry.key << '\t' << entry.count << '\n';
+      }
+    } else {
+      entries.resize(std::min(entries.size(), args_.k));
+      for (const auto& entry : entries) {
+        std::cout << entry.key << '\t' << entry.count << '\t' << entry.error
+                  << '\n';
+      }
+    }
+
+    spdlog::info("Counted {} citations", summary.total());
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to count citations: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  return ExitCode::kOk;
+}
+
+void Top::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
+  args_.k = EnsureArgument<size_t>("k", parsed_args.first);
+  args_.capacity = EnsureArgument<size_t>("capacity", parsed_args.first);
+  args_.exact = parsed_args.first.contains("exact");
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+
+  const auto kBy = EnsureArgument<std::string>("by", parsed_args.first);
+  if (kBy == "domain") {
+    args_.by = Key::kDomain;
+  } else if (kBy == "template") {
+    args_.by = Key::kTemplate;
+  } else if (kBy == "doi-prefix") {
+    args_.by = Key::kDoiPrefix;
+  } else if (kBy == "publisher") {
+    args_.by = Key::kPublisher;
+  } else {
+    throw exceptions::UserInputException(
+        fmt::format("cannot count citations by {}", kBy).c_str());
+  }
+
+  if (args_.capacity < args_.k) {
+    throw exceptions::UserInputException(
+        "capacity must be at least the number of keys listed");
+  }
+
+  spdlog::debug("Top arguments: by={} k={} capacity={} exact={} threads={}",
+                kBy, args_.k, args_.capacity, args_.exact, args_.threads);
+}
+
+void Top::KeyDictionary() {
+  keys_by_id_ = std::nullopt;
+  if (!input_->dictionary || !StringDictionary::Internable(path_->leaf()))
+    return;
+
+  // Each distinct interned value is reduced to its key once rather
+  // than once per citation.
+  const auto& dictionary = *input_->dictionary;
+  keys_by_id_.emplace();
+  keys_by_id_->reserve(dictionary.size());
+  for (uint64_t id = 0; id < dictionary.size(); ++id) {
+    keys_by_id_->push_back(KeyOf(dictionary.Lookup(id)));
+  }
+  input_->rehydrate_strings = false;
+  spdlog::debug("Counting {} by the ids of {} interned strings",
+                path_->path(), dictionary.size());
+}
+
+template <typename Visitor>
+void Top::VisitKeys(const pb::Message& message,
+                    // NOLINTNEXTLINE(whitespace/indent_namespace)
+                    const Visitor& visitor) const {
+  if (keys_by_id_) {
+    const auto* leaf = path_->leaf();
+    path_->VisitParents(message, [&](const pb::Message& parent) {
+      if (const auto kId = StringDictionary::IdOf(parent, leaf)) {
+        if (*kId >= keys_by_id_->size())
+          throw exceptions::UserInputException(
+              "string id is not in the dictionary");
+        if (const auto& key = (*keys_by_id_)[*kId])
+          visitor(*key);
+      } else if (auto key =
+                     KeyOf(parent.GetReflection()->GetString(parent, leaf))) {
+        visitor(*key);
+      }
+    });
+    return;
+  }
+
+  path_->Visit(message, [&](const fields::Value& value) {
+    const auto* text = std::get_if<std::string>(&value);
+    if (text == nullptr)
+      return;
+    if (auto key = KeyOf(*text))
+      visitor(*key);
+  });
+}
+
+SpaceSaving Top::Summarise() {
+  std::vector<SpaceSaving> summaries(std::max(args_.threads, 1U),
+                                     SpaceSaving(args_.capacity));
+
+  scan::ParallelScan(
+      input_.get(), *header_, args_.threads,
+      [&](unsigned worker, uint64_t, const pb::Message& message) {
+        VisitKeys(message,
+                  [&](const std::string& key) { summaries[worker].Add(key); });
+      });
+
+  for (size_t i = 1; i < summaries.size(); ++i) {
+    summaries[0].Merge(summaries[i]);
+  }
+  return std::move(summaries[0]);
+}
+
+std::vector<SpaceSaving::Entry> Top::Recount(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::unordered_set<std::string>& candidates) {
+  using Counts = std::unordered_map<std::string, uint64_t>;
+  std::vector<Counts> counts(std::max(args_.threads, 1U));
+
+  input_ = io::OpenPbfFile(args_.input);
+  io::ReadPbfHeader(input_.get());
+  input_->rehydrate_strings = !keys_by_id_;
+  scan::ParallelScan(
+      input_.get(), *header_, args_.threads,
+      [&](unsigned worker, uint64_t, const pb::Message& message) {
+        VisitKeys(message, [&](const std::string& key) {
+          if (candidates.contains(key))
+            counts[worker][key]++;
+        });
+      });
+  io::ClosePbfFile(std::move(input_));
+
+  for (size_t i = 1; i < counts.size(); ++i) {
+    for (const auto& [key, count] : counts[i]) {
+      counts[0][key] += count;
+    }
+  }
+
+  std::vector<SpaceSaving::Entry> exact;
+  for (const auto& [key, count] : counts[0]) {
+    exact.push_back({key, count, 0});
+  }
+  const size_t kTop = std::min(exact.size(), args_.k);
+  std::partial_sort(exact.begin(), exact.begin() + static_cast<ptrdiff_t>(kTop),
+                    exact.end(), [](const auto& lhs, const auto& rhs) {
+                      if (lhs.count != rhs.count)
+                        return lhs.count > rhs.count;
+                      return lhs.key < rhs.key;
+                    });
+  exact.resize(kTop);
+  return exact;
+}
+
+std::optional<std::string> Top::KeyOf(const std::string& value) const {
+  switch (args_.by) {
+    case Key::kDomain:
+      return Domain(value);
+    case Key::kTemplate:
+      return TemplateName(value);
+    case Key::kDoiPrefix:
+      return DoiPrefix(value);
+    case Key::kPublisher: {
+      const auto kPublisher = Trim(value);
+      if (kPublisher.empty())
+        return std::nullopt;
+      return std::string(kPublisher);
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_TOP_H_
+#define SRC_PBF_TOP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "cli.h"
+#include "fields.h"
+#include "io.h"
+#include "space_saving.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to report the most frequent citation domains,
+/// templates, DOI prefixes or publishers of a PBF file.
+///
+/// Each worker keeps a Space-Saving summary of fixed capacity and the
+/// summaries are merged once the scan has finished, so memory does not
+/// grow with the number of distinct keys. Counts are upper bounds; with
+/// --exact a second scan counts only the keys that could be in the top
+/// k.
+class Top : public Command {
+ public:
+  Top();
+
+  /// @brief Execute the top command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  /// @brief What citations are counted by.
+  enum class Key : std::uint8_t {
+    kDomain,
+    kTemplate,
+    kDoiPrefix,
+    kPublisher,
+  };
+
+  struct Args {
+    std::string input;  ///< Input file path.
+    Key by;             ///< What citations are counted by.
+    size_t k;           ///< Number of keys to report.
+    size_t capacity;    ///< Keys monitored per worker.
+    bool exact;         ///< Recount the candidates exactly.
+    unsigned threads;   ///< Number of worker threads.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Call visitor with the key of every citation of a message
+  /// that has one. Interned values are keyed through keys_by_id_.
+  template <typename Visitor>
+  void VisitKeys(const google::protobuf::Message& message,
+                 const Visitor& visitor) const;
+
+  /// @brief Key every string of the input's dictionary up front and
+  /// have its reader keep the ids, if the counted field is interned.
+  void KeyDictionary();
+
+  /// @brief Summarise the whole file in one parallel scan.
+  SpaceSaving Summarise();
+
+  /// @brief Count the candidates exactly in a second scan.
+  std::vector<SpaceSaving::Entry> Recount(
+      const std::unordered_set<std::string>& candidates);
+
+  /// @brief Reduce a field value to the key it is counted under.
+  /// @return The key, or std::nullopt if the value has none.
+  [[nodiscard]] std::optional<std::string> KeyOf(
+      const std::string& value) const;
+
+  Args args_;
+  std::unique_ptr<wikiopencite::proto::FileHeader> header_;
+  std::unique_ptr<io::PbfFile> input_;
+  std::optional<fields::FieldPath> path_;
+  /// Key of each string of the file's dictionary, when the counted
+  /// field is interned and read by id (see string_dictionary.h).
+  std::optional<std::vector<std::optional<std::string>>> keys_by_id_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_TOP_H_
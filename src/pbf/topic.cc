@@ -5,10 +5,28 @@
 
 #include <memory>
 
+#include "as_of.h"
+#include "bloom.h"
 #include "cat.h"
 #include "cli.h"
+#include "columnarize.h"
 #include "combine.h"
+#include "diff.h"
+#include "generate.h"
+#include "get.h"
+#include "group_by.h"
+#include "index.h"
+#include "intern.h"
+#include "join.h"
+#include "make_doi_table.h"
 #include "meta.h"
+#include "sample.h"
+#include "serve.h"
+#include "sort.h"
+#include "stats.h"
+#include "timeline.h"
+#include "top.h"
+#include "verify.h"
 
 namespace wikiopencite::citescoop::cli::pbf {
 
@@ -19,6 +37,24 @@ std::unique_ptr<Topic> NewPbfTopic() {
   topic->Register(std::shared_ptr<Command>(new Cat()));
   topic->Register(std::shared_ptr<Command>(new Meta()));
   topic->Register(std::shared_ptr<Command>(new Combine()));
+  topic->Register(std::shared_ptr<Command>(new Stats()));
+  topic->Register(std::shared_ptr<Command>(new GroupBy()));
+  topic->Register(std::shared_ptr<Command>(new Columnarize()));
+  topic->Register(std::shared_ptr<Command>(new Generate()));
+  topic->Register(std::shared_ptr<Command>(new Sort()));
+  topic->Register(std::shared_ptr<Command>(new Index()));
+  topic->Register(std::shared_ptr<Command>(new Sample()));
+  topic->Register(std::shared_ptr<Command>(new Diff()));
+  topic->Register(std::shared_ptr<Command>(new Verify()));
+  topic->Register(std::shared_ptr<Command>(new Join()));
+  topic->Register(std::shared_ptr<Command>(new Get()));
+  topic->Register(std::shared_ptr<Command>(new Bloom()));
+  topic->Register(std::shared_ptr<Command>(new MakeDoiTable()));
+  topic->Register(std::shared_ptr<Command>(new Serve()));
+  topic->Register(std::shared_ptr<Command>(new Timeline()));
+  topic->Register(std::shared_ptr<Command>(new AsOf()));
+  topic->Register(std::shared_ptr<Command>(new Top()));
+  topic->Register(std::shared_ptr<Command>(new Intern()));
   return topic;
 }
 }  // namespace wikiopencite::citescoop::cli::pbf
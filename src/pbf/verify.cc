@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "verify.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "boost/program_options/options_description.hpp"
+#include "boost/program_options/parsers.hpp"
+#include "boost/program_options/positional_options.hpp"
+#include "boost/program_options/value_semantic.hpp"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "checksum.h"
+#include "cli.h"
+#include "container.h"
+#include "exceptions.h"
+#include "io.h"
+#include "thread_pool.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+namespace {
+namespace options = boost::program_options;
+namespace fs = std::filesystem;
+
+/// Most corrupt blocks listed individually.
+constexpr size_t kMaxReportedBlocks = 16;
+}  // namespace
+
+Verify::Verify()
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : Command("verify", "Check a PBF file for corruption and truncation") {
+  // clang-format off
+  cli_options_.add_options()
+    ("file", options::value<std::string>()->required(), "Input file.")
+    ("threads,j",
+      options::value<unsigned>()->default_value(
+        ThreadPool::DefaultThreadCount()),
+      "Number of checksumming threads.")
+    ("skip-count",
+      "Only check block checksums, without walking every message to"
+      " compare their number to the header.");
+  positional_options_.add("file", 1);
+  // clang-format on
+}
+
+ExitCode Verify::Run(std::vector<std::string> args,
+                     // NOLINTNEXTLINE(whitespace/indent_namespace)
+                     struct GlobalOptions) {
+  LoadArgs(args);
+
+  std::vector<std::string> problems;
+  try {
+    std::error_code err;
+    const uint64_t kFileSize = fs::file_size(args_.input, err);
+    if (err) {
+      throw exceptions::UserInputException(
+          fmt::format("cannot read {}", args_.input).c_str());
+    }
+
+    std::ifstream stream(args_.input, std::ios::in | std::ios::binary);
+    const auto kTrailer = checksum::ReadTrailer(&stream, kFileSize);
+    stream.close();
+    if (!kTrailer)
+      spdlog::warn("{} has no checksum trailer", args_.input);
+
+    std::atomic<uint64_t> next = 0;
+    ThreadPool pool(std::max(args_.threads, 1U));
+    std::vector<std::future<std::vector<uint64_t>>> checked;
+    if (kTrailer) {
+      for (size_t i = 0; i < pool.size(); ++i) {
+        checked.push_back(pool.Submit([this, &kTrailer, &next]() {
+          return CheckBlocks(*kTrailer, &next);
+        }));
+      }
+    }
+
+    uint64_t messages = 0;
+    if (!args_.skip_count) {
+      messages = CountMessages(kTrailer ? kTrailer->content_size : kFileSize,
+                               &problems);
+    }
+
+    std::vector<uint64_t> corrupt;
+    for (auto& future : checked) {
+      auto blocks = future.get();
+      corrupt.insert(corrupt.end(), blocks.begin(), blocks.end());
+    }
+    std::sort(corrupt.begin(), corrupt.end());
+    for (size_t i = 0; i < std::min(corrupt.size(), kMaxReportedBlocks); ++i) {
+      problems.push_back(fmt::format(
+          "checksum mismatch in bytes {} to {}",
+          corrupt[i] * kTrailer->block_size,
+          std::min((corrupt[i] + 1) * kTrailer->block_size,
+                   kTrailer->content_size)));
+    }
+    if (corrupt.size() > kMaxReportedBlocks) {
+      problems.push_back(fmt::format("{} more corrupt blocks",
+                                     corrupt.size() - kMaxReportedBlocks));
+    }
+
+    if (problems.empty()) {
+      std::cout << fmt::format(
+          "{}: ok, {} checksummed blocks{}\n", args_.input,
+          kTrailer ? kTrailer->checksums.size() : 0,
+          args_.skip_count ? "" : fmt::format(", {} messages", messages));
+    }
+  } catch (const exceptions::CliException& e) {
+    spdlog::critical("Failed to verify input file: {}", e.what());
+    std::cerr << e.what() << '\n';
+
+    return e.code();
+  }
+
+  if (!problems.empty()) {
+    for (const auto& problem : problems) {
+      spdlog::error("{}", problem);
+      std::cerr << args_.input << ": " << problem << '\n';
+    }
+    return ExitCode::kInputError;
+  }
+
+  return ExitCode::kOk;
+}
+
+void Verify::LoadArgs(const std::vector<std::string>& args) {
+  auto parsed_args = ParseArgs(args);
+
+  args_.input = EnsureArgument<std::string>("file", parsed_args.first);
+  args_.threads = EnsureArgument<unsigned>("threads", parsed_args.first);
+  args_.skip_count = parsed_args.first.contains("skip-count");
+
+  spdlog::trace("Verify command arguments: Input: {} Threads: {}",
+                args_.input, args_.threads);
+}
+
+std::vector<uint64_t> Verify::CheckBlocks(const checksum::Trailer& trailer,
+                                          // NOLINTNEXTLINE
+                                          std::atomic<uint64_t>* next) const {
+  std::ifstream stream(args_.input, std::ios::in | std::ios::binary);
+  std::string buffer(trailer.block_size, '\0');
+  std::vector<uint64_t> corrupt;
+
+  for (uint64_t block = next->fetch_add(1); block < trailer.checksums.size();
+       block = next->fetch_add(1)) {
+    const uint64_t kStart = block * trailer.block_size;
+    const uint64_t kSize =
+        std::min(trailer.block_size, trailer.content_size - kStart);
+
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(kStart));
+    stream.read(buffer.data(), static_cast<std::streamsize>(kSize));
+    if (static_cast<uint64_t>(stream.gcount()) != kSize ||
+        checksum::Extend(0, std::string_view(buffer.data(), kSize)) !=
+            trailer.checksums[block]) {
+      corrupt.push_back(block);
+    }
+  }
+
+  return corrupt;
+}
+
+uint64_t Verify::CountMessages(uint64_t content_size,
+                               // NOLINTNEXTLINE(whitespace/indent_namespace)
+                               std::vector<std::string>* problems) const {
+  auto file = io::OpenPbfFile(args_.input);
+  const auto kHeader = io::ReadPbfHeader(file.get());
+  std::istream* payload = io::PayloadStream(file.get());
+
+  // Only the framing is checked. Decoding every message on this one
+  // thread would hold the command to decode speed rather than disk
+  // speed.
+  uint64_t count = 0;
+  std::string frame;
+  try {
+    for (; count < kHeader->count(); ++count) {
+      io::ReadFrame(file.get(), &frame);
+      if (!*payload)
+        break;
+    }
+  } catch (const exceptions::CliException& e) {
+    problems->push_back(
+        fmt::format("failed to read message {}: {}", count, e.what()));
+    io::ClosePbfFile(std::move(file));
+    return count;
+  }
+
+  if (count < kHeader->count()) {
+    problems->push_back(fmt::format("header counts {} messages but only {} "
+                                    "could be read",
+                                    kHeader->count(), count));
+  } else if (container::IsCompressed(*kHeader)
+                 ? payload->peek() != std::istream::traits_type::eof()
+                 : io::TellPayload(file.get()) != content_size) {
+    problems->push_back(fmt::format(
+        "header counts {} messages but more data follows them",
+        kHeader->count()));
+  }
+
+  io::ClosePbfFile(std::move(file));
+  return count;
+}
+
+}  // namespace wikiopencite::citescoop::cli::pbf
@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_PBF_VERIFY_H_
+#define SRC_PBF_VERIFY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "checksum.h"
+#include "cli.h"
+
+namespace wikiopencite::citescoop::cli::pbf {
+
+/// @brief Command to check a PBF file for corruption and truncation.
+///
+/// The blocks covered by the checksum trailer are read and checked on a
+/// thread pool, each thread with its own file handle, while the calling
+/// thread walks the frames of the messages, without decoding them, to
+/// confirm the file holds exactly as many as its header says.
+class Verify : public Command {
+ public:
+  Verify();
+
+  /// @brief Execute the verify command.
+  /// @param args CLI arguments passed to the command.
+  /// @param globals Global options for the CLI.
+  /// @return Exit code representing the result of the command.
+  ExitCode Run(std::vector<std::string> args, GlobalOptions globals) override;
+
+ private:
+  struct Args {
+    std::string input;  ///< Input file path.
+    unsigned threads;   ///< Number of checksumming threads.
+    bool skip_count;    ///< Only check the checksums.
+  };
+
+  /// @brief Parse command line arguments.
+  /// @param args CLI arguments passed to the command.
+  void LoadArgs(const std::vector<std::string>& args);
+
+  /// @brief Check the blocks handed out through next.
+  /// @return Indices of the blocks whose checksum does not match.
+  std::vector<uint64_t> CheckBlocks(const checksum::Trailer& trailer,
+                                    std::atomic<uint64_t>* next) const;
+
+  /// @brief Walk the frame of every message, without decoding it, and
+  /// compare their number to the header.
+  /// @param content_size Bytes before the checksum trailer.
+  /// @return Number of messages read.
+  uint64_t CountMessages(uint64_t content_size,
+                         std::vector<std::string>* problems) const;
+
+  Args args_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::pbf
+
+#endif  // SRC_PBF_VERIFY_H_
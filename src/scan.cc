@@ -0,0 +1,242 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "scan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "bounded_queue.h"
+#include "delta.h"
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::scan {
+
+namespace {
+namespace proto = wikiopencite::proto;
+
+/// Messages per batch handed to a worker. Large enough to amortise the
+/// queue locking, small enough to keep all workers busy.
+constexpr size_t kBatchSize = 256;
+
+/// Batches allowed in flight per worker before the reader blocks.
+constexpr size_t kBatchesPerWorker = 4;
+
+struct Batch {
+  uint64_t first_ordinal;
+  std::vector<std::string> frames;
+};
+
+/// @brief Frames of the groups of one worker, not consecutive in the
+/// file.
+struct GroupedBatch {
+  std::vector<uint64_t> ordinals;
+  std::vector<std::string> frames;
+};
+
+/// @brief Whether a batch holding at least kBatchSize frames may end
+/// before the given frame. Batches of a delta encoded file only end
+/// before a keyframe, so each can be decoded on its own.
+bool CanEndBefore(bool delta_revisions, std::string_view frame) {
+  return !delta_revisions || delta::IsKeyframe(frame);
+}
+}  // namespace
+
+uint64_t ParallelScan(io::PbfFile* file, const proto::FileHeader& header,
+                      // NOLINTNEXTLINE(whitespace/indent_namespace)
+                      unsigned threads, const Visitor& visitor) {
+  return ParallelScanFrames(
+      file, header, threads, true,
+      [&](unsigned worker, uint64_t ordinal, std::string_view,
+          const google::protobuf::Message* message) {
+        visitor(worker, ordinal, *message);
+      });
+}
+
+uint64_t ParallelScanFrames(io::PbfFile* file,
+                            const proto::FileHeader& header,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            unsigned threads, bool decode,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            const FrameVisitor& visitor) {
+  const uint64_t kCount = header.count();
+  io::SetReadAhead(file, threads);
+  // Frames are decoded by the thread visiting them, only if asked to.
+  const auto kVisit = [&](io::FrameDecoder* decoder, unsigned worker,
+                          uint64_t ordinal, std::string_view frame) {
+    visitor(worker, ordinal, frame,
+            decode ? &decoder->Decode(frame) : nullptr);
+  };
+
+  if (threads < 2) {
+    io::FrameDecoder decoder(*file, header.type());
+    std::string frame;
+    for (uint64_t i = 0; i < kCount; ++i) {
+      io::ReadFrame(file, &frame);
+      kVisit(&decoder, 0, i, frame);
+    }
+    return kCount;
+  }
+
+  const bool kDeltaRevisions =
+      file->delta_revisions &&
+      header.type() == proto::FileType::FILE_TYPE_REVISIONS;
+  BoundedQueue<Batch> queue(threads * kBatchesPerWorker);
+  std::exception_ptr failure;
+  std::mutex failure_mutex;
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (unsigned worker = 0; worker < threads; ++worker) {
+    workers.emplace_back([&, worker]() {
+      io::FrameDecoder decoder(*file, header.type());
+      while (auto batch = queue.Pop()) {
+        try {
+          for (size_t i = 0; i < batch->frames.size(); ++i) {
+            kVisit(&decoder, worker, batch->first_ordinal + i,
+                   batch->frames[i]);
+          }
+        } catch (...) {
+          const std::lock_guard<std::mutex> kLock(failure_mutex);
+          if (!failure)
+            failure = std::current_exception();
+          queue.Close();
+        }
+      }
+    });
+  }
+
+  // The reader only cuts the payload into frames, the workers decode
+  // them, rebuilding deltas and putting back interned strings.
+  uint64_t read = 0;
+  try {
+    Batch batch{.first_ordinal = 0, .frames = {}};
+    std::string frame;
+    while (read < kCount) {
+      io::ReadFrame(file, &frame);
+      if (batch.frames.size() >= kBatchSize &&
+          CanEndBefore(kDeltaRevisions, frame)) {
+        const uint64_t kNext = batch.first_ordinal + batch.frames.size();
+        if (!queue.Push(std::move(batch)))
+          break;
+        batch = Batch{.first_ordinal = kNext, .frames = {}};
+        batch.frames.reserve(kBatchSize);
+      }
+      batch.frames.push_back(std::move(frame));
+      read++;
+    }
+    if (!batch.frames.empty())
+      queue.Push(std::move(batch));
+  } catch (...) {
+    const std::lock_guard<std::mutex> kLock(failure_mutex);
+    if (!failure)
+      failure = std::current_exception();
+  }
+
+  queue.Close();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (failure)
+    std::rethrow_exception(failure);
+
+  return read;
+}
+
+uint64_t ParallelScanGrouped(io::PbfFile* file,
+                             const proto::FileHeader& header,
+                             // NOLINTNEXTLINE(whitespace/indent_namespace)
+                             unsigned threads, const GroupOf& group,
+                             // NOLINTNEXTLINE(whitespace/indent_namespace)
+                             const Visitor& visitor) {
+  if (threads < 2)
+    return ParallelScan(file, header, threads, visitor);
+
+  const uint64_t kCount = header.count();
+  io::SetReadAhead(file, threads);
+  std::vector<std::unique_ptr<BoundedQueue<GroupedBatch>>> queues;
+  for (unsigned worker = 0; worker < threads; ++worker) {
+    queues.push_back(
+        std::make_unique<BoundedQueue<GroupedBatch>>(kBatchesPerWorker));
+  }
+  std::exception_ptr failure;
+  std::mutex failure_mutex;
+  auto fail = [&]() {
+    const std::lock_guard<std::mutex> kLock(failure_mutex);
+    if (!failure)
+      failure = std::current_exception();
+    for (auto& queue : queues) {
+      queue->Close();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (unsigned worker = 0; worker < threads; ++worker) {
+    workers.emplace_back([&, worker]() {
+      // A worker sees all messages of its groups in order, so its own
+      // decoder can rebuild delta encoded revisions.
+      io::FrameDecoder decoder(*file, header.type());
+      while (auto batch = queues[worker]->Pop()) {
+        try {
+          for (size_t i = 0; i < batch->frames.size(); ++i) {
+            visitor(worker, batch->ordinals[i],
+                    decoder.Decode(batch->frames[i]));
+          }
+        } catch (...) {
+          fail();
+        }
+      }
+    });
+  }
+
+  uint64_t read = 0;
+  try {
+    std::vector<GroupedBatch> pending(threads);
+    std::string frame;
+    bool open = true;
+    while (open && read < kCount) {
+      io::ReadFrame(file, &frame);
+      const auto kWorker = static_cast<unsigned>(group(frame) % threads);
+      auto& batch = pending[kWorker];
+      batch.ordinals.push_back(read++);
+      batch.frames.push_back(std::move(frame));
+      if (batch.frames.size() >= kBatchSize) {
+        open = queues[kWorker]->Push(std::move(batch));
+        batch = GroupedBatch{};
+      }
+    }
+    for (unsigned worker = 0; open && worker < threads; ++worker) {
+      if (!pending[worker].frames.empty())
+        open = queues[worker]->Push(std::move(pending[worker]));
+    }
+  } catch (...) {
+    fail();
+  }
+
+  for (auto& queue : queues) {
+    queue->Close();
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (failure)
+    std::rethrow_exception(failure);
+
+  return read;
+}
+
+}  // namespace wikiopencite::citescoop::cli::scan
@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_SCAN_H_
+#define SRC_SCAN_H_
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/message.h"
+
+#include "io.h"
+
+namespace wikiopencite::citescoop::cli::scan {
+
+/// @brief Callback run on a worker thread for every message.
+///
+/// @param worker Index of the worker in [0, threads). Callers keep one
+/// accumulator per worker and merge them once the scan has finished, so
+/// no locking is required inside the visitor.
+/// @param ordinal Position of the message in the file, starting at 0.
+/// @param message The decoded message, valid only during the call.
+using Visitor =
+    std::function<void(unsigned worker, uint64_t ordinal,
+                       const google::protobuf::Message& message)>;
+
+/// @brief Read every message following the header of a PBF file and
+/// hand them to worker threads in batches.
+///
+/// The calling thread only cuts the payload into frames (see
+/// io::ReadFrame); the workers decode them and run the visitor, so
+/// decoding, rebuilding delta encoded revisions and putting back
+/// interned strings all scale with the workers. The first exception
+/// thrown by a visitor stops the scan and is rethrown once all workers
+/// have been joined.
+///
+/// @param file File positioned directly after its header.
+/// @param header Header previously read from the file.
+/// @param threads Number of workers. Values below 2 run the visitor on
+/// the calling thread with a worker index of 0.
+/// @param visitor Callback to run for each message.
+/// @return Number of messages read.
+uint64_t ParallelScan(io::PbfFile* file,
+                      const wikiopencite::proto::FileHeader& header,
+                      unsigned threads, const Visitor& visitor);
+
+/// @brief Callback run on a worker thread for every frame of a file.
+///
+/// @param frame The message as stored in the file, see io::ReadFrame.
+/// @param message The decoded message if decoding was asked for, else
+/// null. Both are valid only during the call.
+using FrameVisitor = std::function<void(
+    unsigned worker, uint64_t ordinal, std::string_view frame,
+    const google::protobuf::Message* message)>;
+
+/// @brief ParallelScan for callers that need the stored bytes of each
+/// message, such as those measuring the wire format. Skipping decoding
+/// makes the scan little more than a read of the file.
+/// @param decode Whether to decode each frame for the visitor.
+uint64_t ParallelScanFrames(io::PbfFile* file,
+                            const wikiopencite::proto::FileHeader& header,
+                            unsigned threads, bool decode,
+                            const FrameVisitor& visitor);
+
+/// @brief Key of the group a message belongs to, read from its frame
+/// as stored in the file.
+using GroupOf = std::function<uint64_t(std::string_view frame)>;
+
+/// @brief ParallelScan for files whose messages come in groups that
+/// must each be visited in file order by a single worker, such as the
+/// revisions of a page.
+///
+/// Groups are spread over the workers by key and each worker has its
+/// own queue, so every message of a group reaches the same worker in
+/// file order however long the group is, and a worker may hold the
+/// state of its current group across calls. Group keys should repeat
+/// only within a group.
+///
+/// @param group Key of the group of a frame. It runs on the reading
+/// thread for every message, so should only peek at the frame, as with
+/// binary::WireVarint.
+uint64_t ParallelScanGrouped(io::PbfFile* file,
+                             const wikiopencite::proto::FileHeader& header,
+                             unsigned threads, const GroupOf& group,
+                             const Visitor& visitor);
+
+}  // namespace wikiopencite::citescoop::cli::scan
+
+#endif  // SRC_SCAN_H_
@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "space_saving.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+bool LargerFirst(const SpaceSaving::Entry& lhs,
+                 const SpaceSaving::Entry& rhs) {
+  if (lhs.count != rhs.count)
+    return lhs.count > rhs.count;
+  return lhs.key < rhs.key;
+}
+}  // namespace
+
+SpaceSaving::SpaceSaving(size_t capacity)
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    : capacity_(std::max<size_t>(capacity, 1)) {
+  heap_.reserve(capacity_);
+  positions_.reserve(capacity_);
+}
+
+void SpaceSaving::Add(const std::string& key) {
+  total_++;
+
+  auto found = positions_.find(key);
+  if (found != positions_.end()) {
+    heap_[found->second].count++;
+    SiftDown(found->second);
+    return;
+  }
+
+  if (heap_.size() < capacity_) {
+    heap_.push_back({key, 1, 0});
+    positions_.emplace(key, heap_.size() - 1);
+    SiftUp(heap_.size() - 1);
+    return;
+  }
+
+  // Evict the smallest counter and hand its count to the new key.
+  auto& smallest = heap_.front();
+  positions_.erase(smallest.key);
+  smallest.key = key;
+  smallest.error = smallest.count;
+  smallest.count++;
+  positions_.emplace(key, 0);
+  SiftDown(0);
+}
+
+void SpaceSaving::Merge(const SpaceSaving& other) {
+  const uint64_t kOwnMin = MinCount();
+  const uint64_t kOtherMin = other.MinCount();
+
+  std::vector<Entry> merged;
+  merged.reserve(heap_.size() + other.heap_.size());
+  for (const auto& entry : heap_) {
+    auto found = other.positions_.find(entry.key);
+    if (found == other.positions_.end()) {
+      merged.push_back(
+          {entry.key, entry.count + kOtherMin, entry.error + kOtherMin});
+    } else {
+      const auto& match = other.heap_[found->second];
+      merged.push_back(
+          {entry.key, entry.count + match.count, entry.error + match.error});
+    }
+  }
+  for (const auto& entry : other.heap_) {
+    if (!positions_.contains(entry.key)) {
+      merged.push_back(
+          {entry.key, entry.count + kOwnMin, entry.error + kOwnMin});
+    }
+  }
+
+  // Keys cut here count no more than the smallest kept, so MinCount
+  // still bounds every key not monitored.
+  if (merged.size() > capacity_) {
+    std::nth_element(merged.begin(),
+                     merged.begin() + static_cast<ptrdiff_t>(capacity_),
+                     merged.end(), LargerFirst);
+    merged.resize(capacity_);
+  }
+
+  total_ += other.total_;
+  heap_ = std::move(merged);
+  positions_.clear();
+  for (size_t i = 0; i < heap_.size(); ++i) {
+    positions_.emplace(heap_[i].key, i);
+  }
+  for (size_t i = heap_.size() / 2; i-- > 0;) {
+    SiftDown(i);
+  }
+}
+
+std::vector<SpaceSaving::Entry> SpaceSaving::Top(size_t k) const {
+  std::vector<Entry> top = heap_;
+  k = std::min(k, top.size());
+  std::partial_sort(top.begin(), top.begin() + static_cast<ptrdiff_t>(k),
+                    top.end(), LargerFirst);
+  top.resize(k);
+  return top;
+}
+
+uint64_t SpaceSaving::MinCount() const {
+  if (heap_.size() < capacity_)
+    return 0;
+  return heap_.front().count;
+}
+
+void SpaceSaving::SiftUp(size_t position) {
+  while (position > 0) {
+    const size_t kParent = (position - 1) / 2;
+    if (heap_[kParent].count <= heap_[position].count)
+      return;
+    Swap(kParent, position);
+    position = kParent;
+  }
+}
+
+void SpaceSaving::SiftDown(size_t position) {
+  while (true) {
+    const size_t kLeft = 2 * position + 1;
+    const size_t kRight = kLeft + 1;
+    size_t smallest = position;
+    if (kLeft < heap_.size() && heap_[kLeft].count < heap_[smallest].count)
+      smallest = kLeft;
+    if (kRight < heap_.size() && heap_[kRight].count < heap_[smallest].count)
+      smallest = kRight;
+    if (smallest == position)
+      return;
+    Swap(smallest, position);
+    position = smallest;
+  }
+}
+
+void SpaceSaving::Swap(size_t lhs, size_t rhs) {
+  std::swap(heap_[lhs], heap_[rhs]);
+  positions_[heap_[lhs].key] = lhs;
+  positions_[heap_[rhs].key] = rhs;
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_SPACE_SAVING_H_
+#define SRC_SPACE_SAVING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Space-Saving summary of the most frequent keys of a stream,
+/// in memory fixed by its capacity.
+///
+/// At most capacity keys are monitored. A key not yet monitored
+/// replaces the one with the smallest count and inherits that count as
+/// its error, so counts overestimate by at most their error and any key
+/// occurring more than total / capacity times is monitored. Summaries
+/// can be merged, allowing one per thread.
+class SpaceSaving {
+ public:
+  struct Entry {
+    std::string key;
+    uint64_t count;  ///< Upper bound of the true count.
+    uint64_t error;  ///< Most the count may overestimate by.
+  };
+
+  explicit SpaceSaving(size_t capacity);
+
+  /// @brief Count one occurrence of a key.
+  void Add(const std::string& key);
+
+  /// @brief Fold another summary into this one. Keys missing from one
+  /// side are charged that side's smallest count, which bounds how
+  /// often it could have seen them.
+  void Merge(const SpaceSaving& other);
+
+  /// @brief The k keys with the largest counts, largest first.
+  [[nodiscard]] std::vector<Entry> Top(size_t k) const;
+
+  /// @brief Upper bound of the count of any key not monitored.
+  [[nodiscard]] uint64_t MinCount() const;
+
+  [[nodiscard]] uint64_t total() const { return total_; }
+  [[nodiscard]] size_t size() const { return heap_.size(); }
+  [[nodiscard]] size_t capacity() const { return capacity_; }
+
+ private:
+  void SiftUp(size_t position);
+  void SiftDown(size_t position);
+  void Swap(size_t lhs, size_t rhs);
+
+  size_t capacity_;
+  uint64_t total_ = 0;
+
+  /// Monitored keys as a binary min heap on count.
+  std::vector<Entry> heap_;
+  std::unordered_map<std::string, size_t> positions_;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_SPACE_SAVING_H_
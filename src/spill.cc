@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "spill.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "boost/uuid/uuid.hpp"
+#include "boost/uuid/uuid_generators.hpp"
+#include "boost/uuid/uuid_io.hpp"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+#include "exceptions.h"
+#include "hash.h"
+
+namespace wikiopencite::citescoop::cli::spill {
+
+namespace {
+namespace fs = std::filesystem;
+
+/// Records are framed by a fixed size length so they can be read one
+/// at a time from a stream.
+constexpr size_t kLengthSize = 4;
+}  // namespace
+
+Directory::Directory(const fs::path& parent, std::string_view prefix)
+    : path_(parent / (std::string(prefix) + "-" +
+                      boost::uuids::to_string(
+                          boost::uuids::random_generator()()))) {
+  fs::create_directories(path_);
+}
+
+Directory::~Directory() {
+  std::error_code err;
+  fs::remove_all(path_, err);
+  if (err)
+    spdlog::warn("Failed to remove temporary directory: {}", path_.string());
+}
+
+size_t PartitionFor(std::string_view key, size_t partitions, unsigned level) {
+  // Use the high half so the partition does not correlate with the
+  // bucket the key lands in inside the partition's own table.
+  return static_cast<size_t>(hash::Bytes64(key, level) >> 32U) % partitions;
+}
+
+Files::Files(fs::path directory, std::string name, size_t partitions)
+    : directory_(std::move(directory)), name_(std::move(name)) {
+  for (size_t i = 0; i < partitions; ++i) {
+    partitions_.push_back(std::make_unique<Partition>());
+  }
+}
+
+void Files::PutRecord(std::string* buffer, std::string_view key,
+                      std::string_view value) {
+  std::string record;
+  binary::PutString(&record, key);
+  record.append(value);
+  binary::PutFixed32(buffer, static_cast<uint32_t>(record.size()));
+  buffer->append(record);
+}
+
+void Files::Append(size_t partition, std::string_view records,
+                   size_t memory) {
+  if (records.empty())
+    return;
+
+  auto& spill = *partitions_[partition];
+  const std::lock_guard<std::mutex> kLock(spill.mutex);
+  if (!spill.used) {
+    spill.stream = std::ofstream(
+        Path(partition), std::ios::out | std::ios::binary | std::ios::trunc);
+    spill.used = true;
+  }
+
+  spill.stream.write(records.data(),
+                     static_cast<std::streamsize>(records.size()));
+  if (!spill.stream) {
+    throw exceptions::CliException(
+        fmt::format("failed to write spill file in {}", directory_.string()));
+  }
+  spill.memory += memory;
+  spill.bytes += records.size();
+}
+
+void Files::Close() {
+  for (auto& spill : partitions_) {
+    if (spill->used)
+      spill->stream.close();
+  }
+}
+
+void Files::Read(
+    size_t partition,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const std::function<void(std::string_view, std::string_view)>& visit)
+    const {
+  if (!partitions_[partition]->used)
+    return;
+
+  const auto kFailed = [this]() {
+    return exceptions::CliException(
+        fmt::format("failed to read spill file in {}", directory_.string()));
+  };
+
+  std::ifstream stream(Path(partition), std::ios::in | std::ios::binary);
+  std::array<char, kLengthSize> length{};
+  std::string record;
+  while (stream.read(length.data(), length.size())) {
+    binary::Reader prefix(std::string_view(length.data(), length.size()));
+    record.resize(prefix.Fixed32());
+    if (!stream.read(record.data(),
+                     static_cast<std::streamsize>(record.size())))
+      throw kFailed();
+
+    binary::Reader reader(record);
+    const auto kKey = reader.String();
+    visit(kKey, std::string_view(record).substr(reader.position()));
+  }
+
+  // Only a clean end of file between records ends the loop.
+  if (!stream.eof() || stream.gcount() != 0)
+    throw kFailed();
+}
+
+void Files::Remove(size_t partition) {
+  auto& spill = *partitions_[partition];
+  if (!spill.used)
+    return;
+
+  spill.used = false;
+  spill.memory = 0;
+  spill.bytes = 0;
+  std::error_code err;
+  fs::remove(Path(partition), err);
+}
+
+fs::path Files::Path(size_t partition) const {
+  return directory_ / fmt::format("{}-{}.spill", name_, partition);
+}
+
+}  // namespace wikiopencite::citescoop::cli::spill
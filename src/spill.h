@@ -0,0 +1,393 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_SPILL_H_
+#define SRC_SPILL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "binary.h"
+
+/// Hash tables that spill to disk, shared by the commands aggregating
+/// more keys than fit in memory.
+///
+/// Every worker thread owns a table per partition, chosen by key hash.
+/// When a worker passes its share of the memory limit its largest
+/// partition is appended to that partition's spill file. Once the scan
+/// is done each partition is merged across workers and its spill file.
+/// A partition whose merge would not fit in its share of the limit is
+/// first split again by a differently seeded hash, recursively, so the
+/// merge stays bounded however skewed the keys are.
+namespace wikiopencite::citescoop::cli::spill {
+
+/// @brief Uniquely named temporary directory, removed with everything
+/// in it when destroyed, however the command using it ends.
+class Directory {
+ public:
+  /// @brief Create a directory named prefix followed by a random id.
+  Directory(const std::filesystem::path& parent, std::string_view prefix);
+  ~Directory();
+
+  Directory(const Directory&) = delete;
+  Directory& operator=(const Directory&) = delete;
+
+  [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+
+ private:
+  std::filesystem::path path_;
+};
+
+/// @brief Partition of a key. Each level of splitting hashes with its
+/// own seed, so the keys of one partition spread over the next level.
+size_t PartitionFor(std::string_view key, size_t partitions,
+                    unsigned level = 0);
+
+/// @brief Spill files of a set of partitions, written concurrently by
+/// the workers. Each record is a key and its encoded value.
+class Files {
+ public:
+  Files(std::filesystem::path directory, std::string name,
+        size_t partitions);
+
+  /// @brief Append a record to a buffer for Append.
+  static void PutRecord(std::string* buffer, std::string_view key,
+                        std::string_view value);
+
+  /// @brief Append records to a partition's file. Thread safe.
+  /// @param memory Estimated memory the records held as table entries.
+  /// @throws exceptions::CliException if the file cannot be written.
+  void Append(size_t partition, std::string_view records, size_t memory);
+
+  /// @brief Close the files, once every record has been appended.
+  void Close();
+
+  /// @brief Call visit(key, value) for each record of a partition, in
+  /// the order they were appended.
+  void Read(size_t partition,
+            const std::function<void(std::string_view, std::string_view)>&
+                visit) const;
+
+  /// @brief Delete a partition's file once it has been merged.
+  void Remove(size_t partition);
+
+  [[nodiscard]] size_t partitions() const { return partitions_.size(); }
+
+  /// @brief Estimated memory of a partition's records, as given to
+  /// Append.
+  [[nodiscard]] size_t memory(size_t partition) const {
+    return partitions_[partition]->memory;
+  }
+
+  /// @brief Bytes appended to a partition's file.
+  [[nodiscard]] uint64_t bytes(size_t partition) const {
+    return partitions_[partition]->bytes;
+  }
+
+  /// @brief Name of the files, unique within the directory.
+  [[nodiscard]] const std::string& name() const { return name_; }
+
+  [[nodiscard]] const std::filesystem::path& directory() const {
+    return directory_;
+  }
+
+ private:
+  struct Partition {
+    std::mutex mutex;
+    std::ofstream stream;
+    bool used = false;
+    size_t memory = 0;
+    uint64_t bytes = 0;
+  };
+
+  [[nodiscard]] std::filesystem::path Path(size_t partition) const;
+
+  std::filesystem::path directory_;
+  std::string name_;
+  std::vector<std::unique_ptr<Partition>> partitions_;
+};
+
+/// @brief Tables of every worker, split into partitions that spill to
+/// disk past a memory limit.
+///
+/// Codec describes the values:
+///   static void Encode(const Value& value, std::string* output);
+///   static Value Decode(std::string_view encoded);
+///   static void Merge(Value* into, Value&& from);
+///   static size_t Size(const std::string& key, const Value& value);
+/// where Size estimates the memory an entry holds in a table.
+template <typename Value, typename Codec>
+class PartitionedTables {
+ public:
+  using Table = std::unordered_map<std::string, Value>;
+
+  /// @brief Called with the merged tables of one partition of each
+  /// set, or of a part of it holding the same keys in every set.
+  using Visitor = std::function<void(std::vector<Table>* tables)>;
+
+  /// @param directory Where the spill files are written.
+  /// @param name Name of the spill files, unique within the directory.
+  /// @param memory_limit Memory budget in bytes, shared by the workers
+  /// while scanning and by the partitions merged at once afterwards.
+  PartitionedTables(const std::filesystem::path& directory, std::string name,
+                    unsigned workers, size_t partitions, size_t memory_limit)
+      : workers_(std::max(workers, 1U)),
+        worker_limit_(memory_limit / workers_.size()),
+        files_(directory, std::move(name), partitions) {
+    for (auto& worker : workers_) {
+      worker.partitions.resize(partitions);
+    }
+  }
+
+  /// @brief The table of a worker's partition that holds key.
+  Table& TableFor(unsigned worker, const std::string& key) {
+    return workers_[worker]
+        .partitions[PartitionFor(key, files_.partitions())];
+  }
+
+  /// @brief Account for memory added to a worker's tables, spilling its
+  /// largest partition if it is over its share of the limit.
+  void Grow(unsigned worker, size_t bytes) {
+    auto& tables = workers_[worker];
+    tables.memory += bytes;
+    if (tables.memory > worker_limit_)
+      SpillLargest(&tables);
+  }
+
+  /// @brief Close the spill files, once the scan has finished.
+  void Close() { files_.Close(); }
+
+  [[nodiscard]] size_t partitions() const { return files_.partitions(); }
+
+  /// @brief Merge a partition of every set across workers and spill
+  /// files, splitting it first if it would not fit in the sets' share
+  /// of the limit. All sets must have the same number of partitions.
+  static void Merge(std::span<PartitionedTables* const> sets,
+                    size_t partition, const Visitor& visit) {
+    std::vector<Source> sources;
+    size_t budget = 0;
+    for (auto* set : sets) {
+      Source source{&set->files_, partition, {}};
+      for (auto& worker : set->workers_) {
+        source.tables.push_back(&worker.partitions[partition]);
+      }
+      sources.push_back(std::move(source));
+      budget += set->worker_limit_;
+    }
+
+    MergeSources(&sources, 0, budget, visit);
+    for (auto* set : sets) {
+      set->files_.Remove(partition);
+    }
+  }
+
+ private:
+  /// Partitions a partition too large to merge is split into.
+  static constexpr size_t kFanOut = 16;
+
+  /// Levels of splitting before merging regardless, reached only if a
+  /// few keys hold most of the memory.
+  static constexpr unsigned kMaxLevel = 4;
+
+  /// Bytes of records buffered per partition while splitting.
+  static constexpr size_t kSplitBufferSize = size_t{1} << 20U;
+
+  struct WorkerTables {
+    std::vector<Table> partitions;
+    size_t memory = 0;
+  };
+
+  /// @brief Where the entries of a partition of one set are held.
+  struct Source {
+    const Files* files;
+    size_t partition;
+    std::vector<Table*> tables;
+  };
+
+  void SpillLargest(WorkerTables* tables) {
+    auto largest = std::max_element(
+        tables->partitions.begin(), tables->partitions.end(),
+        [](const Table& lhs, const Table& rhs) {
+          return lhs.size() < rhs.size();
+        });
+    const auto kPartition = static_cast<size_t>(
+        std::distance(tables->partitions.begin(), largest));
+
+    spdlog::debug("Spilling {} partition {} with {} keys", files_.name(),
+                  kPartition, largest->size());
+
+    std::string records;
+    std::string value;
+    size_t freed = 0;
+    for (const auto& [key, entry] : *largest) {
+      value.clear();
+      Codec::Encode(entry, &value);
+      Files::PutRecord(&records, key, value);
+      freed += Codec::Size(key, entry);
+    }
+    files_.Append(kPartition, records, freed);
+
+    Table().swap(*largest);
+    tables->memory -= std::min(freed, tables->memory);
+  }
+
+  static size_t Memory(const Source& source) {
+    size_t memory = source.files->memory(source.partition);
+    for (const auto* table : source.tables) {
+      for (const auto& [key, entry] : *table) {
+        memory += Codec::Size(key, entry);
+      }
+    }
+    return memory;
+  }
+
+  static void MergeSources(std::vector<Source>* sources, unsigned level,
+                           size_t budget, const Visitor& visit) {
+    size_t memory = 0;
+    for (const auto& source : *sources) {
+      memory += Memory(source);
+    }
+
+    if (memory <= budget || level >= kMaxLevel) {
+      std::vector<Table> merged;
+      for (auto& source : *sources) {
+        merged.push_back(Load(&source));
+      }
+      visit(&merged);
+      return;
+    }
+
+    spdlog::debug("Splitting {} partition {} of about {} bytes",
+                  sources->front().files->name(), sources->front().partition,
+                  memory);
+
+    // Every set is split the same way, so each part holds the same keys
+    // in all of them.
+    std::vector<std::unique_ptr<Files>> parts;
+    for (auto& source : *sources) {
+      parts.push_back(Split(&source, level + 1));
+    }
+
+    for (size_t part = 0; part < kFanOut; ++part) {
+      std::vector<Source> next;
+      for (const auto& files : parts) {
+        next.push_back({files.get(), part, {}});
+      }
+      MergeSources(&next, level + 1, budget, visit);
+      for (const auto& files : parts) {
+        files->Remove(part);
+      }
+    }
+  }
+
+  /// @brief Move every entry of a source into one table.
+  static Table Load(Source* source) {
+    Table merged;
+    if (!source->tables.empty()) {
+      merged = std::move(*source->tables.front());
+      *source->tables.front() = Table();
+    }
+    for (size_t i = 1; i < source->tables.size(); ++i) {
+      Table table = std::move(*source->tables[i]);
+      *source->tables[i] = Table();
+      for (auto& [key, entry] : table) {
+        Add(&merged, key, std::move(entry));
+      }
+    }
+
+    source->files->Read(source->partition, [&merged](std::string_view key,
+                                                     std::string_view value) {
+      Add(&merged, std::string(key), Codec::Decode(value));
+    });
+    return merged;
+  }
+
+  static void Add(Table* table, const std::string& key, Value&& entry) {
+    auto found = table->find(key);
+    if (found == table->end()) {
+      table->emplace(key, std::move(entry));
+    } else {
+      Codec::Merge(&found->second, std::move(entry));
+    }
+  }
+
+  /// @brief Write the entries of a source to kFanOut new spill files by
+  /// their partition at the given level, freeing its tables.
+  static std::unique_ptr<Files> Split(Source* source, unsigned level) {
+    auto parts = std::make_unique<Files>(
+        source->files->directory(),
+        source->files->name() + "-" + std::to_string(source->partition),
+        kFanOut);
+
+    std::vector<std::string> buffers(kFanOut);
+    std::vector<double> memory(kFanOut);
+    auto flush = [&](size_t part) {
+      parts->Append(part, buffers[part], static_cast<size_t>(memory[part]));
+      buffers[part].clear();
+      memory[part] = 0;
+    };
+
+    std::string value;
+    for (auto* table : source->tables) {
+      for (const auto& [key, entry] : *table) {
+        const size_t kPart = PartitionFor(key, kFanOut, level);
+        value.clear();
+        Codec::Encode(entry, &value);
+        Files::PutRecord(&buffers[kPart], key, value);
+        memory[kPart] += static_cast<double>(Codec::Size(key, entry));
+        if (buffers[kPart].size() >= kSplitBufferSize)
+          flush(kPart);
+      }
+      Table().swap(*table);
+    }
+
+    // Spilled records are copied without decoding, each taking a share
+    // of the partition's memory in proportion to its size.
+    const auto& kFiles = *source->files;
+    const size_t kPartition = source->partition;
+    const double kMemoryPerByte =
+        kFiles.bytes(kPartition) == 0
+            ? 0
+            : static_cast<double>(kFiles.memory(kPartition)) /
+                  static_cast<double>(kFiles.bytes(kPartition));
+    kFiles.Read(kPartition, [&](std::string_view key,
+                                std::string_view encoded) {
+      const size_t kPart = PartitionFor(key, kFanOut, level);
+      const size_t kBefore = buffers[kPart].size();
+      Files::PutRecord(&buffers[kPart], key, encoded);
+      memory[kPart] += kMemoryPerByte *
+                       static_cast<double>(buffers[kPart].size() - kBefore);
+      if (buffers[kPart].size() >= kSplitBufferSize)
+        flush(kPart);
+    });
+
+    for (size_t part = 0; part < kFanOut; ++part) {
+      flush(part);
+    }
+    parts->Close();
+    return parts;
+  }
+
+  std::vector<WorkerTables> workers_;
+  size_t worker_limit_;
+  Files files_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::spill
+
+#endif  // SRC_SPILL_H_
@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "string_dictionary.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/unknown_field_set.h"
+
+#include "binary.h"
+#include "exceptions.h"
+#include "header.h"
+
+namespace wikiopencite::citescoop::cli {
+
+namespace {
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+}  // namespace
+
+std::optional<StringDictionary> StringDictionary::FromHeader(
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const proto::FileHeader& header) {
+  const auto kStored =
+      header::GetBytes(header, header::kStringDictionaryField);
+  if (!kStored)
+    return std::nullopt;
+
+  StringDictionary dictionary;
+  binary::Reader reader(*kStored);
+  const uint64_t kCount = reader.Varint();
+  for (uint64_t i = 0; i < kCount; ++i) {
+    dictionary.Add(reader.String());
+  }
+  if (!reader.empty() || dictionary.size() != kCount)
+    throw exceptions::UserInputException("corrupt string dictionary");
+  return dictionary;
+}
+
+void StringDictionary::Save(proto::FileHeader* header) const {
+  std::string stored;
+  binary::PutVarint(&stored, strings_.size());
+  for (const auto& value : strings_) {
+    binary::PutString(&stored, value);
+  }
+  header::SetBytes(header, header::kStringDictionaryField, stored);
+}
+
+uint64_t StringDictionary::Add(std::string_view value) {
+  const auto kFound = ids_.find(value);
+  if (kFound != ids_.end())
+    return kFound->second;
+
+  const uint64_t kId = strings_.size();
+  strings_.emplace_back(value);
+  ids_.emplace(strings_.back(), kId);
+  return kId;
+}
+
+std::optional<uint64_t> StringDictionary::Find(std::string_view value) const {
+  const auto kFound = ids_.find(value);
+  if (kFound == ids_.end())
+    return std::nullopt;
+  return kFound->second;
+}
+
+const std::string& StringDictionary::Lookup(uint64_t id) const {
+  if (id >= strings_.size()) {
+    throw exceptions::UserInputException(
+        fmt::format("string id {} is not in the dictionary", id).c_str());
+  }
+  return strings_[id];
+}
+
+void StringDictionary::Encode(pb::Message* message) const {
+  const auto* reflection = message->GetReflection();
+  std::vector<const pb::FieldDescriptor*> fields;
+  reflection->ListFields(*message, &fields);
+
+  for (const auto* field : fields) {
+    if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        const int kSize = reflection->FieldSize(*message, field);
+        for (int i = 0; i < kSize; ++i) {
+          Encode(reflection->MutableRepeatedMessage(message, field, i));
+        }
+      } else {
+        Encode(reflection->MutableMessage(message, field));
+      }
+      continue;
+    }
+
+    if (!Internable(field))
+      continue;
+    const auto kId = Find(reflection->GetString(*message, field));
+    if (!kId)
+      continue;
+    reflection->ClearField(message, field);
+    reflection->MutableUnknownFields(message)->AddVarint(field->number(),
+                                                         *kId);
+  }
+}
+
+void StringDictionary::Rehydrate(pb::Message* message) const {
+  const auto* reflection = message->GetReflection();
+  const auto* descriptor = message->GetDescriptor();
+
+  auto* unknown = reflection->MutableUnknownFields(message);
+  if (!unknown->empty()) {
+    std::vector<int> rehydrated;
+    for (int i = 0; i < unknown->field_count(); ++i) {
+      const auto& id = unknown->field(i);
+      if (id.type() != pb::UnknownField::TYPE_VARINT)
+        continue;
+      const auto* field = descriptor->FindFieldByNumber(id.number());
+      if (field == nullptr || !Internable(field))
+        continue;
+      reflection->SetString(message, field, Lookup(id.varint()));
+      rehydrated.push_back(id.number());
+    }
+    for (const int kNumber : rehydrated) {
+      unknown->DeleteByNumber(kNumber);
+    }
+  }
+
+  std::vector<const pb::FieldDescriptor*> fields;
+  reflection->ListFields(*message, &fields);
+  for (const auto* field : fields) {
+    if (field->cpp_type() != pb::FieldDescriptor::CPPTYPE_MESSAGE)
+      continue;
+    if (field->is_repeated()) {
+      const int kSize = reflection->FieldSize(*message, field);
+      for (int i = 0; i < kSize; ++i) {
+        Rehydrate(reflection->MutableRepeatedMessage(message, field, i));
+      }
+    } else {
+      Rehydrate(reflection->MutableMessage(message, field));
+    }
+  }
+}
+
+std::optional<uint64_t> StringDictionary::IdOf(
+    const pb::Message& message,
+    // NOLINTNEXTLINE(whitespace/indent_namespace)
+    const pb::FieldDescriptor* field) {
+  const auto& unknown = message.GetReflection()->GetUnknownFields(message);
+  for (int i = unknown.field_count() - 1; i >= 0; --i) {
+    const auto& id = unknown.field(i);
+    if (id.number() == field->number() &&
+        id.type() == pb::UnknownField::TYPE_VARINT)
+      return id.varint();
+  }
+  return std::nullopt;
+}
+
+bool StringDictionary::Internable(const pb::FieldDescriptor* field) {
+  return field->cpp_type() == pb::FieldDescriptor::CPPTYPE_STRING &&
+         !field->is_repeated();
+}
+
+}  // namespace wikiopencite::citescoop::cli
@@ -0,0 +1,81 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_STRING_DICTIONARY_H_
+#define SRC_STRING_DICTIONARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+/// Dictionary of strings repeated across the messages of a PBF file.
+///
+/// The dictionary is stored in the header attribute
+/// header::kStringDictionaryField as a varint count followed by the
+/// strings, each a varint length and its bytes. A singular string field
+/// of a message whose value is in the dictionary is written as a varint
+/// of the same field number holding its id instead. Parsers keep a
+/// field with an unexpected wire type as an unknown field, so encoded
+/// messages still parse against the schema with the field unset, and
+/// io::ReadGenericMessage puts the strings back as it reads unless the
+/// caller asks for the ids.
+namespace wikiopencite::citescoop::cli {
+
+class StringDictionary {
+ public:
+  /// @brief The dictionary stored in a header, if there is one.
+  /// @throws exceptions::UserInputException if it is corrupt.
+  static std::optional<StringDictionary> FromHeader(
+      const wikiopencite::proto::FileHeader& header);
+
+  /// @brief Store the dictionary in a header.
+  void Save(wikiopencite::proto::FileHeader* header) const;
+
+  /// @brief Intern a string, returning its id. Ids are given in order
+  /// from 0, so the first strings added get the shortest ids.
+  uint64_t Add(std::string_view value);
+
+  /// @brief The id of a string, if it is interned.
+  [[nodiscard]] std::optional<uint64_t> Find(std::string_view value) const;
+
+  /// @brief The string with the given id.
+  /// @throws exceptions::UserInputException if there is none.
+  [[nodiscard]] const std::string& Lookup(uint64_t id) const;
+
+  /// @brief Replace the interned strings of a message and the messages
+  /// nested in it by their ids.
+  void Encode(google::protobuf::Message* message) const;
+
+  /// @brief Replace the ids of a message and the messages nested in it
+  /// by their strings.
+  /// @throws exceptions::UserInputException for an unknown id.
+  void Rehydrate(google::protobuf::Message* message) const;
+
+  /// @brief The id a field of a message that has not been rehydrated
+  /// refers to, if its value is interned.
+  static std::optional<uint64_t> IdOf(
+      const google::protobuf::Message& message,
+      const google::protobuf::FieldDescriptor* field);
+
+  /// @brief Whether a field may be interned: a singular string or
+  /// bytes field.
+  static bool Internable(const google::protobuf::FieldDescriptor* field);
+
+  [[nodiscard]] size_t size() const { return strings_.size(); }
+
+ private:
+  std::deque<std::string> strings_;  ///< Stable, ids_ points into it.
+  std::unordered_map<std::string_view, uint64_t> ids_;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_STRING_DICTIONARY_H_
@@ -0,0 +1,481 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "synthetic.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "fmt/format.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#include "fields.h"
+
+namespace wikiopencite::citescoop::cli::synthetic {
+
+namespace {
+namespace pb = google::protobuf;
+namespace proto = wikiopencite::proto;
+
+const char* const kTimestampType = "google.protobuf.Timestamp";
+const char* const kSecondsField = "seconds";
+const char* const kUrlField = "url";
+const char* const kTemplateLeaf = "template";
+const char* const kIdsSuffix = "_ids";
+const char* const kYearSuffix = "year";
+
+// 2001-01-15, the day Wikipedia launched, to 2026-01-01.
+constexpr int64_t kFirstTimestamp = 979516800;
+constexpr int64_t kLastTimestamp = 1767225600;
+
+constexpr int64_t kFirstYear = 1900;
+constexpr int64_t kLastYear = 2025;
+
+constexpr uint64_t kRevisionsPerPage = 16;
+constexpr uint64_t kMaxRevisionId = 1300000000;
+constexpr uint64_t kOpenAlexIdBase = 1000000000;
+constexpr uint64_t kMaxRandomId = 100000000;
+constexpr uint64_t kMaxRandomInt = 1000;
+constexpr uint64_t kDoiRegistrants = 40000;
+constexpr uint64_t kFirstDoiRegistrant = 1000;
+constexpr uint64_t kUrlHosts = 5000;
+
+// Share of nested and top level messages with a DOI.
+constexpr double kNestedDoiRate = 0.4;
+constexpr double kTopLevelDoiRate = 0.85;
+
+// Citations per message: a third have none, the rest are log-normal
+// with a median of about five and a long tail.
+constexpr double kNoCitationRate = 0.3;
+constexpr double kCitationMu = 1.6;
+constexpr double kCitationSigma = 1.1;
+constexpr size_t kMaxCitations = 500;
+
+// Other repeated messages and id lists.
+constexpr double kListMu = 1.0;
+constexpr double kListSigma = 0.8;
+constexpr size_t kMaxList = 50;
+constexpr size_t kMaxScalarList = 4;
+
+// Words per free text string.
+constexpr double kWordsMu = 1.8;
+constexpr double kWordsSigma = 0.6;
+constexpr size_t kMaxWords = 64;
+
+// Bytes per bytes field.
+constexpr double kBytesMu = 4.0;
+constexpr double kBytesSigma = 1.0;
+constexpr size_t kMaxBytes = 4096;
+
+constexpr size_t kMaxDepth = 3;
+
+constexpr std::array<std::string_view, 15> kTemplates = {
+    "cite web",         "cite news",       "cite book",
+    "cite journal",     "cite magazine",   "cite av media",
+    "cite report",      "cite conference", "cite thesis",
+    "cite encyclopedia", "cite press release", "cite episode",
+    "citation",         "cite arxiv",      "cite tweet",
+};
+
+constexpr std::array<std::string_view, 48> kWords = {
+    "the",      "of",       "and",      "history",  "national", "university",
+    "journal",  "review",   "science",  "new",      "world",    "report",
+    "annual",   "city",     "river",    "church",   "war",      "music",
+    "album",    "football", "club",     "season",   "election", "party",
+    "species",  "genus",    "family",   "station",  "railway",  "school",
+    "county",   "district", "village",  "museum",   "art",      "film",
+    "series",   "league",   "cup",      "championship", "research", "analysis",
+    "study",    "effects",  "society",  "press",    "times",    "archive",
+};
+
+constexpr uint64_t kGolden = 0x9e3779b97f4a7c15ULL;
+constexpr uint64_t kOrdinalMultiplier = 0xd1b54a32d192ed03ULL;
+constexpr unsigned kMantissaShift = 11;
+constexpr double kMantissaScale = 0x1.0p-53;
+
+int64_t ToInt(const fields::Value& value) {
+  return std::visit(
+      [](const auto& held) -> int64_t {
+        using T = std::decay_t<decltype(held)>;
+        if constexpr (std::is_arithmetic_v<T>) {
+          return static_cast<int64_t>(held);
+        } else {
+          return 0;
+        }
+      },
+      value);
+}
+
+double ToDouble(const fields::Value& value) {
+  if (const auto* real = std::get_if<double>(&value))
+    return *real;
+  return static_cast<double>(ToInt(value));
+}
+
+void SetScalar(pb::Message* message, const pb::FieldDescriptor* field,
+               const fields::Value& value) {
+  const auto* reflection = message->GetReflection();
+  const bool kRepeated = field->is_repeated();
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_INT32: {
+      const auto kValue = static_cast<int32_t>(ToInt(value));
+      kRepeated ? reflection->AddInt32(message, field, kValue)
+                : reflection->SetInt32(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_INT64: {
+      const int64_t kValue = ToInt(value);
+      kRepeated ? reflection->AddInt64(message, field, kValue)
+                : reflection->SetInt64(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT32: {
+      const auto kValue = static_cast<uint32_t>(ToInt(value));
+      kRepeated ? reflection->AddUInt32(message, field, kValue)
+                : reflection->SetUInt32(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT64: {
+      const auto kValue = static_cast<uint64_t>(ToInt(value));
+      kRepeated ? reflection->AddUInt64(message, field, kValue)
+                : reflection->SetUInt64(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE: {
+      const double kValue = ToDouble(value);
+      kRepeated ? reflection->AddDouble(message, field, kValue)
+                : reflection->SetDouble(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_FLOAT: {
+      const auto kValue = static_cast<float>(ToDouble(value));
+      kRepeated ? reflection->AddFloat(message, field, kValue)
+                : reflection->SetFloat(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_BOOL: {
+      const bool kValue = ToInt(value) != 0;
+      kRepeated ? reflection->AddBool(message, field, kValue)
+                : reflection->SetBool(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_ENUM: {
+      const auto kValue = static_cast<int>(ToInt(value));
+      kRepeated ? reflection->AddEnumValue(message, field, kValue)
+                : reflection->SetEnumValue(message, field, kValue);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_STRING: {
+      const auto* text = std::get_if<std::string>(&value);
+      std::string copy = text != nullptr ? *text : std::string();
+      kRepeated ? reflection->AddString(message, field, std::move(copy))
+                : reflection->SetString(message, field, std::move(copy));
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+}
+
+bool EndsWith(const std::string& text, std::string_view suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+/// Small splitmix64 generator. Seeding a fresh one per message is far
+/// cheaper than seeding a Mersenne twister.
+class Synthesizer::Random {
+ public:
+  explicit Random(uint64_t state) : state_(state) {}
+
+  uint64_t Next() {
+    uint64_t value = (state_ += kGolden);
+    value = (value ^ (value >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27U)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31U);
+  }
+
+  /// Uniform in [0, bound).
+  uint64_t Uniform(uint64_t bound) { return bound == 0 ? 0 : Next() % bound; }
+
+  /// Uniform in [0, 1).
+  double Real() {
+    return static_cast<double>(Next() >> kMantissaShift) * kMantissaScale;
+  }
+
+  bool Chance(double probability) { return Real() < probability; }
+
+  double Normal() {
+    const double kU1 = 1.0 - Real();
+    const double kU2 = Real();
+    return std::sqrt(-2.0 * std::log(kU1)) *
+           std::cos(2.0 * std::numbers::pi * kU2);
+  }
+
+  size_t LogNormal(double mu, double sigma, size_t max) {
+    const double kValue = std::exp(mu + sigma * Normal());
+    return std::min(static_cast<size_t>(std::llround(kValue)), max);
+  }
+
+  /// Index into a list of size entries with probability proportional
+  /// to 1 / (index + 1).
+  size_t Zipf(size_t size) {
+    double total = 0;
+    for (size_t i = 0; i < size; ++i) {
+      total += 1.0 / static_cast<double>(i + 1);
+    }
+    double target = Real() * total;
+    for (size_t i = 0; i < size; ++i) {
+      target -= 1.0 / static_cast<double>(i + 1);
+      if (target < 0)
+        return i;
+    }
+    return size - 1;
+  }
+
+  std::string Words(size_t count) {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+      if (i > 0)
+        text.push_back(' ');
+      text.append(kWords[Uniform(kWords.size())]);
+    }
+    if (!text.empty())
+      text[0] = static_cast<char>(std::toupper(text[0]));
+    return text;
+  }
+
+ private:
+  uint64_t state_;
+};
+
+Synthesizer::Synthesizer(proto::FileType file_type, uint64_t seed,
+                         // NOLINTNEXTLINE(whitespace/indent_namespace)
+                         double duplicate_rate)
+    : file_type_(file_type), seed_(seed), duplicate_rate_(duplicate_rate) {
+  switch (file_type) {
+    case proto::FileType::FILE_TYPE_PAGES:
+      primary_id_ = fields::kPageIdField;
+      id_prefix_ = 'P';
+      break;
+    case proto::FileType::FILE_TYPE_REVISIONS:
+      primary_id_ = fields::kRevisionIdField;
+      id_prefix_ = 'R';
+      break;
+    case proto::FileType::FILE_TYPE_OPENALEX_AUTHORS:
+      primary_id_ = fields::kOpenAlexIdField;
+      id_prefix_ = 'A';
+      break;
+    case proto::FileType::FILE_TYPE_OPENALEX_INSTITUTIONS:
+      primary_id_ = fields::kOpenAlexIdField;
+      id_prefix_ = 'I';
+      break;
+    default:
+      primary_id_ = fields::kOpenAlexIdField;
+      id_prefix_ = 'W';
+      break;
+  }
+}
+
+void Synthesizer::Fill(uint64_t ordinal, pb::Message* message) const {
+  Random random(seed_ ^ (ordinal * kOrdinalMultiplier));
+  FillMessage(ordinal, 0, &random, message);
+}
+
+void Synthesizer::FillMessage(uint64_t ordinal, size_t depth, Random* random,
+                              // NOLINTNEXTLINE(whitespace/indent_namespace)
+                              pb::Message* message) const {
+  const auto* descriptor = message->GetDescriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    FillField(ordinal, depth, random, descriptor->field(i), message);
+  }
+}
+
+void Synthesizer::FillField(uint64_t ordinal, size_t depth, Random* random,
+                            const pb::FieldDescriptor* field,
+                            // NOLINTNEXTLINE(whitespace/indent_namespace)
+                            pb::Message* message) const {
+  const std::string& name = field->name();
+  const auto* reflection = message->GetReflection();
+
+  if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+    if (field->message_type()->full_name() == kTimestampType) {
+      auto* timestamp = field->is_repeated()
+                            ? reflection->AddMessage(message, field)
+                            : reflection->MutableMessage(message, field);
+      const auto* seconds =
+          timestamp->GetDescriptor()->FindFieldByName(kSecondsField);
+      if (seconds != nullptr) {
+        const double kRecent = std::sqrt(random->Real());
+        timestamp->GetReflection()->SetInt64(
+            timestamp, seconds,
+            kFirstTimestamp +
+                static_cast<int64_t>(
+                    kRecent * static_cast<double>(kLastTimestamp -
+                                                  kFirstTimestamp)));
+      }
+      return;
+    }
+
+    if (depth >= kMaxDepth)
+      return;
+
+    if (!field->is_repeated()) {
+      FillMessage(ordinal, depth + 1, random,
+                  reflection->MutableMessage(message, field));
+      return;
+    }
+
+    const size_t kCount = RepeatCount(field, random);
+    for (size_t i = 0; i < kCount; ++i) {
+      FillMessage(ordinal, depth + 1, random,
+                  reflection->AddMessage(message, field));
+    }
+    return;
+  }
+
+  const size_t kCount = field->is_repeated() ? RepeatCount(field, random) : 1;
+  for (size_t i = 0; i < kCount; ++i) {
+    fields::Value value;
+
+    if (depth == 0 && name == primary_id_) {
+      if (name == fields::kOpenAlexIdField) {
+        uint64_t source = ordinal;
+        if (ordinal > 0 && random->Chance(duplicate_rate_))
+          source = random->Uniform(ordinal);
+        value = fmt::format("{}{}", id_prefix_, kOpenAlexIdBase + source);
+      } else {
+        value = static_cast<int64_t>(ordinal + 1);
+      }
+    } else if (name == fields::kOpenAlexIdField) {
+      value = fmt::format("{}{}", id_prefix_,
+                          kOpenAlexIdBase + random->Uniform(kMaxRandomId));
+    } else if (depth == 0 && name == fields::kTimestampField &&
+               file_type_ == proto::FileType::FILE_TYPE_REVISIONS) {
+      value = RevisionTimestamp(ordinal, random);
+    } else if (name == fields::kTimestampField) {
+      const double kRecent = std::sqrt(random->Real());
+      value = kFirstTimestamp +
+              static_cast<int64_t>(
+                  kRecent *
+                  static_cast<double>(kLastTimestamp - kFirstTimestamp));
+    } else if (name == fields::kPageIdField) {
+      // Revisions of a page are stored together, as in the dumps.
+      value = static_cast<int64_t>(
+          file_type_ == proto::FileType::FILE_TYPE_REVISIONS
+              ? 1 + ordinal / kRevisionsPerPage
+              : 1 + random->Uniform(kMaxRandomId));
+    } else if (name == fields::kRevisionIdField) {
+      value = static_cast<int64_t>(1 + random->Uniform(kMaxRevisionId));
+    } else if (name == fields::kDoiField) {
+      if (random->Chance(depth > 0 ? kNestedDoiRate : kTopLevelDoiRate)) {
+        value = fmt::format(
+            "10.{}/{}", kFirstDoiRegistrant + random->Uniform(kDoiRegistrants),
+            random->Next());
+      }
+    } else if (name == kTemplateLeaf) {
+      value = std::string(kTemplates[random->Zipf(kTemplates.size())]);
+    } else if (name == kUrlField) {
+      value = fmt::format("https://www.example{}.org/{}/{}",
+                          random->Uniform(kUrlHosts), random->Next(),
+                          random->Uniform(kMaxRandomId));
+    } else if (EndsWith(name, kIdsSuffix)) {
+      value = fmt::format(
+          "{}{}", static_cast<char>(std::toupper(name[0])),
+          kOpenAlexIdBase + random->Uniform(kMaxRandomId));
+    } else if (EndsWith(name, kYearSuffix)) {
+      const double kRecent = std::sqrt(random->Real());
+      value = kFirstYear + static_cast<int64_t>(
+                               kRecent *
+                               static_cast<double>(kLastYear - kFirstYear + 1));
+    } else {
+      switch (field->cpp_type()) {
+        case pb::FieldDescriptor::CPPTYPE_STRING:
+          if (field->type() == pb::FieldDescriptor::TYPE_BYTES) {
+            std::string bytes(
+                random->LogNormal(kBytesMu, kBytesSigma, kMaxBytes), '\0');
+            for (auto& byte : bytes) {
+              byte = static_cast<char>(random->Next());
+            }
+            value = std::move(bytes);
+          } else {
+            value = random->Words(
+                std::max<size_t>(
+                    1, random->LogNormal(kWordsMu, kWordsSigma, kMaxWords)));
+          }
+          break;
+        case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+        case pb::FieldDescriptor::CPPTYPE_FLOAT:
+          value = random->Real();
+          break;
+        case pb::FieldDescriptor::CPPTYPE_BOOL:
+          value = random->Chance(0.5);
+          break;
+        case pb::FieldDescriptor::CPPTYPE_ENUM: {
+          const auto* type = field->enum_type();
+          value = static_cast<int64_t>(
+              type->value(static_cast<int>(random->Uniform(
+                              static_cast<uint64_t>(type->value_count()))))
+                  ->number());
+          break;
+        }
+        default:
+          value = static_cast<int64_t>(random->Uniform(kMaxRandomInt));
+          break;
+      }
+    }
+
+    SetScalar(message, field, value);
+  }
+}
+
+int64_t Synthesizer::RevisionTimestamp(uint64_t ordinal,
+                                       Random* random) const {
+  // The page is created at a time leaning towards recent years, the
+  // same for all its revisions. They then follow in order, each in its
+  // own slice of the time left until the last timestamp.
+  const uint64_t kPage = ordinal / kRevisionsPerPage;
+  const uint64_t kIndex = ordinal % kRevisionsPerPage;
+  Random page(seed_ ^ ~(kPage * kOrdinalMultiplier));
+  const int64_t kCreated =
+      kFirstTimestamp +
+      static_cast<int64_t>(
+          std::sqrt(page.Real()) *
+          static_cast<double>(kLastTimestamp - kFirstTimestamp));
+  const auto kSlice = static_cast<uint64_t>(kLastTimestamp - kCreated) /
+                      kRevisionsPerPage;
+  return kCreated + static_cast<int64_t>(kIndex * kSlice +
+                                         random->Uniform(kSlice));
+}
+
+size_t Synthesizer::RepeatCount(const pb::FieldDescriptor* field,
+                                // NOLINTNEXTLINE(whitespace/indent_namespace)
+                                Random* random) const {
+  if (field->name() == fields::kCitationsField) {
+    if (random->Chance(kNoCitationRate))
+      return 0;
+    return std::max<size_t>(
+        1, random->LogNormal(kCitationMu, kCitationSigma, kMaxCitations));
+  }
+
+  if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE ||
+      EndsWith(field->name(), kIdsSuffix)) {
+    return random->LogNormal(kListMu, kListSigma, kMaxList);
+  }
+
+  return random->Uniform(kMaxScalarList);
+}
+
+}  // namespace wikiopencite::citescoop::cli::synthetic
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_SYNTHETIC_H_
+#define SRC_SYNTHETIC_H_
+
+#include <cstdint>
+
+#include "citescoop/proto/file_header.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+namespace wikiopencite::citescoop::cli::synthetic {
+
+/// @brief Fills messages with synthetic but plausible content, for
+/// load and scale testing.
+///
+/// Fields are populated through reflection. Fields the commands know
+/// about (see fields.h) get values shaped like real data: identifiers
+/// increase with the message ordinal, timestamps lean towards recent
+/// years and rise through the revisions of a page, citation counts and
+/// string lengths follow heavy tailed distributions and templates
+/// follow a Zipf like popularity. Any other field gets a random value
+/// of its type.
+///
+/// Every message depends only on the seed and its ordinal, so the
+/// output is the same however the work is split between threads.
+class Synthesizer {
+ public:
+  /// @param file_type Type of file being generated.
+  /// @param seed Seed for the pseudo random generator.
+  /// @param duplicate_rate Probability that a message reuses the
+  /// OpenAlex id of an earlier message.
+  Synthesizer(wikiopencite::proto::FileType file_type, uint64_t seed,
+              double duplicate_rate);
+
+  /// @brief Populate a cleared message with the content for ordinal.
+  void Fill(uint64_t ordinal, google::protobuf::Message* message) const;
+
+ private:
+  class Random;
+
+  void FillMessage(uint64_t ordinal, size_t depth, Random* random,
+                   google::protobuf::Message* message) const;
+  void FillField(uint64_t ordinal, size_t depth, Random* random,
+                 const google::protobuf::FieldDescriptor* field,
+                 google::protobuf::Message* message) const;
+  /// @brief Timestamp of the revision at ordinal, later than those of
+  /// the earlier revisions of its page.
+  int64_t RevisionTimestamp(uint64_t ordinal, Random* random) const;
+  [[nodiscard]] size_t RepeatCount(
+      const google::protobuf::FieldDescriptor* field, Random* random) const;
+
+  wikiopencite::proto::FileType file_type_;
+  uint64_t seed_;
+  double duplicate_rate_;
+  const char* primary_id_;
+  char id_prefix_;
+};
+
+}  // namespace wikiopencite::citescoop::cli::synthetic
+
+#endif  // SRC_SYNTHETIC_H_
@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2026 The University of St Andrews
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SRC_THREAD_POOL_H_
+#define SRC_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace wikiopencite::citescoop::cli {
+
+/// @brief Fixed size pool of worker threads executing tasks in
+/// submission order.
+class ThreadPool {
+ public:
+  /// @brief Start a pool.
+  /// @param threads Number of worker threads. Zero is treated as one.
+  explicit ThreadPool(unsigned threads);
+
+  /// @brief Finish all queued tasks and join the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// @brief Queue a task for execution on the pool.
+  /// @param task Callable taking no arguments.
+  /// @return Future for the result of the task. Exceptions thrown by
+  /// the task are rethrown from std::future::get.
+  template <typename F>
+  std::future<std::invoke_result_t<F>> Submit(F&& task) {
+    using Result = std::invoke_result_t<F>;
+    auto packaged =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back([packaged]() { (*packaged)(); });
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+  /// @brief Number of worker threads in the pool.
+  [[nodiscard]] size_t size() const { return workers_.size(); }
+
+  /// @brief Default number of threads to use when the user does not
+  /// specify one.
+  static unsigned DefaultThreadCount();
+
+  /// @brief Process wide pool of DefaultThreadCount threads, started on
+  /// first use, for short tasks that never wait on other tasks, such as
+  /// compressing or decompressing a block. Sharing it keeps the number
+  /// of threads fixed however many files are open at once.
+  static ThreadPool& Shared();
+
+ private:
+  void Work();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_ = false;
+};
+
+}  // namespace wikiopencite::citescoop::cli
+
+#endif  // SRC_THREAD_POOL_H_